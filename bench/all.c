@@ -0,0 +1,15 @@
+#include <time.h>
+
+#include <walc.h>
+
+#include <lexer.bench.c>
+#include <parser.bench.c>
+#include <binder.bench.c>
+
+int main()
+{
+	bench_lexer();
+	bench_parser();
+	bench_binder();
+	return 0;
+}
@@ -0,0 +1,60 @@
+// compares binding a large generated source from scratch with reparsing and rebinding it after an edit
+
+void bench_binder()
+{
+	String source = {0};
+	stringAppend(&source, STR("import print(str msg);\n"));
+	int functionCount = 20000;
+	for (int i = 0; i < functionCount; i++) {
+		Str function = strFormat("i32 compute%d(i32 count) {\n"
+								 "\tvar accumulator = count * 3;\n"
+								 "\tfor var i = 0; i < count; i++; { accumulator = accumulator + i; }\n"
+								 "\tif accumulator > 1000 { print(\"big\"); }\n"
+								 "\tcompute%d(accumulator);\n"
+								 "\treturn accumulator;\n"
+								 "}\n",
+								 i, (i + 1) % functionCount);
+		stringAppend(&source, function);
+		strFree(&function);
+	}
+	stringToCStr(&source);
+	Str text = {.buf = source.buf, .len = source.len};
+
+	WlParser p = wlParserCreate(STR("bench.wl"), text);
+	wlParse(&p);
+
+	clock_t start = clock();
+	WlBinder b = wlBind(&p.ast, p.topLevelDeclarations);
+	clock_t end = clock();
+	printf("binder (full): %d functions in %.3fs\n", listLen(b.functions), (end - start) / (f64)CLOCKS_PER_SEC);
+
+	// types and deletes a digit in the middle of the source, which changes a single body
+	char *buf = malloc(source.len + 2);
+	memcpy(buf, source.buf, source.len + 1);
+	u32 offset = strstr(source.buf + source.len / 2, "count * 3") - source.buf + 9;
+
+	int edits = 100;
+	start = clock();
+	for (int i = 0; i < edits; i++) {
+		bool typing = i % 2 == 0;
+		if (typing) {
+			memmove(buf + offset + 1, buf + offset, source.len - offset + 1);
+			buf[offset] = '3';
+		} else {
+			memmove(buf + offset, buf + offset + 1, source.len - offset + 1);
+		}
+		Str edited = {.buf = buf, .len = source.len + typing};
+		wlParserReparse(&p, edited, (WlTextEdit){offset, !typing, typing});
+		wlRebind(&b, p.topLevelDeclarations);
+	}
+	end = clock();
+
+	f64 milliseconds = (end - start) * 1000.0 / CLOCKS_PER_SEC;
+	printf("binder (rebind): %.3fms per reparsed and rebound edit\n", milliseconds / edits);
+	if (listLen(b.diagnostics) != 0) printf("binder: unexpected diagnostics in benchmark source\n");
+
+	wlBinderFree(&b);
+	wlParserFree(&p);
+	free(buf);
+	stringFree(&source);
+}
@@ -0,0 +1,71 @@
+// measures raw lexer throughput on a large synthetic source file
+
+#define BENCHLEXERTARGETSIZE (64 * 1024 * 1024)
+
+static char *benchLexerChunk = "// generated source\n"
+							   "namespace Bench.Module {\n"
+							   "\tuse Other;\n"
+							   "\t/* a block comment with some text */\n"
+							   "\texport i32 computeValue(i32 count, i64 total) {\n"
+							   "\t\ti32 accumulator = 42;\n"
+							   "\t\tfor var i = 0; i < count; i++; {\n"
+							   "\t\t\tif i % 2 == 0 && accumulator >= 10 { accumulator = accumulator + i * 3; }\n"
+							   "\t\t\telse { accumulator = accumulator - (i << 1) | 10; }\n"
+							   "\t\t}\n"
+							   "\t\twhile accumulator > 1000 { accumulator = accumulator / 2; }\n"
+							   "\t\tlet message = \"some string literal\";\n"
+							   "\t\tprint(message);\n"
+							   "\t\treturn accumulator + someIdentifierName * another_one;\n"
+							   "\t}\n"
+							   "\tf64 scale() { 3.25 }\n"
+							   "}\n";
+
+// mostly comments, indentation and long identifiers, like our generated sources
+static char *benchLexerCommentChunk =
+	"/* generated by the model exporter\n"
+	" * do not edit this file by hand, any changes will be overwritten the next time the exporter runs\n"
+	" * /* nested comments are allowed */ and they are skipped as a whole\n"
+	" */\n"
+	"namespace Generated.Model.Entities {\n"
+	"                // the identifier below is derived from the schema path of the entity\n"
+	"                export i32 generatedEntityAccessorForCustomerBillingAddressPostalCode(i32 "
+	"generatedParameterIndex) {\n"
+	"                                // the value is returned as is\n"
+	"                                generatedParameterIndex + generatedEntityOffsetForCustomerBillingAddress\n"
+	"                }\n"
+	"}\n";
+
+void benchLexerSource(char *name, char *chunk)
+{
+	String source = {0};
+	while (source.len < BENCHLEXERTARGETSIZE) {
+		stringAppend(&source, strFromCstr(chunk));
+	}
+
+	Str text = {.buf = stringToCStr(&source), .len = source.len};
+	int tokenCount = 0;
+
+	clock_t start = clock();
+	WlLexer l = wlLexerCreate(STR("bench.wl"), text);
+	while (wlLexerLexToken(&l).kind != WlKind_EOF)
+		tokenCount++;
+	clock_t end = clock();
+
+	f64 seconds = (end - start) / (f64)CLOCKS_PER_SEC;
+	f64 megabytes = source.len / (1024.0 * 1024.0);
+
+	printf("lexer (%s): %d tokens, %.1f MB in %.3fs (%.1f MB/s)\n", name, tokenCount, megabytes, seconds,
+		   megabytes / seconds);
+	if (listLen(l.diagnostics) != 0) {
+		printf("lexer (%s): unexpected diagnostics in benchmark source\n", name);
+	}
+
+	wlLexerFree(&l);
+	stringFree(&source);
+}
+
+void bench_lexer()
+{
+	benchLexerSource("dense", benchLexerChunk);
+	benchLexerSource("comments", benchLexerCommentChunk);
+}
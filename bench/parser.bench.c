@@ -0,0 +1,86 @@
+// compares parsing with the lookahead ring buffer against parsing from the pre-lexed token store
+// and against only brace matching the function bodies or parsing the declarations on all cores
+
+void benchParserMode(char *name, String source, WlParserOptions options)
+{
+	Str text = {.buf = source.buf, .len = source.len};
+
+	clock_t start = clock();
+	WlParser p = wlParserCreateWithOptions(STR("bench.wl"), text, options);
+	wlParse(&p);
+	clock_t end = clock();
+
+	f64 seconds = (end - start) / (f64)CLOCKS_PER_SEC;
+	f64 megabytes = source.len / (1024.0 * 1024.0);
+
+	printf("parser (%s): %d declarations, %.1f MB in %.3fs (%.1f MB/s)\n", name, listLen(p.topLevelDeclarations),
+		   megabytes, seconds, megabytes / seconds);
+	if (!(options & WlParserStreaming)) {
+		int tokenCount = wlTokenStoreLen(&p.tokenStore);
+		int storeBytes = tokenCount * (sizeof(u8) + 3 * sizeof(u32)) + listLen(p.tokenStore.literals) * sizeof(i64);
+		printf("parser (%s): %d tokens in %.1f MB, %.1f MB as WlToken\n", name, tokenCount,
+			   storeBytes / (1024.0 * 1024.0), tokenCount * sizeof(WlToken) / (1024.0 * 1024.0));
+	}
+	int astBytes = p.ast.count * (2 * sizeof(u8) + sizeof(WlNodeRange) + sizeof(WlNodeData)) +
+				   listLen(p.ast.extra) * sizeof(u32);
+	printf("parser (%s): %d nodes and %d extra words in %.1f MB\n", name, p.ast.count, listLen(p.ast.extra),
+		   astBytes / (1024.0 * 1024.0));
+	if (listLen(p.diagnostics) != 0 || listLen(p.lexer.diagnostics) != 0) {
+		printf("parser (%s): unexpected diagnostics in benchmark source\n", name);
+	}
+
+	wlParserFree(&p);
+}
+
+// types and deletes a single character in the middle of the source, like an editor would on every keystroke
+void benchParserReparse(String source)
+{
+	Str text = {.buf = source.buf, .len = source.len};
+	WlParser p = wlParserCreate(STR("bench.wl"), text);
+	wlParse(&p);
+
+	// the edited copy needs room for the typed character and the zero byte
+	char *buf = malloc(source.len + 2);
+	memcpy(buf, source.buf, source.len + 1);
+	u32 offset = strstr(source.buf + source.len / 2, "accumulator") - source.buf + 1;
+
+	int edits = 1000;
+	int incremental = 0;
+	clock_t start = clock();
+	for (int i = 0; i < edits; i++) {
+		bool typing = i % 2 == 0;
+		if (typing) {
+			memmove(buf + offset + 1, buf + offset, source.len - offset + 1);
+			buf[offset] = 'x';
+		} else {
+			memmove(buf + offset, buf + offset + 1, source.len - offset + 1);
+		}
+		Str edited = {.buf = buf, .len = source.len + typing};
+		incremental += wlParserReparse(&p, edited, (WlTextEdit){offset, !typing, typing});
+	}
+	clock_t end = clock();
+
+	f64 milliseconds = (end - start) * 1000.0 / CLOCKS_PER_SEC;
+	printf("parser (reparse): %d of %d single character edits were incremental, %.3fms per edit\n", incremental, edits,
+		   milliseconds / edits);
+	wlParserFree(&p);
+	free(buf);
+}
+
+void bench_parser()
+{
+	String source = {0};
+	while (source.len < BENCHLEXERTARGETSIZE / 16) {
+		stringAppend(&source, strFromCstr(benchLexerChunk));
+	}
+	// the lexer expects a zero byte after the source
+	stringToCStr(&source);
+
+	benchParserMode("streaming", source, WlParserStreaming);
+	benchParserMode("token store", source, WlParserDefault);
+	benchParserMode("lazy bodies", source, WlParserLazyBodies);
+	benchParserMode("parallel", source, WlParserParallel);
+	benchParserReparse(source);
+
+	stringFree(&source);
+}
@@ -25,6 +25,11 @@ export i64 postDecrement(i64 n) { n-- }
 export i64 negate(i64 b) { -b }
 export bool negateBool(bool b) { !b }
 
+// i64 literals take all 64 bits
+export i64 beyond32() { 4294967296 }
+export i64 largest() { 9223372036854775807 }
+export i64 offset(i64 a) { a + 4294967296 }
+
 export i32 something() {
     // you can use do blocks to perform advanced calculations within an expression
     // the return type is i32 and the rest of the types are inferred from there on out
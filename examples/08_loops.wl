@@ -0,0 +1,22 @@
+// loops that count are unrolled, a loop that runs a known number of times becomes copies of its body
+// and others run several copies of their body per iteration
+
+export i32 counted() {
+    var s = 0;
+    for var i = 0; i < 4; i++; {
+        s++;
+        --s;
+        s++;
+    }
+    return s;
+}
+
+export i32 countedTo(i32 n) {
+    var s = 0;
+    for var i = 0; i < n; i++; {
+        s++;
+        --s;
+        s++;
+    }
+    return s;
+}
@@ -0,0 +1,20 @@
+// the value of an expression statement is thrown away
+
+@noinline i32 triple(i32 a) { a * 3 }
+
+export i32 increments(i32 n) {
+    var s = n;
+    s++;
+    --s;
+    s++;
+    triple(s);
+    if s > 1 {
+        --s;
+    }
+    s
+}
+
+export count() {
+    var b = 1;
+    b++;
+}
@@ -5,6 +5,7 @@
 void run();
 void build();
 void test();
+void bench();
 
 void describe_project()
 {
@@ -15,6 +16,7 @@ void describe_project()
 	addCommand("run", run);
 	addCommand("build", build);
 	addCommand("test", test);
+	addCommand("bench", bench);
 }
 
 void build()
@@ -35,3 +37,10 @@ void test()
 
 	compileAndRun("./test/all.c");
 }
+
+void bench()
+{
+	includeDir("bench");
+
+	compileAndRun("./bench/all.c");
+}
@@ -1,23 +1,74 @@
+#include <thread.h>
 #include <walc.h>
 
-WlBType wlBindType(WlToken tk)
-{
-	if (tk.kind == WlKind_Missing) return WlBType_u0;
-
-	assert(tk.kind == WlKind_Symbol);
+// atoms of the builtin type names and of the notes bodies read, interned when the first binder is created
+// bodies may be bound on several threads, which must not intern
+static WlAtom wlBTypeAtoms[WlBType_end];
+static WlAtom wlUnrollAtom;
 
+void wlBindTypeAtoms()
+{
+	if (wlBTypeAtoms[0]) return;
 	for (int i = 0; i < WlBType_end; i++) {
-		// TODO: cache Str
-		Str typeString = strFromCstr(WlBTypeText[i]);
-		if (strEqual(tk.valueStr, typeString)) {
-			return i;
-		}
+		wlBTypeAtoms[i] = wlIntern(strFromCstr(WlBTypeText[i]));
 	}
+	wlUnrollAtom = wlIntern(STR("unroll"));
+}
 
-	PANIC("Unknown type %.*s %d", STRPRINT(tk.valueStr), WlBType_unknown);
+typedef struct {
+	WlAtom atom;
+	WlBType type;
+} WlTypeName;
+
+// the types that can be named in a program, every binder starts out with the builtins
+// types declared by the program would be registered together with the signatures, bodies only look types up so the
+// workers of wlBindBodies share the registry of their binder
+typedef struct {
+	// open addressing table keyed by atom hash, the capacity is a power of two
+	WlTypeName *slots;
+	u32 count;
+	u32 capacity;
+} WlTypeRegistry;
+
+// WlBType_unknown when no type has that name
+WlBType wlTypeLookup(WlTypeRegistry *r, WlAtom atom)
+{
+	u32 mask = r->capacity - 1;
+	for (u32 slot = wlAtomHash(atom) & mask; r->capacity && r->slots[slot].atom; slot = (slot + 1) & mask) {
+		if (r->slots[slot].atom == atom) return r->slots[slot].type;
+	}
 	return WlBType_unknown;
 }
 
+static void wlTypeIndex(WlTypeRegistry *r, WlTypeName name)
+{
+	u32 mask = r->capacity - 1;
+	u32 slot = wlAtomHash(name.atom) & mask;
+	while (r->slots[slot].atom)
+		slot = (slot + 1) & mask;
+	r->slots[slot] = name;
+}
+
+// the table lives in the arena, a grown table leaves the old one behind like the symbol tables of scopes
+void wlTypeRegister(WlTypeRegistry *r, WlAtom atom, WlBType type, ArenaAllocator *arena)
+{
+	assert(wlTypeLookup(r, atom) == WlBType_unknown && "type names are unique");
+
+	// keep the table at most half full
+	r->count++;
+	if (r->count * 2 > r->capacity) {
+		u32 oldCapacity = r->capacity;
+		WlTypeName *old = r->slots;
+		r->capacity = oldCapacity ? oldCapacity * 2 : 32;
+		r->slots = arenaMalloc(r->capacity * sizeof(WlTypeName), arena);
+		memset(r->slots, 0, r->capacity * sizeof(WlTypeName));
+		for (u32 i = 0; i < oldCapacity; i++) {
+			if (old[i].atom) wlTypeIndex(r, old[i]);
+		}
+	}
+	wlTypeIndex(r, (WlTypeName){.atom = atom, .type = type});
+}
+
 typedef enum
 {
 	WlBKind_None,
@@ -41,6 +92,8 @@ typedef enum
 	WlBKind_StringLiteral,
 	WlBKind_NumberLiteral,
 	WlBKind_BoolLiteral,
+	// assigns a WlBoundAssignment to a local and evaluates to the value, only made by the eliminator
+	WlBKind_AssignmentExpression,
 } WlBKind;
 
 typedef enum
@@ -66,6 +119,8 @@ typedef enum
 	WlBOperator_Increment,
 	WlBOperator_Decrement,
 	WlBOperator_Negate,
+	// the high half of the product of two 32 bit integers, only made by the reducer
+	WlBOperator_MultiplyHigh,
 } WlBOperator;
 
 typedef enum
@@ -85,6 +140,11 @@ typedef enum
 	WlSFlag_Immutable = 16,
 	WlSFlag_Import = 32,
 	WlSFlag_Export = 64,
+	// marked with @entrypoint, a root for wlBindReachable just like exports
+	WlSFlag_Entrypoint = 128,
+	// marked with @inline or @noinline, calls to the function are always or never inlined, see inlineCalls
+	WlSFlag_Inline = 256,
+	WlSFlag_NoInline = 512,
 } WlSymbolFlags;
 
 struct WlBoundFunction;
@@ -94,30 +154,52 @@ struct WlbNode;
 
 typedef struct WlSymbol {
 	int index;
+	WlAtom atom;
+	// text of the atom, kept around for diagnostics and the emitter
 	Str name;
 	WlBType type;
 	WlSymbolFlags flags;
+	// variables declared with var or let have their type inferred, see wlTypeFind
+	// set while the body of their function is bound, 0 once the type is solved
+	u32 typeVar;
 	union {
 		// if function
 		struct WlBoundFunction *function;
 		// if namespace
 		struct WlScope *scope;
-		// if variable
-		List(struct WlSymbol *) typeLinked;
 		// if constant
 		struct WlbNode *initializer;
 	};
 } WlSymbol;
 
+// scopes with more symbols than this also index them in a hash table, smaller ones are scanned
+#define WLSCOPELINEARSYMBOLS 8
+
 typedef struct WlScope {
 	List(struct WlScope *) usedScopes;
+	// in declaration order, the emitter relies on the parameters of a function coming first
 	List(WlSymbol *) symbols;
+	// open addressing table of the symbols keyed by atom, names are unique within a scope
+	// the capacity is a power of two or 0 while the scope is small
+	WlSymbol **slots;
+	u32 slotCapacity;
+	// set for the global and namespace scopes once the uses are bound, their names don't change after that
+	bool sealed;
+	// sealed scopes that use other scopes precompute every name visible without looking at the parents
+	// the names of the scope come first, then those of the used scopes in the order they are searched
+	// a name appears once per symbol kind, the same open addressing scheme as slots
+	WlSymbol **visible;
+	u32 visibleCapacity;
 	struct WlScope *parentScope;
+	// the global or namespace scope this one replaced in wlRebind, functions declared again keep its symbols
+	struct WlScope *previous;
 } WlScope;
 
 typedef struct WlbNode {
 	WlBKind kind;
 	WlBType type;
+	// nodes of an abstract type point at a type variable, their type is final once the function is solved
+	u32 typeVar;
 	WlSpan span;
 	union {
 		void *data;
@@ -163,16 +245,51 @@ typedef struct {
 	WlbNode expression;
 } WlBoundReturn;
 
+// a symbol outside of its function that a body resolved, see wlRebind
+typedef struct {
+	WlAtom *path;
+	int pathLen;
+	WlSymbolFlags flags;
+	WlSymbol *symbol;
+	// of the function at the time the body was bound, calls are the only dependencies
+	u64 signature;
+} WlBodyDependency;
+
 typedef struct WlBoundFunction {
 	WlScope *scope;
 	int paramCount;
 	WlbNode body;
 	WlSymbol *symbol;
+	// queued for body binding by wlBindReachable
+	bool reached;
+	// set by lower, bodies kept by wlRebind are not lowered again
+	bool lowered;
+	// set by eliminate, the last pass, bodies kept by wlRebind are not optimized again
+	bool optimized;
+	// set by inlineCalls once a call in the body was replaced by the body of the function it called
+	bool inlined;
+	// set by shake, functions that can't be called from an export or @entrypoint function are left out of the module
+	bool live;
+	// hash and offset of the declaration text, a body is only kept when the text of its declaration is the same
+	u64 syntaxHash;
+	u32 syntaxStart;
+	// see wlSignatureHash, set once the parameters are bound
+	u64 signature;
+	// what the body and its local functions resolved outside of the function, set for the bodies bound by wlBind
+	WlBodyDependency *dependencies;
+	int dependencyCount;
+	// the diagnostics and local functions of the body are [start, end) of the diagnostics and functions of the binder
+	int diagnosticStart;
+	int diagnosticEnd;
+	int localStart;
+	int localEnd;
+	// the function of the same symbol before wlRebind, NULL once the rebind is done
+	struct WlBoundFunction *previous;
 } WlBoundFunction;
 
 typedef struct WlBoundUse {
 	WlScope *scope;
-	List(WlToken) path;
+	WlNode path;
 	WlSymbol *symbol;
 } WlBoundUse;
 
@@ -185,6 +302,8 @@ typedef struct {
 typedef struct {
 	WlbNode condition;
 	WlbNode block;
+	// the n of the @unroll(n) of the for loop it was lowered from, 0 when the unroller decides, see unrollFunction
+	int unroll;
 } WlBoundWhile;
 
 typedef struct {
@@ -198,6 +317,7 @@ typedef struct {
 	WlbNode postCondition;
 	WlbNode block;
 	WlScope *scope;
+	int unroll;
 } WlBoundFor;
 
 typedef struct WlBoundVariable {
@@ -210,14 +330,59 @@ typedef struct {
 	WlSymbol *symbol;
 } WlBoundAssignment;
 
+// bodies are only bound in parallel when every worker gets at least this many
+#define BINDERWORKERBODIES 64
+
+// a type variable of the function that is being bound, see wlTypeFind
+// type is the most specific type known for its class, which is a literal type (integer, floating) until a concrete
+// type is found, or inferWeak when nothing is known yet
+typedef struct {
+	u32 parent;
+	u32 rank;
+	WlBType type;
+} WlTypeVar;
+
+// a path resolved from a sealed scope, see wlFindSymbolInNamespace
+typedef struct {
+	WlScope *scope;
+	WlAtom *path;
+	int pathLen;
+	WlSymbolFlags flags;
+	u32 hash;
+	WlSymbol *symbol;
+} WlResolution;
+
 typedef struct {
+	// the syntax tree that is being bound
+	WlAst *ast;
+	// the text the bodies were bound from, string literals point into it, see wlRebind
+	Str source;
 	List(WlBoundFunction *) functions;
 	List(WlBoundUse *) uses;
 	List(WlScope *) scopes;
 	List(WlDiagnostic) diagnostics;
 	WlSymbol *currentVariable;
 	WlBType currentReturnType;
+	// the type variable the returns of the current do block are unified with, 0 in function bodies
+	u32 currentReturnVar;
+	// reset for every function body, variable 0 means a node or symbol has no type variable
+	List(WlTypeVar) typeVars;
 	ArenaAllocator arena;
+	// set by wlBindReachable, bodies are only bound once a call reaches their function
+	// lazily parsed bodies are parsed with the parser on first use
+	WlParser *parser;
+	List(WlBoundFunction *) pending;
+	// the next body of pending that wlBindNextBody binds
+	int pendingNext;
+	WlTypeRegistry types;
+	// open addressing table of resolved paths, the capacity is a power of two or 0 while it is empty
+	WlResolution **resolutions;
+	u32 resolutionCount;
+	u32 resolutionCapacity;
+	// the top-level function whose body is being bound by wlBindBodies, its dependencies are collected in
+	// dependencies
+	WlBoundFunction *dependent;
+	List(WlBodyDependency) dependencies;
 } WlBinder;
 
 WlScope *WlCreateAndPushScope(WlBinder *b)
@@ -238,9 +403,131 @@ void WlPopScope(WlBinder *b)
 	assert(!listIsEmpty(b->scopes) && "The global scope shouldn't be popped");
 }
 
-WlSymbol *wlFindSymbol(WlBinder *b, Str name, WlSymbolFlags flags, bool recurse);
+// the symbol named name declared directly in s, without looking at used or parent scopes
+static WlSymbol *wlScopeLookup(WlScope *s, WlAtom name)
+{
+	if (s->slotCapacity == 0) {
+		for (int i = 0; i < listLen(s->symbols); i++) {
+			if (s->symbols[i]->atom == name) return s->symbols[i];
+		}
+		return NULL;
+	}
+
+	u32 mask = s->slotCapacity - 1;
+	for (u32 slot = wlAtomHash(name) & mask; s->slots[slot]; slot = (slot + 1) & mask) {
+		if (s->slots[slot]->atom == name) return s->slots[slot];
+	}
+	return NULL;
+}
+
+static void wlScopeIndex(WlScope *s, WlSymbol *symbol)
+{
+	u32 mask = s->slotCapacity - 1;
+	u32 slot = wlAtomHash(symbol->atom) & mask;
+	while (s->slots[slot])
+		slot = (slot + 1) & mask;
+	s->slots[slot] = symbol;
+}
 
-WlSymbol *wlPushSymbol(WlBinder *b, Str name, WlBType type, WlSymbolFlags flags)
+// the tables live in the binder arena, a grown table leaves the old one behind which at most doubles their memory
+static void wlScopeInsert(WlScope *s, WlSymbol *symbol, ArenaAllocator *arena)
+{
+	assert(!s->sealed && "sealed scopes cannot gain symbols");
+	listPush(&s->symbols, symbol);
+	u32 count = listLen(s->symbols);
+	if (count <= WLSCOPELINEARSYMBOLS) return;
+
+	// keep the table at most half full
+	if (count * 2 > s->slotCapacity) {
+		u32 newCapacity = s->slotCapacity ? s->slotCapacity * 2 : 4 * WLSCOPELINEARSYMBOLS;
+		s->slots = arenaMalloc(newCapacity * sizeof(WlSymbol *), arena);
+		memset(s->slots, 0, newCapacity * sizeof(WlSymbol *));
+		s->slotCapacity = newCapacity;
+		for (u32 i = 0; i < count; i++) {
+			wlScopeIndex(s, s->symbols[i]);
+		}
+	} else {
+		wlScopeIndex(s, symbol);
+	}
+}
+
+// the first symbol named name of the given kind (or of any kind when type is 0) in the visible table of s
+static WlSymbol *wlVisibleLookup(WlScope *s, WlAtom name, WlSymbolFlags type)
+{
+	u32 mask = s->visibleCapacity - 1;
+	for (u32 slot = wlAtomHash(name) & mask; s->visible[slot]; slot = (slot + 1) & mask) {
+		WlSymbol *smb = s->visible[slot];
+		if (smb->atom == name && (!type || type == (smb->flags & WlSFlag_TypeBits))) return smb;
+	}
+	return NULL;
+}
+
+// names with the same atom share a probe sequence, so they are found in the order they were inserted
+static void wlVisibleInsert(WlScope *s, WlSymbol *symbol)
+{
+	WlSymbolFlags type = symbol->flags & WlSFlag_TypeBits;
+	u32 mask = s->visibleCapacity - 1;
+	u32 slot = wlAtomHash(symbol->atom) & mask;
+	for (; s->visible[slot]; slot = (slot + 1) & mask) {
+		WlSymbol *smb = s->visible[slot];
+		// shadowed by a symbol of the same kind that is searched first
+		if (smb->atom == symbol->atom && type == (smb->flags & WlSFlag_TypeBits)) return;
+	}
+	s->visible[slot] = symbol;
+}
+
+// collects the symbols of s followed by those of the scopes it uses, depth first like wlFindSymbolInScope
+static void wlCollectVisible(WlScope *s, List(WlScope *) * visited, List(WlSymbol *) * names)
+{
+	for (int i = 0; i < listLen(*visited); i++) {
+		if ((*visited)[i] == s) return;
+	}
+	listPush(visited, s);
+
+	for (int i = 0; i < listLen(s->symbols); i++) {
+		listPush(names, s->symbols[i]);
+	}
+	for (int i = 0; i < listLen(s->usedScopes); i++) {
+		wlCollectVisible(s->usedScopes[i], visited, names);
+	}
+}
+
+// global and namespace scopes only declare namespaces, imports and functions, which are all bound with the signatures
+// so once the uses are bound too, everything they can see is known
+static void wlSealScope(WlBinder *b, WlScope *s)
+{
+	if (s->sealed) return;
+	s->sealed = true;
+
+	for (int i = 0; i < listLen(s->symbols); i++) {
+		WlSymbol *smb = s->symbols[i];
+		if ((smb->flags & WlSFlag_TypeBits) == WlSFlag_Namespace && smb->scope) wlSealScope(b, smb->scope);
+	}
+
+	if (listIsEmpty(s->usedScopes)) return;
+
+	List(WlScope *) visited = listNew();
+	List(WlSymbol *) names = listNew();
+	wlCollectVisible(s, &visited, &names);
+
+	// keep the table at most half full
+	u32 capacity = 4 * WLSCOPELINEARSYMBOLS;
+	while (capacity < (u32)listLen(names) * 2)
+		capacity *= 2;
+	s->visible = arenaMalloc(capacity * sizeof(WlSymbol *), &b->arena);
+	memset(s->visible, 0, capacity * sizeof(WlSymbol *));
+	s->visibleCapacity = capacity;
+	for (int i = 0; i < listLen(names); i++) {
+		wlVisibleInsert(s, names[i]);
+	}
+
+	listFree(&visited);
+	listFree(&names);
+}
+
+WlSymbol *wlFindSymbol(WlBinder *b, WlAtom name, WlSymbolFlags flags, bool recurse);
+
+WlSymbol *wlPushSymbol(WlBinder *b, WlAtom name, WlBType type, WlSymbolFlags flags)
 {
 	WlSymbol *existing = wlFindSymbol(b, name, WlSFlag_None, false);
 	if (existing) {
@@ -251,41 +538,49 @@ WlSymbol *wlPushSymbol(WlBinder *b, Str name, WlBType type, WlSymbolFlags flags)
 		}
 	}
 
-	List(WlSymbol *) symbols = listPeek(&b->scopes)->symbols;
+	// a function that is declared again keeps its symbol, so the bodies that wlRebind keeps still call it
+	// its function is left as it was until the declaration replaces it
+	WlScope *scope = listPeek(&b->scopes);
+	WlSymbol *newSymbol = NULL;
+	if (scope->previous && (flags & WlSFlag_TypeBits) == WlSFlag_Function) {
+		newSymbol = wlScopeLookup(scope->previous, name);
+		if (newSymbol && (newSymbol->flags & WlSFlag_TypeBits) != WlSFlag_Function) newSymbol = NULL;
+	}
+	if (!newSymbol) {
+		newSymbol = arenaMalloc(sizeof(WlSymbol), &b->arena);
+		*newSymbol = (WlSymbol){.scope = NULL};
+	}
 
-	WlSymbol *newSymbol = arenaMalloc(sizeof(WlSymbol), &b->arena);
-	*newSymbol = (WlSymbol){
-		.name = name,
-		.type = type,
-		.flags = flags,
-		.index = -1,
-		.scope = NULL,
-	};
-	listPush(&symbols, newSymbol);
-	listPeek(&b->scopes)->symbols = symbols;
+	newSymbol->atom = name;
+	newSymbol->name = wlAtomText(name);
+	newSymbol->type = type;
+	newSymbol->flags = flags;
+	newSymbol->index = -1;
+	newSymbol->typeVar = 0;
+	wlScopeInsert(scope, newSymbol, &b->arena);
 
 	return newSymbol;
 }
 
-WlSymbol *wlPushVariable(WlBinder *b, WlSpan span, Str name, WlBType type, bool immutable)
+WlSymbol *wlPushVariable(WlBinder *b, WlSpan span, WlAtom name, WlBType type, bool immutable)
 {
 	WlSymbolFlags flags = WlSFlag_Variable;
 	if (immutable) flags |= WlSFlag_Immutable;
 	WlSymbol *s = wlPushSymbol(b, name, type, flags);
 
 	if (!s) {
-		WlDiagnostic d = {.kind = VariableAlreadyExistsDiagnostic, .span = span, .str1 = name};
+		WlDiagnostic d = {.kind = VariableAlreadyExistsDiagnostic, .span = span, .str1 = wlAtomText(name)};
 		listPush(&b->diagnostics, d);
 	}
 	return s;
 }
 
-WlSymbol *wlFindVariable(WlBinder *b, WlSpan span, Str name)
+WlSymbol *wlFindVariable(WlBinder *b, WlSpan span, WlAtom name)
 {
 	WlSymbol *variable = wlFindSymbol(b, name, WlSFlag_Variable, true);
 
 	if (!variable) {
-		WlDiagnostic d = {.kind = VariableNotFoundDiagnostic, .span = span, .str1 = name};
+		WlDiagnostic d = {.kind = VariableNotFoundDiagnostic, .span = span, .str1 = wlAtomText(name)};
 		listPush(&b->diagnostics, d);
 		return NULL;
 	}
@@ -297,65 +592,172 @@ WlSymbol *wlFindVariable(WlBinder *b, WlSpan span, Str name)
 	return variable;
 }
 
-WlSymbol *wlFindSymbolInScope(WlBinder *b, WlScope *s, Str name, WlSymbolFlags flags, bool recurse)
+// the type a type name refers to, unknown names are reported and bound as WlBType_unknown, which converts to and from
+// every type so that they are only reported once
+WlBType wlBindType(WlBinder *b, WlNode n)
 {
-	WlSymbol *found = NULL;
+	if (wlAstKind(b->ast, n) == WlKind_Missing) return WlBType_u0;
+
+	WlAtom atom = wlAstAtom(b->ast, n);
+	WlBType type = wlTypeLookup(&b->types, atom);
+	if (type == WlBType_unknown) {
+		WlDiagnostic d = {.kind = UnknownTypeDiagnostic, .span = wlAstSpan(b->ast, n), .str1 = wlAtomText(atom)};
+		listPush(&b->diagnostics, d);
+	}
+	return type;
+}
 
+WlSymbol *wlFindSymbolInScope(WlBinder *b, WlScope *s, WlAtom name, WlSymbolFlags flags, bool recurse)
+{
 	WlSymbolFlags type = flags & WlSFlag_TypeBits;
 
-	for (int i = 0; i < listLen(s->symbols); i++) {
-		WlSymbol *smb = s->symbols[i];
-		if (strEqual(name, smb->name) && (!type || type == (smb->flags & WlSFlag_TypeBits))) {
-			found = smb;
-			break;
-		}
-	}
+	WlSymbol *found = NULL;
+	if (s->visibleCapacity) {
+		found = wlVisibleLookup(s, name, type);
+	} else {
+		found = wlScopeLookup(s, name);
+		if (found && type && type != (found->flags & WlSFlag_TypeBits)) found = NULL;
 
-	if (!found) {
-		for (int i = 0; i < listLen(s->usedScopes); i++) {
+		for (int i = 0; !found && i < listLen(s->usedScopes); i++) {
 			found = wlFindSymbolInScope(b, s->usedScopes[i], name, flags, false);
-			if (found) return found;
 		}
+	}
 
-		if (recurse && s->parentScope) {
-			return wlFindSymbolInScope(b, s->parentScope, name, flags, true);
-		}
+	if (!found && recurse && s->parentScope) {
+		return wlFindSymbolInScope(b, s->parentScope, name, flags, true);
 	}
 
 	return found;
 }
 
-WlSymbol *wlFindSymbolInNamespace(WlBinder *b, List(WlToken) path, WlSymbolFlags flags)
+// walks a dotted path, the first segment is looked up in scope and its parents, the others in the namespace before them
+static WlSymbol *wlResolvePath(WlBinder *b, WlScope *scope, WlAtom *path, int pathLen, WlSymbolFlags flags)
 {
-	int pathLen = listLen(path);
-
 	WlSymbol *s = NULL;
-	WlScope *scope;
-	assert(pathLen > 0);
-	for (int i = 0; i < pathLen; i += 2) {
+	for (int i = 0; i < pathLen; i++) {
 		bool isLast = i == pathLen - 1;
-		if (i == 0) {
-			s = wlFindSymbol(b, path[i].valueStr, isLast ? flags : WlSFlag_Namespace, true);
-			if (!isLast) {
-				assert(s != NULL);
-				assert(s->flags == WlSFlag_Namespace);
-				assert(s->scope != NULL);
-				scope = s->scope;
-			}
-		} else {
-			assert(s != NULL);
-			s = wlFindSymbolInScope(b, scope, path[i].valueStr, isLast ? flags : WlSFlag_Namespace, false);
-			if (!isLast) {
-				assert(s != NULL);
-				assert(s->flags == WlSFlag_Namespace);
-				assert(s->scope != NULL);
-				scope = s->scope;
-			}
+		s = wlFindSymbolInScope(b, scope, path[i], isLast ? flags : WlSFlag_Namespace, i == 0);
+		if (!isLast) {
+			if (!s) return NULL;
+			assert(s->flags == WlSFlag_Namespace);
+			assert(s->scope != NULL);
+			scope = s->scope;
+		}
+	}
+	return s;
+}
+
+static u32 wlResolutionHash(WlScope *scope, WlAtom *path, int pathLen, WlSymbolFlags flags)
+{
+	u32 hash = (u32)((size_t)scope >> 4) * 2654435761u ^ flags;
+	for (int i = 0; i < pathLen; i++) {
+		hash = (hash ^ wlAtomHash(path[i])) * 16777619u;
+	}
+	return hash;
+}
+
+static void wlResolutionIndex(WlBinder *b, WlResolution *r)
+{
+	u32 mask = b->resolutionCapacity - 1;
+	u32 slot = r->hash & mask;
+	while (b->resolutions[slot])
+		slot = (slot + 1) & mask;
+	b->resolutions[slot] = r;
+}
+
+// resolving from a sealed scope always gives the same symbol, so the walk only happens once per scope and path
+static WlSymbol *wlResolveCached(WlBinder *b, WlScope *scope, WlAtom *path, int pathLen, WlSymbolFlags flags)
+{
+	u32 hash = wlResolutionHash(scope, path, pathLen, flags);
+	u32 mask = b->resolutionCapacity - 1;
+	for (u32 slot = hash & mask; b->resolutionCapacity && b->resolutions[slot]; slot = (slot + 1) & mask) {
+		WlResolution *r = b->resolutions[slot];
+		if (r->hash == hash && r->scope == scope && r->flags == flags && r->pathLen == pathLen &&
+			memcmp(r->path, path, pathLen * sizeof(WlAtom)) == 0) {
+			return r->symbol;
+		}
+	}
+
+	WlSymbol *symbol = wlResolvePath(b, scope, path, pathLen, flags);
+	if (!symbol) return NULL;
+
+	// the path points into the syntax tree, which may change before the binder is done with it
+	// rounded up so that the arena stays aligned for the pointers allocated after it
+	WlResolution *r = arenaMalloc(sizeof(WlResolution) + (pathLen * sizeof(WlAtom) + 7) / 8 * 8, &b->arena);
+	*r = (WlResolution){
+		.scope = scope,
+		.path = (WlAtom *)(r + 1),
+		.pathLen = pathLen,
+		.flags = flags,
+		.hash = hash,
+		.symbol = symbol,
+	};
+	memcpy(r->path, path, pathLen * sizeof(WlAtom));
+
+	// keep the table at most half full, a grown table leaves the old one behind in the arena
+	b->resolutionCount++;
+	if (b->resolutionCount * 2 > b->resolutionCapacity) {
+		u32 oldCapacity = b->resolutionCapacity;
+		WlResolution **old = b->resolutions;
+		b->resolutionCapacity = oldCapacity ? oldCapacity * 2 : 64;
+		b->resolutions = arenaMalloc(b->resolutionCapacity * sizeof(WlResolution *), &b->arena);
+		memset(b->resolutions, 0, b->resolutionCapacity * sizeof(WlResolution *));
+		for (u32 i = 0; i < oldCapacity; i++) {
+			if (old[i]) wlResolutionIndex(b, old[i]);
+		}
+	}
+	wlResolutionIndex(b, r);
+
+	return symbol;
+}
+
+// a hash of everything a body can rely on when it calls a function: its kind, return type and parameter types
+u64 wlSignatureHash(WlSymbol *s)
+{
+	u64 hash = 14695981039346656037ull;
+	hash = (hash ^ s->flags) * 1099511628211ull;
+	hash = (hash ^ s->type) * 1099511628211ull;
+	if ((s->flags & WlSFlag_TypeBits) == WlSFlag_Function && s->function) {
+		WlBoundFunction *fn = s->function;
+		hash = (hash ^ fn->paramCount) * 1099511628211ull;
+		for (int i = 0; i < fn->paramCount; i++) {
+			hash = (hash ^ fn->scope->symbols[i]->type) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+// the same path resolves to the same symbol for the whole function, so it is only recorded once
+static void wlAddDependency(WlBinder *b, WlAtom *path, int pathLen, WlSymbolFlags flags, WlSymbol *symbol)
+{
+	for (int i = 0; i < listLen(b->dependencies); i++) {
+		WlBodyDependency *d = &b->dependencies[i];
+		if (d->symbol == symbol && d->flags == flags && d->pathLen == pathLen &&
+			memcmp(d->path, path, pathLen * sizeof(WlAtom)) == 0) {
+			return;
 		}
 	}
+	WlBodyDependency d = {.path = path, .pathLen = pathLen, .flags = flags, .symbol = symbol};
+	listPush(&b->dependencies, d);
+}
+
+WlSymbol *wlFindSymbolInNamespace(WlBinder *b, WlAtom *path, int pathLen, WlSymbolFlags flags)
+{
+	assert(pathLen > 0);
+
+	// scopes that are still being bound can gain symbols that shadow the ones above them
+	// so the first segment is looked up in those as usual, and only what resolves from a sealed scope is cached
+	WlScope *scope = listPeek(&b->scopes);
+	WlSymbolFlags firstFlags = pathLen == 1 ? flags : WlSFlag_Namespace;
+	while (!scope->sealed && scope->parentScope && !wlFindSymbolInScope(b, scope, path[0], firstFlags, false)) {
+		scope = scope->parentScope;
+	}
+
+	WlSymbol *s = scope->sealed ? wlResolveCached(b, scope, path, pathLen, flags)
+								: wlResolvePath(b, scope, path, pathLen, flags);
 
 	if (s == NULL) {
-		Str name = path[listLen(path) - 1].valueStr;
+		Str name = wlAtomText(path[pathLen - 1]);
 		PANIC("Failed to find symbol %.*s", STRPRINT(name));
 		return NULL;
 	}
@@ -366,10 +768,13 @@ WlSymbol *wlFindSymbolInNamespace(WlBinder *b, List(WlToken) path, WlSymbolFlags
 		PANIC("expected symbol type %d but got %d", (flags & WlSFlag_TypeBits), (s->flags & WlSFlag_TypeBits));
 	}
 
+	// what resolves from a sealed scope is declared outside of the function
+	if (scope->sealed && b->dependent) wlAddDependency(b, path, pathLen, flags, s);
+
 	return s;
 }
 
-WlSymbol *wlFindSymbol(WlBinder *b, Str name, WlSymbolFlags flags, bool recurse)
+WlSymbol *wlFindSymbol(WlBinder *b, WlAtom name, WlSymbolFlags flags, bool recurse)
 {
 	WlScope *s = listPeek(&b->scopes);
 
@@ -381,9 +786,9 @@ isLiteral(WlBKind kind)
 	return kind == WlBKind_NumberLiteral || kind == WlBKind_BoolLiteral || kind == WlBKind_StringLiteral;
 }
 
-WlBOperator wlBindOperator(WlToken op)
+WlBOperator wlBindOperator(WlKind op)
 {
-	switch (op.kind) {
+	switch (op) {
 	case WlKind_OpPlus: return WlBOperator_Add;
 	case WlKind_OpMinus: return WlBOperator_Subtract;
 	case WlKind_OpStar: return WlBOperator_Multiply;
@@ -405,7 +810,7 @@ WlBOperator wlBindOperator(WlToken op)
 	case WlKind_OpBang: return WlBOperator_Negate;
 	case WlKind_OpPlusPlus: return WlBOperator_Increment;
 	case WlKind_OpMinusMinus: return WlBOperator_Decrement;
-	default: PANIC("Unhandled operator kind %s", WlKindText[op.kind]);
+	default: PANIC("Unhandled operator kind %s", WlKindText[op]);
 	}
 }
 
@@ -452,111 +857,279 @@ bool isSubType(WlBType child, WlBType parent)
 	}
 }
 
-// NOTE: this isn't actually used as of right now since variables are never added to the "typelinked" list
-//
-void propagateVariableType(WlSymbol *s, WlBType type)
+WlBType makeContreteType(WlBType t)
+{
+	switch (t) {
+	case WlBType_integerNumber: return WlBType_i64;
+	case WlBType_floatingNumber: return WlBType_f64;
+	default: return t;
+	}
+}
+
+// unknown type names and failed conversions were reported already, they are compatible with every type so that
+// what depends on them is not reported again
+bool wlIsReportedType(WlBType t) { return t == WlBType_unknown || t == WlBType_error; }
+
+// the most specific type that satisfies both a and b, or WlBType_error when there is none
+WlBType wlTypeJoin(WlBType a, WlBType b)
 {
-	assert(s != NULL);
+	if (wlIsReportedType(a) || wlIsReportedType(b)) return WlBType_unknown;
+	if (a == b || b == WlBType_inferWeak) return a;
+	if (a == WlBType_inferWeak) return b;
+	if (isSubType(a, b)) return b;
+	if (isSubType(b, a)) return a;
+	return WlBType_error;
+}
 
-	// constants keep their most abstract possible type
-	// that way they can be used in any context
-	if (s->flags & WlSFlag_Constant) {
-		assert(s->type == type || isSubType(s->type, type));
-		return;
+// forgets the type variables of the previous function
+void wlTypeVarsReset(WlBinder *b)
+{
+	if (listIsEmpty(b->typeVars)) {
+		listPush(&b->typeVars, ((WlTypeVar){0}));
+	} else {
+		LISTHEAD(b->typeVars)->len = 1;
 	}
+}
 
-	s->type = type;
-	for (int i = 0; i < listLen(s->typeLinked); i++) {
-		WlSymbol *linked = s->typeLinked[i];
-		assert(linked != NULL);
-		if (linked->type == type) continue;
-		if (isSubType(linked->type, type)) {
-			propagateVariableType(linked, type);
-		} else {
-			PANIC("expected %.*s to be of type %d but it is of type %d", STRPRINT(linked->name), type, linked->type);
+u32 wlTypeVarCreate(WlBinder *b, WlBType type)
+{
+	if (listIsEmpty(b->typeVars)) wlTypeVarsReset(b);
+	u32 v = listLen(b->typeVars);
+	listPush(&b->typeVars, ((WlTypeVar){.parent = v, .rank = 0, .type = type}));
+	return v;
+}
+
+// the representative of the class of v, halving the path on the way
+u32 wlTypeFind(WlBinder *b, u32 v)
+{
+	WlTypeVar *vars = b->typeVars;
+	while (vars[v].parent != v) {
+		vars[v].parent = vars[vars[v].parent].parent;
+		v = vars[v].parent;
+	}
+	return v;
+}
+
+WlBType wlTypeOfVar(WlBinder *b, u32 v) { return b->typeVars[wlTypeFind(b, v)].type; }
+
+// the type of n as far as it is known right now
+WlBType wlNodeType(WlBinder *b, WlbNode n) { return n.typeVar ? wlTypeOfVar(b, n.typeVar) : n.type; }
+
+// narrows the class of v down to type, false when they are incompatible
+bool wlTypeConstrain(WlBinder *b, u32 v, WlBType type)
+{
+	WlTypeVar *root = &b->typeVars[wlTypeFind(b, v)];
+	WlBType joined = wlTypeJoin(root->type, type);
+	if (joined == WlBType_error) return false;
+	root->type = joined;
+	return true;
+}
+
+// merges the classes of x and y, false when their types are incompatible
+bool wlTypeUnify(WlBinder *b, u32 x, u32 y)
+{
+	x = wlTypeFind(b, x);
+	y = wlTypeFind(b, y);
+	if (x == y) return true;
+
+	WlTypeVar *vars = b->typeVars;
+	WlBType joined = wlTypeJoin(vars[x].type, vars[y].type);
+	if (joined == WlBType_error) return false;
+
+	if (vars[x].rank < vars[y].rank) {
+		u32 t = x;
+		x = y;
+		y = t;
+	}
+	vars[y].parent = x;
+	if (vars[x].rank == vars[y].rank) vars[x].rank++;
+	vars[x].type = joined;
+	return true;
+}
+
+// requires two nodes to end up with the same type
+bool wlTypeUnifyNodes(WlBinder *b, WlbNode *x, WlbNode *y)
+{
+	if (x->typeVar && y->typeVar) return wlTypeUnify(b, x->typeVar, y->typeVar);
+	if (x->typeVar) return wlTypeConstrain(b, x->typeVar, y->type);
+	if (y->typeVar) return wlTypeConstrain(b, y->typeVar, x->type);
+	return x->type == y->type || wlIsReportedType(x->type) || wlIsReportedType(y->type);
+}
+
+// every type change of a number literal goes through here, an integer literal becomes a float the moment its type does
+void wlSetNodeType(WlbNode *n, WlBType type)
+{
+	bool holdsInteger = n->type == WlBType_integerNumber || wlIsIntegerType(n->type);
+	if (n->kind == WlBKind_NumberLiteral && holdsInteger && wlIsFloatType(type)) {
+		n->dataFloat = (f64)n->dataNum;
+	}
+	n->type = type;
+}
+
+// checks that n can be of the expected type, inferring it when n is of an abstract type
+void softCast(WlBinder *b, WlbNode *n, WlBType expected)
+{
+	if (expected == WlBType_inferWeak) return;
+
+	if (n->typeVar) {
+		WlBType type = wlTypeOfVar(b, n->typeVar);
+		if (expected == WlBType_inferStrong) expected = makeContreteType(type);
+		if (expected == WlBType_inferWeak || wlTypeConstrain(b, n->typeVar, expected)) {
+			wlSetNodeType(n, wlTypeOfVar(b, n->typeVar));
+			return;
 		}
+	} else if (n->type == expected || expected == WlBType_inferStrong || wlIsReportedType(n->type) ||
+			   wlIsReportedType(expected)) {
+		return;
 	}
+
+	WlDiagnostic d = {.kind = CannotImplicitlyConvertDiagnostic,
+					  .span = n->span,
+					  .num1 = wlNodeType(b, *n),
+					  .num2 = expected};
+	listPush(&b->diagnostics, d);
+	n->type = WlBType_error;
+	n->typeVar = 0;
 }
 
-// changes the type of an expression after a more concrete type is found
-void propagateType(WlbNode *expr, WlBType type)
+void wlSolveSymbol(WlBinder *b, WlSymbol *s)
 {
-	if (expr->type == type) return;
-	assert(!wlIsConcreteType(expr->type));
-	assert(expr->type != type);
+	if (!s || !s->typeVar) return;
+	s->type = makeContreteType(wlTypeOfVar(b, s->typeVar));
+	s->typeVar = 0;
+}
 
-	expr->type = type;
+// gives every node and variable of a bound body its final type, abstract types that were never narrowed down get
+// their default type
+void wlSolveTypes(WlBinder *b, WlbNode *n)
+{
+	if (n->typeVar) {
+		wlSetNodeType(n, makeContreteType(wlTypeOfVar(b, n->typeVar)));
+		n->typeVar = 0;
+	}
 
-	switch (expr->kind) {
-	case WlBKind_BinaryExpression: {
-		WlBoundBinaryExpression *bin = expr->data;
-		propagateType(&bin->left, type);
-		propagateType(&bin->right, type);
+	switch (n->kind) {
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			wlSolveTypes(b, &blk->nodes[i]);
+		}
 	} break;
-	case WlBKind_TernaryExpression: {
-		WlBoundTernaryExpression *tr = expr->data;
-		propagateType(&tr->thenExpr, type);
-		propagateType(&tr->elseExpr, type);
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		wlSolveTypes(b, &st->condition);
+		wlSolveTypes(b, &st->thenBlock);
+		wlSolveTypes(b, &st->elseBlock);
 	} break;
-	case WlBKind_NumberLiteral: {
-		if (wlIsFloatType(type) && expr->type == WlBType_integerNumber) {
-			expr->dataFloat = (f64)expr->dataNum;
-		}
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		wlSolveTypes(b, &st->block);
+		wlSolveTypes(b, &st->condition);
 	} break;
-	case WlBKind_DoExpression: {
-		WlBoundBlock *blk = expr->data;
-		WlbNode last = listPeek(&blk->nodes);
-		propagateType(&last, type);
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		wlSolveTypes(b, &st->condition);
+		wlSolveTypes(b, &st->block);
+	} break;
+	case WlBKind_ForLoop: {
+		WlBoundFor *st = n->data;
+		wlSolveTypes(b, &st->preCondition);
+		wlSolveTypes(b, &st->condition);
+		wlSolveTypes(b, &st->postCondition);
+		wlSolveTypes(b, &st->block);
+	} break;
+	case WlBKind_VariableDeclaration: {
+		WlBoundVariable *st = n->data;
+		wlSolveSymbol(b, st->symbol);
+		wlSolveTypes(b, &st->initializer);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		wlSolveTypes(b, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			wlSolveTypes(b, &st->args[i]);
+		}
 	} break;
 	case WlBKind_Return: {
-		WlBoundReturn *ret = expr->data;
-		propagateType(&ret->expression, type);
+		WlBoundReturn *st = n->data;
+		wlSolveTypes(b, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		wlSolveTypes(b, &st->left);
+		wlSolveTypes(b, &st->right);
 	} break;
-	case WlBKind_Ref: {
-		WlSymbol *s = expr->data;
-		propagateVariableType(s, type);
+	case WlBKind_TernaryExpression: {
+		WlBoundTernaryExpression *st = n->data;
+		wlSolveTypes(b, &st->condition);
+		wlSolveTypes(b, &st->thenExpr);
+		wlSolveTypes(b, &st->elseExpr);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		wlSolveTypes(b, &st->expression);
+	} break;
+	case WlBKind_PostUnaryExpression: {
+		WlBoundPostUnaryExpression *st = n->data;
+		wlSolveTypes(b, &st->expression);
 	} break;
-	default: PANIC("Unhandled kind in propagateType %d", expr->kind);
+	default: break;
 	}
 }
 
-WlBType makeContreteType(WlBType t)
+// queues the body of a function for binding when only reachable functions are bound
+void wlBinderReach(WlBinder *b, WlBoundFunction *fn)
 {
-	switch (t) {
-	case WlBType_integerNumber: return WlBType_i64;
-	case WlBType_floatingNumber: return WlBType_f64;
-	default: return t;
-	}
+	if (!b->parser || fn->reached) return;
+	fn->reached = true;
+	if (fn->symbol->flags & WlSFlag_Import) return;
+	listPush(&b->pending, fn);
 }
 
-void softCast(WlBinder *b, WlbNode *n, WlBType expected)
+// the flags of the bare @entrypoint, @inline and @noinline notes of a function, other notes are ignored
+WlSymbolFlags wlNoteFlags(WlAst *ast, WlNodeRange notes)
 {
-	if (n->type == expected) return;
-	if (expected == WlBType_inferWeak) return;
+	static WlAtom entrypoint = 0, inlineNote = 0, noinline = 0;
+	if (!entrypoint) {
+		entrypoint = wlIntern(STR("entrypoint"));
+		inlineNote = wlIntern(STR("inline"));
+		noinline = wlIntern(STR("noinline"));
+	}
 
-	if (expected == WlBType_inferStrong) {
-		if (!wlIsConcreteType(n->type)) {
-			propagateType(n, makeContreteType(n->type));
-		}
-		return;
+	WlSymbolFlags flags = WlSFlag_None;
+	for (int i = 0; i < notes.len; i++) {
+		int pathLen;
+		WlAtom *path = wlAstPath(ast, wlAstCall(ast, wlAstChild(ast, notes, i)).path, &pathLen);
+		if (pathLen != 1) continue;
+		if (path[0] == entrypoint) flags |= WlSFlag_Entrypoint;
+		if (path[0] == inlineNote) flags |= WlSFlag_Inline;
+		if (path[0] == noinline) flags |= WlSFlag_NoInline;
 	}
+	return flags;
+}
 
-	if (isSubType(n->type, expected)) {
-		propagateType(n, expected);
-	} else {
-		WlDiagnostic d = {.kind = CannotImplicitlyConvertDiagnostic,
-						  .span = n->span,
-						  .num1 = n->type,
-						  .num2 = expected};
-		listPush(&b->diagnostics, d);
-		n->type = WlBType_error;
+// the n of an @unroll(n) note of a for loop, 0 without one
+int wlNoteUnroll(WlAst *ast, WlNodeRange notes)
+{
+	for (int i = 0; i < notes.len; i++) {
+		WlSyntaxCall note = wlAstCall(ast, wlAstChild(ast, notes, i));
+		int pathLen;
+		WlAtom *path = wlAstPath(ast, note.path, &pathLen);
+		if (pathLen != 1 || path[0] != wlUnrollAtom || note.args.len != 1) continue;
+		WlNode n = wlAstChild(ast, note.args, 0);
+		if (wlAstKind(ast, n) == WlKind_Number) return (int)min(wlAstData(ast, n).valueNum, INT32_MAX);
 	}
+	return 0;
 }
 
-WlbNode wlBindFunction(WlBinder *b, WlToken tk);
-WlbNode wlBindUse(WlBinder *b, List(WlToken) path);
-WlbNode wlBindExpressionOfType(WlBinder *b, WlToken expression, WlBType type);
-WlbNode wlBindBlock(WlBinder *b, WlSyntaxBlock body, bool createScope);
+WlbNode wlBindFunction(WlBinder *b, WlNode n);
+WlbNode wlBindUse(WlBinder *b, WlNode path);
+WlbNode wlBindExpressionOfType(WlBinder *b, WlNode expression, WlBType type);
+WlbNode wlBindBlock(WlBinder *b, WlNode body, bool createScope);
 
 WlBType resolveBinaryExpressionType(WlBType operandType, WlBOperator op)
 {
@@ -583,31 +1156,37 @@ WlBType resolveBinaryExpressionType(WlBType operandType, WlBOperator op)
 	}
 }
 
-WlbNode wlBindExpression(WlBinder *b, WlToken expression)
+WlbNode wlBindExpression(WlBinder *b, WlNode expression)
 {
-	switch (expression.kind) {
+	WlAst *ast = b->ast;
+	WlNodeData data = wlAstData(ast, expression);
+	WlSpan span = wlAstSpan(ast, expression);
+
+	switch (wlAstKind(ast, expression)) {
 	case WlKind_Number: {
 		return (WlbNode){
 			.kind = WlBKind_NumberLiteral,
-			.dataNum = expression.valueNum,
+			.dataNum = data.valueNum,
 			.type = WlBType_integerNumber,
-			.span = expression.span,
+			.typeVar = wlTypeVarCreate(b, WlBType_integerNumber),
+			.span = span,
 		};
 	} break;
 	case WlKind_FloatNumber: {
 		return (WlbNode){
 			.kind = WlBKind_NumberLiteral,
-			.dataFloat = expression.valueFloat,
+			.dataFloat = data.valueFloat,
 			.type = WlBType_floatingNumber,
-			.span = expression.span,
+			.typeVar = wlTypeVarCreate(b, WlBType_floatingNumber),
+			.span = span,
 		};
 	} break;
 	case WlKind_String: {
 		return (WlbNode){
 			.kind = WlBKind_StringLiteral,
-			.dataStr = expression.valueStr,
+			.dataStr = wlAstString(ast, expression),
 			.type = WlBType_str,
-			.span = expression.span,
+			.span = span,
 		};
 	} break;
 	case WlKind_KwTrue: {
@@ -615,7 +1194,7 @@ WlbNode wlBindExpression(WlBinder *b, WlToken expression)
 			.kind = WlBKind_BoolLiteral,
 			.dataNum = 1,
 			.type = WlBType_bool,
-			.span = expression.span,
+			.span = span,
 		};
 	} break;
 	case WlKind_KwFalse: {
@@ -623,39 +1202,35 @@ WlbNode wlBindExpression(WlBinder *b, WlToken expression)
 			.kind = WlBKind_BoolLiteral,
 			.dataNum = 0,
 			.type = WlBType_bool,
-			.span = expression.span,
+			.span = span,
 		};
 	} break;
 	case WlKind_StParenthesizedExpression: {
-		WlParenthesizedExpression pr = *(WlParenthesizedExpression *)expression.valuePtr;
-		WlbNode expr = wlBindExpression(b, pr.expr);
+		WlbNode expr = wlBindExpression(b, data.lhs);
 		return expr;
 	}
 	case WlKind_StBinaryExpression: {
-		WlBinaryExpression ex = *(WlBinaryExpression *)expression.valuePtr;
+		WlBinaryExpression ex = wlAstBinary(ast, expression);
 		WlBoundBinaryExpression bex;
 
 		bex.left = wlBindExpression(b, ex.left);
 		bex.operator= wlBindOperator(ex.operator);
-		if (wlIsConcreteType(bex.left.type)) {
-			bex.right = wlBindExpressionOfType(b, ex.right, bex.left.type);
+		WlBType leftType = wlNodeType(b, bex.left);
+		if (wlIsConcreteType(leftType)) {
+			bex.right = wlBindExpressionOfType(b, ex.right, leftType);
 		} else {
 			bex.right = wlBindExpression(b, ex.right);
 		}
 
-		if (bex.left.type != bex.right.type) {
-			if (isSubType(bex.left.type, bex.right.type)) {
-				softCast(b, &bex.left, bex.right.type);
-			} else if (isSubType(bex.right.type, bex.left.type)) {
-				softCast(b, &bex.right, bex.left.type);
-			} else {
-				PANIC("Binary expression operands must be of same type, got %d %d", bex.left.type, bex.right.type);
-			}
+		if (!wlTypeUnifyNodes(b, &bex.left, &bex.right)) {
+			PANIC("Binary expression operands must be of same type, got %d %d", wlNodeType(b, bex.left),
+				  wlNodeType(b, bex.right));
 		}
 
-		WlBType type = resolveBinaryExpressionType(bex.left.type, bex.operator);
-
-		// todo: get the proper return type based on the operator and operands
+		WlBType operandType = wlNodeType(b, bex.left);
+		WlBType type = resolveBinaryExpressionType(operandType, bex.operator);
+		// arithmetic is of the type of its operands, so it shares their type variable
+		u32 typeVar = type == operandType ? (bex.left.typeVar ? bex.left.typeVar : bex.right.typeVar) : 0;
 
 		WlBoundBinaryExpression *bexp = arenaMalloc(sizeof(WlBoundBinaryExpression), &b->arena);
 		*bexp = bex;
@@ -664,67 +1239,85 @@ WlbNode wlBindExpression(WlBinder *b, WlToken expression)
 			.kind = WlBKind_BinaryExpression,
 			.data = bexp,
 			.type = type,
-			.span = expression.span,
+			.typeVar = typeVar,
+			.span = span,
 		};
 	}
 	case WlKind_StTernaryExpression: {
-		WlTernaryExpression expr = *(WlTernaryExpression *)expression.valuePtr;
+		WlTernaryExpression expr = wlAstTernary(ast, expression);
 
 		WlBoundTernaryExpression *btr = arenaMalloc(sizeof(WlBoundTernaryExpression), &b->arena);
 		btr->condition = wlBindExpressionOfType(b, expr.condition, WlBType_bool);
 		btr->thenExpr = wlBindExpression(b, expr.thenExpr);
 		btr->elseExpr = wlBindExpression(b, expr.elseExpr);
 
-		// TODO: handle type coersion for ternary
-		assert(btr->thenExpr.type == btr->elseExpr.type);
+		if (!wlTypeUnifyNodes(b, &btr->thenExpr, &btr->elseExpr)) {
+			PANIC("Ternary branches must be of same type, got %d %d", wlNodeType(b, btr->thenExpr),
+				  wlNodeType(b, btr->elseExpr));
+		}
 
 		return (WlbNode){
 			.kind = WlBKind_TernaryExpression,
 			.data = btr,
-			.span = expression.span,
-			.type = btr->thenExpr.type,
+			.span = span,
+			.type = wlNodeType(b, btr->thenExpr),
+			.typeVar = btr->thenExpr.typeVar ? btr->thenExpr.typeVar : btr->elseExpr.typeVar,
 		};
 	} break;
 
 	case WlKind_StCall: {
-		static int foo = 0;
-
-		WlSyntaxCall call = *(WlSyntaxCall *)expression.valuePtr;
+		WlSyntaxCall call = wlAstCall(ast, expression);
 
 		WlBoundCallExpression bcall = {0};
-		WlSymbol *function = wlFindSymbolInNamespace(b, call.path, WlSFlag_Function);
+		int pathLen;
+		WlAtom *path = wlAstPath(ast, call.path, &pathLen);
+		WlSymbol *function = wlFindSymbolInNamespace(b, path, pathLen, WlSFlag_Function);
 		List(WlbNode) args = listNew();
-		int argLen = (listLen(call.args) + 1) / 2;
+		int argLen = call.args.len;
 
 		int paramCount;
 		assert((function->flags & WlSFlag_TypeBits) == WlSFlag_Function);
-		if (!function)
-			PANIC("Failed to find function by name %.*s", STRPRINT(call.path[listLen(call.path) - 1].valueStr));
+		if (!function) PANIC("Failed to find function by name %.*s", STRPRINT(wlAtomText(path[pathLen - 1])));
 
 		int expectedArgLen = function->function->paramCount;
 		if (argLen != expectedArgLen) PANIC("Expected %d arguments but got %d", expectedArgLen, argLen);
 
 		for (int i = 0; i < argLen; i++) {
-			WlbNode arg = wlBindExpressionOfType(b, call.args[i * 2], function->function->scope->symbols[i]->type);
+			WlbNode arg =
+				wlBindExpressionOfType(b, wlAstChild(ast, call.args, i), function->function->scope->symbols[i]->type);
 			listPush(&args, arg);
 		}
 		bcall.args = args;
 		bcall.function = function;
+		wlBinderReach(b, function->function);
 
 		WlBoundCallExpression *bcallp = arenaMalloc(sizeof(WlBoundCallExpression), &b->arena);
 		*bcallp = bcall;
-		foo++;
-		return (WlbNode){.kind = WlBKind_Call, .data = bcallp, .type = WlBType_u0, .span = expression.span};
+		// a call is of the return type of the function, so the value of a call can be used
+		return (WlbNode){.kind = WlBKind_Call, .data = bcallp, .type = function->type, .span = span};
 	}
 
 	case WlKind_StRef: {
-		List(WlToken) path = expression.valuePtr;
-		WlSymbol *variable = wlFindSymbolInNamespace(b, path, WlSFlag_Variable);
+		int pathLen;
+		WlAtom *path = wlAstPath(ast, expression, &pathLen);
+		WlSymbol *variable = wlFindSymbolInNamespace(b, path, pathLen, WlSFlag_Variable);
+
+		// constants keep their literal type, so every use can be of a different type
+		u32 typeVar = variable->typeVar;
+		if ((variable->flags & WlSFlag_Constant) && !wlIsConcreteType(variable->type)) {
+			typeVar = wlTypeVarCreate(b, variable->type);
+		}
 
-		return (WlbNode){.kind = WlBKind_Ref, .data = variable, .type = variable->type, .span = expression.span};
+		return (WlbNode){
+			.kind = WlBKind_Ref,
+			.data = variable,
+			.type = typeVar ? wlTypeOfVar(b, typeVar) : variable->type,
+			.typeVar = typeVar,
+			.span = span,
+		};
 	}
 	case WlKind_StPreUnary: {
-		WlPreUnaryExpression un = *(WlPreUnaryExpression *)expression.valuePtr;
+		WlUnaryExpression un = wlAstUnary(ast, expression);
 		WlBOperator operator= wlBindOperator(un.operator);
 		WlbNode expr = wlBindExpression(b, un.expression);
 
@@ -743,10 +1336,11 @@ WlbNode wlBindExpression(WlBinder *b, WlToken expression)
 			PANIC("Illegal type %d for operator %d", expr.type, operator);
 		}
 
-		return (WlbNode){.kind = WlBKind_PreUnaryExpression, .data = unp, .type = expr.type, .span = expression.span};
+		return (WlbNode){
+			.kind = WlBKind_PreUnaryExpression, .data = unp, .type = expr.type, .typeVar = expr.typeVar, .span = span};
 	}
 	case WlKind_StPostUnary: {
-		WlPostUnaryExpression un = *(WlPostUnaryExpression *)expression.valuePtr;
+		WlUnaryExpression un = wlAstUnary(ast, expression);
 		WlbNode expr = wlBindExpression(b, un.expression);
 		WlBOperator operator= wlBindOperator(un.operator);
 
@@ -763,26 +1357,36 @@ WlbNode wlBindExpression(WlBinder *b, WlToken expression)
 			PANIC("Illegal type %d for operator %d", expr.type, operator);
 		}
 
-		return (WlbNode){.kind = WlBKind_PostUnaryExpression, .data = unp, .type = expr.type, .span = expression.span};
+		return (WlbNode){
+			.kind = WlBKind_PostUnaryExpression, .data = unp, .type = expr.type, .typeVar = expr.typeVar, .span = span};
 	}
 
 	case WlKind_StDo: {
-		WlSyntaxDo exp = *(WlSyntaxDo *)expression.valuePtr;
+		// the value of the block is whatever its returns are unified to
+		WlBType outerReturnType = b->currentReturnType;
+		u32 outerReturnVar = b->currentReturnVar;
 		b->currentReturnType = WlBType_inferWeak;
-		WlbNode expr = wlBindBlock(b, exp.block, true);
+		b->currentReturnVar = wlTypeVarCreate(b, WlBType_inferWeak);
+
+		WlbNode expr = wlBindBlock(b, data.lhs, true);
 		assert(listLen(((WlBoundBlock *)expr.data)->nodes) > 0);
-		if (expr.type == WlBType_u0) PANIC("Do block must return a value");
+		expr.typeVar = b->currentReturnVar;
+		expr.type = wlTypeOfVar(b, expr.typeVar);
+		if (expr.type == WlBType_u0 || expr.type == WlBType_inferWeak) PANIC("Do block must return a value");
+
+		b->currentReturnType = outerReturnType;
+		b->currentReturnVar = outerReturnVar;
 
 		expr.kind = WlBKind_DoExpression;
-		expr.span = expression.span;
+		expr.span = span;
 		return expr;
 	}
 
-	default: PANIC("Unhandled expression kind %s", WlKindText[expression.kind]);
+	default: PANIC("Unhandled expression kind %s", WlKindText[wlAstKind(ast, expression)]);
 	}
 }
 
-WlbNode wlBindExpressionOfType(WlBinder *b, WlToken expression, WlBType expectedType)
+WlbNode wlBindExpressionOfType(WlBinder *b, WlNode expression, WlBType expectedType)
 {
 	WlbNode n = wlBindExpression(b, expression);
 
@@ -791,18 +1395,24 @@ WlbNode wlBindExpressionOfType(WlBinder *b, WlToken expression, WlBType expected
 	return n;
 }
 
-WlbNode wlBindStatement(WlBinder *b, WlToken statement)
+WlbNode wlBindStatement(WlBinder *b, WlNode statement)
 {
-	switch (statement.kind) {
-	case WlKind_StReturnStatement: {
-		WlReturnStatement ret = *(WlReturnStatement *)statement.valuePtr;
+	WlAst *ast = b->ast;
+	WlNodeData data = wlAstData(ast, statement);
+	WlSpan span = wlAstSpan(ast, statement);
 
+	switch (wlAstKind(ast, statement)) {
+	case WlKind_StReturnStatement: {
 		WlBoundReturn bret;
 
-		if (ret.expression.kind != WlKind_Missing) {
-			WlBType t = b->currentReturnType;
-			bret.expression = wlBindExpressionOfType(b, ret.expression, t);
-			b->currentReturnType = bret.expression.type;
+		if (data.lhs != WLNODEMISSING && b->currentReturnVar) {
+			bret.expression = wlBindExpression(b, data.lhs);
+			bool unified = bret.expression.typeVar
+							   ? wlTypeUnify(b, b->currentReturnVar, bret.expression.typeVar)
+							   : wlTypeConstrain(b, b->currentReturnVar, bret.expression.type);
+			if (!unified) PANIC("The returns of a do block must be of the same type");
+		} else if (data.lhs != WLNODEMISSING) {
+			bret.expression = wlBindExpressionOfType(b, data.lhs, b->currentReturnType);
 		} else {
 			if (b->currentReturnType != WlBType_u0) {
 				PANIC("Expected return to have expression because return type is not u0");
@@ -813,107 +1423,132 @@ WlbNode wlBindStatement(WlBinder *b, WlToken statement)
 
 		WlBoundReturn *bretp = arenaMalloc(sizeof(WlBoundReturn), &b->arena);
 		*bretp = bret;
-		return (WlbNode){.kind = WlBKind_Return, .data = bretp, .type = bret.expression.type, .span = statement.span};
+		return (WlbNode){.kind = WlBKind_Return,
+						 .data = bretp,
+						 .type = bret.expression.type,
+						 .typeVar = bret.expression.typeVar,
+						 .span = span};
 	} break;
 	case WlKind_StExpressionStatement: {
-		WlExpressionStatement ex = *(WlExpressionStatement *)statement.valuePtr;
-		WlbNode n = wlBindExpressionOfType(b, ex.expression, WlBType_u0);
+		// the value is dropped, so it can be of any type
+		WlbNode n = wlBindExpressionOfType(b, data.lhs, WlBType_inferWeak);
 		return n;
 	} break;
 	case WlKind_StVariableDeclaration: {
-		WlSyntaxVariableDeclaration var = *(WlSyntaxVariableDeclaration *)statement.valuePtr;
+		WlSyntaxVariableDeclaration var = wlAstVariableDeclaration(ast, statement);
 		WlBoundVariable *bvar = arenaMalloc(sizeof(WlBoundVariable), &b->arena);
 
-		WlBType type = var.type.kind == WlKind_KwVar || var.type.kind == WlKind_KwLet //
+		WlKind typeKind = wlAstKind(ast, var.type);
+		WlBType type = typeKind == WlKind_KwVar || typeKind == WlKind_KwLet //
 						   ? WlBType_inferWeak
-						   : wlBindType(var.type);
+						   : wlBindType(b, var.type);
 
-		bool isImmutable = var.type.kind == WlKind_KwLet;
-		Str name = var.name.valueStr;
-		WlSpan span = var.name.span;
+		bool isImmutable = typeKind == WlKind_KwLet;
+		WlAtom name = wlAstAtom(ast, var.name);
+		WlSpan nameSpan = wlAstSpan(ast, var.name);
 
-		bvar->symbol = wlPushVariable(b, span, name, type, isImmutable);
+		bvar->symbol = wlPushVariable(b, nameSpan, name, type, isImmutable);
 
-		if (var.initializer.kind == WlKind_Missing) {
+		if (var.initializer == WLNODEMISSING) {
 			bvar->initializer = (WlbNode){.kind = WlBKind_None};
 			if (isImmutable) PANIC("immutable must have initializer");
+			if (type == WlBType_inferWeak) bvar->symbol->typeVar = wlTypeVarCreate(b, WlBType_inferWeak);
 		} else {
 			b->currentVariable = bvar->symbol;
 			bvar->initializer = wlBindExpressionOfType(b, var.initializer, type);
 			b->currentVariable = NULL;
 
-			type = bvar->initializer.type;
-			bvar->symbol->type = bvar->initializer.type;
-
 			if (isImmutable && isLiteral(bvar->initializer.kind)) {
+				// constants are inlined and keep the type of their literal, see WlKind_StRef
+				bvar->symbol->type = wlNodeType(b, bvar->initializer);
 				bvar->symbol->flags |= WlSFlag_Constant;
 				bvar->symbol->initializer = &bvar->initializer;
+			} else if (type == WlBType_inferWeak) {
+				// the variable is of whatever type its initializer turns out to be
+				bvar->symbol->typeVar = bvar->initializer.typeVar
+											? bvar->initializer.typeVar
+											: wlTypeVarCreate(b, bvar->initializer.type);
+				bvar->symbol->type = wlTypeOfVar(b, bvar->symbol->typeVar);
 			}
+			type = bvar->symbol->type;
 		}
 
-		return (WlbNode){.kind = WlBKind_VariableDeclaration, .data = bvar, .type = type, .span = statement.span};
+		return (WlbNode){.kind = WlBKind_VariableDeclaration, .data = bvar, .type = type, .span = span};
 	} break;
 	case WlKind_StVariableAssignement: {
-		WlAssignmentExpression var = *(WlAssignmentExpression *)statement.valuePtr;
 		WlBoundAssignment *bvar = arenaMalloc(sizeof(WlBoundAssignment), &b->arena);
 
-		WlSymbol *variable = wlFindSymbol(b, var.variable.valueStr, WlSFlag_Variable, true);
+		WlSymbol *variable = wlFindSymbol(b, wlAstAtom(ast, data.lhs), WlSFlag_Variable, true);
 		if (variable->flags & WlSFlag_Immutable) {
 			PANIC("Cannot assign to immutable %.*s", STRPRINT(variable->name));
 		}
 
 		bvar->symbol = variable;
-		bvar->expression = wlBindExpressionOfType(b, var.expression, variable->type);
+		if (variable->typeVar) {
+			bvar->expression = wlBindExpression(b, data.rhs);
+			WlbNode target = {.type = variable->type, .typeVar = variable->typeVar};
+			if (!wlTypeUnifyNodes(b, &target, &bvar->expression)) {
+				WlDiagnostic d = {.kind = CannotImplicitlyConvertDiagnostic,
+								  .span = bvar->expression.span,
+								  .num1 = wlNodeType(b, bvar->expression),
+								  .num2 = wlTypeOfVar(b, variable->typeVar)};
+				listPush(&b->diagnostics, d);
+			}
+		} else {
+			bvar->expression = wlBindExpressionOfType(b, data.rhs, variable->type);
+		}
 
-		return (
-			WlbNode){.kind = WlBKind_VariableAssignment, .data = bvar, .type = variable->type, .span = statement.span};
+		return (WlbNode){.kind = WlBKind_VariableAssignment,
+						 .data = bvar,
+						 .type = variable->type,
+						 .typeVar = variable->typeVar,
+						 .span = span};
 	} break;
 	case WlKind_StIf: {
-		WlSyntaxIf st = *(WlSyntaxIf *)statement.valuePtr;
+		WlSyntaxIf st = wlAstIf(ast, statement);
 		WlBoundIf *bi = arenaMalloc(sizeof(WlBoundIf), &b->arena);
 		bi->condition = wlBindExpressionOfType(b, st.condition, WlBType_bool);
 		bi->thenBlock = wlBindBlock(b, st.thenBlock, true);
-		bi->elseBlock = st.elseKeyword.kind == WlKind_Missing //
+		bi->elseBlock = st.elseBlock == WLNODEMISSING //
 							? (WlbNode){.kind = WlBKind_None}
 							: wlBindBlock(b, st.elseBlock, true);
-		return (WlbNode){.kind = WlBKind_If, .data = bi, .type = WlBType_u0, .span = statement.span};
+		return (WlbNode){.kind = WlBKind_If, .data = bi, .type = WlBType_u0, .span = span};
 	} break;
 	case WlKind_StFor: {
-		WlSyntaxFor st = *(WlSyntaxFor *)statement.valuePtr;
+		WlSyntaxFor st = wlAstFor(ast, statement);
 		WlBoundFor *bf = arenaMalloc(sizeof(WlBoundFor), &b->arena);
 
 		bf->scope = WlCreateAndPushScope(b);
 		bf->preCondition = wlBindStatement(b, st.preCondition);
-		assert(st.condition.kind == WlKind_StExpressionStatement);
-		bf->condition =
-			wlBindExpressionOfType(b, ((WlExpressionStatement *)st.condition.valuePtr)->expression, WlBType_bool);
+		assert(wlAstKind(ast, st.condition) == WlKind_StExpressionStatement);
+		bf->condition = wlBindExpressionOfType(b, wlAstData(ast, st.condition).lhs, WlBType_bool);
 		bf->postCondition = wlBindStatement(b, st.postCondition);
 		bf->block = wlBindBlock(b, st.block, true);
+		bf->unroll = wlNoteUnroll(ast, st.notes);
 		WlPopScope(b);
 
-		return (WlbNode){.kind = WlBKind_ForLoop, .data = bf, .type = WlBType_u0, .span = statement.span};
+		return (WlbNode){.kind = WlBKind_ForLoop, .data = bf, .type = WlBType_u0, .span = span};
 	} break;
 	case WlKind_StWhile: {
-		WlSyntaxWhile st = *(WlSyntaxWhile *)statement.valuePtr;
 		WlBoundWhile *bf = arenaMalloc(sizeof(WlBoundWhile), &b->arena);
-		bf->condition = wlBindExpressionOfType(b, st.condition, WlBType_bool);
-		bf->block = wlBindBlock(b, st.block, true);
-		return (WlbNode){.kind = WlBKind_WhileLoop, .data = bf, .type = WlBType_u0, .span = statement.span};
+		bf->condition = wlBindExpressionOfType(b, data.lhs, WlBType_bool);
+		bf->block = wlBindBlock(b, data.rhs, true);
+		bf->unroll = 0;
+		return (WlbNode){.kind = WlBKind_WhileLoop, .data = bf, .type = WlBType_u0, .span = span};
 	} break;
 	case WlKind_StDoWhile: {
-		WlSyntaxDoWhile st = *(WlSyntaxDoWhile *)statement.valuePtr;
 		WlBoundDoWhile *bf = arenaMalloc(sizeof(WlBoundDoWhile), &b->arena);
-		bf->condition = wlBindExpressionOfType(b, st.condition, WlBType_bool);
-		bf->block = wlBindBlock(b, st.block, true);
-		return (WlbNode){.kind = WlBKind_DoWhileLoop, .data = bf, .type = WlBType_u0, .span = statement.span};
+		bf->condition = wlBindExpressionOfType(b, data.rhs, WlBType_bool);
+		bf->block = wlBindBlock(b, data.lhs, true);
+		return (WlbNode){.kind = WlBKind_DoWhileLoop, .data = bf, .type = WlBType_u0, .span = span};
 	} break;
 	case WlKind_StFunction: return wlBindFunction(b, statement);
-	case WlKind_StUse: return wlBindUse(b, ((WlSyntaxUse *)statement.valuePtr)->path);
-	default: PANIC("Unhandled statement kind %s", WlKindText[statement.kind]);
+	case WlKind_StUse: return wlBindUse(b, data.lhs);
+	default: PANIC("Unhandled statement kind %s", WlKindText[wlAstKind(ast, statement)]);
 	}
 }
 
-WlScope *WlCreateAndPushNamespace(WlBinder *b, Str name)
+WlScope *WlCreateAndPushNamespace(WlBinder *b, WlAtom name)
 {
 	WlSymbol *ns = wlPushSymbol(b, name, WlBType_u0, WlSFlag_Namespace);
 
@@ -921,12 +1556,17 @@ WlScope *WlCreateAndPushNamespace(WlBinder *b, Str name)
 	// in this case we shouldn't create a new scope and instead
 	// just keep the existing one
 	if (ns->scope == NULL) {
+		WlScope *parent = listPeek(&b->scopes);
 		WlScope *scope = arenaMalloc(sizeof(WlScope), &b->arena);
 		*scope = (WlScope){
 			.usedScopes = listNew(),
 			.symbols = listNew(),
-			.parentScope = listPeek(&b->scopes),
+			.parentScope = parent,
 		};
+		if (parent->previous) {
+			WlSymbol *previous = wlScopeLookup(parent->previous, name);
+			if (previous && (previous->flags & WlSFlag_TypeBits) == WlSFlag_Namespace) scope->previous = previous->scope;
+		}
 		ns->scope = scope;
 	}
 
@@ -934,7 +1574,7 @@ WlScope *WlCreateAndPushNamespace(WlBinder *b, Str name)
 	return ns->scope;
 }
 
-WlbNode wlBindBlock(WlBinder *b, WlSyntaxBlock body, bool createScope)
+WlbNode wlBindBlock(WlBinder *b, WlNode body, bool createScope)
 {
 	WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &b->arena);
 	*blk = (WlBoundBlock){0};
@@ -946,31 +1586,35 @@ WlbNode wlBindBlock(WlBinder *b, WlSyntaxBlock body, bool createScope)
 
 	blk->nodes = listNew();
 
-	int len = listLen(body.statements);
-	for (int i = 0; i < len; i++) {
-		WlbNode st = wlBindStatement(b, body.statements[i]);
-		bool isLast = i == len - 1;
+	WlNodeRange statements = wlAstData(b->ast, body).range;
+	for (int i = 0; i < statements.len; i++) {
+		WlbNode st = wlBindStatement(b, wlAstChild(b->ast, statements, i));
 		listPush(&blk->nodes, st);
 	}
 
 	if (createScope) WlPopScope(b);
 
-	return (WlbNode){.kind = WlBKind_Block,
-					 .type = b->currentReturnType,
-					 .data = blk,
-					 .span = spanFromTokens(body.curlyOpen, body.curlyClose)};
+	return (WlbNode){.kind = WlBKind_Block, .type = b->currentReturnType, .data = blk, .span = wlAstSpan(b->ast, body)};
 }
 
-WlBinder wlBinderCreate()
+WlBinder wlBinderCreate(WlAst *ast)
 {
 	WlBinder b = {
+		.ast = ast,
+		.source = ast ? ast->source : STREMPTY,
 		.functions = listNew(),
 		.uses = listNew(),
 		.scopes = listNew(),
 		.diagnostics = listNew(),
+		.typeVars = listNew(),
 		.arena = arenaCreate(),
 	};
 
+	wlBindTypeAtoms();
+	for (int i = 0; i < WlBType_end; i++) {
+		wlTypeRegister(&b.types, wlBTypeAtoms[i], i, &b.arena);
+	}
+
 	//	 push the global scope
 	WlCreateAndPushScope(&b);
 	return b;
@@ -981,43 +1625,67 @@ void wlBinderFree(WlBinder *b)
 	arenaFree(&b->arena);
 	listFree(&b->functions);
 	listFree(&b->scopes);
+	listFree(&b->typeVars);
+	listFree(&b->dependencies);
+	if (b->pending) listFree(&b->pending);
+}
+
+void wlBindDeclarations(WlBinder *b, WlNode *declarations, int declarationCount);
+
+// pushes the parameters of a function or import into the current scope and returns how many there are
+int wlBindParameters(WlBinder *b, WlNodeRange parameters)
+{
+	for (int i = 0; i < parameters.len; i++) {
+		WlNodeData param = wlAstData(b->ast, wlAstChild(b->ast, parameters, i));
+
+		WlBType paramType = wlBindType(b, param.lhs);
+		wlPushSymbol(b, wlAstAtom(b->ast, param.rhs), paramType, WlSFlag_Variable | WlSFlag_Immutable);
+	}
+	return parameters.len;
 }
 
-void wlBindDeclarations(WlBinder *b, List(WlToken) declarations);
+// every declaration is hashed on every rebind, so this takes eight bytes at a time
+u64 wlTextHash(Str text)
+{
+	u64 hash = 14695981039346656037ull;
+	size_t i = 0;
+	for (; i + 8 <= text.len; i += 8) {
+		u64 word;
+		memcpy(&word, text.buf + i, 8);
+		hash = (hash ^ word) * 1099511628211ull;
+	}
+	for (; i < text.len; i++) {
+		hash = (hash ^ (u8)text.buf[i]) * 1099511628211ull;
+	}
+	return hash;
+}
 
-WlbNode wlBindFunction(WlBinder *b, WlToken tk)
+WlbNode wlBindFunction(WlBinder *b, WlNode n)
 {
-	WlSyntaxFunction fn = *(WlSyntaxFunction *)(tk.valuePtr);
+	WlSyntaxFunction fn = wlAstFunction(b->ast, n);
 
-	WlBType returnType = wlBindType(fn.type);
+	WlBType returnType = wlBindType(b, fn.type);
 
 	WlSymbolFlags flags = WlSFlag_Function | WlSFlag_Immutable;
-	if (fn.export.kind == WlKind_KwExport) flags |= WlSFlag_Export;
-	WlSymbol *functionSymbol = wlPushSymbol(b, fn.name.valueStr, returnType, flags);
+	if (fn.export) flags |= WlSFlag_Export;
+	flags |= wlNoteFlags(b->ast, fn.notes);
+	WlSymbol *functionSymbol = wlPushSymbol(b, wlAstAtom(b->ast, fn.name), returnType, flags);
 
 	WlScope *s = WlCreateAndPushScope(b);
 
-	int paramCount = 0;
-
 	WlBoundFunction *bf = arenaMalloc(sizeof(WlBoundFunction), &b->arena);
-
+	WlNodeRange text = b->ast->spans[n];
+	*bf = (WlBoundFunction){
+		.symbol = functionSymbol,
+		.scope = s,
+		.body = {.kind = WlBKind_Unresolved, .dataNum = fn.body},
+		.syntaxHash = wlTextHash(strSlice(b->ast->source, text.start, text.len)),
+		.syntaxStart = text.start,
+		.previous = functionSymbol->function,
+	};
 	functionSymbol->function = bf;
-	bf->symbol = functionSymbol;
-
-	for (int i = 0; i < listLen(fn.parameterList); i += 2) {
-		paramCount++;
-		WlToken paramToken = fn.parameterList[i];
-		WlSyntaxParameter param = *(WlSyntaxParameter *)paramToken.valuePtr;
-
-		WlBType paramType = wlBindType(param.type);
-
-		wlPushSymbol(b, param.name.valueStr, paramType, WlSFlag_Variable | WlSFlag_Immutable);
-	}
-
-	bf->scope = s;
-	bf->paramCount = paramCount;
-	bf->body = (WlbNode){.kind = WlBKind_Unresolved, .data = &((WlSyntaxFunction *)tk.valuePtr)->body};
-	// bf->body = wlBindBlock(b, fn.body, false);
+	bf->paramCount = wlBindParameters(b, fn.parameters);
+	bf->signature = wlSignatureHash(functionSymbol);
 	listPush(&b->functions, bf);
 
 	WlPopScope(b);
@@ -1027,15 +1695,32 @@ WlbNode wlBindFunction(WlBinder *b, WlToken tk)
 void wlBindFunctionBody(WlBinder *b, WlBoundFunction *fn)
 {
 	assert(fn->body.kind == WlBKind_Unresolved);
+	WlNode body = (WlNode)fn->body.dataNum;
+	if (wlAstKind(b->ast, body) == WlKind_StLazyBlock) {
+		assert(b->parser != NULL);
+		int errorCount = listLen(b->parser->diagnostics);
+		wlParseLazyBlock(b->parser, body);
+		// the syntax errors are reported by the parser, the body is left empty like a released one
+		if (listLen(b->parser->diagnostics) != errorCount) {
+			fn->body = (WlbNode){.kind = WlBKind_None};
+			return;
+		}
+	}
+
 	listPush(&b->scopes, fn->scope);
+	wlTypeVarsReset(b);
 	b->currentReturnType = fn->symbol->type;
-	fn->body = wlBindBlock(b, *(WlSyntaxBlock *)(fn->body.data), false);
+	b->currentReturnVar = 0;
+	fn->body = wlBindBlock(b, body, false);
+	wlSolveTypes(b, &fn->body);
 	WlPopScope(b);
 }
 
-WlbNode wlBindUse(WlBinder *b, List(WlToken) path)
+WlbNode wlBindUse(WlBinder *b, WlNode path)
 {
-	WlSymbol *namespace = wlFindSymbolInNamespace(b, path, WlSFlag_Namespace);
+	int pathLen;
+	WlAtom *atoms = wlAstPath(b->ast, path, &pathLen);
+	WlSymbol *namespace = wlFindSymbolInNamespace(b, atoms, pathLen, WlSFlag_Namespace);
 
 	WlScope *current = listPeek(&b->scopes);
 	assert(namespace != NULL);
@@ -1054,88 +1739,665 @@ WlbNode wlBindUse(WlBinder *b, List(WlToken) path)
 // - first bind namespaces, imports, function signatures
 //    - keep track of the encountered "use" statements and the scope they were declared in
 // - bind the use statements
+// - seal the global and namespace scopes, which precomputes the names they can see through their uses
 // - bind the function bodies
-WlBinder wlBind(List(WlToken) declarations)
+void wlBindSignatures(WlBinder *b, List(WlNode) declarations)
+{
+	wlBindDeclarations(b, declarations, listLen(declarations));
+
+	for (int i = 0; i < listLen(b->uses); i++) {
+		listPush(&b->scopes, b->uses[i]->scope);
+		wlBindUse(b, b->uses[i]->path);
+		listPop(&b->scopes);
+	}
+
+	wlSealScope(b, b->scopes[0]);
+}
+
+typedef struct {
+	// every worker binds with a binder of its own, which has its own scope stack, arena, diagnostics and path cache
+	// local functions declared by the bodies end up in its functions
+	WlBinder binder;
+	WlBoundFunction **bodies;
+	int first;
+	int stride;
+	int count;
+	// where the diagnostics and local functions of each body end in the binder of the worker, indexed like bodies
+	int *diagnosticEnds;
+	int *functionEnds;
+} WlBinderWork;
+
+// binds a body and then the bodies of the local functions it declared, which are appended to the functions of b
+// everything they resolve outside of the function becomes a dependency of fn
+static void wlBindBodyAndLocals(WlBinder *b, WlBoundFunction *fn)
+{
+	if (b->dependencies) LISTHEAD(b->dependencies)->len = 0;
+	b->dependent = fn;
+
+	int declared = listLen(b->functions);
+	wlBindFunctionBody(b, fn);
+	for (int i = declared; i < listLen(b->functions); i++) {
+		wlBindFunctionBody(b, b->functions[i]);
+	}
+
+	// the paths point into the syntax tree, which is gone by the time wlRebind looks at them
+	// they are copied right after the dependencies, the size is rounded up to keep the arena aligned
+	b->dependent = NULL;
+	fn->dependencyCount = listLen(b->dependencies);
+	int atomCount = 0;
+	for (int i = 0; i < fn->dependencyCount; i++) {
+		atomCount += b->dependencies[i].pathLen;
+	}
+	size_t size = fn->dependencyCount * sizeof(WlBodyDependency) + (atomCount * sizeof(WlAtom) + 7) / 8 * 8;
+	fn->dependencies = arenaMalloc(size, &b->arena);
+	WlAtom *path = (WlAtom *)(fn->dependencies + fn->dependencyCount);
+	for (int i = 0; i < fn->dependencyCount; i++) {
+		WlBodyDependency d = b->dependencies[i];
+		memcpy(path, d.path, d.pathLen * sizeof(WlAtom));
+		d.path = path;
+		path += d.pathLen;
+		d.signature = d.symbol->function->signature;
+		fn->dependencies[i] = d;
+	}
+}
+
+static void wlBinderWorker(void *arg)
 {
-	WlBinder b = wlBinderCreate();
-	wlBindDeclarations(&b, declarations);
+	WlBinderWork *work = arg;
+	for (int i = work->first; i < work->count; i += work->stride) {
+		work->bodies[i]->diagnosticStart = listLen(work->binder.diagnostics);
+		work->bodies[i]->localStart = listLen(work->binder.functions);
+		wlBindBodyAndLocals(&work->binder, work->bodies[i]);
+		work->diagnosticEnds[i] = listLen(work->binder.diagnostics);
+		work->functionEnds[i] = listLen(work->binder.functions);
+	}
+}
 
-	for (int i = 0; i < listLen(b.uses); i++) {
-		listPush(&b.scopes, b.uses[i]->scope);
-		wlBindUse(&b, b.uses[i]->path);
-		listPop(&b.scopes);
+// binds the given bodies on up to threadCount threads
+// a body only reads the signatures and writes its own scopes, so they can be bound in any order
+// the diagnostics and local functions are merged back in the order of the bodies, so they never depend on the threads
+// every body remembers where its diagnostics and local functions ended up
+static void wlBindBodyList(WlBinder *b, List(WlBoundFunction *) bodies, int threadCount)
+{
+	int bodyCount = listLen(bodies);
+
+	int workerCount = min(max(threadCount, 1), bodyCount / BINDERWORKERBODIES);
+	if (workerCount <= 1) {
+		for (int i = 0; i < bodyCount; i++) {
+			bodies[i]->diagnosticStart = listLen(b->diagnostics);
+			bodies[i]->localStart = listLen(b->functions);
+			wlBindBodyAndLocals(b, bodies[i]);
+			bodies[i]->diagnosticEnd = listLen(b->diagnostics);
+			bodies[i]->localEnd = listLen(b->functions);
+		}
+		return;
 	}
 
+	Thread *threads = malloc(workerCount * sizeof(Thread));
+	WlBinderWork *work = malloc(workerCount * sizeof(WlBinderWork));
+	int *ends = malloc(2 * bodyCount * sizeof(int));
+	if (!threads || !work || !ends) PANIC("Failed to allocate workers");
+	for (int i = 0; i < workerCount; i++) {
+		work[i] = (WlBinderWork){
+			.binder =
+				{
+					.ast = b->ast,
+					.functions = listNew(),
+					.scopes = listNew(),
+					.diagnostics = listNew(),
+					.typeVars = listNew(),
+					.types = b->types,
+					.arena = arenaCreate(),
+				},
+			.bodies = bodies,
+			.first = i,
+			.stride = workerCount,
+			.count = bodyCount,
+			.diagnosticEnds = ends,
+			.functionEnds = ends + bodyCount,
+		};
+		// the bodies push their own scope on top of the global one
+		listPush(&work[i].binder.scopes, b->scopes[0]);
+	}
+	// the calling thread takes the first share instead of waiting idle
+	for (int i = 1; i < workerCount; i++) {
+		threadStart(&threads[i], wlBinderWorker, &work[i]);
+	}
+	wlBinderWorker(&work[0]);
+	for (int i = 1; i < workerCount; i++) {
+		threadJoin(&threads[i]);
+	}
+
+	// body i was bound by worker i % workerCount, starting where its starts say in the lists of that worker
+	for (int i = 0; i < bodyCount; i++) {
+		WlBinderWork *w = &work[i % workerCount];
+		WlBoundFunction *fn = bodies[i];
+		int diagnosticStart = listLen(b->diagnostics);
+		int localStart = listLen(b->functions);
+		for (int j = fn->diagnosticStart; j < w->diagnosticEnds[i]; j++) {
+			listPush(&b->diagnostics, w->binder.diagnostics[j]);
+		}
+		for (int j = fn->localStart; j < w->functionEnds[i]; j++) {
+			listPush(&b->functions, w->binder.functions[j]);
+		}
+		fn->diagnosticStart = diagnosticStart;
+		fn->diagnosticEnd = listLen(b->diagnostics);
+		fn->localStart = localStart;
+		fn->localEnd = listLen(b->functions);
+	}
+
+	// the bound bodies live in the worker arenas
+	for (int i = 0; i < workerCount; i++) {
+		arenaAppend(&b->arena, &work[i].binder.arena);
+		listFree(&work[i].binder.functions);
+		listFree(&work[i].binder.scopes);
+		listFree(&work[i].binder.diagnostics);
+		listFree(&work[i].binder.typeVars);
+		listFree(&work[i].binder.dependencies);
+	}
+
+	free(ends);
+	free(work);
+	free(threads);
+}
+
+// binds the bodies of all functions on up to threadCount threads
+void wlBindBodies(WlBinder *b, int threadCount)
+{
+	List(WlBoundFunction *) bodies = listNew();
+	for (int i = 0; i < listLen(b->functions); i++) {
+		if (b->functions[i]->symbol->flags & WlSFlag_Import) continue;
+		listPush(&bodies, b->functions[i]);
+	}
+	wlBindBodyList(b, bodies, threadCount);
+	listFree(&bodies);
+}
+
+WlBinder wlBind(WlAst *ast, List(WlNode) declarations)
+{
+	WlBinder b = wlBinderCreate(ast);
+	wlBindSignatures(&b, declarations);
+	wlBindBodies(&b, threadProcessorCount());
+	return b;
+}
+
+// binds the signatures and queues the bodies of the exports and @entrypoint functions, without binding any body
+WlBinder wlBinderCreateReachable(WlParser *p)
+{
+	WlBinder b = wlBinderCreate(&p->ast);
+	b.parser = p;
+	b.pending = listNew();
+	wlBindSignatures(&b, p->topLevelDeclarations);
+
 	for (int i = 0; i < listLen(b.functions); i++) {
-		if (b.functions[i]->symbol->flags & WlSFlag_Import) {
-			continue;
+		if (b.functions[i]->symbol->flags & (WlSFlag_Export | WlSFlag_Entrypoint)) {
+			wlBinderReach(&b, b.functions[i]);
 		}
-		wlBindFunctionBody(&b, b.functions[i]);
 	}
 	return b;
 }
 
-void wlBindDeclarations(WlBinder *b, List(WlToken) declarations)
+// like wlBind, but only binds the bodies of functions that can be reached from an export or @entrypoint
+// together with WlParserLazyBodies, the bodies that are never reached are never parsed either
+// unreached functions keep their unresolved body and are left out by the emitter
+WlBinder wlBindReachable(WlParser *p)
 {
-	int declarationCount = listLen(declarations);
+	WlBinder b = wlBinderCreateReachable(p);
+
+	// binding a body may reach more functions, which are appended to the worklist
+	for (int i = 0; i < listLen(b.pending); i++) {
+		wlBindFunctionBody(&b, b.pending[i]);
+	}
+	return b;
+}
+
+// what a body bound by wlBindNextBody added to the syntax tree and the binder, wlReleaseBody drops it again
+typedef struct {
+	WlBoundFunction *function;
+	// the body node and the token range it had while it was lazy, it is turned back into a lazy body
+	WlNode syntax;
+	WlNodeData lazy;
+	bool wasLazy;
+	int nodeCount;
+	int extraCount;
+	// the local functions of the body are the functions from here on
+	int functionCount;
+	// the arena of the binder, the body is bound into an arena of its own until it is released
+	ArenaAllocator arena;
+} WlStreamedBody;
+
+// binds the next queued body of a binder of wlBinderCreateReachable, returns false once nothing is queued anymore
+// local functions can only be reached from the body that declares them, so the ones it reaches are bound with it
+// and taken off the queue again, only the top-level functions it reached stay queued
+bool wlBindNextBody(WlBinder *b, WlStreamedBody *body)
+{
+	if (b->pendingNext == listLen(b->pending)) return false;
+
+	WlBoundFunction *fn = b->pending[b->pendingNext++];
+	WlAst *ast = b->ast;
+	WlNode syntax = (WlNode)fn->body.dataNum;
+	*body = (WlStreamedBody){
+		.function = fn,
+		.syntax = syntax,
+		.lazy = ast->data[syntax],
+		.wasLazy = wlAstKind(ast, syntax) == WlKind_StLazyBlock,
+		.nodeCount = ast->count,
+		.extraCount = listLen(ast->extra),
+		.functionCount = listLen(b->functions),
+		.arena = b->arena,
+	};
+	b->arena = arenaCreate();
+
+	int queued = listLen(b->pending);
+	wlBindFunctionBody(b, fn);
+
+	int kept = queued;
+	for (int i = queued; i < listLen(b->pending); i++) {
+		WlBoundFunction *reached = b->pending[i];
+		if (reached->scope->parentScope->sealed) {
+			b->pending[kept++] = reached;
+		} else {
+			wlBindFunctionBody(b, reached);
+		}
+	}
+	LISTHEAD(b->pending)->len = kept;
+	return true;
+}
+
+static void wlReleaseScope(WlScope *s)
+{
+	listFree(&s->symbols);
+	listFree(&s->usedScopes);
+}
+
+// frees the lists of a bound tree, the nodes themselves are in the arena
+// the scope of the function is kept, it outlives the body
+static void wlReleaseNode(WlbNode *n, WlScope *keep)
+{
+	switch (n->kind) {
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			wlReleaseNode(&blk->nodes[i], keep);
+		}
+		listFree(&blk->nodes);
+		// the blocks of lowered increments have no scope
+		if (blk->scope && blk->scope != keep) wlReleaseScope(blk->scope);
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		wlReleaseNode(&st->condition, keep);
+		wlReleaseNode(&st->thenBlock, keep);
+		wlReleaseNode(&st->elseBlock, keep);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		wlReleaseNode(&st->block, keep);
+		wlReleaseNode(&st->condition, keep);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		wlReleaseNode(&st->condition, keep);
+		wlReleaseNode(&st->block, keep);
+	} break;
+	case WlBKind_ForLoop: {
+		WlBoundFor *st = n->data;
+		wlReleaseNode(&st->preCondition, keep);
+		wlReleaseNode(&st->condition, keep);
+		wlReleaseNode(&st->postCondition, keep);
+		wlReleaseNode(&st->block, keep);
+		wlReleaseScope(st->scope);
+	} break;
+	case WlBKind_VariableDeclaration: {
+		WlBoundVariable *st = n->data;
+		wlReleaseNode(&st->initializer, keep);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		wlReleaseNode(&st->expression, keep);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			wlReleaseNode(&st->args[i], keep);
+		}
+		listFree(&st->args);
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		wlReleaseNode(&st->expression, keep);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		wlReleaseNode(&st->left, keep);
+		wlReleaseNode(&st->right, keep);
+	} break;
+	case WlBKind_TernaryExpression: {
+		WlBoundTernaryExpression *st = n->data;
+		wlReleaseNode(&st->condition, keep);
+		wlReleaseNode(&st->thenExpr, keep);
+		wlReleaseNode(&st->elseExpr, keep);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		wlReleaseNode(&st->expression, keep);
+	} break;
+	case WlBKind_PostUnaryExpression: {
+		WlBoundPostUnaryExpression *st = n->data;
+		wlReleaseNode(&st->expression, keep);
+	} break;
+	default: break;
+	}
+}
+
+// drops the syntax, the bound tree, the locals and the local functions of a body bound by wlBindNextBody
+// the function is left with an empty body, only its signature is kept
+void wlReleaseBody(WlBinder *b, WlStreamedBody *body)
+{
+	WlBoundFunction *fn = body->function;
+	wlReleaseNode(&fn->body, fn->scope);
+	fn->body = (WlbNode){.kind = WlBKind_None};
+	for (int i = body->functionCount; i < listLen(b->functions); i++) {
+		WlBoundFunction *local = b->functions[i];
+		wlReleaseNode(&local->body, local->scope);
+		wlReleaseScope(local->scope);
+	}
+	LISTHEAD(b->functions)->len = body->functionCount;
+
+	// the parameters come first in the scope of the function, the table of a large scope is built again for them
+	WlScope *s = fn->scope;
+	if (s->symbols) LISTHEAD(s->symbols)->len = fn->paramCount;
+	if (s->usedScopes) LISTHEAD(s->usedScopes)->len = 0;
+	s->slots = NULL;
+	s->slotCapacity = 0;
+	if (fn->paramCount > WLSCOPELINEARSYMBOLS) {
+		s->slotCapacity = 4 * WLSCOPELINEARSYMBOLS;
+		while (s->slotCapacity < (u32)fn->paramCount * 2)
+			s->slotCapacity *= 2;
+		s->slots = arenaMalloc(s->slotCapacity * sizeof(WlSymbol *), &body->arena);
+		memset(s->slots, 0, s->slotCapacity * sizeof(WlSymbol *));
+		for (int i = 0; i < fn->paramCount; i++) {
+			wlScopeIndex(s, s->symbols[i]);
+		}
+	}
+
+	// the cached paths are in the arena of the body as well
+	arenaFree(&b->arena);
+	b->arena = body->arena;
+	b->resolutions = NULL;
+	b->resolutionCount = 0;
+	b->resolutionCapacity = 0;
+
+	WlAst *ast = b->ast;
+	ast->count = body->nodeCount;
+	if (ast->extra) LISTHEAD(ast->extra)->len = body->extraCount;
+	if (body->wasLazy) {
+		ast->kinds[body->syntax] = WlKind_StLazyBlock;
+		ast->data[body->syntax] = body->lazy;
+	}
+}
+
+static void wlRebaseSpan(WlSpan *span, i32 delta)
+{
+	if (!span->file) return;
+	span->start += delta;
+}
+
+// moves the spans of a kept body to where its declaration is now, string literals point into the source as well
+static void wlRebaseSpans(WlbNode *n, i32 delta, WlAst *ast)
+{
+	wlRebaseSpan(&n->span, delta);
+
+	switch (n->kind) {
+	case WlBKind_StringLiteral: {
+		if (n->span.file) n->dataStr = strSlice(ast->source, n->span.start + 1, n->span.len - 2);
+	} break;
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			wlRebaseSpans(&blk->nodes[i], delta, ast);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		wlRebaseSpans(&st->condition, delta, ast);
+		wlRebaseSpans(&st->thenBlock, delta, ast);
+		wlRebaseSpans(&st->elseBlock, delta, ast);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		wlRebaseSpans(&st->block, delta, ast);
+		wlRebaseSpans(&st->condition, delta, ast);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		wlRebaseSpans(&st->condition, delta, ast);
+		wlRebaseSpans(&st->block, delta, ast);
+	} break;
+	case WlBKind_ForLoop: {
+		WlBoundFor *st = n->data;
+		wlRebaseSpans(&st->preCondition, delta, ast);
+		wlRebaseSpans(&st->condition, delta, ast);
+		wlRebaseSpans(&st->postCondition, delta, ast);
+		wlRebaseSpans(&st->block, delta, ast);
+	} break;
+	case WlBKind_VariableDeclaration: {
+		WlBoundVariable *st = n->data;
+		wlRebaseSpans(&st->initializer, delta, ast);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		wlRebaseSpans(&st->expression, delta, ast);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			wlRebaseSpans(&st->args[i], delta, ast);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		wlRebaseSpans(&st->expression, delta, ast);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		wlRebaseSpans(&st->left, delta, ast);
+		wlRebaseSpans(&st->right, delta, ast);
+	} break;
+	case WlBKind_TernaryExpression: {
+		WlBoundTernaryExpression *st = n->data;
+		wlRebaseSpans(&st->condition, delta, ast);
+		wlRebaseSpans(&st->thenExpr, delta, ast);
+		wlRebaseSpans(&st->elseExpr, delta, ast);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		wlRebaseSpans(&st->expression, delta, ast);
+	} break;
+	case WlBKind_PostUnaryExpression: {
+		WlBoundPostUnaryExpression *st = n->data;
+		wlRebaseSpans(&st->expression, delta, ast);
+	} break;
+	default: break;
+	}
+}
+
+// a body can be kept when the text of its declaration is the same and everything it resolved outside of the function
+// still resolves to a symbol with the same signature
+// bodies that had calls inlined into them are bound again, the bodies they copied may have changed
+static bool wlCanKeepBody(WlBinder *b, WlBoundFunction *fn, List(WlBoundFunction *) oldFunctions)
+{
+	WlBoundFunction *previous = fn->previous;
+	if (!previous || previous->body.kind == WlBKind_Unresolved || previous->syntaxHash != fn->syntaxHash) return false;
+	if (previous->inlined) return false;
+	for (int i = previous->localStart; i < previous->localEnd; i++) {
+		if (oldFunctions[i]->inlined) return false;
+	}
+
+	WlScope *scope = fn->scope->parentScope;
+	for (int i = 0; i < previous->dependencyCount; i++) {
+		WlBodyDependency d = previous->dependencies[i];
+		// not through the cache, most of these paths are never resolved again
+		WlSymbol *s = wlResolvePath(b, scope, d.path, d.pathLen, d.flags);
+		if (s != d.symbol || s->function->signature != d.signature) return false;
+	}
+	return true;
+}
+
+// binds the declarations again after the syntax tree changed, usually after wlParserReparse
+// the bodies whose declaration text is the same and whose dependencies did not change are kept as they are,
+// together with their local functions and diagnostics. only the others are bound again
+// the result is the same as that of wlBind, except that kept bodies stay lowered and optimized when the passes already
+// ran on them
+// what is replaced stays in the arena until the binder is freed
+void wlRebind(WlBinder *b, List(WlNode) declarations)
+{
+	assert(!b->parser && "binders of wlBindReachable cannot be rebound");
+
+	List(WlBoundFunction *) oldFunctions = b->functions;
+	List(WlDiagnostic) oldDiagnostics = b->diagnostics;
+	WlScope *oldGlobal = b->scopes[0];
+
+	// the new global scope finds the functions declared before through previous
+	b->functions = listNew();
+	b->diagnostics = listNew();
+	listFree(&b->uses);
+	LISTHEAD(b->scopes)->len = 0;
+	b->resolutions = NULL;
+	b->resolutionCount = 0;
+	b->resolutionCapacity = 0;
+	WlCreateAndPushScope(b)->previous = oldGlobal;
+	wlBindSignatures(b, declarations);
+
+	int declared = listLen(b->functions);
+	int signatureDiagnostics = listLen(b->diagnostics);
+	List(WlBoundFunction *) stale = listNew();
+	for (int i = 0; i < declared; i++) {
+		WlBoundFunction *fn = b->functions[i];
+		if (fn->symbol->flags & WlSFlag_Import) continue;
+		if (wlCanKeepBody(b, fn, oldFunctions)) {
+			WlBoundFunction *previous = fn->previous;
+			previous->scope->parentScope = fn->scope->parentScope;
+			fn->scope = previous->scope;
+			fn->body = previous->body;
+			fn->lowered = previous->lowered;
+			fn->optimized = previous->optimized;
+			fn->dependencies = previous->dependencies;
+			fn->dependencyCount = previous->dependencyCount;
+			fn->diagnosticStart = previous->diagnosticStart;
+			fn->diagnosticEnd = previous->diagnosticEnd;
+			fn->localStart = previous->localStart;
+			fn->localEnd = previous->localEnd;
+		} else {
+			fn->previous = NULL;
+			listPush(&stale, fn);
+		}
+	}
+	wlBindBodyList(b, stale, threadProcessorCount());
+	listFree(&stale);
+
+	// put the diagnostics and local functions of kept and bound bodies back in the order of the bodies
+	List(WlBoundFunction *) functions = listNew();
+	List(WlDiagnostic) diagnostics = listNew();
+	for (int i = 0; i < declared; i++) {
+		listPush(&functions, b->functions[i]);
+	}
+	for (int i = 0; i < signatureDiagnostics; i++) {
+		listPush(&diagnostics, b->diagnostics[i]);
+	}
+	for (int i = 0; i < declared; i++) {
+		WlBoundFunction *fn = b->functions[i];
+		if (fn->symbol->flags & WlSFlag_Import) continue;
+
+		// kept bodies only have to be walked when their declaration moved or the text is in a new buffer
+		bool kept = fn->previous != NULL;
+		i32 delta = kept ? (i32)fn->syntaxStart - (i32)fn->previous->syntaxStart : 0;
+		bool moved = kept && (delta != 0 || b->source.buf != b->ast->source.buf);
+		if (moved) wlRebaseSpans(&fn->body, delta, b->ast);
+
+		int diagnosticStart = listLen(diagnostics);
+		for (int j = fn->diagnosticStart; j < fn->diagnosticEnd; j++) {
+			WlDiagnostic d = kept ? oldDiagnostics[j] : b->diagnostics[j];
+			if (moved) wlRebaseSpan(&d.span, delta);
+			listPush(&diagnostics, d);
+		}
+		int localStart = listLen(functions);
+		for (int j = fn->localStart; j < fn->localEnd; j++) {
+			WlBoundFunction *local = kept ? oldFunctions[j] : b->functions[j];
+			if (kept) local->symbol->index = -1;
+			if (moved) wlRebaseSpans(&local->body, delta, b->ast);
+			listPush(&functions, local);
+		}
+
+		fn->diagnosticStart = diagnosticStart;
+		fn->diagnosticEnd = listLen(diagnostics);
+		fn->localStart = localStart;
+		fn->localEnd = listLen(functions);
+		fn->previous = NULL;
+	}
+
+	listFree(&b->functions);
+	listFree(&b->diagnostics);
+	listFree(&oldFunctions);
+	listFree(&oldDiagnostics);
+	b->functions = functions;
+	b->diagnostics = diagnostics;
+	b->source = b->ast->source;
+}
+
+void wlBindDeclarations(WlBinder *b, WlNode *declarations, int declarationCount)
+{
+	WlAst *ast = b->ast;
 
 	for (int i = 0; i < declarationCount; i++) {
-		WlToken tk = declarations[i];
-		switch (tk.kind) {
+		WlNode n = declarations[i];
+		switch (wlAstKind(ast, n)) {
 		case WlKind_StNamespace: {
-			WlSyntaxNamespace ns = *(WlSyntaxNamespace *)(tk.valuePtr);
-			Str name = ns.path[listLen(ns.path) - 1].valueStr;
-			int depth = 0;
+			WlNodeData ns = wlAstData(ast, n);
+			int depth;
+			WlAtom *path = wlAstPath(ast, ns.lhs, &depth);
 
-			for (int i = 0; i < listLen(ns.path); i += 2) {
-				WlCreateAndPushNamespace(b, ns.path[i].valueStr);
-				depth++;
+			for (int i = 0; i < depth; i++) {
+				WlCreateAndPushNamespace(b, path[i]);
 			}
 
-			wlBindDeclarations(b, ns.body.statements);
+			WlNodeRange body = wlAstData(ast, ns.rhs).range;
+			wlBindDeclarations(b, ast->extra + body.start, body.len);
 
 			for (int i = 0; i < depth; i++) {
 				WlPopScope(b);
 			}
 		} break;
 		case WlKind_StImport: {
-			WlSyntaxImport im = *(WlSyntaxImport *)(tk.valuePtr);
+			WlSyntaxFunction im = wlAstFunction(ast, n);
 
 			WlBoundFunction *bf = arenaMalloc(sizeof(WlBoundFunction), &b->arena);
 
-			WlSymbol *functionSymbol =
-				wlPushSymbol(b, im.name.valueStr, WlBType_u0, WlSFlag_Function | WlSFlag_Immutable | WlSFlag_Import);
-			bf->symbol = functionSymbol;
+			WlSymbol *functionSymbol = wlPushSymbol(b, wlAstAtom(ast, im.name), WlBType_u0,
+													WlSFlag_Function | WlSFlag_Immutable | WlSFlag_Import);
 			WlScope *s = WlCreateAndPushScope(b);
+			*bf = (WlBoundFunction){.symbol = functionSymbol, .scope = s, .body = {.kind = WlBKind_None}};
 			functionSymbol->function = bf;
-			bf->scope = s;
-			int paramCount = 0;
-
-			for (int i = 0; i < listLen(im.parameterList); i += 2) {
-				paramCount++;
-				WlToken paramToken = im.parameterList[i];
-				WlSyntaxParameter param = *(WlSyntaxParameter *)paramToken.valuePtr;
-
-				WlBType paramType = wlBindType(param.type);
-				wlPushSymbol(b, param.name.valueStr, paramType, WlSFlag_Variable | WlSFlag_Immutable);
-			}
+			bf->paramCount = wlBindParameters(b, im.parameters);
+			bf->signature = wlSignatureHash(functionSymbol);
 
 			WlPopScope(b);
-			bf->paramCount = paramCount;
 
 			listPush(&b->functions, bf);
 		} break;
 		case WlKind_StFunction: {
-			wlBindFunction(b, tk);
+			wlBindFunction(b, n);
 		} break;
 		case WlKind_StUse: {
 			WlBoundUse *us = arenaMalloc(sizeof(WlBoundUse), &b->arena);
-			us->path = ((WlSyntaxUse *)tk.valuePtr)->path;
+			us->path = wlAstData(ast, n).lhs;
 			us->scope = listPeek(&b->scopes);
 			listPush(&b->uses, us);
 		} break;
 		case WlKind_Bad: break;
-		default: PANIC("Unhandled declaration kind %s", WlKindText[tk.kind]); break;
+		default: PANIC("Unhandled declaration kind %s", WlKindText[wlAstKind(ast, n)]); break;
 		}
 	}
 }
@@ -1,21 +1,51 @@
 #include <walc.h>
 
-WlSpan spanFromRange(Str filename, Str source, size_t start, size_t end)
+// the files spans point into, spans only keep the index of their file so they stay small
+// a file is known by its name, adding the same name again replaces its text, which is what reparsing an edit does
+// the name is interned, so it outlives the string it was given as
+typedef struct {
+	WlAtom name;
+	Str filename;
+	Str source;
+} WlSourceFile;
+
+static List(WlSourceFile) wlSourceFiles = NULL;
+
+u32 wlSourceFileAdd(Str filename, Str source)
 {
-	return (WlSpan){.filename = filename, .source = source, .start = start, .len = end - start};
+	if (!wlSourceFiles) listPush(&wlSourceFiles, (WlSourceFile){0});
+
+	WlAtom name = wlIntern(filename);
+	for (int i = 1; i < listLen(wlSourceFiles); i++) {
+		if (wlSourceFiles[i].name == name) {
+			wlSourceFiles[i].source = source;
+			return i;
+		}
+	}
+	listPush(&wlSourceFiles, ((WlSourceFile){.name = name, .filename = wlAtomText(name), .source = source}));
+	return listLen(wlSourceFiles) - 1;
+}
+
+WlSourceFile wlSourceFileGet(u32 file)
+{
+	if (!wlSourceFiles || file >= listLen(wlSourceFiles)) return (WlSourceFile){0};
+	return wlSourceFiles[file];
+}
+
+WlSpan spanFromRange(u32 file, size_t start, size_t end)
+{
+	return (WlSpan){.file = file, .start = start, .len = end - start};
 }
 
 WlSpan spanFromTokens(WlToken start, WlToken end)
 {
-	return (WlSpan){.filename = start.span.filename,
-					.source = start.span.source,
-					.start = start.span.start,
-					.len = end.span.start + end.span.len};
+	return (WlSpan){.file = start.span.file, .start = start.span.start, .len = end.span.start + end.span.len};
 }
 
 void diagnosticPrint(WlDiagnostic d)
 {
-	Str errSlice = strSlice(d.span.source, d.span.start, d.span.len);
+	WlSourceFile file = wlSourceFileGet(d.span.file);
+	Str errSlice = file.source.buf ? strSlice(file.source, d.span.start, d.span.len) : STREMPTY;
 
 	// TODO: fix span ranges, line printing etc.
 	// int lineStart = d.span.start;
@@ -29,7 +59,7 @@ void diagnosticPrint(WlDiagnostic d)
 
 	// Str lineSlice = strSlice(d.span.source, lineStart, lineEnd - lineStart);
 
-	printf("%s%.*s:%d:%d:%s %sfatal error:%s ", TERMBOLD, STRPRINT(d.span.filename), d.span.start, d.span.len,
+	printf("%s%.*s:%d:%d:%s %sfatal error:%s ", TERMBOLD, STRPRINT(file.filename), d.span.start, d.span.len,
 		   TERMCLEAR, TERMRED, TERMCLEAR);
 
 	switch (d.kind) {
@@ -39,6 +69,9 @@ void diagnosticPrint(WlDiagnostic d)
 	case UnterminatedStringDiagnostic: {
 		printf("Unexpected End of file, expected '\"'\n", STRPRINT(errSlice));
 	} break;
+	case IntegerLiteralOverflowDiagnostic: {
+		printf("Integer literal %s%.*s%s does not fit in 64 bits\n", TERMBOLDCYAN, STRPRINT(errSlice), TERMCLEAR);
+	} break;
 	case UnexpectedTokenDiagnostic: {
 		if (d.kind2) {
 			printf("Unexpected token %s%.*s%s, expected %s\n", TERMBOLDCYAN, STRPRINT(errSlice), TERMCLEAR,
@@ -65,6 +98,9 @@ void diagnosticPrint(WlDiagnostic d)
 		printf("Cannot implicitly convert from %s%s%s to %s%s%s\n", TERMBOLDCYAN, WlBTypeText[d.num1], TERMCLEAR,
 			   TERMBOLDCYAN, WlBTypeText[d.num2], TERMCLEAR);
 	} break;
+	case UnknownTypeDiagnostic: {
+		printf("Unknown type %s%.*s%s\n", TERMBOLDCYAN, STRPRINT(d.str1), TERMCLEAR);
+	} break;
 	default: PANIC("unhandled diagnostic kind %d\n", d.kind);
 	}
 
@@ -0,0 +1,310 @@
+#include <walc.h>
+
+// common subexpression elimination by value numbering, expressions that compute a value that was computed before are
+// replaced by a local that keeps it
+// every value gets a number from what computes it and the numbers of its operands, a variable is numbered by its
+// symbol and how often it was assigned, so an assignment makes the values that read the variable unavailable
+// the first expression that computed a value assigns it to the local with local.tee, the others read the local
+// a value is only reused where it was computed first on every path, values computed in a branch or loop are forgotten
+// once it ends and loops make the values that read what they assign unavailable before they start
+// runs last, after reduce, on bodies that are lowered
+
+typedef struct {
+	// what the value is computed by, its kind, type and operator, symbol, function or literal, and its operands
+	WlBKind kind;
+	WlBType type;
+	u64 what;
+	int operands[2];
+	// the expression that computed it first, NULL for values that aren't worth a local
+	WlbNode *first;
+	// the local the first expression assigns it to, once it is computed again
+	WlSymbol *local;
+} WlValue;
+
+typedef struct {
+	WlSymbol *symbol;
+	int assignments;
+} WlValueVersion;
+
+typedef struct {
+	WlBinder *b;
+	// the function the values are in, the new locals are added to its scope
+	WlBoundFunction *fn;
+	// the values available at the expression that is numbered, a number is an index
+	List(WlValue) values;
+	// how often the variables that were assigned are
+	List(WlValueVersion) versions;
+	// decides which calls are pure, only those are values
+	WlHoister purity;
+	List(WlSymbol *) assigned;
+} WlEliminator;
+
+static int eliminatorVersion(WlEliminator *e, WlSymbol *s)
+{
+	for (int i = 0; i < listLen(e->versions); i++) {
+		if (e->versions[i].symbol == s) return e->versions[i].assignments;
+	}
+	return 0;
+}
+
+static void eliminatorAssign(WlEliminator *e, WlSymbol *s)
+{
+	for (int i = 0; i < listLen(e->versions); i++) {
+		if (e->versions[i].symbol == s) {
+			e->versions[i].assignments++;
+			return;
+		}
+	}
+	listPush(&e->versions, ((WlValueVersion){.symbol = s, .assignments = 1}));
+}
+
+static int eliminatorLookup(WlEliminator *e, WlValue v)
+{
+	for (int i = 0; i < listLen(e->values); i++) {
+		WlValue *o = &e->values[i];
+		if (o->kind == v.kind && o->type == v.type && o->what == v.what && o->operands[0] == v.operands[0] &&
+			o->operands[1] == v.operands[1]) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static bool eliminatorIsCommutative(WlBOperator op, WlBType type)
+{
+	if (wlIsFloatType(type)) return false;
+	switch (op) {
+	case WlBOperator_Add:
+	case WlBOperator_Multiply:
+	case WlBOperator_Equal:
+	case WlBOperator_NotEqual:
+	case WlBOperator_BitwiseAnd:
+	case WlBOperator_Xor:
+	case WlBOperator_BitwiseOr:
+	case WlBOperator_And:
+	case WlBOperator_Or: return true;
+	default: return false;
+	}
+}
+
+static int eliminatorNumber(WlEliminator *e, WlbNode n, bool add);
+
+// the arguments of a call are numbered as a list of pairs, -2 is the empty list
+static int eliminatorArguments(WlEliminator *e, List(WlbNode) args, int i, bool add)
+{
+	if (i == listLen(args)) return -2;
+	int head = eliminatorNumber(e, args[i], add);
+	int tail = eliminatorArguments(e, args, i + 1, add);
+	if (head < 0 || tail == -1) return -1;
+
+	WlValue v = {.kind = WlBKind_None, .operands = {head, tail}};
+	int number = eliminatorLookup(e, v);
+	if (number < 0 && add) {
+		number = listLen(e->values);
+		listPush(&e->values, v);
+	}
+	return number;
+}
+
+// the number of the value n computes, -1 when it isn't a value or when add is false and the value is not available
+// with add set the values of n and its operands become available, n is their first expression
+static int eliminatorNumber(WlEliminator *e, WlbNode n, bool add)
+{
+	WlValue v = {.kind = n.kind, .type = n.type};
+	switch (n.kind) {
+	case WlBKind_NumberLiteral:
+	case WlBKind_BoolLiteral: v.what = n.dataNum; break;
+	case WlBKind_Ref: {
+		// the locals of values are numbered as the value
+		for (int i = 0; i < listLen(e->values); i++) {
+			if (e->values[i].local == n.data) return i;
+		}
+		v.what = (u64)n.data;
+		v.operands[0] = eliminatorVersion(e, n.data);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		v.what = st->operator;
+		v.operands[0] = eliminatorNumber(e, st->left, add);
+		v.operands[1] = eliminatorNumber(e, st->right, add);
+		if (v.operands[0] < 0 || v.operands[1] < 0) return -1;
+		// a + b and b + a are the same value
+		if (eliminatorIsCommutative(st->operator, st->left.type) && v.operands[0] > v.operands[1]) {
+			int left = v.operands[0];
+			v.operands[0] = v.operands[1];
+			v.operands[1] = left;
+		}
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		v.what = st->operator;
+		v.operands[0] = eliminatorNumber(e, st->expression, add);
+		if (v.operands[0] < 0) return -1;
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		if (!hoisterIsPureFunction(&e->purity, st->function->function)) return -1;
+		v.what = (u64)st->function->function;
+		v.operands[0] = eliminatorArguments(e, st->args, 0, add);
+		if (v.operands[0] == -1) return -1;
+	} break;
+	case WlBKind_AssignmentExpression: return eliminatorNumber(e, ((WlBoundAssignment *)n.data)->expression, add);
+	default: return -1;
+	}
+
+	int number = eliminatorLookup(e, v);
+	if (number < 0 && add) {
+		number = listLen(e->values);
+		listPush(&e->values, v);
+	}
+	return number;
+}
+
+// the expression in n becomes a read of the local of the value it computes when that was computed before
+// otherwise its operands are, and then it is the first expression of its value
+static void eliminateExpression(WlEliminator *e, WlbNode *n);
+
+static void eliminateOperands(WlEliminator *e, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		eliminateExpression(e, &st->left);
+		eliminateExpression(e, &st->right);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		eliminateExpression(e, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			eliminateExpression(e, &st->args[i]);
+		}
+	} break;
+	default: break;
+	}
+}
+
+static void eliminateNode(WlEliminator *e, WlbNode *n);
+
+static void eliminateExpression(WlEliminator *e, WlbNode *n)
+{
+	bool worth = hoisterIsWorthHoisting(*n);
+	int number = worth ? eliminatorNumber(e, *n, false) : -1;
+	if (number >= 0 && e->values[number].first) {
+		WlValue *v = &e->values[number];
+		if (!v->local) {
+			v->local = lowerAddLocal(e->b, e->fn,
+									 (WlSymbol){.name = STR("common"), .type = n->type, .flags = WlSFlag_Variable});
+
+			WlbNode first = *v->first;
+			WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &e->b->arena);
+			*asg = (WlBoundAssignment){.expression = first, .symbol = v->local};
+			*v->first =
+				(WlbNode){.kind = WlBKind_AssignmentExpression, .type = first.type, .data = asg, .span = first.span};
+		}
+		*n = (WlbNode){.kind = WlBKind_Ref, .type = n->type, .data = v->local, .span = n->span};
+		return;
+	}
+
+	if (n->kind != WlBKind_BinaryExpression && n->kind != WlBKind_PreUnaryExpression && n->kind != WlBKind_Call) {
+		eliminateNode(e, n);
+		return;
+	}
+	eliminateOperands(e, n);
+	number = eliminatorNumber(e, *n, true);
+	if (worth && number >= 0 && !e->values[number].first) e->values[number].first = n;
+}
+
+// the values computed in a branch or loop are forgotten after it
+static void eliminateBranch(WlEliminator *e, WlbNode *n)
+{
+	int available = listLen(e->values);
+	eliminateNode(e, n);
+	if (e->values) LISTHEAD(e->values)->len = available;
+}
+
+// the values that read what a loop assigns are not available in it, they might be from an earlier iteration
+static void eliminatorEnterLoop(WlEliminator *e, WlbNode loop)
+{
+	if (e->assigned) LISTHEAD(e->assigned)->len = 0;
+	hoisterCollectAssigned(loop, &e->assigned);
+	for (int i = 0; i < listLen(e->assigned); i++) {
+		eliminatorAssign(e, e->assigned[i]);
+	}
+}
+
+static void eliminateNode(WlEliminator *e, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			eliminateNode(e, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		eliminateExpression(e, &st->condition);
+		eliminateBranch(e, &st->thenBlock);
+		eliminateBranch(e, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		int available = listLen(e->values);
+		eliminatorEnterLoop(e, *n);
+		eliminateExpression(e, &st->condition);
+		eliminateNode(e, &st->block);
+		if (e->values) LISTHEAD(e->values)->len = available;
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		int available = listLen(e->values);
+		eliminatorEnterLoop(e, *n);
+		eliminateNode(e, &st->block);
+		eliminateExpression(e, &st->condition);
+		if (e->values) LISTHEAD(e->values)->len = available;
+	} break;
+	case WlBKind_VariableDeclaration: {
+		WlBoundVariable *st = n->data;
+		eliminateExpression(e, &st->initializer);
+		eliminatorAssign(e, st->symbol);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		eliminateExpression(e, &st->expression);
+		eliminatorAssign(e, st->symbol);
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		eliminateExpression(e, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression:
+	case WlBKind_PreUnaryExpression:
+	case WlBKind_Call: eliminateExpression(e, n); break;
+	default: break;
+	}
+}
+
+void eliminateFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (!fn->lowered || fn->optimized || fn->body.kind != WlBKind_Block) return;
+	fn->optimized = true;
+	WlEliminator e = {.b = b, .fn = fn, .purity = {.b = b, .fn = fn}};
+	eliminateNode(&e, &fn->body);
+	listFree(&e.values);
+	listFree(&e.versions);
+	listFree(&e.assigned);
+	listFree(&e.purity.pure);
+	listFree(&e.purity.impure);
+	listFree(&e.purity.deciding);
+}
+
+// runs after reduce, so the values the reducer computes more than once are shared too
+void eliminate(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		eliminateFunction(b, b->functions[i]);
+	}
+}
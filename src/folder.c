@@ -0,0 +1,311 @@
+#include <walc.h>
+
+// constant folding and propagation over a lowered body
+// operators with literal operands are evaluated the way wasm would at run time, so the literal is emitted instead
+// let bindings that fold to a literal become constants, which inlines them into their uses like the binder's constants
+// operations that would trap are left alone, so they still trap when they run
+
+typedef struct {
+	WlBinder *b;
+	// the immutables the body being folded assigns more than once, which are not propagated
+	List(WlSymbol *) reassigned;
+} WlFolder;
+
+static bool folderIsFoldableType(WlBType t)
+{
+	switch (t) {
+	case WlBType_bool:
+	case WlBType_i32:
+	case WlBType_u32:
+	case WlBType_i64:
+	case WlBType_u64:
+	case WlBType_f32:
+	case WlBType_f64: return true;
+	default: return false;
+	}
+}
+
+static bool folderIsLiteral(WlbNode n) { return n.kind == WlBKind_NumberLiteral && folderIsFoldableType(n.type); }
+
+// integer literals are kept sign extended for signed types and zero extended for unsigned ones
+static WlbNode folderIntegerLiteral(WlbNode n, WlBType type, u64 value)
+{
+	switch (type) {
+	case WlBType_bool:
+	case WlBType_i32: value = (u64)(i64)(i32)(u32)value; break;
+	case WlBType_u32: value = (u32)value; break;
+	default: break;
+	}
+	return (WlbNode){.kind = WlBKind_NumberLiteral, .type = type, .dataNum = (i64)value, .span = n.span};
+}
+
+static WlbNode folderFloatLiteral(WlbNode n, WlBType type, f64 value)
+{
+	if (type == WlBType_f32) value = (f32)value;
+	return (WlbNode){.kind = WlBKind_NumberLiteral, .type = type, .dataFloat = value, .span = n.span};
+}
+
+static bool foldCompare(WlBOperator op, int order)
+{
+	switch (op) {
+	case WlBOperator_Greater: return order > 0;
+	case WlBOperator_GreaterOrEqual: return order >= 0;
+	case WlBOperator_Less: return order < 0;
+	case WlBOperator_LessOrEqual: return order <= 0;
+	case WlBOperator_Equal: return order == 0;
+	case WlBOperator_NotEqual: return order != 0;
+	default: PANIC("Unhandled comparison %d", op);
+	}
+	return false;
+}
+
+static bool folderIsComparison(WlBOperator op) { return op >= WlBOperator_Greater && op <= WlBOperator_NotEqual; }
+
+// i32 and i64 arithmetic wraps, division is signed or unsigned by type and shift counts are taken modulo the width
+static bool foldIntegerBinary(WlBType type, WlBOperator op, u64 a, u64 b, u64 *result)
+{
+	bool wide = type == WlBType_i64 || type == WlBType_u64;
+	bool isSigned = type == WlBType_i32 || type == WlBType_i64;
+	u64 mask = wide ? UINT64_MAX : UINT32_MAX;
+	a &= mask;
+	b &= mask;
+	i64 sa = wide ? (i64)a : (i32)(u32)a;
+	i64 sb = wide ? (i64)b : (i32)(u32)b;
+	i64 min = wide ? INT64_MIN : INT32_MIN;
+
+	if (folderIsComparison(op)) {
+		int order = isSigned ? (sa > sb) - (sa < sb) : (a > b) - (a < b);
+		*result = foldCompare(op, order);
+		return true;
+	}
+
+	switch (op) {
+	case WlBOperator_Add: *result = a + b; break;
+	case WlBOperator_Subtract: *result = a - b; break;
+	case WlBOperator_Multiply: *result = a * b; break;
+	case WlBOperator_Divide:
+		// division by zero and the overflowing signed division trap
+		if (b == 0 || (isSigned && sa == min && sb == -1)) return false;
+		*result = isSigned ? (u64)(sa / sb) : a / b;
+		break;
+	case WlBOperator_Modulo:
+		if (b == 0) return false;
+		// the remainder of the overflowing signed division is 0 in wasm, it is undefined in C
+		if (isSigned && sb == -1) {
+			*result = 0;
+		} else {
+			*result = isSigned ? (u64)(sa % sb) : a % b;
+		}
+		break;
+	case WlBOperator_ShiftLeft: *result = a << (b & (wide ? 63 : 31)); break;
+	case WlBOperator_ShiftRight: {
+		u64 count = b & (wide ? 63 : 31);
+		if (!isSigned) {
+			*result = a >> count;
+		} else {
+			// shifts the sign in without relying on the implementation defined shift of negative numbers
+			*result = sa < 0 ? ~(~(u64)sa >> count) : (u64)sa >> count;
+		}
+	} break;
+	case WlBOperator_BitwiseAnd:
+	case WlBOperator_And: *result = a & b; break;
+	case WlBOperator_Xor: *result = a ^ b; break;
+	case WlBOperator_BitwiseOr:
+	case WlBOperator_Or: *result = a | b; break;
+	default: return false;
+	}
+	*result &= mask;
+	return true;
+}
+
+// f32 operations round after every step, like they would in wasm
+static bool foldFloatBinary(WlBType type, WlBOperator op, f64 a, f64 b, WlbNode *result, WlbNode n)
+{
+	if (folderIsComparison(op)) {
+		// every comparison with a NaN is false except for !=
+		bool holds = op == WlBOperator_NotEqual ? a != b : foldCompare(op, (a > b) - (a < b)) && a == a && b == b;
+		*result = folderIntegerLiteral(n, WlBType_bool, holds);
+		return true;
+	}
+
+	f64 value;
+	if (type == WlBType_f32) {
+		f32 x = (f32)a, y = (f32)b;
+		switch (op) {
+		case WlBOperator_Add: value = (f32)(x + y); break;
+		case WlBOperator_Subtract: value = (f32)(x - y); break;
+		case WlBOperator_Multiply: value = (f32)(x * y); break;
+		case WlBOperator_Divide: value = (f32)(x / y); break;
+		default: return false;
+		}
+	} else {
+		switch (op) {
+		case WlBOperator_Add: value = a + b; break;
+		case WlBOperator_Subtract: value = a - b; break;
+		case WlBOperator_Multiply: value = a * b; break;
+		case WlBOperator_Divide: value = a / b; break;
+		default: return false;
+		}
+	}
+	*result = folderFloatLiteral(n, type, value);
+	return true;
+}
+
+static void foldBinary(WlbNode *n)
+{
+	WlBoundBinaryExpression *bin = n->data;
+	if (!folderIsLiteral(bin->left) || !folderIsLiteral(bin->right)) return;
+
+	WlBType type = bin->left.type;
+	if (type == WlBType_f32 || type == WlBType_f64) {
+		WlbNode result;
+		if (foldFloatBinary(type, bin->operator, bin->left.dataFloat, bin->right.dataFloat, &result, *n)) *n = result;
+		return;
+	}
+
+	u64 value;
+	if (!foldIntegerBinary(type == WlBType_bool ? WlBType_i32 : type, bin->operator, bin->left.dataNum,
+						   bin->right.dataNum, &value)) {
+		return;
+	}
+	*n = folderIntegerLiteral(*n, n->type, value);
+}
+
+static void foldPreUnary(WlbNode *n)
+{
+	WlBoundPreUnaryExpression *un = n->data;
+	WlbNode x = un->expression;
+	if (!folderIsLiteral(x)) return;
+
+	switch (un->operator) {
+	case WlBOperator_Negate: *n = folderIntegerLiteral(*n, n->type, x.dataNum == 0); break;
+	case WlBOperator_Subtract:
+		if (x.type == WlBType_f32 || x.type == WlBType_f64) {
+			*n = folderFloatLiteral(*n, x.type, -x.dataFloat);
+		} else {
+			*n = folderIntegerLiteral(*n, x.type, 0 - (u64)x.dataNum);
+		}
+		break;
+	default: break;
+	}
+}
+
+static void foldNode(WlFolder *f, WlbNode *n);
+
+// a value block whose statements all folded away is the value of its last node
+static void foldBlock(WlFolder *f, WlbNode *n)
+{
+	WlBoundBlock *blk = n->data;
+	int len = listLen(blk->nodes);
+	for (int i = 0; i < len; i++) {
+		foldNode(f, &blk->nodes[i]);
+	}
+
+	if (len == 0 || !folderIsFoldableType(n->type) || !folderIsLiteral(blk->nodes[len - 1])) return;
+	for (int i = 0; i < len - 1; i++) {
+		if (blk->nodes[i].kind != WlBKind_None) return;
+	}
+	*n = blk->nodes[len - 1];
+}
+
+static void foldNode(WlFolder *f, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_BoolLiteral: n->kind = WlBKind_NumberLiteral; break;
+	case WlBKind_Block:
+	case WlBKind_DoExpression: foldBlock(f, n); break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		foldNode(f, &st->condition);
+		foldNode(f, &st->thenBlock);
+		foldNode(f, &st->elseBlock);
+		// only the branch that is taken is left
+		if (folderIsLiteral(st->condition)) {
+			WlbNode taken = st->condition.dataNum ? st->thenBlock : st->elseBlock;
+			*n = taken.kind == WlBKind_None ? (WlbNode){.kind = WlBKind_None} : taken;
+		}
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		foldNode(f, &st->condition);
+		foldNode(f, &st->block);
+		if (folderIsLiteral(st->condition) && !st->condition.dataNum) *n = (WlbNode){.kind = WlBKind_None};
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		foldNode(f, &st->block);
+		foldNode(f, &st->condition);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		foldNode(f, &st->expression);
+		// a let binding that is assigned once and folds to a literal is a constant from here on
+		WlSymbol *s = st->symbol;
+		bool once = true;
+		for (int i = 0; i < listLen(f->reassigned); i++) {
+			if (f->reassigned[i] == s) once = false;
+		}
+		if ((s->flags & WlSFlag_Immutable) && (s->flags & WlSFlag_TypeBits) == WlSFlag_Variable && once &&
+			folderIsLiteral(st->expression)) {
+			s->flags |= WlSFlag_Constant;
+			s->initializer = &st->expression;
+			*n = (WlbNode){.kind = WlBKind_None};
+		}
+	} break;
+	case WlBKind_Ref: {
+		WlSymbol *s = n->data;
+		if (s->flags & WlSFlag_Constant) {
+			WlbNode value = *s->initializer;
+			wlSetNodeType(&value, n->type);
+			value.span = n->span;
+			*n = value;
+		}
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			foldNode(f, &st->args[i]);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		foldNode(f, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		foldNode(f, &st->left);
+		foldNode(f, &st->right);
+		foldBinary(n);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		foldNode(f, &st->expression);
+		foldPreUnary(n);
+	} break;
+	default: break;
+	}
+}
+
+void foldFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (fn->optimized || fn->body.kind != WlBKind_Block) return;
+	WlFolder f = {.b = b, .reassigned = listNew()};
+	List(WlSymbol *) assigned = listNew();
+	lowerCollectAssignments(fn->body, &assigned, &f.reassigned);
+
+	// the body stays a block even when it folds to a single value
+	WlBoundBlock *blk = fn->body.data;
+	for (int i = 0; i < listLen(blk->nodes); i++) {
+		foldNode(&f, &blk->nodes[i]);
+	}
+	listFree(&assigned);
+	listFree(&f.reassigned);
+}
+
+// runs after lower, once ternaries, increments and for loops are gone
+void fold(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		foldFunction(b, b->functions[i]);
+	}
+}
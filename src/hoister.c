@@ -0,0 +1,336 @@
+#include <walc.h>
+
+// loop invariant code motion, computes expressions whose value is the same on every iteration once before the loop
+// an expression is invariant when it only reads variables the loop doesn't assign and calls pure functions
+// it is assigned to a new local before the loop and the loop reads the local instead
+// expressions are hoisted even when the loop might not run, so only those that can't trap or have side effects are.
+// integer division and remainder trap on 0, so they stay in the loop
+// runs after fold, on bodies that are lowered, so for loops are already while loops
+
+typedef struct {
+	WlBinder *b;
+	// the function the loops are in, the new locals are added to its scope
+	WlBoundFunction *fn;
+	// functions whose purity was decided, and those it is being decided for
+	List(WlBoundFunction *) pure;
+	List(WlBoundFunction *) impure;
+	List(WlBoundFunction *) deciding;
+	// the variables the loop that is hoisted from assigns
+	List(WlSymbol *) assigned;
+	// the assignments of the hoisted expressions to their locals
+	List(WlbNode) hoisted;
+} WlHoister;
+
+static bool hoisterContains(List(WlBoundFunction *) functions, WlBoundFunction *fn)
+{
+	for (int i = 0; i < listLen(functions); i++) {
+		if (functions[i] == fn) return true;
+	}
+	return false;
+}
+
+static bool hoisterIsTrapping(WlBOperator op, WlBType type)
+{
+	return (op == WlBOperator_Divide || op == WlBOperator_Modulo) && !wlIsFloatType(type);
+}
+
+static bool hoisterIsPureFunction(WlHoister *h, WlBoundFunction *fn);
+
+// pure bodies can be run ahead of time, they have no side effects, can't trap and always return
+static bool hoisterIsPureNode(WlHoister *h, WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_None:
+	case WlBKind_Function:
+	case WlBKind_Ref:
+	case WlBKind_NumberLiteral:
+	case WlBKind_StringLiteral: return true;
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			if (!hoisterIsPureNode(h, blk->nodes[i])) return false;
+		}
+		return true;
+	}
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		return hoisterIsPureNode(h, st->condition) && hoisterIsPureNode(h, st->thenBlock) &&
+			   hoisterIsPureNode(h, st->elseBlock);
+	}
+	// assigning the locals of the function is not a side effect of calling it
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		return hoisterIsPureNode(h, st->expression);
+	}
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			if (!hoisterIsPureNode(h, st->args[i])) return false;
+		}
+		return hoisterIsPureFunction(h, st->function->function);
+	}
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		if (hoisterIsTrapping(st->operator, st->left.type)) return false;
+		return hoisterIsPureNode(h, st->left) && hoisterIsPureNode(h, st->right);
+	}
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		return hoisterIsPureNode(h, st->expression);
+	}
+	// loops might not end and returns leave the caller
+	default: return false;
+	}
+}
+
+// imports and bodies that aren't bound, like those the streaming compiler released, are never pure
+// a function that calls itself is not either, it might not return
+static bool hoisterIsPureFunction(WlHoister *h, WlBoundFunction *fn)
+{
+	if (hoisterContains(h->pure, fn)) return true;
+	if (hoisterContains(h->impure, fn) || hoisterContains(h->deciding, fn)) return false;
+	if ((fn->symbol->flags & WlSFlag_Import) || !fn->lowered || fn->body.kind != WlBKind_Block) return false;
+
+	listPush(&h->deciding, fn);
+	bool pure = hoisterIsPureNode(h, fn->body);
+	LISTHEAD(h->deciding)->len--;
+
+	if (pure) {
+		listPush(&h->pure, fn);
+	} else {
+		listPush(&h->impure, fn);
+	}
+	return pure;
+}
+
+static void hoisterCollectAssigned(WlbNode n, List(WlSymbol *) * assigned)
+{
+	switch (n.kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			hoisterCollectAssigned(blk->nodes[i], assigned);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		hoisterCollectAssigned(st->condition, assigned);
+		hoisterCollectAssigned(st->thenBlock, assigned);
+		hoisterCollectAssigned(st->elseBlock, assigned);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		hoisterCollectAssigned(st->condition, assigned);
+		hoisterCollectAssigned(st->block, assigned);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		hoisterCollectAssigned(st->block, assigned);
+		hoisterCollectAssigned(st->condition, assigned);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		hoisterCollectAssigned(st->expression, assigned);
+		listPush(assigned, st->symbol);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			hoisterCollectAssigned(st->args[i], assigned);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n.data;
+		hoisterCollectAssigned(st->expression, assigned);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		hoisterCollectAssigned(st->left, assigned);
+		hoisterCollectAssigned(st->right, assigned);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		hoisterCollectAssigned(st->expression, assigned);
+	} break;
+	default: break;
+	}
+}
+
+static bool hoisterIsInvariant(WlHoister *h, WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_NumberLiteral: return true;
+	case WlBKind_Ref: {
+		for (int i = 0; i < listLen(h->assigned); i++) {
+			if (h->assigned[i] == n.data) return false;
+		}
+		return true;
+	}
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			if (!hoisterIsInvariant(h, st->args[i])) return false;
+		}
+		return hoisterIsPureFunction(h, st->function->function);
+	}
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		if (hoisterIsTrapping(st->operator, st->left.type)) return false;
+		return hoisterIsInvariant(h, st->left) && hoisterIsInvariant(h, st->right);
+	}
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		return hoisterIsInvariant(h, st->expression);
+	}
+	default: return false;
+	}
+}
+
+// only computations are worth a local, and only values that fit in one
+static bool hoisterIsWorthHoisting(WlbNode n)
+{
+	if (n.kind != WlBKind_BinaryExpression && n.kind != WlBKind_PreUnaryExpression && n.kind != WlBKind_Call) {
+		return false;
+	}
+	switch (n.type) {
+	case WlBType_bool:
+	case WlBType_i32:
+	case WlBType_u32:
+	case WlBType_i64:
+	case WlBType_u64:
+	case WlBType_f32:
+	case WlBType_f64: return true;
+	default: return false;
+	}
+}
+
+// replaces the largest invariant expressions in n by a local that is assigned before the loop
+static void hoistExpressions(WlHoister *h, WlbNode *n)
+{
+	if (hoisterIsWorthHoisting(*n) && hoisterIsInvariant(h, *n)) {
+		WlSymbol *local =
+			lowerAddLocal(h->b, h->fn, (WlSymbol){.name = STR("hoisted"), .type = n->type, .flags = WlSFlag_Variable});
+
+		WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &h->b->arena);
+		*asg = (WlBoundAssignment){.expression = *n, .symbol = local};
+		listPush(&h->hoisted, ((WlbNode){.kind = WlBKind_VariableAssignment, .type = n->type, .data = asg}));
+		*n = (WlbNode){.kind = WlBKind_Ref, .type = n->type, .data = local, .span = n->span};
+		return;
+	}
+
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			hoistExpressions(h, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		hoistExpressions(h, &st->condition);
+		hoistExpressions(h, &st->thenBlock);
+		hoistExpressions(h, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		hoistExpressions(h, &st->condition);
+		hoistExpressions(h, &st->block);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		hoistExpressions(h, &st->block);
+		hoistExpressions(h, &st->condition);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		hoistExpressions(h, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			hoistExpressions(h, &st->args[i]);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		hoistExpressions(h, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		hoistExpressions(h, &st->left);
+		hoistExpressions(h, &st->right);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		hoistExpressions(h, &st->expression);
+	} break;
+	default: break;
+	}
+}
+
+// the loop becomes a block that assigns the hoisted locals and then runs the loop
+static void hoistLoop(WlHoister *h, WlbNode *loop)
+{
+	if (h->assigned) LISTHEAD(h->assigned)->len = 0;
+	if (h->hoisted) LISTHEAD(h->hoisted)->len = 0;
+	hoisterCollectAssigned(*loop, &h->assigned);
+	hoistExpressions(h, loop);
+	if (!listLen(h->hoisted)) return;
+
+	WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &h->b->arena);
+	*blk = (WlBoundBlock){.scope = NULL, .nodes = listNew()};
+	for (int i = 0; i < listLen(h->hoisted); i++) {
+		listPush(&blk->nodes, h->hoisted[i]);
+	}
+	listPush(&blk->nodes, *loop);
+	*loop = (WlbNode){.kind = WlBKind_Block, .type = WlBType_u0, .data = blk, .span = loop->span};
+}
+
+// inner loops are hoisted from first, what they hoist may be invariant in the outer loop too
+static void hoistNode(WlHoister *h, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			hoistNode(h, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		hoistNode(h, &st->thenBlock);
+		hoistNode(h, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		hoistNode(h, &st->block);
+		hoistLoop(h, n);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		hoistNode(h, &st->block);
+		hoistLoop(h, n);
+	} break;
+	default: break;
+	}
+}
+
+void hoistFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (!fn->lowered || fn->optimized || fn->body.kind != WlBKind_Block) return;
+	WlHoister h = {.b = b, .fn = fn};
+	hoistNode(&h, &fn->body);
+	listFree(&h.pure);
+	listFree(&h.impure);
+	listFree(&h.deciding);
+	listFree(&h.assigned);
+	listFree(&h.hoisted);
+}
+
+// runs after fold, so folded expressions are not hoisted into a local
+void hoist(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		hoistFunction(b, b->functions[i]);
+	}
+}
@@ -0,0 +1,353 @@
+#include <walc.h>
+
+// replaces calls to small functions with a copy of their body
+// runs after lower, the body of the called function has to be lowered too and may not return early,
+// its last node is the value of the call
+// the parameters become locals of the caller that are assigned the arguments, arguments that are literals or
+// immutable variables are used as they are. the locals of the called function are copied into the caller
+// a function that is being inlined is never inlined into itself, so recursion stops at the first call
+// @inline functions are inlined regardless of their size, @noinline functions never are
+
+// the most nodes the body of a function can have for its calls to be inlined
+#define INLINERMAXCOST 24
+// the cost of a body with nodes that can't be copied
+#define INLINERUNCOPYABLE INT32_MAX
+
+typedef struct {
+	WlSymbol *from;
+	WlbNode to;
+} WlInlineSubstitution;
+
+typedef struct {
+	WlBinder *b;
+	// the function whose body calls are inlined into, the copied locals are added to its scope
+	WlBoundFunction *caller;
+	// the functions whose bodies are being copied, innermost last
+	List(WlBoundFunction *) inlining;
+	List(WlInlineSubstitution) substitutions;
+} WlInliner;
+
+// adds the number of nodes of n to cost, counting stops once it is over limit
+static int inlinerCost(WlbNode n, int cost, int limit)
+{
+	if (cost > limit) return cost;
+	cost++;
+
+	switch (n.kind) {
+	case WlBKind_None:
+	case WlBKind_Function:
+	case WlBKind_NumberLiteral:
+	case WlBKind_StringLiteral: return cost;
+	case WlBKind_Ref: {
+		// strings take two locals, which the emitter only reads and writes for parameters
+		WlSymbol *s = n.data;
+		return s->type == WlBType_str ? INLINERUNCOPYABLE : cost;
+	}
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			cost = inlinerCost(blk->nodes[i], cost, limit);
+		}
+		return cost;
+	}
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		cost = inlinerCost(st->condition, cost, limit);
+		cost = inlinerCost(st->thenBlock, cost, limit);
+		return inlinerCost(st->elseBlock, cost, limit);
+	}
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		cost = inlinerCost(st->condition, cost, limit);
+		return inlinerCost(st->block, cost, limit);
+	}
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		cost = inlinerCost(st->block, cost, limit);
+		return inlinerCost(st->condition, cost, limit);
+	}
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		if (st->symbol->type == WlBType_str) return INLINERUNCOPYABLE;
+		return inlinerCost(st->expression, cost, limit);
+	}
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			cost = inlinerCost(st->args[i], cost, limit);
+		}
+		return cost;
+	}
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		cost = inlinerCost(st->left, cost, limit);
+		return inlinerCost(st->right, cost, limit);
+	}
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		return inlinerCost(st->expression, cost, limit);
+	}
+	// an early return would return from the caller
+	default: return INLINERUNCOPYABLE;
+	}
+}
+
+// with @inline the size doesn't matter, but the body still has to be one that can be copied
+static bool inlinerCanInline(WlInliner *in, WlBoundFunction *callee)
+{
+	WlSymbolFlags flags = callee->symbol->flags;
+	if (flags & (WlSFlag_Import | WlSFlag_NoInline)) return false;
+	if (!callee->lowered || callee->body.kind != WlBKind_Block) return false;
+	if (callee == in->caller) return false;
+	for (int i = 0; i < listLen(in->inlining); i++) {
+		if (in->inlining[i] == callee) return false;
+	}
+	for (int i = 0; i < callee->paramCount; i++) {
+		if (callee->scope->symbols[i]->type == WlBType_str) return false;
+	}
+
+	int limit = (flags & WlSFlag_Inline) ? INLINERUNCOPYABLE - 1 : INLINERMAXCOST;
+	return inlinerCost(callee->body, 0, limit) <= limit;
+}
+
+static WlSymbol *inlinerLocal(WlInliner *in, WlSymbol *s)
+{
+	for (int i = 0; i < listLen(in->substitutions); i++) {
+		if (in->substitutions[i].from == s) return in->substitutions[i].to.data;
+	}
+	return s;
+}
+
+static WlbNode inlinerCopy(WlInliner *in, WlbNode n)
+{
+	ArenaAllocator *arena = &in->b->arena;
+
+	switch (n.kind) {
+	// local functions are added to the module on their own, calls to them still work from the caller
+	case WlBKind_Function: return (WlbNode){.kind = WlBKind_None};
+	case WlBKind_Ref: {
+		for (int i = 0; i < listLen(in->substitutions); i++) {
+			if (in->substitutions[i].from != n.data) continue;
+			WlbNode to = in->substitutions[i].to;
+			to.span = n.span;
+			return to;
+		}
+		return n;
+	}
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		WlBoundBlock *copy = arenaMalloc(sizeof(WlBoundBlock), arena);
+		// the locals of the block are already hoisted into the function
+		*copy = (WlBoundBlock){.scope = NULL, .nodes = listNew()};
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			listPush(&copy->nodes, inlinerCopy(in, blk->nodes[i]));
+		}
+		n.data = copy;
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		WlBoundIf *copy = arenaMalloc(sizeof(WlBoundIf), arena);
+		copy->condition = inlinerCopy(in, st->condition);
+		copy->thenBlock = inlinerCopy(in, st->thenBlock);
+		copy->elseBlock = inlinerCopy(in, st->elseBlock);
+		n.data = copy;
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		WlBoundWhile *copy = arenaMalloc(sizeof(WlBoundWhile), arena);
+		copy->condition = inlinerCopy(in, st->condition);
+		copy->block = inlinerCopy(in, st->block);
+		copy->unroll = st->unroll;
+		n.data = copy;
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		WlBoundDoWhile *copy = arenaMalloc(sizeof(WlBoundDoWhile), arena);
+		copy->block = inlinerCopy(in, st->block);
+		copy->condition = inlinerCopy(in, st->condition);
+		n.data = copy;
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		WlBoundAssignment *copy = arenaMalloc(sizeof(WlBoundAssignment), arena);
+		copy->expression = inlinerCopy(in, st->expression);
+		copy->symbol = inlinerLocal(in, st->symbol);
+		n.data = copy;
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		WlBoundCallExpression *copy = arenaMalloc(sizeof(WlBoundCallExpression), arena);
+		*copy = (WlBoundCallExpression){.function = st->function, .args = listNew()};
+		for (int i = 0; i < listLen(st->args); i++) {
+			listPush(&copy->args, inlinerCopy(in, st->args[i]));
+		}
+		n.data = copy;
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		WlBoundBinaryExpression *copy = arenaMalloc(sizeof(WlBoundBinaryExpression), arena);
+		copy->left = inlinerCopy(in, st->left);
+		copy->operator= st->operator;
+		copy->right = inlinerCopy(in, st->right);
+		n.data = copy;
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		WlBoundPreUnaryExpression *copy = arenaMalloc(sizeof(WlBoundPreUnaryExpression), arena);
+		copy->operator= st->operator;
+		copy->expression = inlinerCopy(in, st->expression);
+		n.data = copy;
+	} break;
+	default: break;
+	}
+	return n;
+}
+
+// a local of the caller that stands in for a parameter or local of the called function
+static WlbNode inlinerAddLocal(WlInliner *in, WlSymbol *s)
+{
+	WlSymbol *local = lowerAddLocal(in->b, in->caller, *s);
+	return (WlbNode){.kind = WlBKind_Ref, .type = s->type, .data = local};
+}
+
+// arguments that can stand in for a parameter that the called function never assigns
+static bool inlinerIsStable(WlbNode arg)
+{
+	if (arg.kind == WlBKind_NumberLiteral) return true;
+	return arg.kind == WlBKind_Ref && (((WlSymbol *)arg.data)->flags & WlSFlag_Immutable);
+}
+
+static bool inlinerContains(List(WlSymbol *) symbols, WlSymbol *s)
+{
+	for (int i = 0; i < listLen(symbols); i++) {
+		if (symbols[i] == s) return true;
+	}
+	return false;
+}
+
+static void inlineNode(WlInliner *in, WlbNode *n);
+
+// the call becomes a block that assigns the arguments and then runs the copied body, its last node is the value
+static void inlineCall(WlInliner *in, WlbNode *n)
+{
+	WlBoundCallExpression *call = n->data;
+	WlBoundFunction *callee = call->function->function;
+	if (!inlinerCanInline(in, callee)) return;
+
+	int substitutionStart = listLen(in->substitutions);
+	WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &in->b->arena);
+	*blk = (WlBoundBlock){.scope = NULL, .nodes = listNew()};
+
+	// parameters can be assigned by increments and decrements, those always get a local
+	List(WlSymbol *) assigned = listNew();
+	List(WlSymbol *) reassigned = listNew();
+	lowerCollectAssignments(callee->body, &assigned, &reassigned);
+
+	for (int i = 0; i < callee->paramCount; i++) {
+		WlSymbol *param = callee->scope->symbols[i];
+		WlbNode arg = call->args[i];
+		if (inlinerIsStable(arg) && !inlinerContains(assigned, param)) {
+			listPush(&in->substitutions, ((WlInlineSubstitution){param, arg}));
+			continue;
+		}
+		WlbNode local = inlinerAddLocal(in, param);
+		WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &in->b->arena);
+		*asg = (WlBoundAssignment){.expression = arg, .symbol = local.data};
+		listPush(&blk->nodes, ((WlbNode){.kind = WlBKind_VariableAssignment, .type = param->type, .data = asg}));
+		listPush(&in->substitutions, ((WlInlineSubstitution){param, local}));
+	}
+	listFree(&assigned);
+	listFree(&reassigned);
+	for (int i = callee->paramCount; i < listLen(callee->scope->symbols); i++) {
+		WlSymbol *s = callee->scope->symbols[i];
+		if ((s->flags & WlSFlag_TypeBits) != WlSFlag_Variable || (s->flags & WlSFlag_Constant)) continue;
+		listPush(&in->substitutions, ((WlInlineSubstitution){s, inlinerAddLocal(in, s)}));
+	}
+
+	WlBoundBlock *body = callee->body.data;
+	for (int i = 0; i < listLen(body->nodes); i++) {
+		listPush(&blk->nodes, inlinerCopy(in, body->nodes[i]));
+	}
+	if (in->substitutions) LISTHEAD(in->substitutions)->len = substitutionStart;
+
+	listFree(&call->args);
+	*n = (WlbNode){.kind = WlBKind_Block, .type = n->type, .data = blk, .span = n->span};
+	in->caller->inlined = true;
+
+	// calls in the copy are inlined as well, but not those back into the function that was just copied
+	listPush(&in->inlining, callee);
+	for (int i = 0; i < listLen(blk->nodes); i++) {
+		inlineNode(in, &blk->nodes[i]);
+	}
+	LISTHEAD(in->inlining)->len--;
+}
+
+static void inlineNode(WlInliner *in, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			inlineNode(in, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		inlineNode(in, &st->condition);
+		inlineNode(in, &st->thenBlock);
+		inlineNode(in, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		inlineNode(in, &st->condition);
+		inlineNode(in, &st->block);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		inlineNode(in, &st->block);
+		inlineNode(in, &st->condition);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		inlineNode(in, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			inlineNode(in, &st->args[i]);
+		}
+		inlineCall(in, n);
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		inlineNode(in, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		inlineNode(in, &st->left);
+		inlineNode(in, &st->right);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		inlineNode(in, &st->expression);
+	} break;
+	default: break;
+	}
+}
+
+void inlineFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (!fn->lowered || fn->optimized || fn->body.kind != WlBKind_Block) return;
+	WlInliner in = {.b = b, .caller = fn, .inlining = listNew(), .substitutions = listNew()};
+	inlineNode(&in, &fn->body);
+	listFree(&in.inlining);
+	listFree(&in.substitutions);
+}
+
+// runs between lower and fold, so the folder sees the arguments that are literals in the copied bodies
+void inlineCalls(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		inlineFunction(b, b->functions[i]);
+	}
+}
@@ -0,0 +1,95 @@
+#include <walc.h>
+
+// compilation wide string table
+// identifiers are interned once by the lexer, after that they are compared by atom
+// atom 0 is reserved to mean "no name"
+typedef struct {
+	// atom -> text and atom -> hash
+	List(Str) strings;
+	List(u32) hashes;
+	// open addressing table of atoms, the capacity is always a power of two
+	WlAtom *slots;
+	u32 slotCapacity;
+	// owns the text of every interned string, so atoms outlive the sources they came from
+	ArenaAllocator arena;
+} WlInterner;
+
+static WlInterner wlInterner = {0};
+
+u32 wlHashStr(Str s)
+{
+	// FNV-1a
+	u32 hash = 2166136261u;
+	for (int i = 0; i < s.len; i++) {
+		hash ^= (u8)s.buf[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void wlInternerGrow(WlInterner *in)
+{
+	u32 newCapacity = in->slotCapacity ? in->slotCapacity * 2 : 1024;
+	WlAtom *newSlots = calloc(newCapacity, sizeof(WlAtom));
+	if (!newSlots) PANIC("Failed to grow interner");
+
+	for (u32 i = 0; i < in->slotCapacity; i++) {
+		WlAtom atom = in->slots[i];
+		if (!atom) continue;
+		u32 slot = in->hashes[atom] & (newCapacity - 1);
+		while (newSlots[slot])
+			slot = (slot + 1) & (newCapacity - 1);
+		newSlots[slot] = atom;
+	}
+
+	free(in->slots);
+	in->slots = newSlots;
+	in->slotCapacity = newCapacity;
+}
+
+WlAtom wlInternWithHash(Str s, u32 hash)
+{
+	WlInterner *in = &wlInterner;
+	if (in->slotCapacity == 0) {
+		in->arena = arenaCreate();
+		// reserve atom 0
+		listPush(&in->strings, STREMPTY);
+		listPush(&in->hashes, 0);
+	}
+
+	// keep the table at most half full
+	if ((u32)listLen(in->strings) * 2 >= in->slotCapacity) wlInternerGrow(in);
+
+	u32 mask = in->slotCapacity - 1;
+	u32 slot = hash & mask;
+	while (in->slots[slot]) {
+		WlAtom atom = in->slots[slot];
+		if (in->hashes[atom] == hash && strEqual(in->strings[atom], s)) return atom;
+		slot = (slot + 1) & mask;
+	}
+
+	char *text = arenaMalloc(s.len + 1, &in->arena);
+	memcpy(text, s.buf, s.len);
+	text[s.len] = '\0';
+
+	WlAtom atom = listLen(in->strings);
+	listPush(&in->strings, ((Str){text, s.len}));
+	listPush(&in->hashes, hash);
+	in->slots[slot] = atom;
+	return atom;
+}
+
+WlAtom wlIntern(Str s) { return wlInternWithHash(s, wlHashStr(s)); }
+
+// returns the interned text, which is null terminated and lives as long as the interner
+Str wlAtomText(WlAtom atom)
+{
+	assert(atom < listLen(wlInterner.strings));
+	return wlInterner.strings[atom];
+}
+
+u32 wlAtomHash(WlAtom atom)
+{
+	assert(atom < listLen(wlInterner.hashes));
+	return wlInterner.hashes[atom];
+}
@@ -83,4 +83,23 @@ void leb128EncodeS(int number, DynamicBuf *buf)
 	assert((number == 0 || number == -1) && "Number should be fully consumed");
 }
 
+// i64.const takes the full 64 bits, which take up to 10 bytes of 7 bits
+void leb128EncodeS64(int64_t number, DynamicBuf *buf)
+{
+	const u8 SIGNBIT = 0x40;
+	const u8 MSB = 0x80;
+	while (true) {
+		u8 byte = number & 0x7f;
+		// shifts the sign in without relying on the implementation defined shift of negative numbers
+		number = number < 0 ? ~(~number >> 7) : number >> 7;
+
+		bool isSigned = byte & SIGNBIT;
+		if ((number == 0 && !isSigned) || (number == -1 && isSigned)) {
+			dynamicBufPush(buf, byte);
+			return;
+		}
+		dynamicBufPush(buf, byte | MSB);
+	}
+}
+
 #endif // LEB128_H
@@ -15,6 +15,7 @@ void lowerNode(WlBinder *b, WlbNode *n)
 
 		WlScope *targetScope = listPeek(&b->scopes);
 		if (blk.scope != targetScope && blk.scope) {
+			// hoisted locals only go into the list for the emitter, the lookup table is done once binding is
 			for (int i = 0; i < listLen(blk.scope->symbols); i++) {
 				listPush(&targetScope->symbols, blk.scope->symbols[i]);
 			}
@@ -65,6 +66,7 @@ void lowerNode(WlBinder *b, WlbNode *n)
 		WlBoundWhile *whl = arenaMalloc(sizeof(WlBoundWhile), &b->arena);
 		whl->condition = st->condition;
 		whl->block = st->block;
+		whl->unroll = st->unroll;
 
 		WlBoundBlock *innerBlk = st->block.data;
 		listPush(&innerBlk->nodes, st->postCondition);
@@ -99,11 +101,6 @@ void lowerNode(WlBinder *b, WlbNode *n)
 	} break;
 	case WlBKind_VariableAssignment: {
 		WlBoundAssignment *st = n->data;
-		// oops! abstract type slipped through...
-		// TODO: maybe do this elsewhere
-		if (st->symbol->type != st->expression.type) {
-			propagateType(&st->expression, st->symbol->type);
-		}
 		lowerNode(b, &st->expression);
 	} break;
 	case WlBKind_Call: {
@@ -115,10 +112,10 @@ void lowerNode(WlBinder *b, WlbNode *n)
 	case WlBKind_Ref: {
 		WlSymbol *s = n->data;
 		if (s->flags & WlSFlag_Constant) {
-			if (s->initializer->type != n->type) {
-				propagateType(s->initializer, n->type);
-			}
-			*n = *s->initializer;
+			// every use has its own type, the literal is converted to it
+			WlbNode value = *s->initializer;
+			wlSetNodeType(&value, n->type);
+			*n = value;
 		}
 	} break;
 	case WlBKind_Return: {
@@ -154,9 +151,7 @@ void lowerNode(WlBinder *b, WlbNode *n)
 			bin->left = st->expression;
 			bin->operator= st->operator== WlBOperator_Increment ? WlBOperator_Add : WlBOperator_Subtract;
 			bin->right = (WlbNode){.kind = WlBKind_NumberLiteral, .type = WlBType_integerNumber, .dataNum = 1};
-			if (bin->right.type != bin->left.type) {
-				propagateType(&bin->right, bin->left.type);
-			}
+			wlSetNodeType(&bin->right, bin->left.type);
 
 			WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &b->arena);
 			asg->symbol = st->expression.data;
@@ -186,9 +181,7 @@ void lowerNode(WlBinder *b, WlbNode *n)
 		bin->left = st->expression;
 		bin->operator= st->operator== WlBOperator_Increment ? WlBOperator_Add : WlBOperator_Subtract;
 		bin->right = (WlbNode){.kind = WlBKind_NumberLiteral, .type = WlBType_integerNumber, .dataNum = 1};
-		if (bin->right.type != bin->left.type) {
-			propagateType(&bin->right, bin->left.type);
-		}
+		wlSetNodeType(&bin->right, bin->left.type);
 
 		WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &b->arena);
 		asg->symbol = st->expression.data;
@@ -213,12 +206,95 @@ void lowerNode(WlBinder *b, WlbNode *n)
 	}
 }
 
+void lowerFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	fn->lowered = true;
+
+	WlbNode body = fn->body;
+	listPush(&b->scopes, fn->scope);
+	lowerNode(b, &body);
+	listPop(&b->scopes);
+}
+
 void lower(WlBinder *b)
 {
 	for (int i = 0; i < listLen(b->functions); i++) {
-		WlBoundFunction fn = *b->functions[i];
-		listPush(&b->scopes, fn.scope);
-		lowerNode(b, &fn.body);
-		listPop(&b->scopes);
+		// bodies kept by wlRebind were lowered before
+		if (b->functions[i]->lowered) continue;
+		lowerFunction(b, b->functions[i]);
+	}
+}
+
+// adds a copy of s to the locals of a lowered body, for the passes after lower that need a local of their own
+// only the emitter looks at these, so the lookup table of the scope is left alone
+WlSymbol *lowerAddLocal(WlBinder *b, WlBoundFunction *fn, WlSymbol s)
+{
+	WlSymbol *local = arenaMalloc(sizeof(WlSymbol), &b->arena);
+	*local = s;
+	local->index = -1;
+	listPush(&fn->scope->symbols, local);
+	return local;
+}
+
+// collects the immutable symbols that a lowered body assigns, in assigned, and those it assigns more than once, in
+// reassigned. immutables are assigned once by their declaration, but increments and decrements assign them too
+void lowerCollectAssignments(WlbNode n, List(WlSymbol *) * assigned, List(WlSymbol *) * reassigned)
+{
+	switch (n.kind) {
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			lowerCollectAssignments(blk->nodes[i], assigned, reassigned);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		lowerCollectAssignments(st->condition, assigned, reassigned);
+		lowerCollectAssignments(st->thenBlock, assigned, reassigned);
+		lowerCollectAssignments(st->elseBlock, assigned, reassigned);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		lowerCollectAssignments(st->condition, assigned, reassigned);
+		lowerCollectAssignments(st->block, assigned, reassigned);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		lowerCollectAssignments(st->block, assigned, reassigned);
+		lowerCollectAssignments(st->condition, assigned, reassigned);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		lowerCollectAssignments(st->expression, assigned, reassigned);
+		if (!(st->symbol->flags & WlSFlag_Immutable)) break;
+		for (int i = 0; i < listLen(*assigned); i++) {
+			if ((*assigned)[i] == st->symbol) {
+				listPush(reassigned, st->symbol);
+				return;
+			}
+		}
+		listPush(assigned, st->symbol);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			lowerCollectAssignments(st->args[i], assigned, reassigned);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n.data;
+		lowerCollectAssignments(st->expression, assigned, reassigned);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		lowerCollectAssignments(st->left, assigned, reassigned);
+		lowerCollectAssignments(st->right, assigned, reassigned);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		lowerCollectAssignments(st->expression, assigned, reassigned);
+	} break;
+	default: break;
 	}
 }
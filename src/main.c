@@ -5,22 +5,18 @@ int main(int argc, char **argv)
 	Str filename = STR("examples/07_notes.wl");
 	Str source;
 
-	fileReadAllText(filename.buf, &source) || PANIC("Failed to open file");
+	fileMapAllText(filename.buf, &source) || PANIC("Failed to open file");
 
-	WlParser p = wlParserCreate(filename, source);
+	// bodies are only parsed and bound when they can be reached from an export or @entrypoint
+	// every body is compiled and released before the next one is parsed, see emitWasmStreaming
+	WlParser p = wlParserCreateWithOptions(filename, source, WlParserLazyBodies | WlParserParallel);
 	wlParse(&p);
 
-	WlBinder b = wlBind(p.topLevelDeclarations);
+	WlBinder b = wlBinderCreateReachable(&p);
+	Buf wasm = emitWasmStreaming(&b);
 
 	// for (int i = 0; i < topLevelCount; i++) {
-	// 	wlPrint(p.topLevelDeclarations[i]);
-	// }
-
-	// int functionCount = listLen(b.functions);
-	// for (int i = 0; i < functionCount; i++) {
-	// 	WlBoundFunction *fn = b.functions[i];
-	// 	printf("%s%s %.*s(){}\n", (fn->symbol->flags & WlSFlag_Export) ? "export " : "", WlBTypeText[fn->symbol->type],
-	// 		   STRPRINT(fn->symbol->name));
+	// 	wlPrint(&p.ast, p.topLevelDeclarations[i]);
 	// }
 
 	bool hasDiagnostics = listLen(p.diagnostics) || listLen(p.lexer.diagnostics) || listLen(b.diagnostics);
@@ -33,10 +29,10 @@ int main(int argc, char **argv)
 		for (int i = 0; i < listLen(b.diagnostics); i++)
 			diagnosticPrint(b.diagnostics[i]);
 	} else {
-		lower(&b);
-		Buf wasm = emitWasm(&b);
 		fileWriteAllBytes("out.wasm", wasm) || PANIC("Failed to write wasm");
 	}
 
+	wlBinderFree(&b);
 	wlParserFree(&p);
+	fileUnmap(&source);
 }
@@ -0,0 +1,119 @@
+#ifndef NUMBER_H
+#define NUMBER_H
+#include <sti_base.h>
+
+// numeric literal helpers used by the lexer
+// decimal runs are consumed eight digits at a time by treating them as a single 64 bit word (SWAR)
+
+// largest value that can still take eight more digits without overflowing a u64
+#define NUMBER_SWAR_LIMIT 100000000000ull
+// largest value that can still take one more digit without overflowing a u64
+#define NUMBER_DIGIT_LIMIT 1000000000000000000ull
+// integers up to 2^53 are exactly representable as f64
+#define NUMBER_F64_EXACT_LIMIT (1ull << 53)
+
+// loads 8 bytes so that the first byte ends up in the lowest byte of the word
+static inline u64 numberLoad8(char *buf)
+{
+	u64 chunk;
+	memcpy(&chunk, buf, sizeof(chunk));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	chunk = __builtin_bswap64(chunk);
+#endif
+	return chunk;
+}
+
+// true when all 8 bytes of the chunk are ascii digits
+// adding 6 pushes any byte above '9' into the next nibble, so both halves must read 0x3
+static inline bool numberIsEightDigits(u64 chunk)
+{
+	return ((chunk & 0xF0F0F0F0F0F0F0F0ull) | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+		   0x3333333333333333ull;
+}
+
+// converts 8 ascii digits into their value, the first byte is the most significant digit
+// every step multiplies neighbouring lanes together: digits into pairs, pairs into quads, quads into the result
+static inline u64 numberParseEightDigits(u64 chunk)
+{
+	chunk = ((chunk & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+	chunk = ((chunk & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+	return (u32)(((chunk & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32);
+}
+
+// consumes a run of decimal digits into value, returns the index of the first byte that is not a digit
+// overflow is set when the digits do not fit in a u64, the run is still consumed entirely
+static inline int numberParseDecimal(char *buf, int i, int len, u64 *value, bool *overflow)
+{
+	u64 v = *value;
+	while (i + 8 <= len && v < NUMBER_SWAR_LIMIT) {
+		u64 chunk = numberLoad8(buf + i);
+		if (!numberIsEightDigits(chunk)) break;
+		v = v * 100000000 + numberParseEightDigits(chunk);
+		i += 8;
+	}
+	while (i < len && buf[i] >= '0' && buf[i] <= '9') {
+		u8 digit = buf[i] - '0';
+		if (v > (UINT64_MAX - digit) / 10) {
+			*overflow = true;
+		} else {
+			v = v * 10 + digit;
+		}
+		i++;
+	}
+	*value = v;
+	return i;
+}
+
+// consumes the digits after the decimal point, appending them to mantissa
+// digits that no longer fit are dropped, truncated is set if any of them were not zero
+static inline int numberParseFraction(char *buf, int i, int len, u64 *mantissa, int *fractionDigits, bool *truncated)
+{
+	u64 m = *mantissa;
+	int digits = *fractionDigits;
+	while (i + 8 <= len && m < NUMBER_SWAR_LIMIT) {
+		u64 chunk = numberLoad8(buf + i);
+		if (!numberIsEightDigits(chunk)) break;
+		m = m * 100000000 + numberParseEightDigits(chunk);
+		digits += 8;
+		i += 8;
+	}
+	while (i < len && buf[i] >= '0' && buf[i] <= '9') {
+		u8 digit = buf[i] - '0';
+		if (m < NUMBER_DIGIT_LIMIT) {
+			m = m * 10 + digit;
+			digits++;
+		} else if (digit) {
+			*truncated = true;
+		}
+		i++;
+	}
+	*mantissa = m;
+	*fractionDigits = digits;
+	return i;
+}
+
+// parses the decimal float literal in buf[start, end) into a correctly rounded f64
+// mantissa * 10^-fractionDigits is exact when both operands are exactly representable, because IEEE division
+// rounds once (Clinger's fast path). everything else is handed to strtod, which rounds correctly
+static inline f64 numberToF64(char *buf, int start, int end, u64 mantissa, int fractionDigits, bool truncated)
+{
+	static const f64 powersOfTen[] = {
+		1e0,  1e1,	1e2,  1e3,	1e4,  1e5,	1e6,  1e7,	1e8,  1e9,	1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	if (!truncated && mantissa <= NUMBER_F64_EXACT_LIMIT && fractionDigits <= 22) {
+		return (f64)mantissa / powersOfTen[fractionDigits];
+	}
+
+	char small[64];
+	int len = end - start;
+	char *text = len < sizeof(small) ? small : malloc(len + 1);
+	memcpy(text, buf + start, len);
+	text[len] = '\0';
+	f64 value = strtod(text, NULL);
+	if (text != small) free(text);
+	return value;
+}
+
+#endif
@@ -1,30 +1,128 @@
+#include <number.h>
+#include <scan.h>
+#include <thread.h>
 #include <walc.h>
 
 typedef struct {
 	Str filename;
+	// see wlSourceFileAdd
+	u32 file;
 	Str source;
 	int index;
 	List(WlDiagnostic) diagnostics;
 } WlLexer;
 
-bool isDigit(char c) { return c >= '0' && c <= '9'; }
+// character classes used by the lexer, one table lookup per character
+enum {
+	WlChar_Whitespace = 1 << 0,
+	WlChar_Digit = 1 << 1,
+	WlChar_HexDigit = 1 << 2,
+	WlChar_Lowercase = 1 << 3,
+	WlChar_Symbol = 1 << 4,
+	WlChar_SymbolStart = 1 << 5,
+};
+
+#define __ 0
+#define WS WlChar_Whitespace
+#define DG (WlChar_Digit | WlChar_HexDigit | WlChar_Symbol)
+#define HX (WlChar_HexDigit | WlChar_Symbol | WlChar_SymbolStart)
+#define UP (WlChar_Symbol | WlChar_SymbolStart)
+#define LH (WlChar_Lowercase | WlChar_HexDigit | WlChar_Symbol | WlChar_SymbolStart)
+#define LO (WlChar_Lowercase | WlChar_Symbol | WlChar_SymbolStart)
+#define SY (WlChar_Symbol | WlChar_SymbolStart)
+static const u8 wlCharClass[256] = {
+	__, __, __, __, __, __, __, __, __, WS, WS, __, __, WS, __, __, // 0_
+	__, __, __, __, __, __, __, __, __, __, __, __, __, __, __, __, // 1_
+	WS, __, __, __, __, __, __, __, __, __, __, __, __, __, __, __, // 2_
+	DG, DG, DG, DG, DG, DG, DG, DG, DG, DG, __, __, __, __, __, __, // 3_
+	__, HX, HX, HX, HX, HX, HX, UP, UP, UP, UP, UP, UP, UP, UP, UP, // 4_
+	UP, UP, UP, UP, UP, UP, UP, UP, UP, UP, UP, __, __, __, __, SY, // 5_
+	SY, LH, LH, LH, LH, LH, LH, LO, LO, LO, LO, LO, LO, LO, LO, LO, // 6_
+	LO, LO, LO, LO, LO, LO, LO, LO, LO, LO, LO, __, __, __, __, __, // 7_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // 8_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // 9_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // A_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // B_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // C_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // D_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, // E_
+	SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, SY, __, // F_
+};
+#undef __
+#undef WS
+#undef DG
+#undef HX
+#undef UP
+#undef LH
+#undef LO
+#undef SY
+
+#define wlCharIs(c, class) (wlCharClass[(u8)(c)] & (class))
+
+bool isDigit(char c) { return wlCharIs(c, WlChar_Digit); }
 bool isBinaryDigit(char c) { return c == '0' || c == '1'; }
-bool isHexDigit(char c) { return isDigit(c) || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'); }
-bool isLowercaseLetter(char c) { return c >= 'a' && c <= 'z'; }
+bool isHexDigit(char c) { return wlCharIs(c, WlChar_HexDigit); }
+bool isLowercaseLetter(char c) { return wlCharIs(c, WlChar_Lowercase); }
 bool isUppercaseLetter(char c) { return c >= 'A' && c <= 'Z'; }
 bool isLetter(char c) { return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'); }
-bool isCompilerReserved(char c)
+bool isCompilerReserved(char c) { return !wlCharIs(c, WlChar_Symbol); }
+bool isSymbol(char c) { return wlCharIs(c, WlChar_Symbol); }
+bool isSymbolStart(char c) { return wlCharIs(c, WlChar_SymbolStart); }
+
+// perfect hash over the keyword set, generated offline
+// every keyword is at least 2 characters, so the first two are always in bounds
+#define WLKEYWORDHASH(s, len) (((u8)(s)[0] + (u8)(s)[1] * 52 + (len)) & 63)
+typedef struct {
+	Str text;
+	WlKind kind;
+} WlKeywordSlot;
+
+static const WlKeywordSlot wlKeywordSlots[64] = {
+	[1] = {{"enum", 4}, WlKind_KwEnum},
+	[3] = {{"in", 2}, WlKind_KwIn},
+	[6] = {{"inout", 5}, WlKind_KwInout},
+	[9] = {{"struct", 6}, WlKind_KwStruct},
+	[11] = {{"export", 6}, WlKind_KwExport},
+	[12] = {{"type", 4}, WlKind_KwType},
+	[15] = {{"break", 5}, WlKind_KwBreak},
+	[19] = {{"import", 6}, WlKind_KwImport},
+	[20] = {{"use", 3}, WlKind_KwUse},
+	[25] = {{"else", 4}, WlKind_KwElse},
+	[27] = {{"case", 4}, WlKind_KwCase},
+	[28] = {{"while", 5}, WlKind_KwWhile},
+	[31] = {{"false", 5}, WlKind_KwFalse},
+	[32] = {{"true", 4}, WlKind_KwTrue},
+	[35] = {{"if", 2}, WlKind_KwIf},
+	[37] = {{"switch", 6}, WlKind_KwSwitch},
+	[43] = {{"namespace", 9}, WlKind_KwNamespace},
+	[45] = {{"var", 3}, WlKind_KwVar},
+	[47] = {{"default", 7}, WlKind_KwDefault},
+	[50] = {{"do", 2}, WlKind_KwDo},
+	[51] = {{"let", 3}, WlKind_KwLet},
+	[53] = {{"for", 3}, WlKind_KwFor},
+	[54] = {{"out", 3}, WlKind_KwOut},
+	[55] = {{"continue", 8}, WlKind_KwContinue},
+	[60] = {{"return", 6}, WlKind_KwReturn},
+};
+
+// returns the keyword kind for the given identifier or WlKind_Symbol if it isn't one
+WlKind wlKeywordLookup(char *s, int len)
 {
-	return (c >= 0 && c <= 47) || (c >= 58 && c <= 64) || (c >= 91 && c <= 94) || (c >= 123 && c <= 127) || (c == 255);
+	if (len < 2) return WlKind_Symbol;
+	const WlKeywordSlot *slot = &wlKeywordSlots[WLKEYWORDHASH(s, len)];
+	if (slot->text.len != len || memcmp(slot->text.buf, s, len) != 0) return WlKind_Symbol;
+	return slot->kind;
 }
-bool isSymbol(char c) { return !isCompilerReserved(c); }
-bool isSymbolStart(char c) { return !isDigit(c) && !isCompilerReserved(c); }
 
+// the source must be followed by a zero byte, which the lexer uses to detect the end of the input
+// string literals, fileReadAllText and fileMapAllText all provide one
 WlLexer wlLexerCreate(Str filename, Str source)
 {
+	assert(source.buf && source.buf[source.len] == '\0');
 	if (strEqual(filename, STREMPTY)) filename = STR("<compiler generated source>");
 	return (WlLexer){
 		.filename = filename,
+		.file = wlSourceFileAdd(filename, source),
 		.source = source,
 		.index = 0,
 		.diagnostics = listNew(),
@@ -33,25 +131,30 @@ WlLexer wlLexerCreate(Str filename, Str source)
 
 void wlLexerFree(WlLexer *l) { listFree(&l->diagnostics); }
 
-char wlLexerCurrent(WlLexer *l) { return l->index < l->source.len ? l->source.buf[l->index] : '\0'; }
-char wlLexerLookahead(WlLexer *l, int n) { return l->index + n < l->source.len ? l->source.buf[l->index + n] : '\0'; }
+// no bounds checks needed thanks to the zero sentinel, lookahead is only used after a non zero current character
+char wlLexerCurrent(WlLexer *l) { return l->source.buf[l->index]; }
+char wlLexerLookahead(WlLexer *l, int n) { return l->source.buf[l->index + n]; }
 
 WlToken wlLexerBasic(WlLexer *l, int len, WlKind kind)
 {
-	WlSpan span = {.filename = l->filename, .source = l->source, .start = l->index, .len = len};
+	WlSpan span = {.file = l->file, .start = l->index, .len = len};
 	l->index += len;
 	return (WlToken){.kind = kind, .span = span};
 }
 
 void wlLexerTrim(WlLexer *l)
 {
-	while (isWhitespace(wlLexerCurrent(l)))
+	// most tokens are separated by a few bytes of whitespace, only go wide for longer runs like indentation
+	for (int i = 0; i < 8; i++) {
+		if (!wlCharIs(wlLexerCurrent(l), WlChar_Whitespace)) return;
 		l->index++;
+	}
+	l->index = scanSkipWhitespace(l->source.buf, l->index, l->source.len);
 }
 
 WlToken lexerReport(WlLexer *l, WlDiagnosticKind kind, int start, int end)
 {
-	WlSpan span = spanFromRange(l->filename, l->source, start, l->index);
+	WlSpan span = spanFromRange(l->file, start, l->index);
 	WlDiagnostic d = {.kind = kind, .span = span};
 	listPush(&l->diagnostics, d);
 	return (WlToken){.kind = WlKind_Bad, .span = span};
@@ -64,12 +167,7 @@ lexStart:
 
 	// skip single line comments
 	if (wlLexerCurrent(l) == '/' && wlLexerLookahead(l, 1) == '/') {
-		while (!isEndOfLine(wlLexerCurrent(l))) {
-			l->index++;
-		}
-		while (isNewline(wlLexerCurrent(l))) {
-			l->index++;
-		}
+		l->index = scanFindEndOfLine(l->source.buf, l->index + 2, l->source.len);
 		goto lexStart;
 	}
 	// skip multi line comments
@@ -77,6 +175,9 @@ lexStart:
 		int level = 0;
 		l->index += 2;
 		while (true) {
+			// jump straight to the next '/', '*' or end of input
+			l->index = scanFindCommentDelimiter(l->source.buf, l->index, l->source.len);
+
 			if (wlLexerCurrent(l) == '\0') {
 				return lexerReport(l, UnterminatedCommentDiagnostic, l->index - 2, l->index);
 			}
@@ -159,8 +260,7 @@ lexStart:
 		l->index++;
 		int start = l->index;
 
-		while (wlLexerCurrent(l) != '\0' && wlLexerCurrent(l) != '"')
-			l->index++;
+		l->index = scanFindStringEnd(l->source.buf, l->index, l->source.len);
 
 		if (wlLexerCurrent(l) == '\0') {
 			return lexerReport(l, UnterminatedStringDiagnostic, start, l->index);
@@ -169,7 +269,7 @@ lexStart:
 		l->index++;
 
 		return (WlToken){.kind = WlKind_String,
-						 .span = spanFromRange(l->filename, l->source, start - 1, l->index),
+						 .span = spanFromRange(l->file, start - 1, l->index),
 						 .valueStr = value};
 	} break;
 	case '0':
@@ -183,104 +283,78 @@ lexStart:
 	case '8':
 	case '9': {
 		int start = l->index;
-		int value = 0;
-		if (current == '0') {
-			switch (wlLexerLookahead(l, 1)) {
-			case 'x': {
-				l->index += 2;
-				while (isHexDigit(wlLexerCurrent(l))) {
-					char d = wlLexerCurrent(l);
-					u8 digitValue;
-					if (isLowercaseLetter(d))
-						digitValue = d - 'a' + 10;
-					else if (isUppercaseLetter(d))
-						digitValue = d - 'A' + 10;
-					else
-						digitValue = d - '0';
-
-					value <<= 4;
-					value += digitValue;
-					l->index++;
-				}
-			}
-			case 'b': {
-				l->index += 2;
-				while (isBinaryDigit(wlLexerCurrent(l))) {
-					u8 digitValue = wlLexerCurrent(l) - '0';
-					value <<= 1;
-					value += digitValue;
-					l->index++;
-				}
-			}
-			default: {
-				// matched 0
+		u64 value = 0;
+		bool overflow = false;
+		if (current == '0' && wlLexerLookahead(l, 1) == 'x') {
+			l->index += 2;
+			while (isHexDigit(wlLexerCurrent(l))) {
+				char d = wlLexerCurrent(l);
+				u8 digitValue;
+				if (isLowercaseLetter(d))
+					digitValue = d - 'a' + 10;
+				else if (isUppercaseLetter(d))
+					digitValue = d - 'A' + 10;
+				else
+					digitValue = d - '0';
+
+				if (value >> 60) overflow = true;
+				value = (value << 4) | digitValue;
 				l->index++;
-				goto floatTest;
 			}
-			}
-
-		} else {
-			while (isDigit(wlLexerCurrent(l))) {
+		} else if (current == '0' && wlLexerLookahead(l, 1) == 'b') {
+			l->index += 2;
+			while (isBinaryDigit(wlLexerCurrent(l))) {
 				u8 digitValue = wlLexerCurrent(l) - '0';
-				value *= 10;
-				value += digitValue;
+				if (value >> 63) overflow = true;
+				value = (value << 1) | digitValue;
 				l->index++;
 			}
-		floatTest:
+		} else {
+			l->index = numberParseDecimal(l->source.buf, l->index, l->source.len, &value, &overflow);
+
 			if (wlLexerCurrent(l) == '.') {
-				l->index++;
-				int floatDivisor = 1;
-				int floatValue;
-				while (isDigit(wlLexerCurrent(l))) {
-					u8 digitValue = wlLexerCurrent(l) - '0';
-					floatValue *= 10;
-					floatValue += digitValue;
-					l->index++;
-					floatDivisor *= 10;
-				}
-				f64 finalValue = value + (floatValue / (f64)floatDivisor);
+				// the integer part becomes the start of the mantissa, an overflowing one is simply left to strtod
+				int fractionDigits = 0;
+				bool truncated = overflow;
+				l->index = numberParseFraction(l->source.buf, l->index + 1, l->source.len, &value, &fractionDigits,
+											   &truncated);
 				return (WlToken){
 					.kind = WlKind_FloatNumber,
-					.valueFloat = finalValue,
-					.span = spanFromRange(l->filename, l->source, start, l->index),
+					.valueFloat = numberToF64(l->source.buf, start, l->index, value, fractionDigits, truncated),
+					.span = spanFromRange(l->file, start, l->index),
 				};
 			}
 		}
+
+		if (overflow) return lexerReport(l, IntegerLiteralOverflowDiagnostic, start, l->index);
+
 		return (WlToken){
 			.kind = WlKind_Number,
-			.valueNum = value,
-			.span = spanFromRange(l->filename, l->source, start, l->index),
+			.valueNum = (i64)value,
+			.span = spanFromRange(l->file, start, l->index),
 		};
 	} break;
 	default: {
-	unmatched : {
-	}
-		if (isLowercaseLetter(current)) {
-			for (int i = WlKind_Keywords_Start + 1; i < WlKind_Keywords_End; i++) {
-				// TODO: bake into Str's beforehand so we don't have to convert from cstr
-				Str keyword = strFromCstr(WlKindText[i]);
-				char afterKeyword = wlLexerLookahead(l, keyword.len);
-				if (strEqual(strSlice(l->source, l->index, keyword.len), keyword) && !isSymbol(afterKeyword)) {
-					int start = l->index;
-					l->index += keyword.len;
-					return (WlToken){
-						.kind = i,
-						.span = spanFromRange(l->filename, l->source, start, l->index),
-					};
-					break;
-				}
-			}
-		}
-
 		if (isSymbolStart(current)) {
 			int start = l->index;
-			while (isSymbol(wlLexerCurrent(l)))
-				l->index++;
+			l->index = scanSymbolRun(l->source.buf, start + 1, l->source.len);
+
+			WlKind kind = wlCharIs(current, WlChar_Lowercase)
+							  ? wlKeywordLookup(l->source.buf + start, l->index - start)
+							  : WlKind_Symbol;
+			if (kind != WlKind_Symbol) {
+				return (WlToken){
+					.kind = kind,
+					.span = spanFromRange(l->file, start, l->index),
+				};
+			}
+
 			Str symbolName = strSlice(l->source, start, l->index - start);
 			return (WlToken){
 				.kind = WlKind_Symbol,
+				.atom = wlIntern(symbolName),
 				.valueStr = symbolName,
-				.span = spanFromRange(l->filename, l->source, start, l->index),
+				.span = spanFromRange(l->file, start, l->index),
 			};
 		} else {
 			l->index++;
@@ -306,193 +380,601 @@ List(WlToken) wlLexerLexTokens(WlLexer *l)
 	return tokens;
 }
 
+// structure of arrays storage for a fully lexed file
+// the span of every token is stored as start/len into the source, the lexer's file and source are shared
+// strings get their value from the source text, symbols store their atom and numbers keep theirs in the literals
+// side table
 typedef struct {
-	WlToken expression;
-	WlToken semicolon;
-} WlExpressionStatement;
+	u32 file;
+	Str source;
+	int count;
+	int capacity;
+	u8 *kinds;
+	u32 *starts;
+	u32 *lens;
+	// atom for symbols, index into literals for numbers
+	u32 *values;
+	List(i64) literals;
+} WlTokenStore;
+
+void wlTokenStoreReserve(WlTokenStore *s, int capacity)
+{
+	s->kinds = realloc(s->kinds, capacity * sizeof(u8));
+	s->starts = realloc(s->starts, capacity * sizeof(u32));
+	s->lens = realloc(s->lens, capacity * sizeof(u32));
+	s->values = realloc(s->values, capacity * sizeof(u32));
+	if (!s->kinds || !s->starts || !s->lens || !s->values) PANIC("Failed to allocate token store");
+	s->capacity = capacity;
+}
 
-typedef struct {
-	WlToken returnKeyword;
-	WlToken expression;
-	WlToken semicolon;
-} WlReturnStatement;
+void wlTokenStorePush(WlTokenStore *s, WlToken t)
+{
+	if (s->count == s->capacity) wlTokenStoreReserve(s, s->capacity ? s->capacity * 2 : 64);
+
+	u32 value = 0;
+	if (t.kind == WlKind_Symbol) {
+		value = t.atom;
+	} else if (t.kind == WlKind_Number || t.kind == WlKind_FloatNumber) {
+		value = listLen(s->literals);
+		listPush(&s->literals, t.valueNum);
+	}
 
-typedef struct {
-	WlToken left;
-	WlToken operator;
-	WlToken right;
-} WlBinaryExpression;
+	s->kinds[s->count] = t.kind;
+	s->starts[s->count] = t.span.start;
+	s->lens[s->count] = t.span.len;
+	s->values[s->count] = value;
+	s->count++;
+}
 
-typedef struct {
-	WlToken operator;
-	WlToken expression;
-} WlPreUnaryExpression;
+// lexes all tokens up front into a token store
+// unlike wlLexerLexTokens the EOF token is stored, so lookahead past the end keeps returning EOF
+WlTokenStore wlLexerLexTokenStore(WlLexer *l)
+{
+	WlTokenStore s = {.file = l->file, .source = l->source};
 
-typedef struct {
-	WlToken expression;
-	WlToken operator;
-} WlPostUnaryExpression;
+	// rough guess to avoid most regrowing, sources average a token every 4 to 6 bytes
+	wlTokenStoreReserve(&s, l->source.len / 4 + 16);
 
-typedef struct {
-	WlToken condition;
-	WlToken question;
-	WlToken thenExpr;
-	WlToken colon;
-	WlToken elseExpr;
-} WlTernaryExpression;
+	while (true) {
+		WlToken t = wlLexerLexToken(l);
+		wlTokenStorePush(&s, t);
+		if (t.kind == WlKind_EOF) break;
+	}
 
-typedef struct {
-	WlToken variable;
-	WlToken equals;
-	WlToken expression;
-	WlToken semicolon;
-} WlAssignmentExpression;
+	return s;
+}
 
-typedef struct {
-	List(WlToken) path;
-	WlToken parenOpen;
-	List(WlToken) args;
-	WlToken parenClose;
-} WlSyntaxCall;
+// index of the first token that starts at or after offset
+int wlTokenStoreFind(WlTokenStore *s, u32 offset)
+{
+	int low = 0;
+	int high = s->count;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (s->starts[mid] < offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	return low;
+}
 
-typedef struct {
-	WlToken at;
-	List(WlToken) path;
-	WlToken parenOpen;
-	List(WlToken) args;
-	WlToken parenClose;
-} WlSyntaxNote;
+static inline int wlTokenStoreLen(WlTokenStore *s) { return s->count; }
 
-typedef struct {
-	WlToken curlyOpen;
-	List(WlToken) statements;
-	WlToken curlyClose;
-} WlSyntaxBlock;
+// materializes the token at the given index
+WlToken wlTokenStoreGet(WlTokenStore *s, int index)
+{
+	WlKind kind = s->kinds[index];
+	WlToken t = {
+		.kind = kind,
+		.span = {.file = s->file, .start = s->starts[index], .len = s->lens[index]},
+	};
+
+	switch (kind) {
+	case WlKind_Symbol:
+		t.atom = s->values[index];
+		t.valueStr = strSlice(s->source, t.span.start, t.span.len);
+		break;
+	case WlKind_String: t.valueStr = strSlice(s->source, t.span.start + 1, t.span.len - 2); break;
+	case WlKind_Number:
+	case WlKind_FloatNumber: t.valueNum = s->literals[s->values[index]]; break;
+	default: break;
+	}
+
+	return t;
+}
+
+void wlTokenStoreFree(WlTokenStore *s)
+{
+	free(s->kinds);
+	free(s->starts);
+	free(s->lens);
+	free(s->values);
+	listFree(&s->literals);
+	*s = (WlTokenStore){0};
+}
+
+// flat syntax tree
+// nodes live in parallel arrays and are addressed by their index, node 0 is the missing node
+// the meaning of a node's data depends on its kind, see the layout table below
+// nodes with more than two children, or a variable number of them, keep them in the shared extra array
+//
+// kind                         lhs                               rhs
+// Symbol                       atom
+// Number, FloatNumber          valueNum / valueFloat (both words)
+// String, KwTrue, KwFalse      (value comes from the span)
+// StRef, StBlock               range: atoms of the path / statement nodes in extra
+// StLazyBlock                  token index of '{'                token index after '}' 
+// StCall, StNote               path (StRef)                      extra: args.start, args.len
+// StFunction, StImport         extra: notes.start, notes.len,    body (StBlock, functions only)
+//                                     type, name, params.start, params.len
+// StFunctionParameter          type (Symbol)                     name (Symbol)
+// StNamespace                  path (StRef)                      body (StBlock)
+// StUse                        path (StRef)
+// StVariableDeclaration        extra: type, name                 initializer
+// StVariableAssignement        variable (Symbol)                 expression
+// StExpressionStatement        expression
+// StReturnStatement            expression
+// StParenthesizedExpression    expression
+// StBinaryExpression           left                              right, op is the operator
+// StPreUnary, StPostUnary      expression                        op is the operator
+// StTernaryExpression          condition                         extra: then, else
+// StIf                         condition                         extra: then, else
+// StDo                         block
+// StWhile                      condition                         block
+// StDoWhile                    block                             condition
+// StFor                        extra: pre, condition, post,      block
+//                                     notes.start, notes.len
+// Bad                          a bad token has no data, a function that failed to parse keeps the function layout
+typedef u32 WlNode;
+#define WLNODEMISSING 0
 
 typedef struct {
-	WlToken type;
-	WlToken name;
-} WlSyntaxParameter;
+	u32 start;
+	u32 len;
+} WlNodeRange;
+
+typedef union {
+	struct {
+		u32 lhs;
+		u32 rhs;
+	};
+	WlNodeRange range;
+	i64 valueNum;
+	f64 valueFloat;
+} WlNodeData;
 
 typedef struct {
-	List(WlToken) notes;
-	WlToken export;
-	WlToken type;
-	WlToken name;
-	WlToken parenOpen;
-	List(WlToken) parameterList;
-	WlToken parenClose;
-	WlSyntaxBlock body;
-} WlSyntaxFunction;
+	u32 file;
+	Str source;
+	int count;
+	int capacity;
+	u8 *kinds;
+	// operator kind for expressions, WlKind_KwExport for exported functions
+	u8 *ops;
+	WlNodeRange *spans;
+	WlNodeData *data;
+	List(u32) extra;
+} WlAst;
+
+void wlAstReserve(WlAst *ast, int capacity)
+{
+	ast->kinds = realloc(ast->kinds, capacity * sizeof(u8));
+	ast->ops = realloc(ast->ops, capacity * sizeof(u8));
+	ast->spans = realloc(ast->spans, capacity * sizeof(WlNodeRange));
+	ast->data = realloc(ast->data, capacity * sizeof(WlNodeData));
+	if (!ast->kinds || !ast->ops || !ast->spans || !ast->data) PANIC("Failed to allocate syntax tree");
+	ast->capacity = capacity;
+}
+
+WlNode wlAstPush(WlAst *ast, WlKind kind, WlKind op, u32 start, u32 end, WlNodeData data)
+{
+	if (ast->count == ast->capacity) wlAstReserve(ast, ast->capacity ? ast->capacity * 2 : 256);
+	WlNode n = ast->count++;
+	ast->kinds[n] = kind;
+	ast->ops[n] = op;
+	ast->spans[n] = (WlNodeRange){start, end - start};
+	ast->data[n] = data;
+	return n;
+}
+
+WlAst wlAstCreate(u32 file, Str source)
+{
+	WlAst ast = {.file = file, .source = source, .extra = listNew()};
+	wlAstPush(&ast, WlKind_Missing, 0, 0, 0, (WlNodeData){0});
+	return ast;
+}
+
+void wlAstFree(WlAst *ast)
+{
+	free(ast->kinds);
+	free(ast->ops);
+	free(ast->spans);
+	free(ast->data);
+	listFree(&ast->extra);
+	*ast = (WlAst){0};
+}
+
+// appends count words to the extra array and returns the index of the first one
+u32 wlAstPushExtra(WlAst *ast, int count, u32 *values)
+{
+	u32 start = listLen(ast->extra);
+	for (int i = 0; i < count; i++) {
+		listPush(&ast->extra, values[i]);
+	}
+	return start;
+}
+
+static inline WlKind wlAstKind(WlAst *ast, WlNode n) { return ast->kinds[n]; }
+static inline WlNodeData wlAstData(WlAst *ast, WlNode n) { return ast->data[n]; }
+static inline WlNode wlAstChild(WlAst *ast, WlNodeRange r, int i) { return ast->extra[r.start + i]; }
+
+WlSpan wlAstSpan(WlAst *ast, WlNode n)
+{
+	WlNodeRange r = ast->spans[n];
+	return (WlSpan){.file = ast->file, .start = r.start, .len = r.len};
+}
+
+WlAtom wlAstAtom(WlAst *ast, WlNode n)
+{
+	assert(ast->kinds[n] == WlKind_Symbol);
+	return ast->data[n].lhs;
+}
+
+Str wlAstString(WlAst *ast, WlNode n)
+{
+	assert(ast->kinds[n] == WlKind_String);
+	WlNodeRange r = ast->spans[n];
+	return strSlice(ast->source, r.start + 1, r.len - 2);
+}
+
+// path atoms of a reference
+WlAtom *wlAstPath(WlAst *ast, WlNode ref, int *len)
+{
+	assert(ast->kinds[ref] == WlKind_StRef);
+	WlNodeRange r = ast->data[ref].range;
+	*len = r.len;
+	return ast->extra + r.start;
+}
+
+// views that decode a node into its named children
 
 typedef struct {
-	List(WlToken) notes;
-	WlToken namespace;
-	List(WlToken) path;
-	WlSyntaxBlock body;
-} WlSyntaxNamespace;
+	WlNode left;
+	WlKind operator;
+	WlNode right;
+} WlBinaryExpression;
 
 typedef struct {
-	List(WlToken) notes;
-	WlToken use;
-	List(WlToken) path;
-	WlToken semicolon;
-} WlSyntaxUse;
+	WlKind operator;
+	WlNode expression;
+} WlUnaryExpression;
 
 typedef struct {
-	WlToken ifKeyword;
-	WlToken condition;
-	WlSyntaxBlock thenBlock;
-	WlToken elseKeyword;
-	WlSyntaxBlock elseBlock;
-} WlSyntaxIf;
+	WlNode condition;
+	WlNode thenExpr;
+	WlNode elseExpr;
+} WlTernaryExpression;
 
 typedef struct {
-	WlToken parenOpen;
-	WlToken expr;
-	WlToken parenClose;
-} WlParenthesizedExpression;
+	WlNode path;
+	WlNodeRange args;
+} WlSyntaxCall;
+
 typedef struct {
-	WlToken doKeyword;
-	WlSyntaxBlock block;
-} WlSyntaxDo;
+	WlNodeRange notes;
+	bool export;
+	WlNode type;
+	WlNode name;
+	WlNodeRange parameters;
+	WlNode body;
+} WlSyntaxFunction;
 
 typedef struct {
-	WlToken whileKeyword;
-	WlToken condition;
-	WlSyntaxBlock block;
-} WlSyntaxWhile;
+	WlNode type;
+	WlNode name;
+	WlNode initializer;
+} WlSyntaxVariableDeclaration;
 
 typedef struct {
-	WlToken doKeyword;
-	WlSyntaxBlock block;
-	WlToken whileKeyword;
-	WlToken condition;
-	WlToken semicolon;
-} WlSyntaxDoWhile;
+	WlNode condition;
+	WlNode thenBlock;
+	WlNode elseBlock;
+} WlSyntaxIf;
 
 typedef struct {
-	WlToken forKeyword;
-	WlToken preCondition;
-	WlToken semicolon;
-	WlToken condition;
-	WlToken semicolon2;
-	WlToken postCondition;
-	WlSyntaxBlock block;
+	WlNode preCondition;
+	WlNode condition;
+	WlNode postCondition;
+	WlNode block;
+	WlNodeRange notes;
 } WlSyntaxFor;
 
-typedef struct {
-	List(WlToken) notes;
-	WlToken import;
-	WlToken type;
-	WlToken name;
-	WlToken parenOpen;
-	List(WlToken) parameterList;
-	WlToken parenClose;
-	WlToken semicolon;
-} WlSyntaxImport;
+WlBinaryExpression wlAstBinary(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	return (WlBinaryExpression){.left = d.lhs, .operator= ast->ops[n], .right = d.rhs};
+}
 
-typedef struct {
-	WlToken export;
-	WlToken type;
-	WlToken name;
-	WlToken equals;
-	WlToken initializer;
-	WlToken semicolon;
-} WlSyntaxVariableDeclaration;
+WlUnaryExpression wlAstUnary(WlAst *ast, WlNode n)
+{
+	return (WlUnaryExpression){.operator= ast->ops[n], .expression = ast->data[n].lhs};
+}
+
+WlTernaryExpression wlAstTernary(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	return (WlTernaryExpression){.condition = d.lhs, .thenExpr = ast->extra[d.rhs], .elseExpr = ast->extra[d.rhs + 1]};
+}
+
+// also used for notes, which share the layout
+WlSyntaxCall wlAstCall(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	return (WlSyntaxCall){.path = d.lhs, .args = {ast->extra[d.rhs], ast->extra[d.rhs + 1]}};
+}
+
+// also used for imports, which share the layout but have no body
+WlSyntaxFunction wlAstFunction(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	u32 *e = ast->extra + d.lhs;
+	return (WlSyntaxFunction){
+		.notes = {e[0], e[1]},
+		.export = ast->ops[n] == WlKind_KwExport,
+		.type = e[2],
+		.name = e[3],
+		.parameters = {e[4], e[5]},
+		.body = d.rhs,
+	};
+}
+
+WlSyntaxVariableDeclaration wlAstVariableDeclaration(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	return (WlSyntaxVariableDeclaration){
+		.type = ast->extra[d.lhs],
+		.name = ast->extra[d.lhs + 1],
+		.initializer = d.rhs,
+	};
+}
+
+WlSyntaxIf wlAstIf(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	return (WlSyntaxIf){.condition = d.lhs, .thenBlock = ast->extra[d.rhs], .elseBlock = ast->extra[d.rhs + 1]};
+}
+
+WlSyntaxFor wlAstFor(WlAst *ast, WlNode n)
+{
+	WlNodeData d = ast->data[n];
+	u32 *e = ast->extra + d.lhs;
+	return (WlSyntaxFor){
+		.preCondition = e[0],
+		.condition = e[1],
+		.postCondition = e[2],
+		.block = d.rhs,
+		.notes = {e[3], e[4]},
+	};
+}
+
+// moves the indices held by nodes [first, ast->count) and by their extra words
+// nodes that are not missing move by nodeShift, extra indices move by extraShift
+static void wlAstRelocate(WlAst *ast, int first, int nodeShift, u32 extraShift)
+{
+#define MOVE(n) ((n) = (n) == WLNODEMISSING ? WLNODEMISSING : (n) + nodeShift)
+// empty ranges are always {0, 0}, so they stay put
+#define MOVERANGE(start, len)                                                                                          \
+	do {                                                                                                               \
+		if ((len) == 0) break;                                                                                         \
+		(start) += extraShift;                                                                                         \
+		for (u32 i = 0; i < (len); i++)                                                                                \
+			MOVE(ast->extra[(start) + i]);                                                                             \
+	} while (0)
+
+	for (int n = first; n < ast->count; n++) {
+		WlNodeData *d = &ast->data[n];
+		switch (ast->kinds[n]) {
+		case WlKind_StRef:
+			if (d->range.len) d->range.start += extraShift;
+			break;
+		case WlKind_StBlock: MOVERANGE(d->range.start, d->range.len); break;
+		case WlKind_StCall:
+		case WlKind_StNote: {
+			MOVE(d->lhs);
+			d->rhs += extraShift;
+			u32 *e = ast->extra + d->rhs;
+			MOVERANGE(e[0], e[1]);
+		} break;
+		case WlKind_Bad:
+			// bad tokens have no data
+			if (d->rhs == WLNODEMISSING) break;
+		case WlKind_StFunction:
+		case WlKind_StImport: {
+			d->lhs += extraShift;
+			MOVE(d->rhs);
+			u32 *e = ast->extra + d->lhs;
+			MOVERANGE(e[0], e[1]);
+			MOVE(e[2]);
+			MOVE(e[3]);
+			MOVERANGE(e[4], e[5]);
+		} break;
+		case WlKind_StTernaryExpression:
+		case WlKind_StIf:
+			MOVE(d->lhs);
+			d->rhs += extraShift;
+			MOVE(ast->extra[d->rhs]);
+			MOVE(ast->extra[d->rhs + 1]);
+			break;
+		case WlKind_StVariableDeclaration:
+			d->lhs += extraShift;
+			MOVE(d->rhs);
+			MOVE(ast->extra[d->lhs]);
+			MOVE(ast->extra[d->lhs + 1]);
+			break;
+		case WlKind_StFor: {
+			d->lhs += extraShift;
+			MOVE(d->rhs);
+			u32 *e = ast->extra + d->lhs;
+			for (int i = 0; i < 3; i++)
+				MOVE(e[i]);
+			MOVERANGE(e[3], e[4]);
+		} break;
+		case WlKind_StDo:
+		case WlKind_StUse:
+		case WlKind_StExpressionStatement:
+		case WlKind_StReturnStatement:
+		case WlKind_StParenthesizedExpression:
+		case WlKind_StPreUnary:
+		case WlKind_StPostUnary: MOVE(d->lhs); break;
+		case WlKind_StNamespace:
+		case WlKind_StWhile:
+		case WlKind_StDoWhile:
+		case WlKind_StFunctionParameter:
+		case WlKind_StVariableAssignement:
+		case WlKind_StBinaryExpression:
+			MOVE(d->lhs);
+			MOVE(d->rhs);
+			break;
+		// lazy blocks hold token indices, everything else is a leaf
+		default: assert(ast->kinds[n] < WlKind_Syntax_Start || ast->kinds[n] == WlKind_StLazyBlock); break;
+		}
+	}
+#undef MOVERANGE
+#undef MOVE
+}
+
+// appends every node of src except the missing node to dst
+// returns how far the node indices of src moved, so the caller can translate its own references to them
+int wlAstAppend(WlAst *dst, WlAst *src)
+{
+	int first = dst->count;
+	int nodeShift = first - 1;
+	int count = src->count - 1;
+	if (first + count > dst->capacity) wlAstReserve(dst, max(first + count, dst->capacity * 2));
+	memcpy(dst->kinds + first, src->kinds + 1, count * sizeof(u8));
+	memcpy(dst->ops + first, src->ops + 1, count * sizeof(u8));
+	memcpy(dst->spans + first, src->spans + 1, count * sizeof(WlNodeRange));
+	memcpy(dst->data + first, src->data + 1, count * sizeof(WlNodeData));
+	dst->count += count;
+
+	u32 extraShift = listLen(dst->extra);
+	int extraCount = listLen(src->extra);
+	if (extraCount) {
+		int needed = extraShift + extraCount + 1;
+		if (listCapacity(dst->extra) < needed) listReserve(&dst->extra, max(needed, listCapacity(dst->extra) * 2));
+		memcpy(dst->extra + extraShift, src->extra, extraCount * sizeof(u32));
+		LISTHEAD(dst->extra)->len += extraCount;
+	}
+
+	wlAstRelocate(dst, first, nodeShift, extraShift);
+	return nodeShift;
+}
 
 #define PARSERMAXLOOKAHEAD 8
+// top-level declarations are handed to the workers of a parallel parse in chunks of about this many tokens
+#define PARSERCHUNKTOKENS 16384
+
+typedef enum
+{
+	WlParserDefault = 0,
+	// lex on demand into the lookahead ring buffer instead of lexing the whole file up front
+	WlParserStreaming = 1,
+	// only brace match function bodies, they are parsed once the binder reaches them with wlParseLazyBlock
+	// requires the token store, so it is ignored when streaming
+	WlParserLazyBodies = 2,
+	// parse the top-level declarations of large files on all cores, see wlParseParallel
+	// requires the token store, so it is ignored when streaming
+	WlParserParallel = 4,
+} WlParserOptions;
 
 typedef struct {
 	WlLexer lexer;
-	List(WlToken) topLevelDeclarations;
+	WlAst ast;
+	List(WlNode) topLevelDeclarations;
 	List(WlDiagnostic) diagnostics;
-	ArenaAllocator arena;
+	bool streaming;
+	bool lazyBodies;
+	bool parallel;
+	WlTokenStore tokenStore;
+	int tokenCursor;
+	// the token store is read as if it ended with EOF at this index, which lets workers parse a part of it
+	int tokenEnd;
 	WlToken tokens[PARSERMAXLOOKAHEAD];
 	int tokenIndex;
 	int lookaheadCount;
+	// end of the last taken token, nodes span from their first token up to here
+	u32 lastTokenEnd;
+	// children of the lists being parsed, moved to the extra array once a list is complete
+	List(u32) scratch;
 	bool sectionStart;
-	List(WlToken) notes;
+	WlNodeRange notes;
+	// wlParserReparse leaves replaced nodes behind, past this many nodes it parses the whole file again
+	int reparseNodeLimit;
+	// set once wlParseBodyLazily found no closing brace before tokenEnd and parsed the body right away
+	// wlParserReparse parses the whole file again after that, an edit anywhere further on could close the body
+	bool unclosedBody;
 } WlParser;
 
-WlParser wlParserCreate(Str filename, Str source)
+WlParser wlParserCreateWithOptions(Str filename, Str source, WlParserOptions options)
 {
 	WlLexer l = wlLexerCreate(filename, source);
-	return (WlParser){
+	bool streaming = options & WlParserStreaming;
+	WlParser p = (WlParser){
 		.lexer = l,
+		.ast = wlAstCreate(l.file, source),
 		.topLevelDeclarations = listNew(),
 		.diagnostics = listNew(),
-		.notes = listNew(),
-		.arena = arenaCreate(),
+		.scratch = listNew(),
+		.streaming = streaming,
+		.lazyBodies = !streaming && (options & WlParserLazyBodies),
+		.parallel = !streaming && (options & WlParserParallel),
+		.tokenCursor = 0,
 		.tokens = {0},
 		.lookaheadCount = 0,
 		.tokenIndex = 0,
 	};
+	if (!streaming) {
+		p.tokenStore = wlLexerLexTokenStore(&p.lexer);
+		p.tokenEnd = wlTokenStoreLen(&p.tokenStore) - 1;
+	}
+	return p;
+}
+
+WlParser wlParserCreate(Str filename, Str source)
+{
+	return wlParserCreateWithOptions(filename, source, WlParserDefault);
+}
+WlParser wlParserCreateStreaming(Str filename, Str source)
+{
+	return wlParserCreateWithOptions(filename, source, WlParserStreaming);
+}
+WlParser wlParserCreateLazy(Str filename, Str source)
+{
+	return wlParserCreateWithOptions(filename, source, WlParserLazyBodies);
+}
+
+static inline int wlParserStoreIndex(WlParser *p, int amount)
+{
+	int index = p->tokenCursor + amount;
+	return index < p->tokenEnd ? index : p->tokenEnd;
 }
 
 WlToken wlParserLookahead(WlParser *p, int amount)
 {
 	assert(amount <= PARSERMAXLOOKAHEAD);
+	if (!p->streaming) {
+		int index = wlParserStoreIndex(p, amount);
+		WlToken t = wlTokenStoreGet(&p->tokenStore, index);
+		if (index == p->tokenEnd) {
+			// the end of a worker's part of the store reads as an EOF in front of the next token
+			t.kind = WlKind_EOF;
+			t.span.len = 0;
+		}
+		return t;
+	}
+
 	while (amount >= p->lookaheadCount) {
 		int index = (p->tokenIndex + p->lookaheadCount) % PARSERMAXLOOKAHEAD;
 		p->lookaheadCount++;
@@ -501,11 +983,34 @@ WlToken wlParserLookahead(WlParser *p, int amount)
 	return p->tokens[(p->tokenIndex + amount) % PARSERMAXLOOKAHEAD];
 }
 
+// like wlParserLookahead but only reads the kind, so nothing needs to be materialized
+WlKind wlParserLookaheadKind(WlParser *p, int amount)
+{
+	if (!p->streaming) {
+		int index = p->tokenCursor + amount;
+		return index < p->tokenEnd ? p->tokenStore.kinds[index] : WlKind_EOF;
+	}
+	return wlParserLookahead(p, amount).kind;
+}
+
 WlToken wlParserPeek(WlParser *p) { return wlParserLookahead(p, 0); }
+WlKind wlParserPeekKind(WlParser *p) { return wlParserLookaheadKind(p, 0); }
+
+// source offset of the next token, which is where a node that starts with it begins
+u32 wlParserPeekStart(WlParser *p)
+{
+	if (!p->streaming) return p->tokenStore.starts[wlParserStoreIndex(p, 0)];
+	return wlParserLookahead(p, 0).span.start;
+}
 
 WlToken wlParserTake(WlParser *p)
 {
-	WlToken t = wlParserLookahead(p, 0); // p->hasToken ? p->current : wlLexerLexToken(&p->lexer);
+	WlToken t = wlParserLookahead(p, 0);
+	p->lastTokenEnd = t.span.start + t.span.len;
+	if (!p->streaming) {
+		if (t.kind != WlKind_EOF) p->tokenCursor++;
+		return t;
+	}
 	p->lookaheadCount--;
 	p->tokenIndex = (p->tokenIndex + 1) % PARSERMAXLOOKAHEAD;
 	return t;
@@ -517,8 +1022,8 @@ WlToken parserReport(WlParser *p, WlDiagnosticKind kind, WlToken t, WlKind expec
 		WlDiagnostic d = {.kind = kind, .span = t.span, .kind1 = t.kind, .kind2 = expected};
 		listPush(&p->diagnostics, d);
 		t.kind = WlKind_Bad;
-		return t;
 	}
+	return t;
 }
 
 WlToken wlParserMatch_impl(WlParser *p, WlKind kind, const char *file, int line)
@@ -533,7 +1038,44 @@ WlToken wlParserMatch_impl(WlParser *p, WlKind kind, const char *file, int line)
 }
 #define wlParserMatch(p, k) wlParserMatch_impl(p, k, __FILE__, __LINE__)
 
-void wlParserAddTopLevelStatement(WlParser *p, WlToken tk) { listPush(&p->topLevelDeclarations, tk); }
+// adds a node spanning from start to the end of the last taken token
+WlNode wlParserNode(WlParser *p, WlKind kind, WlKind op, u32 start, WlNodeData data)
+{
+	return wlAstPush(&p->ast, kind, op, start, p->lastTokenEnd, data);
+}
+
+// turns a token into a leaf node
+WlNode wlParserLeaf(WlParser *p, WlToken t)
+{
+	WlNodeData data = {0};
+	switch (t.kind) {
+	case WlKind_Missing: return WLNODEMISSING;
+	case WlKind_Symbol: data.lhs = t.atom; break;
+	case WlKind_Number: data.valueNum = t.valueNum; break;
+	case WlKind_FloatNumber: data.valueFloat = t.valueFloat; break;
+	default: break;
+	}
+	return wlAstPush(&p->ast, t.kind, 0, t.span.start, t.span.start + t.span.len, data);
+}
+
+WlNode wlParserMatchLeaf(WlParser *p, WlKind kind) { return wlParserLeaf(p, wlParserMatch(p, kind)); }
+
+// children of a list are collected on the scratch stack, because nested lists are parsed in between
+// once the list is complete they are moved to the extra array in one go, empty lists are always {0, 0}
+static inline int wlParserListStart(WlParser *p) { return listLen(p->scratch); }
+
+static inline void wlParserListPush(WlParser *p, u32 child) { listPush(&p->scratch, child); }
+
+WlNodeRange wlParserListEnd(WlParser *p, int listStart)
+{
+	int len = listLen(p->scratch) - listStart;
+	if (len == 0) return (WlNodeRange){0};
+	WlNodeRange range = {.start = wlAstPushExtra(&p->ast, len, p->scratch + listStart), .len = len};
+	LISTHEAD(p->scratch)->len = listStart;
+	return range;
+}
+
+void wlParserAddTopLevelStatement(WlParser *p, WlNode n) { listPush(&p->topLevelDeclarations, n); }
 
 typedef enum
 {
@@ -541,196 +1083,142 @@ typedef enum
 	BlockParseDeclarations = 1,
 } BlockParseOptions;
 
-WlToken wlParseDeclaration(WlParser *p, bool topLevel);
-WlToken wlParseExpression(WlParser *p);
-WlToken wlParseUse(WlParser *p);
-WlSyntaxBlock wlParseBlock(WlParser *p, BlockParseOptions options);
+WlNode wlParseDeclaration(WlParser *p, bool topLevel);
+WlNode wlParseExpression(WlParser *p);
+WlNode wlParseUse(WlParser *p);
+WlNode wlParseBlock(WlParser *p, BlockParseOptions options);
 
-WlToken wlParseParameter(WlParser *p)
+WlNode wlParseParameter(WlParser *p)
 {
-	WlSyntaxParameter param;
-	param.type = wlParserMatch(p, WlKind_Symbol);
-	param.name = wlParserMatch(p, WlKind_Symbol);
-
-	WlSyntaxParameter *paramp = arenaMalloc(sizeof(WlSyntaxParameter), &p->arena);
-	*paramp = param;
-	return (WlToken){
-		.kind = WlKind_StFunctionParameter,
-		.valuePtr = paramp,
-		.span = spanFromTokens(param.type, param.name),
-	};
+	u32 start = wlParserPeekStart(p);
+	WlNode type = wlParserMatchLeaf(p, WlKind_Symbol);
+	WlNode name = wlParserMatchLeaf(p, WlKind_Symbol);
+	return wlParserNode(p, WlKind_StFunctionParameter, 0, start, (WlNodeData){.lhs = type, .rhs = name});
 }
 
-List(WlToken) wlParseParameterList(WlParser *p)
+WlNodeRange wlParseParameterList(WlParser *p)
 {
-	List(WlToken) list = listNew();
+	int list = wlParserListStart(p);
 
 	while (true) {
-		if (wlParserPeek(p).kind != WlKind_Symbol) break;
-		WlToken param = wlParseParameter(p);
-		listPush(&list, param);
+		if (wlParserPeekKind(p) != WlKind_Symbol) break;
+		WlNode param = wlParseParameter(p);
+		wlParserListPush(p, param);
 
-		if (wlParserPeek(p).kind != WlKind_TkComma) break;
-		WlToken delim = wlParserMatch(p, WlKind_TkComma);
-		listPush(&list, delim);
+		if (wlParserPeekKind(p) != WlKind_TkComma) break;
+		wlParserMatch(p, WlKind_TkComma);
 	}
-	return list;
+	return wlParserListEnd(p, list);
 }
 
-List(WlToken) wlParseArgumentList(WlParser *p)
+WlNodeRange wlParseArgumentList(WlParser *p)
 {
-	List(WlToken) list = listNew();
+	int list = wlParserListStart(p);
 
 	while (true) {
-		if (wlParserPeek(p).kind == WlKind_TkParenClose) break;
-		WlToken arg = wlParseExpression(p);
-		listPush(&list, arg);
+		if (wlParserPeekKind(p) == WlKind_TkParenClose) break;
+		WlNode arg = wlParseExpression(p);
+		wlParserListPush(p, arg);
 
-		if (wlParserPeek(p).kind != WlKind_TkComma) break;
-		WlToken delim = wlParserMatch(p, WlKind_TkComma);
-		listPush(&list, delim);
+		if (wlParserPeekKind(p) != WlKind_TkComma) break;
+		wlParserMatch(p, WlKind_TkComma);
 	}
-	return list;
+	return wlParserListEnd(p, list);
 }
 
-List(WlToken) wlParseReferencePath(WlParser *p)
+// a reference only needs the names along its path, so it stores atoms instead of symbol nodes
+WlNode wlParseReferencePath(WlParser *p)
 {
-	List(WlToken) path = listNew();
+	u32 start = wlParserPeekStart(p);
+	int list = wlParserListStart(p);
 
 	while (true) {
 		WlToken segment = wlParserMatch(p, WlKind_Symbol);
-		listPush(&path, segment);
+		wlParserListPush(p, segment.atom);
 
-		if (wlParserPeek(p).kind != WlKind_TkDot) break;
-		WlToken delim = wlParserMatch(p, WlKind_TkDot);
-		listPush(&path, delim);
+		if (wlParserPeekKind(p) != WlKind_TkDot) break;
+		wlParserMatch(p, WlKind_TkDot);
 	}
-	return path;
+	WlNodeRange path = wlParserListEnd(p, list);
+	return wlParserNode(p, WlKind_StRef, 0, start, (WlNodeData){.range = path});
 }
 
-WlToken parseNote(WlParser *p)
+// the path is followed by optional arguments: foo.bar(args)
+WlNode wlParseCallTail(WlParser *p, WlKind kind, u32 start, WlNode path)
 {
-	WlSyntaxNote *note = arenaMalloc(sizeof(WlSyntaxNote), &p->arena);
-	WlToken last;
-	note->at = wlParserMatch(p, WlKind_TkAt);
-	note->path = wlParseReferencePath(p);
-	if (wlParserPeek(p).kind == WlKind_TkParenOpen) {
-		note->parenOpen = wlParserMatch(p, WlKind_TkParenOpen);
-		note->args = wlParseArgumentList(p);
-		note->parenClose = wlParserMatch(p, WlKind_TkParenClose);
-		last = note->parenClose;
-	} else {
-		last = note->path[listLen(note->path) - 1];
+	WlNodeRange args = {0};
+	if (wlParserPeekKind(p) == WlKind_TkParenOpen) {
+		wlParserMatch(p, WlKind_TkParenOpen);
+		args = wlParseArgumentList(p);
+		wlParserMatch(p, WlKind_TkParenClose);
 	}
+	u32 extra = wlAstPushExtra(&p->ast, 2, (u32[]){args.start, args.len});
+	return wlParserNode(p, kind, 0, start, (WlNodeData){.lhs = path, .rhs = extra});
+}
 
-	return (WlToken){
-		.kind = WlKind_StNote,
-		.valuePtr = note,
-		.span = spanFromTokens(note->at, last),
-	};
+WlNode parseNote(WlParser *p)
+{
+	u32 start = wlParserPeekStart(p);
+	wlParserMatch(p, WlKind_TkAt);
+	WlNode path = wlParseReferencePath(p);
+	return wlParseCallTail(p, WlKind_StNote, start, path);
 }
 
-List(WlToken) parseNotes(WlParser *p)
+WlNodeRange parseNotes(WlParser *p)
 {
-	List(WlToken) notes = listNew();
-	while (wlParserPeek(p).kind == WlKind_TkAt) {
-		WlToken note = parseNote(p);
-		listPush(&notes, note);
+	int list = wlParserListStart(p);
+	while (wlParserPeekKind(p) == WlKind_TkAt) {
+		WlNode note = parseNote(p);
+		wlParserListPush(p, note);
 	}
-	return notes;
+	return wlParserListEnd(p, list);
 }
 
-WlToken wlParsePrimaryExpression(WlParser *p)
+WlNode wlParsePrimaryExpression(WlParser *p)
 {
-	switch (wlParserPeek(p).kind) {
+	u32 start = wlParserPeekStart(p);
+
+	switch (wlParserPeekKind(p)) {
 
 	case WlKind_TkParenOpen: {
-		WlParenthesizedExpression pr = {0};
-		pr.parenOpen = wlParserMatch(p, WlKind_TkParenOpen);
-		pr.expr = wlParseExpression(p);
-		pr.parenOpen = wlParserMatch(p, WlKind_TkParenClose);
-
-		WlParenthesizedExpression *prp = arenaMalloc(sizeof(WlParenthesizedExpression), &p->arena);
-		*prp = pr;
-		return (WlToken){.kind = WlKind_StParenthesizedExpression,
-						 .valuePtr = prp,
-						 .span = spanFromTokens(pr.parenOpen, pr.parenClose)};
+		wlParserMatch(p, WlKind_TkParenOpen);
+		WlNode expr = wlParseExpression(p);
+		wlParserMatch(p, WlKind_TkParenClose);
+		return wlParserNode(p, WlKind_StParenthesizedExpression, 0, start, (WlNodeData){.lhs = expr});
 	} break;
 	case WlKind_KwDo: {
-		WlSyntaxDo st = {0};
-		st.doKeyword = wlParserMatch(p, WlKind_KwDo);
-		st.block = wlParseBlock(p, BlockParseStatements);
-
-		WlSyntaxDo *stp = arenaMalloc(sizeof(WlSyntaxDo), &p->arena);
-		*stp = st;
-		return (
-			WlToken){.kind = WlKind_StDo, .valuePtr = stp, .span = spanFromTokens(st.doKeyword, st.block.curlyClose)};
+		wlParserMatch(p, WlKind_KwDo);
+		WlNode block = wlParseBlock(p, BlockParseStatements);
+		return wlParserNode(p, WlKind_StDo, 0, start, (WlNodeData){.lhs = block});
 	} break;
 	case WlKind_OpPlusPlus:
 	case WlKind_OpMinusMinus:
 	case WlKind_OpMinus:
 	case WlKind_OpBang: {
-		WlPreUnaryExpression expr = {0};
-		expr.operator= wlParserTake(p);
-		expr.expression = wlParsePrimaryExpression(p);
-		WlPreUnaryExpression *exprp = arenaMalloc(sizeof(WlPreUnaryExpression), &p->arena);
-		*exprp = expr;
-
-		return (WlToken){
-			.kind = WlKind_StPreUnary,
-			.valuePtr = exprp,
-			.span = spanFromTokens(expr.operator, expr.expression),
-		};
+		WlKind operator= wlParserTake(p).kind;
+		WlNode expr = wlParsePrimaryExpression(p);
+		return wlParserNode(p, WlKind_StPreUnary, operator, start, (WlNodeData){.lhs = expr});
 	} break;
-	case WlKind_Number: return wlParserTake(p);
-	case WlKind_FloatNumber: return wlParserTake(p);
-	case WlKind_String: return wlParserTake(p);
-	case WlKind_KwTrue: return wlParserTake(p);
-	case WlKind_KwFalse: return wlParserTake(p);
+	case WlKind_Number: return wlParserLeaf(p, wlParserTake(p));
+	case WlKind_FloatNumber: return wlParserLeaf(p, wlParserTake(p));
+	case WlKind_String: return wlParserLeaf(p, wlParserTake(p));
+	case WlKind_KwTrue: return wlParserLeaf(p, wlParserTake(p));
+	case WlKind_KwFalse: return wlParserLeaf(p, wlParserTake(p));
 	case WlKind_Symbol: {
-		List(WlToken) path = wlParseReferencePath(p);
-		if (wlParserPeek(p).kind == WlKind_TkParenOpen) {
-			WlSyntaxCall call = {0};
-			call.path = path;
-			call.parenOpen = wlParserMatch(p, WlKind_TkParenOpen);
-			call.args = wlParseArgumentList(p);
-			call.parenClose = wlParserMatch(p, WlKind_TkParenClose);
-
-			WlSyntaxCall *callp = arenaMalloc(sizeof(WlSyntaxCall), &p->arena);
-			*callp = call;
-
-			return (WlToken){
-				.kind = WlKind_StCall,
-				.valuePtr = callp,
-				.span = spanFromTokens(call.path[0], call.parenClose),
-			};
+		WlNode ref = wlParseReferencePath(p);
+		if (wlParserPeekKind(p) == WlKind_TkParenOpen) {
+			return wlParseCallTail(p, WlKind_StCall, start, ref);
+		} else if (wlParserPeekKind(p) == WlKind_OpPlusPlus || wlParserPeekKind(p) == WlKind_OpMinusMinus) {
+			WlKind operator= wlParserTake(p).kind;
+			return wlParserNode(p, WlKind_StPostUnary, operator, start, (WlNodeData){.lhs = ref});
 		} else {
-			WlToken ref = {
-				.kind = WlKind_StRef,
-				.valuePtr = path,
-				.span = spanFromTokens(path[0], path[listLen(path) - 1]),
-			};
-
-			if (wlParserPeek(p).kind == WlKind_OpPlusPlus || wlParserPeek(p).kind == WlKind_OpMinusMinus) {
-				WlPostUnaryExpression post = {
-					.expression = ref,
-					.operator= wlParserTake(p),
-				};
-				WlPostUnaryExpression *postp = arenaMalloc(sizeof(WlPostUnaryExpression), &p->arena);
-				*postp = post;
-
-				WlToken ref = {
-					.kind = WlKind_StPostUnary,
-					.valuePtr = postp,
-					.span = spanFromTokens(ref, post.expression),
-				};
-				return ref;
-			} else {
-				return ref;
-			}
+			return ref;
 		}
 	} break;
-	default: return parserReport(p, UnexpectedTokenInPrimaryExpressionDiagnostic, wlParserTake(p), 0);
+	default: {
+		WlToken t = parserReport(p, UnexpectedTokenInPrimaryExpressionDiagnostic, wlParserTake(p), 0);
+		return wlParserLeaf(p, t);
+	}
 	}
 }
 
@@ -761,97 +1249,92 @@ int operatorPrecedence(WlKind operator)
 	}
 }
 
-WlToken parseTernary(WlParser *p, WlToken condition)
+WlNode parseTernary(WlParser *p, u32 start, WlNode condition)
 {
-	WlTernaryExpression tr = {0};
-	tr.condition = condition;
-	tr.question = wlParserMatch(p, WlKind_OpQuestion);
-	tr.thenExpr = wlParseExpression(p);
-	tr.colon = wlParserMatch(p, WlKind_OpColon);
-	tr.elseExpr = wlParseExpression(p);
+	wlParserMatch(p, WlKind_OpQuestion);
+	WlNode thenExpr = wlParseExpression(p);
+	wlParserMatch(p, WlKind_OpColon);
+	WlNode elseExpr = wlParseExpression(p);
 
-	WlTernaryExpression *exprData = arenaMalloc(sizeof(WlTernaryExpression), &p->arena);
-	*exprData = tr;
-	return (WlToken){.kind = WlKind_StTernaryExpression,
-					 .valuePtr = exprData,
-					 .span = spanFromTokens(tr.condition, tr.elseExpr)};
+	u32 extra = wlAstPushExtra(&p->ast, 2, (u32[]){thenExpr, elseExpr});
+	return wlParserNode(p, WlKind_StTernaryExpression, 0, start, (WlNodeData){.lhs = condition, .rhs = extra});
 }
 
-WlToken wlParseBinaryExpression(WlParser *p, int previousPrecedence)
+WlNode wlParseBinaryExpression(WlParser *p, int previousPrecedence)
 {
-	WlToken left = wlParsePrimaryExpression(p);
-	while (isBinaryOperator(wlParserPeek(p).kind)) {
-		WlToken operator= wlParserPeek(p);
-		int precedence = operatorPrecedence(operator.kind);
+	u32 start = wlParserPeekStart(p);
+	WlNode left = wlParsePrimaryExpression(p);
+	while (isBinaryOperator(wlParserPeekKind(p))) {
+		int precedence = operatorPrecedence(wlParserPeekKind(p));
 
 		if (precedence <= previousPrecedence) {
 			return left;
 		}
 
-		if (operator.kind == WlKind_OpQuestion) {
-			WlToken tern = parseTernary(p, left);
-			left = tern;
+		if (wlParserPeekKind(p) == WlKind_OpQuestion) {
+			left = parseTernary(p, start, left);
 			continue;
 		}
 
-		operator= wlParserTake(p);
-
-		WlToken right = wlParseBinaryExpression(p, precedence);
+		WlKind operator= wlParserTake(p).kind;
 
-		WlBinaryExpression *exprData = arenaMalloc(sizeof(WlBinaryExpression), &p->arena);
-		*exprData = (WlBinaryExpression){.left = left, .operator= operator, .right = right };
+		WlNode right = wlParseBinaryExpression(p, precedence);
 
-		WlToken binaryExpression = {.kind = WlKind_StBinaryExpression,
-									.valuePtr = exprData,
-									.span = spanFromTokens(left, right)};
-		left = binaryExpression;
+		left = wlParserNode(p, WlKind_StBinaryExpression, operator, start, (WlNodeData){.lhs = left, .rhs = right});
 	}
 
 	return left;
 }
-WlToken wlParseFullBinaryExpression(WlParser *p) { return wlParseBinaryExpression(p, -1); }
+WlNode wlParseFullBinaryExpression(WlParser *p) { return wlParseBinaryExpression(p, -1); }
 
-WlToken wlParseExpression(WlParser *p) { return wlParseFullBinaryExpression(p); }
+WlNode wlParseExpression(WlParser *p) { return wlParseFullBinaryExpression(p); }
 
-WlToken wlParseStatement(WlParser *p)
+WlNode wlParseStatement(WlParser *p);
+
+// like functions, the span of a for loop starts after its notes
+static WlNode wlParseFor(WlParser *p, WlNodeRange notes)
+{
+	u32 start = wlParserPeekStart(p);
+	wlParserMatch(p, WlKind_KwFor);
+	WlNode preCondition = wlParseStatement(p);
+	WlNode condition = wlParseStatement(p);
+	WlNode postCondition = wlParseStatement(p);
+	WlNode block = wlParseBlock(p, BlockParseStatements);
+
+	u32 extra =
+		wlAstPushExtra(&p->ast, 5, (u32[]){preCondition, condition, postCondition, notes.start, notes.len});
+	return wlParserNode(p, WlKind_StFor, 0, start, (WlNodeData){.lhs = extra, .rhs = block});
+}
+
+WlNode wlParseStatement(WlParser *p)
 {
-	switch (wlParserPeek(p).kind) {
+	u32 start = wlParserPeekStart(p);
+
+	switch (wlParserPeekKind(p)) {
 	case WlKind_KwUse: return wlParseUse(p); break;
 
 	case WlKind_KwReturn: {
-		WlReturnStatement st = {0};
-
-		st.returnKeyword = wlParserTake(p);
-		if (wlParserPeek(p).kind == WlKind_TkSemicolon) {
-			st.expression = (WlToken){WlKind_Missing};
-		} else {
-			st.expression = wlParseExpression(p);
+		wlParserTake(p);
+		WlNode expression = WLNODEMISSING;
+		if (wlParserPeekKind(p) != WlKind_TkSemicolon) {
+			expression = wlParseExpression(p);
 		}
-		st.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
-
-		WlReturnStatement *stp = arenaMalloc(sizeof(WlReturnStatement), &p->arena);
-		*stp = st;
+		wlParserMatch(p, WlKind_TkSemicolon);
 
-		return (WlToken){.kind = WlKind_StReturnStatement,
-						 .valuePtr = stp,
-						 .span = spanFromTokens(st.returnKeyword, st.semicolon)};
+		return wlParserNode(p, WlKind_StReturnStatement, 0, start, (WlNodeData){.lhs = expression});
 	} break;
 	case WlKind_KwVar: goto variableDeclaration; break;
 	case WlKind_KwLet: goto variableDeclaration; break;
 	case WlKind_Symbol: {
-		switch (wlParserLookahead(p, 1).kind) {
+		switch (wlParserLookaheadKind(p, 1)) {
 		case WlKind_OpEquals: {
-			WlAssignmentExpression var = {0};
-			var.variable = wlParserMatch(p, WlKind_Symbol);
-			var.equals = wlParserMatch(p, WlKind_OpEquals);
-			var.expression = wlParseExpression(p);
-			var.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
-
-			WlAssignmentExpression *varp = arenaMalloc(sizeof(WlAssignmentExpression), &p->arena);
-			*varp = var;
-			return (WlToken){.kind = WlKind_StVariableAssignement,
-							 .valuePtr = varp,
-							 .span = spanFromTokens(var.variable, var.semicolon)};
+			WlNode variable = wlParserMatchLeaf(p, WlKind_Symbol);
+			wlParserMatch(p, WlKind_OpEquals);
+			WlNode expression = wlParseExpression(p);
+			wlParserMatch(p, WlKind_TkSemicolon);
+
+			return wlParserNode(p, WlKind_StVariableAssignement, 0, start,
+								(WlNodeData){.lhs = variable, .rhs = expression});
 		}
 		case WlKind_Symbol: {
 			// local function
@@ -860,405 +1343,792 @@ WlToken wlParseStatement(WlParser *p)
 			// because foo() {} looks like a call expression at first
 			// we'd need to start parsing the argument list
 			// and then swap over to parsing a parameter list if any errors occur
-			if (wlParserLookahead(p, 2).kind == WlKind_TkParenOpen) {
+			if (wlParserLookaheadKind(p, 2) == WlKind_TkParenOpen) {
 				return wlParseDeclaration(p, false);
 			}
 		variableDeclaration : {
 		}
-			WlSyntaxVariableDeclaration var = {0};
-			var.export = (WlToken){.kind = WlKind_Missing};
-			if (wlParserPeek(p).kind == WlKind_KwVar || wlParserPeek(p).kind == WlKind_KwLet) {
-				var.type = wlParserTake(p);
+			WlNode type;
+			if (wlParserPeekKind(p) == WlKind_KwVar || wlParserPeekKind(p) == WlKind_KwLet) {
+				type = wlParserLeaf(p, wlParserTake(p));
 			} else {
-				var.type = wlParserMatch(p, WlKind_Symbol);
+				type = wlParserMatchLeaf(p, WlKind_Symbol);
 			}
-			var.name = wlParserMatch(p, WlKind_Symbol);
-			if (wlParserPeek(p).kind == WlKind_OpEquals) {
-				var.equals = wlParserMatch(p, WlKind_OpEquals);
-				var.initializer = wlParseExpression(p);
-			} else {
-				var.equals = (WlToken){.kind = WlKind_Missing};
-				var.initializer = (WlToken){.kind = WlKind_Missing};
+			WlNode name = wlParserMatchLeaf(p, WlKind_Symbol);
+			WlNode initializer = WLNODEMISSING;
+			if (wlParserPeekKind(p) == WlKind_OpEquals) {
+				wlParserMatch(p, WlKind_OpEquals);
+				initializer = wlParseExpression(p);
 			}
-			var.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
+			wlParserMatch(p, WlKind_TkSemicolon);
 
-			WlSyntaxVariableDeclaration *varp = arenaMalloc(sizeof(WlSyntaxVariableDeclaration), &p->arena);
-			*varp = var;
-			return (WlToken){.kind = WlKind_StVariableDeclaration,
-							 .valuePtr = varp,
-							 .span = spanFromTokens(var.type, var.semicolon)};
+			u32 extra = wlAstPushExtra(&p->ast, 2, (u32[]){type, name});
+			return wlParserNode(p, WlKind_StVariableDeclaration, 0, start,
+								(WlNodeData){.lhs = extra, .rhs = initializer});
 		} break;
 		default: goto defaultExpression; break;
 		}
 
 	} break;
 	case WlKind_KwIf: {
-		WlSyntaxIf st = {0};
-		st.ifKeyword = wlParserMatch(p, WlKind_KwIf);
-		st.condition = wlParseExpression(p);
-		st.thenBlock = wlParseBlock(p, BlockParseStatements);
-		WlToken last;
-		if (wlParserPeek(p).kind == WlKind_KwElse) {
-			st.elseKeyword = wlParserMatch(p, WlKind_KwElse);
-			st.elseBlock = wlParseBlock(p, BlockParseStatements);
-			last = st.elseBlock.curlyClose;
-		} else {
-			st.elseKeyword = (WlToken){.kind = WlKind_Missing};
-			last = st.thenBlock.curlyClose;
+		wlParserMatch(p, WlKind_KwIf);
+		WlNode condition = wlParseExpression(p);
+		WlNode thenBlock = wlParseBlock(p, BlockParseStatements);
+		WlNode elseBlock = WLNODEMISSING;
+		if (wlParserPeekKind(p) == WlKind_KwElse) {
+			wlParserMatch(p, WlKind_KwElse);
+			elseBlock = wlParseBlock(p, BlockParseStatements);
 		}
 
-		WlSyntaxIf *stp = arenaMalloc(sizeof(WlSyntaxIf), &p->arena);
-		*stp = st;
-		return (WlToken){.kind = WlKind_StIf, .valuePtr = stp, .span = spanFromTokens(st.ifKeyword, last)};
+		u32 extra = wlAstPushExtra(&p->ast, 2, (u32[]){thenBlock, elseBlock});
+		return wlParserNode(p, WlKind_StIf, 0, start, (WlNodeData){.lhs = condition, .rhs = extra});
 
 	} break;
 	case WlKind_KwDo: {
-		WlSyntaxDoWhile st = {0};
-		st.doKeyword = wlParserMatch(p, WlKind_KwDo);
-		st.block = wlParseBlock(p, BlockParseStatements);
-
-		st.whileKeyword = wlParserMatch(p, WlKind_KwWhile);
-		st.condition = wlParseExpression(p);
-		st.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
-		WlSyntaxDoWhile *stp = arenaMalloc(sizeof(WlSyntaxDoWhile), &p->arena);
-		*stp = st;
-		return (WlToken){.kind = WlKind_StDoWhile, .valuePtr = stp, .span = spanFromTokens(st.doKeyword, st.semicolon)};
+		wlParserMatch(p, WlKind_KwDo);
+		WlNode block = wlParseBlock(p, BlockParseStatements);
+
+		wlParserMatch(p, WlKind_KwWhile);
+		WlNode condition = wlParseExpression(p);
+		wlParserMatch(p, WlKind_TkSemicolon);
+		return wlParserNode(p, WlKind_StDoWhile, 0, start, (WlNodeData){.lhs = block, .rhs = condition});
 	} break;
 	case WlKind_KwWhile: {
-		WlSyntaxWhile st = {0};
-		st.whileKeyword = wlParserMatch(p, WlKind_KwWhile);
-		st.condition = wlParseExpression(p);
-		st.block = wlParseBlock(p, BlockParseStatements);
+		wlParserMatch(p, WlKind_KwWhile);
+		WlNode condition = wlParseExpression(p);
+		WlNode block = wlParseBlock(p, BlockParseStatements);
 
-		WlSyntaxWhile *stp = arenaMalloc(sizeof(WlSyntaxWhile), &p->arena);
-		*stp = st;
-		return (WlToken){.kind = WlKind_StWhile,
-						 .valuePtr = stp,
-						 .span = spanFromTokens(st.whileKeyword, st.block.curlyClose)};
+		return wlParserNode(p, WlKind_StWhile, 0, start, (WlNodeData){.lhs = condition, .rhs = block});
 
 	} break;
-	case WlKind_KwFor: {
-		WlSyntaxFor st = {0};
-		st.forKeyword = wlParserMatch(p, WlKind_KwFor);
-		st.preCondition = wlParseStatement(p);
-		// st.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
-		st.condition = wlParseStatement(p);
-		// st.semicolon2 = wlParserMatch(p, WlKind_TkSemicolon);
-		st.postCondition = wlParseStatement(p);
-		st.block = wlParseBlock(p, BlockParseStatements);
-
-		WlSyntaxFor *stp = arenaMalloc(sizeof(WlSyntaxFor), &p->arena);
-		*stp = st;
-		return (
-			WlToken){.kind = WlKind_StFor, .valuePtr = stp, .span = spanFromTokens(st.forKeyword, st.block.curlyClose)};
-
+	case WlKind_KwFor: return wlParseFor(p, (WlNodeRange){0});
+	case WlKind_TkAt: {
+		// only for loops take notes, they are left out of other statements
+		WlNodeRange notes = parseNotes(p);
+		if (wlParserPeekKind(p) == WlKind_KwFor) return wlParseFor(p, notes);
+		return wlParseStatement(p);
 	} break;
 	default: {
 	defaultExpression : {
 	}
-		WlToken expression = wlParseExpression(p);
-		if (wlParserPeek(p).kind == WlKind_TkCurlyClose) {
+		WlNode expression = wlParseExpression(p);
+		if (wlParserPeekKind(p) == WlKind_TkCurlyClose) {
 			// implicit return statement
-			WlReturnStatement st = {0};
-			st.returnKeyword = (WlToken){.kind = WlKind_Missing};
-			st.expression = expression;
-			st.semicolon = (WlToken){.kind = WlKind_Missing};
-			WlReturnStatement *stp = arenaMalloc(sizeof(WlReturnStatement), &p->arena);
-			*stp = st;
-			return (WlToken){.kind = WlKind_StReturnStatement,
-							 .valuePtr = stp,
-							 .span = spanFromTokens(st.expression, st.semicolon)};
+			return wlParserNode(p, WlKind_StReturnStatement, 0, start, (WlNodeData){.lhs = expression});
 		} else {
-			WlExpressionStatement st = {0};
-			st.expression = expression;
-			st.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
-			WlExpressionStatement *stp = arenaMalloc(sizeof(WlExpressionStatement), &p->arena);
-			*stp = st;
-			return (WlToken){.kind = WlKind_StExpressionStatement,
-							 .valuePtr = stp,
-							 .span = spanFromTokens(st.expression, st.semicolon)};
+			wlParserMatch(p, WlKind_TkSemicolon);
+			return wlParserNode(p, WlKind_StExpressionStatement, 0, start, (WlNodeData){.lhs = expression});
 		}
 	} break;
 	}
 }
 
-WlSyntaxBlock wlParseBlock(WlParser *p, BlockParseOptions options)
+WlNode wlParseBlock(WlParser *p, BlockParseOptions options)
 {
-	WlSyntaxBlock blk = {0};
-	blk.curlyOpen = wlParserMatch(p, WlKind_TkCurlyOpen);
-	blk.statements = listNew();
+	u32 start = wlParserPeekStart(p);
+	wlParserMatch(p, WlKind_TkCurlyOpen);
+	int list = wlParserListStart(p);
 	p->sectionStart = true;
-	while (wlParserPeek(p).kind != WlKind_TkCurlyClose && wlParserPeek(p).kind != WlKind_EOF) {
-		WlToken tk;
+	while (wlParserPeekKind(p) != WlKind_TkCurlyClose && wlParserPeekKind(p) != WlKind_EOF) {
+		WlNode n;
 		if (options == BlockParseStatements) {
-			tk = wlParseStatement(p);
-			listPush(&blk.statements, tk);
+			n = wlParseStatement(p);
 		} else {
-			tk = wlParseDeclaration(p, false);
-			listPush(&blk.statements, tk);
+			n = wlParseDeclaration(p, false);
 		}
-		if (tk.kind != WlKind_StUse) p->sectionStart = false;
+		wlParserListPush(p, n);
+		if (wlAstKind(&p->ast, n) != WlKind_StUse) p->sectionStart = false;
 	}
 
-	blk.curlyClose = wlParserMatch(p, WlKind_TkCurlyClose);
-	return blk;
+	wlParserMatch(p, WlKind_TkCurlyClose);
+	WlNodeRange statements = wlParserListEnd(p, list);
+	return wlParserNode(p, WlKind_StBlock, 0, start, (WlNodeData){.range = statements});
 }
 
-WlToken wlParseImport(WlParser *p)
+// type and name of a function or import, the type may be left out: main() means u0 main()
+static void wlParseSignature(WlParser *p, WlNode *type, WlNode *name, WlNodeRange *parameters)
 {
-	WlSyntaxImport im = {0};
-
-	im.notes = p->notes;
-	im.import = wlParserMatch(p, WlKind_KwImport);
-	im.type = wlParserMatch(p, WlKind_Symbol);
+	WlToken typeToken = wlParserMatch(p, WlKind_Symbol);
 
-	// infer type as u0
-	if (wlParserPeek(p).kind == WlKind_TkParenOpen) {
-		im.name = im.type;
-		im.type.kind = WlKind_Missing;
+	if (wlParserPeekKind(p) == WlKind_TkParenOpen) {
+		*name = wlParserLeaf(p, typeToken);
+		*type = WLNODEMISSING;
 	} else {
-		im.name = wlParserMatch(p, WlKind_Symbol);
+		*type = wlParserLeaf(p, typeToken);
+		*name = wlParserMatchLeaf(p, WlKind_Symbol);
 	}
 
-	im.parenOpen = wlParserMatch(p, WlKind_TkParenOpen);
-	im.parameterList = wlParseParameterList(p);
-	im.parenClose = wlParserMatch(p, WlKind_TkParenClose);
-	im.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
+	wlParserMatch(p, WlKind_TkParenOpen);
+	*parameters = wlParseParameterList(p);
+	wlParserMatch(p, WlKind_TkParenClose);
+}
 
-	WlSyntaxImport *imp = arenaMalloc(sizeof(WlSyntaxImport), &p->arena);
-	*imp = im;
+// skips over a function body by matching braces on the token kinds, without building any nodes
+// the body is parsed later by wlParseLazyBlock, unbalanced bodies are parsed right away so they report errors
+WlNode wlParseBodyLazily(WlParser *p)
+{
+	u8 *kinds = p->tokenStore.kinds;
+	int open = p->tokenCursor;
+	int eof = p->tokenEnd;
+	if (wlParserPeekKind(p) != WlKind_TkCurlyOpen) return wlParseBlock(p, BlockParseStatements);
+
+	int depth = 0;
+	int close = open;
+	for (; close < eof; close++) {
+		if (kinds[close] == WlKind_TkCurlyOpen) {
+			depth++;
+		} else if (kinds[close] == WlKind_TkCurlyClose) {
+			if (--depth == 0) break;
+		}
+	}
+	if (close == eof) {
+		p->unclosedBody = true;
+		return wlParseBlock(p, BlockParseStatements);
+	}
 
-	WlToken tk = {.kind = WlKind_StImport, .valuePtr = imp, .span = spanFromTokens(im.import, im.semicolon)};
-	return tk;
+	u32 start = p->tokenStore.starts[open];
+	p->tokenCursor = close + 1;
+	p->lastTokenEnd = p->tokenStore.starts[close] + p->tokenStore.lens[close];
+	return wlParserNode(p, WlKind_StLazyBlock, 0, start, (WlNodeData){.lhs = open, .rhs = close + 1});
 }
 
-WlToken wlParseFunction(WlParser *p)
+// parses a body that was skipped by wlParseBodyLazily
+// the lazy node is turned into the parsed block in place, so everything that refers to it stays valid
+void wlParseLazyBlock(WlParser *p, WlNode lazy)
 {
-	int errorCount = listLen(p->diagnostics);
-
-	WlSyntaxFunction fn = {0};
+	assert(wlAstKind(&p->ast, lazy) == WlKind_StLazyBlock);
+
+	int cursor = p->tokenCursor;
+	int tokenEnd = p->tokenEnd;
+	u32 lastTokenEnd = p->lastTokenEnd;
+	bool sectionStart = p->sectionStart;
+	WlNodeRange notes = p->notes;
+
+	// the body reads as if the file ended after its closing brace, so recovering from an error can't run past it
+	p->tokenCursor = p->ast.data[lazy].lhs;
+	p->tokenEnd = p->ast.data[lazy].rhs;
+	WlNode block = wlParseBlock(p, BlockParseStatements);
+	// or the block was closed by another brace, then the tokens up to the closing brace are left over
+	if (p->tokenCursor < p->tokenEnd) parserReport(p, UnexpectedTokenDiagnostic, wlParserPeek(p), 0);
+	p->tokenEnd = tokenEnd;
+
+	p->ast.kinds[lazy] = WlKind_StBlock;
+	p->ast.data[lazy] = p->ast.data[block];
+	// the block is always the last node that was pushed, so it can be dropped again
+	assert(block == p->ast.count - 1);
+	p->ast.count--;
+
+	p->tokenCursor = cursor;
+	p->lastTokenEnd = lastTokenEnd;
+	p->sectionStart = sectionStart;
+	p->notes = notes;
+}
 
-	fn.notes = p->notes;
-	WlToken first = {.kind = WlKind_Missing};
+WlNode wlParseImport(WlParser *p)
+{
+	u32 start = wlParserPeekStart(p);
+	WlNodeRange notes = p->notes;
+	WlNode type, name;
+	WlNodeRange parameters;
+
+	wlParserMatch(p, WlKind_KwImport);
+	wlParseSignature(p, &type, &name, &parameters);
+	wlParserMatch(p, WlKind_TkSemicolon);
+
+	u32 extra = wlAstPushExtra(&p->ast, 6,
+							   (u32[]){notes.start, notes.len, type, name, parameters.start, parameters.len});
+	return wlParserNode(p, WlKind_StImport, 0, start, (WlNodeData){.lhs = extra});
+}
 
-	if (wlParserPeek(p).kind == WlKind_KwExport) {
-		fn.export = wlParserMatch(p, WlKind_KwExport);
-		first = fn.export;
-	} else {
-		fn.export = (WlToken){.kind = WlKind_Missing};
-	}
+WlNode wlParseFunction(WlParser *p)
+{
+	int errorCount = listLen(p->diagnostics);
 
-	fn.type = wlParserMatch(p, WlKind_Symbol);
-	if (first.kind == WlKind_Missing) first = fn.type;
+	u32 start = wlParserPeekStart(p);
+	WlNodeRange notes = p->notes;
+	WlKind export = 0;
+	WlNode type, name;
+	WlNodeRange parameters;
 
-	// infer type as u0
-	if (wlParserPeek(p).kind == WlKind_TkParenOpen) {
-		fn.name = fn.type;
-		fn.type.kind = WlKind_Missing;
-	} else {
-		fn.name = wlParserMatch(p, WlKind_Symbol);
+	if (wlParserPeekKind(p) == WlKind_KwExport) {
+		export = wlParserMatch(p, WlKind_KwExport).kind;
 	}
 
-	fn.parenOpen = wlParserMatch(p, WlKind_TkParenOpen);
-	fn.parameterList = wlParseParameterList(p);
-	fn.parenClose = wlParserMatch(p, WlKind_TkParenClose);
-	fn.body = wlParseBlock(p, BlockParseStatements);
-	WlSyntaxFunction *fnp = arenaMalloc(sizeof(WlSyntaxFunction), &p->arena);
-	*fnp = fn;
+	wlParseSignature(p, &type, &name, &parameters);
+	WlNode body = p->lazyBodies ? wlParseBodyLazily(p) : wlParseBlock(p, BlockParseStatements);
 
 	bool hasError = errorCount != listLen(p->diagnostics);
-	WlToken tk = (WlToken){.kind = hasError ? WlKind_Bad : WlKind_StFunction,
-						   .valuePtr = fnp,
-						   .span = spanFromTokens(first, fn.body.curlyClose)};
-
-	return tk;
+	u32 extra = wlAstPushExtra(&p->ast, 6,
+							   (u32[]){notes.start, notes.len, type, name, parameters.start, parameters.len});
+	return wlParserNode(p, hasError ? WlKind_Bad : WlKind_StFunction, export, start,
+						(WlNodeData){.lhs = extra, .rhs = body});
 }
 
-WlToken wlParseNamespace(WlParser *p)
+WlNode wlParseNamespace(WlParser *p)
 {
-	WlSyntaxNamespace ns = {0};
-
-	ns.notes = p->notes;
-	ns.namespace = wlParserMatch(p, WlKind_KwNamespace);
-
-	ns.path = wlParseReferencePath(p);
-	ns.body = wlParseBlock(p, BlockParseDeclarations);
+	u32 start = wlParserPeekStart(p);
+	wlParserMatch(p, WlKind_KwNamespace);
 
-	WlSyntaxNamespace *nsp = arenaMalloc(sizeof(WlSyntaxNamespace), &p->arena);
-	*nsp = ns;
+	WlNode path = wlParseReferencePath(p);
+	WlNode body = wlParseBlock(p, BlockParseDeclarations);
 
-	WlToken tk = (WlToken){.kind = WlKind_StNamespace,
-						   .valuePtr = nsp,
-						   .span = spanFromTokens(ns.namespace, ns.body.curlyClose)};
-	return tk;
+	return wlParserNode(p, WlKind_StNamespace, 0, start, (WlNodeData){.lhs = path, .rhs = body});
 }
 
-WlToken wlParseUse(WlParser *p)
+WlNode wlParseUse(WlParser *p)
 {
-	WlSyntaxUse us = {0};
-	us.notes = p->notes;
-	us.use = wlParserMatch(p, WlKind_KwUse);
+	u32 start = wlParserPeekStart(p);
+	wlParserMatch(p, WlKind_KwUse);
 
-	us.path = wlParseReferencePath(p);
-	us.semicolon = wlParserMatch(p, WlKind_TkSemicolon);
+	WlNode path = wlParseReferencePath(p);
+	wlParserMatch(p, WlKind_TkSemicolon);
 
-	WlSyntaxUse *usp = arenaMalloc(sizeof(WlSyntaxUse), &p->arena);
-	*usp = us;
-
-	WlSpan span = spanFromTokens(us.use, us.semicolon);
+	WlNode n = wlParserNode(p, WlKind_StUse, 0, start, (WlNodeData){.lhs = path});
 
 	if (!p->sectionStart) {
-		WlDiagnostic d = {.kind = useAfterSectionStartDiagnostic, .span = span};
+		WlDiagnostic d = {.kind = useAfterSectionStartDiagnostic, .span = wlAstSpan(&p->ast, n)};
 		listPush(&p->diagnostics, d);
 	}
 
-	WlToken tk = (WlToken){
-		.kind = WlKind_StUse,
-		.valuePtr = usp,
-		.span = span,
-	};
-	return tk;
+	return n;
 }
 
-WlToken wlParseDeclaration(WlParser *p, bool topLevel)
+WlNode wlParseDeclaration(WlParser *p, bool topLevel)
 {
 	p->notes = parseNotes(p);
-	WlToken tk;
-	switch (wlParserPeek(p).kind) {
-	case WlKind_KwUse: tk = wlParseUse(p); break;
-	case WlKind_KwImport: tk = wlParseImport(p); break;
-	case WlKind_KwNamespace: tk = wlParseNamespace(p); break;
+	WlNode n = WLNODEMISSING;
+	switch (wlParserPeekKind(p)) {
+	case WlKind_KwUse: n = wlParseUse(p); break;
+	case WlKind_KwImport: n = wlParseImport(p); break;
+	case WlKind_KwNamespace: n = wlParseNamespace(p); break;
 	case WlKind_EOF: PANIC("Unexpected EOF,expected declaration"); break;
-	default: tk = wlParseFunction(p); break;
+	default: n = wlParseFunction(p); break;
 	}
-	if (topLevel) wlParserAddTopLevelStatement(p, tk);
-	p->notes = NULL;
-	return tk;
+	if (topLevel) wlParserAddTopLevelStatement(p, n);
+	p->notes = (WlNodeRange){0};
+	return n;
+}
+
+static void wlParseDeclarations(WlParser *p)
+{
+	while (wlParserPeekKind(p) != WlKind_EOF) {
+		WlNode n = wlParseDeclaration(p, true);
+		if (wlAstKind(&p->ast, n) != WlKind_StUse) p->sectionStart = false;
+	}
+}
+
+typedef struct {
+	int start;
+	int end;
+	// no declaration other than a use comes before the chunk
+	bool sectionStart;
+} WlParserChunk;
+
+// splits the top-level declarations into chunks of at least chunkTokens tokens
+// a declaration ends with a ';' or a '}' at brace depth 0. the lexer already turned comments and strings into
+// tokens, so the braces inside of them don't count. unbalanced braces leave the rest of the file in one chunk
+List(WlParserChunk) wlParserSplitChunks(WlParser *p, int chunkTokens)
+{
+	List(WlParserChunk) chunks = listNew();
+	u8 *kinds = p->tokenStore.kinds;
+	int end = p->tokenEnd;
+
+	WlParserChunk chunk = {.start = p->tokenCursor, .sectionStart = p->sectionStart};
+	bool declarationStart = true;
+	bool sectionStart = p->sectionStart;
+	int depth = 0;
+	for (int i = chunk.start; i < end; i++) {
+		WlKind kind = kinds[i];
+		if (declarationStart) {
+			if (i - chunk.start >= chunkTokens) {
+				chunk.end = i;
+				listPush(&chunks, chunk);
+				chunk = (WlParserChunk){.start = i, .sectionStart = sectionStart};
+			}
+			if (kind != WlKind_KwUse) sectionStart = false;
+			declarationStart = false;
+		}
+
+		if (kind == WlKind_TkCurlyOpen) {
+			depth++;
+		} else if (kind == WlKind_TkCurlyClose) {
+			depth = depth > 0 ? depth - 1 : 0;
+			declarationStart = depth == 0;
+		} else if (kind == WlKind_TkSemicolon) {
+			declarationStart = depth == 0;
+		}
+	}
+	chunk.end = end;
+	listPush(&chunks, chunk);
+	return chunks;
+}
+
+typedef struct {
+	WlParser *parsers;
+	int first;
+	int stride;
+	int count;
+} WlParserWork;
+
+static void wlParserWorker(void *arg)
+{
+	WlParserWork *work = arg;
+	for (int i = work->first; i < work->count; i += work->stride) {
+		wlParseDeclarations(&work->parsers[i]);
+	}
+}
+
+// parses the remaining top-level declarations on up to threadCount threads
+// the declarations are split into chunks that are parsed by their own parser, which shares the token store
+// the chunks are merged back in source order, so the result only depends on chunkTokens, never on the threads
+void wlParseParallel(WlParser *p, int threadCount, int chunkTokens)
+{
+	assert(!p->streaming);
+	List(WlParserChunk) chunks = wlParserSplitChunks(p, chunkTokens);
+	int chunkCount = listLen(chunks);
+	if (chunkCount == 1) {
+		listFree(&chunks);
+		wlParseDeclarations(p);
+		return;
+	}
+
+	WlParser *parsers = malloc(chunkCount * sizeof(WlParser));
+	if (!parsers) PANIC("Failed to allocate parsers");
+	for (int i = 0; i < chunkCount; i++) {
+		parsers[i] = (WlParser){
+			.ast = wlAstCreate(p->ast.file, p->ast.source),
+			.topLevelDeclarations = listNew(),
+			.diagnostics = listNew(),
+			.scratch = listNew(),
+			.lazyBodies = p->lazyBodies,
+			.tokenStore = p->tokenStore,
+			.tokenCursor = chunks[i].start,
+			.tokenEnd = chunks[i].end,
+			.sectionStart = chunks[i].sectionStart,
+		};
+	}
+
+	int workerCount = min(max(threadCount, 1), chunkCount);
+	Thread *threads = malloc(workerCount * sizeof(Thread));
+	WlParserWork *work = malloc(workerCount * sizeof(WlParserWork));
+	if (!threads || !work) PANIC("Failed to allocate workers");
+	for (int i = 0; i < workerCount; i++) {
+		work[i] = (WlParserWork){.parsers = parsers, .first = i, .stride = workerCount, .count = chunkCount};
+	}
+	// the calling thread takes the first share instead of waiting idle
+	for (int i = 1; i < workerCount; i++) {
+		threadStart(&threads[i], wlParserWorker, &work[i]);
+	}
+	wlParserWorker(&work[0]);
+	for (int i = 1; i < workerCount; i++) {
+		threadJoin(&threads[i]);
+	}
+
+	for (int i = 0; i < chunkCount; i++) {
+		WlParser *c = &parsers[i];
+		int shift = wlAstAppend(&p->ast, &c->ast);
+		for (int j = 0; j < listLen(c->topLevelDeclarations); j++) {
+			WlNode n = c->topLevelDeclarations[j];
+			wlParserAddTopLevelStatement(p, n == WLNODEMISSING ? n : n + shift);
+		}
+		for (int j = 0; j < listLen(c->diagnostics); j++) {
+			listPush(&p->diagnostics, c->diagnostics[j]);
+		}
+		p->lastTokenEnd = c->lastTokenEnd;
+		p->sectionStart = c->sectionStart;
+
+		wlAstFree(&c->ast);
+		listFree(&c->topLevelDeclarations);
+		listFree(&c->diagnostics);
+		listFree(&c->scratch);
+	}
+	p->tokenCursor = p->tokenEnd;
+
+	free(work);
+	free(threads);
+	free(parsers);
+	listFree(&chunks);
 }
 
 void wlParse(WlParser *p)
 {
 	p->sectionStart = true;
-	while (wlParserPeek(p).kind != WlKind_EOF) {
-		WlToken tk = wlParseDeclaration(p, true);
-		if (tk.kind != WlKind_StUse) p->sectionStart = false;
+	if (p->parallel) {
+		wlParseParallel(p, threadProcessorCount(), PARSERCHUNKTOKENS);
+	} else {
+		wlParseDeclarations(p);
 	}
+	p->reparseNodeLimit = p->ast.count * 2 + 1024;
 }
 
 WlParser wlParserFree(WlParser *p)
 {
-	arenaFree(&p->arena);
+	wlAstFree(&p->ast);
 	wlLexerFree(&p->lexer);
+	wlTokenStoreFree(&p->tokenStore);
 	listFree(&p->topLevelDeclarations);
+	listFree(&p->scratch);
 }
 
-void wlPrint(WlToken tk);
+// replaces removed bytes at offset with inserted bytes
+typedef struct {
+	u32 offset;
+	u32 removed;
+	u32 inserted;
+} WlTextEdit;
 
-void wlPrintBlock(WlSyntaxBlock blk)
+static void wlParserFullReparse(WlParser *p, Str source)
 {
-	wlPrint(blk.curlyOpen);
-	printf("\n");
-	for (int i = 0; i < listLen(blk.statements); i++) {
-		WlToken st = blk.statements[i];
-		wlPrint(st);
-		printf("\n");
+	WlParserOptions options = (p->streaming ? WlParserStreaming : 0) | (p->lazyBodies ? WlParserLazyBodies : 0) |
+							  (p->parallel ? WlParserParallel : 0);
+	Str filename = p->lexer.filename;
+	listFree(&p->diagnostics);
+	wlParserFree(p);
+	*p = wlParserCreateWithOptions(filename, source, options);
+	wlParse(p);
+}
+
+// drops the diagnostics inside of [start, end), moves the ones after it by delta and puts replacements in between
+static void wlSpliceDiagnostics(List(WlDiagnostic) * diagnostics, u32 start, u32 end, i32 delta,
+								List(WlDiagnostic) replacements)
+{
+	List(WlDiagnostic) old = *diagnostics;
+	List(WlDiagnostic) result = listNew();
+	for (int i = 0; i < listLen(old); i++) {
+		if (old[i].span.start >= start) continue;
+		listPush(&result, old[i]);
+	}
+	for (int i = 0; i < listLen(replacements); i++) {
+		listPush(&result, replacements[i]);
 	}
-	wlPrint(blk.curlyClose);
-	printf("\n");
+	for (int i = 0; i < listLen(old); i++) {
+		if (old[i].span.start < end) continue;
+		old[i].span.start += delta;
+		listPush(&result, old[i]);
+	}
+	listFree(&old);
+	*diagnostics = result;
 }
 
-void wlPrintReferencePath(List(WlToken) path)
+// a declaration starts at its first note, the span of a function or import starts after them
+static u32 wlParserDeclarationStart(WlParser *p, WlNode n)
 {
-	for (int i = 0; i < listLen(path); i++) {
-		wlPrint(path[i]);
+	WlKind kind = wlAstKind(&p->ast, n);
+	bool hasNotes = kind == WlKind_StFunction || kind == WlKind_StImport ||
+					(kind == WlKind_Bad && wlAstData(&p->ast, n).rhs != WLNODEMISSING);
+	if (hasNotes) {
+		WlNodeRange notes = wlAstFunction(&p->ast, n).notes;
+		if (notes.len) return p->ast.spans[wlAstChild(&p->ast, notes, 0)].start;
 	}
+	return p->ast.spans[n].start;
 }
 
-void wlPrint(WlToken tk)
+// updates a parse after the source was edited, source is the complete text after the edit
+// only the top-level declarations that touch the edit are lexed and parsed again, the nodes of all other
+// declarations are kept as they are and only their spans move. returns false when the edit could not be contained,
+// for example because it opened a comment or unbalanced the braces, in which case the whole file was parsed again
+bool wlParserReparse(WlParser *p, Str source, WlTextEdit edit)
 {
-	if (tk.kind < WlKind_Syntax_Start) {
-		if (tk.kind == WlKind_Missing) {
+	int declarationCount = listLen(p->topLevelDeclarations);
+	if (p->streaming || declarationCount == 0 || p->ast.count > p->reparseNodeLimit || p->unclosedBody) {
+		wlParserFullReparse(p, source);
+		return false;
+	}
+
+	WlTokenStore *store = &p->tokenStore;
+	WlNode *declarations = p->topLevelDeclarations;
+	WlNodeRange *spans = p->ast.spans;
+	i32 delta = (i32)edit.inserted - (i32)edit.removed;
+	u32 editEnd = edit.offset + edit.removed;
+
+	// the region starts at the last declaration that starts before the edit and ends at the first one that ends
+	// after it, so the tokens on either side of the edit are always lexed again together with the new text
+	int low = 0, high = declarationCount;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (wlParserDeclarationStart(p, declarations[mid]) < edit.offset) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	int first = max(low - 1, 0);
+	low = first;
+	high = declarationCount;
+	while (low < high) {
+		int mid = low + (high - low) / 2;
+		if (spans[declarations[mid]].start + spans[declarations[mid]].len <= editEnd) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	int last = min(low, declarationCount - 1);
+
+	// a region that reaches the last declaration runs up to and including the EOF token
+	bool toEnd = last == declarationCount - 1;
+	u32 regionStart = first == 0 ? 0 : wlParserDeclarationStart(p, declarations[first]);
+	u32 regionEnd = toEnd ? p->ast.source.len : spans[declarations[last]].start + spans[declarations[last]].len;
+	int oldFirstToken = wlTokenStoreFind(store, regionStart);
+	int oldEndToken = toEnd ? store->count : wlTokenStoreFind(store, regionEnd);
+
+	bool sectionStart = true;
+	for (int i = 0; i < first; i++) {
+		if (wlAstKind(&p->ast, declarations[i]) != WlKind_StUse) sectionStart = false;
+	}
+	bool sectionStartAfter = sectionStart;
+	for (int i = first; i <= last; i++) {
+		if (wlAstKind(&p->ast, declarations[i]) != WlKind_StUse) sectionStartAfter = false;
+	}
+
+	// lex the region again, the lexer only carries its position between tokens, so once the next token starts
+	// where the first unchanged token moved to, the rest of the tokens are known to be the same
+	WlLexer l = wlLexerCreate(p->lexer.filename, source);
+	l.index = regionStart;
+	WlTokenStore fresh = {.file = store->file, .source = source};
+	bool synced = toEnd;
+	while (true) {
+		WlToken t = wlLexerLexToken(&l);
+		if (!toEnd && t.span.start >= regionEnd + delta) {
+			synced = t.span.start == store->starts[oldEndToken] + delta;
+			break;
+		}
+		wlTokenStorePush(&fresh, t);
+		if (t.kind == WlKind_EOF) break;
+	}
+	if (!synced) {
+		wlLexerFree(&l);
+		wlTokenStoreFree(&fresh);
+		wlParserFullReparse(p, source);
+		return false;
+	}
+
+	// splice the fresh tokens in, the literals of the replaced tokens are left unused
+	int tokenDelta = fresh.count - (oldEndToken - oldFirstToken);
+	if (store->count + tokenDelta > store->capacity) {
+		wlTokenStoreReserve(store, max(store->count + tokenDelta, store->capacity * 2));
+	}
+	int tail = store->count - oldEndToken;
+	int to = oldEndToken + tokenDelta;
+	if (tokenDelta) {
+		memmove(store->kinds + to, store->kinds + oldEndToken, tail * sizeof(u8));
+		memmove(store->starts + to, store->starts + oldEndToken, tail * sizeof(u32));
+		memmove(store->lens + to, store->lens + oldEndToken, tail * sizeof(u32));
+		memmove(store->values + to, store->values + oldEndToken, tail * sizeof(u32));
+	}
+	if (delta) {
+		for (int i = to; i < store->count + tokenDelta; i++) {
+			store->starts[i] += delta;
+		}
+	}
+	u32 literalBase = listLen(store->literals);
+	for (int i = 0; i < listLen(fresh.literals); i++) {
+		listPush(&store->literals, fresh.literals[i]);
+	}
+	for (int i = 0; i < fresh.count; i++) {
+		int at = oldFirstToken + i;
+		store->kinds[at] = fresh.kinds[i];
+		store->starts[at] = fresh.starts[i];
+		store->lens[at] = fresh.lens[i];
+		bool isLiteral = fresh.kinds[i] == WlKind_Number || fresh.kinds[i] == WlKind_FloatNumber;
+		store->values[at] = isLiteral ? fresh.values[i] + literalBase : fresh.values[i];
+	}
+	store->count += tokenDelta;
+	store->source = source;
+	wlTokenStoreFree(&fresh);
+
+	// parse the region on its own, it ends in an EOF just like the chunks of a parallel parse
+	int oldNodeCount = p->ast.count;
+	List(WlNode) oldDeclarations = p->topLevelDeclarations;
+	List(WlDiagnostic) oldDiagnostics = p->diagnostics;
+	p->topLevelDeclarations = listNew();
+	p->diagnostics = listNew();
+	p->ast.source = source;
+	p->tokenCursor = oldFirstToken;
+	p->tokenEnd = oldEndToken + tokenDelta - (toEnd ? 1 : 0);
+	p->sectionStart = sectionStart;
+	p->notes = (WlNodeRange){0};
+	wlParseDeclarations(p);
+
+	// the region has to parse the same way it would as part of the whole file: it may not run into the EOF that
+	// cuts it off, and the uses that follow it have to stay at the start of the file or stay out of it
+	// a lazy body that runs into it is parsed right away, while in the whole file its brace may close further on
+	bool contained = toEnd || (p->sectionStart == sectionStartAfter && !p->unclosedBody);
+	for (int i = 0; i < listLen(p->diagnostics) && !toEnd; i++) {
+		if (p->diagnostics[i].kind1 == WlKind_EOF) contained = false;
+	}
+	if (!contained) {
+		wlLexerFree(&l);
+		listFree(&p->topLevelDeclarations);
+		p->topLevelDeclarations = oldDeclarations;
+		listFree(&p->diagnostics);
+		p->diagnostics = oldDiagnostics;
+		wlParserFullReparse(p, source);
+		return false;
+	}
+
+	List(WlNode) regionDeclarations = p->topLevelDeclarations;
+	p->topLevelDeclarations = listNew();
+	for (int i = 0; i < first; i++) {
+		listPush(&p->topLevelDeclarations, oldDeclarations[i]);
+	}
+	for (int i = 0; i < listLen(regionDeclarations); i++) {
+		listPush(&p->topLevelDeclarations, regionDeclarations[i]);
+	}
+	for (int i = last + 1; i < declarationCount; i++) {
+		listPush(&p->topLevelDeclarations, oldDeclarations[i]);
+	}
+	listFree(&regionDeclarations);
+	listFree(&oldDeclarations);
+
+	// the kept declarations after the region move with the text, unparsed lazy bodies also move with their tokens
+	spans = p->ast.spans;
+	if (delta) {
+		// written without a branch so that it vectorizes, this loop is most of the cost of an edit
+		for (int n = 1; n < oldNodeCount; n++) {
+			spans[n].start += spans[n].start >= regionEnd ? delta : 0;
+		}
+	}
+	if (p->lazyBodies && tokenDelta) {
+		for (int n = 1; n < oldNodeCount; n++) {
+			if (p->ast.kinds[n] == WlKind_StLazyBlock && p->ast.data[n].lhs >= oldEndToken) {
+				p->ast.data[n].lhs += tokenDelta;
+				p->ast.data[n].rhs += tokenDelta;
+			}
+		}
+	}
+
+	u32 spliceEnd = toEnd ? UINT32_MAX : regionEnd;
+	List(WlDiagnostic) regionDiagnostics = p->diagnostics;
+	p->diagnostics = oldDiagnostics;
+	wlSpliceDiagnostics(&p->diagnostics, regionStart, spliceEnd, delta, regionDiagnostics);
+	wlSpliceDiagnostics(&p->lexer.diagnostics, regionStart, spliceEnd, delta, l.diagnostics);
+	listFree(&regionDiagnostics);
+	wlLexerFree(&l);
+
+	p->lexer.source = source;
+	p->lexer.index = source.len;
+	p->tokenEnd = store->count - 1;
+	p->tokenCursor = p->tokenEnd;
+	p->lastTokenEnd = source.len;
+	return true;
+}
+
+void wlPrint(WlAst *ast, WlNode n);
+
+void wlPrintList(WlAst *ast, WlNodeRange list, char *separator)
+{
+	for (int i = 0; i < list.len; i++) {
+		if (i) printf("%s", separator);
+		wlPrint(ast, wlAstChild(ast, list, i));
+	}
+}
+
+void wlPrintReferencePath(WlAst *ast, WlNode ref)
+{
+	int len;
+	WlAtom *path = wlAstPath(ast, ref, &len);
+	for (int i = 0; i < len; i++) {
+		printf(i ? ".%.*s" : "%.*s", STRPRINT(wlAtomText(path[i])));
+	}
+	printf(" ");
+}
+
+void wlPrint(WlAst *ast, WlNode n)
+{
+	WlKind kind = wlAstKind(ast, n);
+	WlNodeData d = wlAstData(ast, n);
+
+	if (kind < WlKind_Syntax_Start) {
+		if (kind == WlKind_Missing) {
 			// print nothing :3c
-		} else if (tk.kind == WlKind_String) {
-			printf("%s::\"%.*s\" ", WlKindText[tk.kind], STRPRINT(tk.valueStr));
-		} else if (tk.kind == WlKind_Symbol) {
-			printf("%s::%.*s ", WlKindText[tk.kind], STRPRINT(tk.valueStr));
-		} else if (tk.kind == WlKind_Number) {
-			printf("%s::%d ", WlKindText[tk.kind], tk.valueNum);
+		} else if (kind == WlKind_String) {
+			printf("%s::\"%.*s\" ", WlKindText[kind], STRPRINT(wlAstString(ast, n)));
+		} else if (kind == WlKind_Symbol) {
+			printf("%s::%.*s ", WlKindText[kind], STRPRINT(wlAtomText(d.lhs)));
+		} else if (kind == WlKind_Number) {
+			printf("%s::%lld ", WlKindText[kind], (long long)d.valueNum);
 		} else {
-			printf("%s ", WlKindText[tk.kind]);
+			printf("%s ", WlKindText[kind]);
 		}
 		return;
 	}
 
-	switch (tk.kind) {
+	switch (kind) {
+	case WlKind_StBlock: {
+		printf("{\n");
+		for (int i = 0; i < d.range.len; i++) {
+			wlPrint(ast, wlAstChild(ast, d.range, i));
+			printf("\n");
+		}
+		printf("}\n");
+	} break;
 	case WlKind_StBinaryExpression: {
-		WlBinaryExpression bin = *(WlBinaryExpression *)tk.valuePtr;
-		wlPrint(bin.left);
-		wlPrint(bin.operator);
-		wlPrint(bin.right);
+		WlBinaryExpression bin = wlAstBinary(ast, n);
+		wlPrint(ast, bin.left);
+		printf("%s ", WlKindText[bin.operator]);
+		wlPrint(ast, bin.right);
 	} break;
 	case WlKind_StExpressionStatement: {
-		WlExpressionStatement ex = *(WlExpressionStatement *)tk.valuePtr;
-		wlPrint(ex.expression);
-		wlPrint(ex.semicolon);
+		wlPrint(ast, d.lhs);
+		printf("; ");
 	} break;
 	case WlKind_StReturnStatement: {
-		WlReturnStatement ret = *(WlReturnStatement *)tk.valuePtr;
-		wlPrint(ret.returnKeyword);
-		wlPrint(ret.expression);
-		wlPrint(ret.semicolon);
+		printf("return ");
+		wlPrint(ast, d.lhs);
+		printf("; ");
 	} break;
 	case WlKind_StFunction: {
-		WlSyntaxFunction *fn = tk.valuePtr;
-		if (fn->export.kind == WlKind_KwExport) {
-			wlPrint(fn->export);
-		}
-		wlPrint(fn->type);
-		wlPrint(fn->name);
-		wlPrint(fn->parenOpen);
-		wlPrint(fn->parenClose);
-		wlPrintBlock(fn->body);
+		WlSyntaxFunction fn = wlAstFunction(ast, n);
+		if (fn.export) printf("export ");
+		wlPrint(ast, fn.type);
+		wlPrint(ast, fn.name);
+		printf("( ");
+		wlPrintList(ast, fn.parameters, ", ");
+		printf(") ");
+		wlPrint(ast, fn.body);
 	} break;
 	case WlKind_StImport: {
-		WlSyntaxImport *fn = tk.valuePtr;
-		wlPrint(fn->import);
-		wlPrint(fn->type);
-		wlPrint(fn->name);
-		wlPrint(fn->parenOpen);
-		wlPrint(fn->parenClose);
-		wlPrint(fn->semicolon);
+		WlSyntaxFunction fn = wlAstFunction(ast, n);
+		printf("import ");
+		wlPrint(ast, fn.type);
+		wlPrint(ast, fn.name);
+		printf("( ");
+		wlPrintList(ast, fn.parameters, ", ");
+		printf("); ");
+	} break;
+	case WlKind_StFunctionParameter: {
+		wlPrint(ast, d.lhs);
+		wlPrint(ast, d.rhs);
 	} break;
 	case WlKind_StCall: {
-		WlSyntaxCall call = *(WlSyntaxCall *)tk.valuePtr;
-		wlPrintReferencePath(call.path);
-		wlPrint(call.parenOpen);
-		for (int i = 0; i < listLen(call.args); i++) {
-			wlPrint(call.args[i]);
-		}
-		wlPrint(call.parenClose);
+		WlSyntaxCall call = wlAstCall(ast, n);
+		wlPrintReferencePath(ast, call.path);
+		printf("( ");
+		wlPrintList(ast, call.args, ", ");
+		printf(") ");
 	} break;
 	case WlKind_StVariableDeclaration: {
-		WlSyntaxVariableDeclaration var = *(WlSyntaxVariableDeclaration *)tk.valuePtr;
-		wlPrint(var.export);
-		wlPrint(var.type);
-		wlPrint(var.name);
-		wlPrint(var.equals);
-		wlPrint(var.initializer);
-		wlPrint(var.semicolon);
+		WlSyntaxVariableDeclaration var = wlAstVariableDeclaration(ast, n);
+		wlPrint(ast, var.type);
+		wlPrint(ast, var.name);
+		if (var.initializer != WLNODEMISSING) {
+			printf("= ");
+			wlPrint(ast, var.initializer);
+		}
+		printf("; ");
 	} break;
 	case WlKind_StVariableAssignement: {
-		WlAssignmentExpression var = *(WlAssignmentExpression *)tk.valuePtr;
-		wlPrint(var.variable);
-		wlPrint(var.equals);
-		wlPrint(var.expression);
-		wlPrint(var.semicolon);
+		wlPrint(ast, d.lhs);
+		printf("= ");
+		wlPrint(ast, d.rhs);
+		printf("; ");
 	} break;
 	case WlKind_StRef: {
 		printf("<ref>::");
-		wlPrintReferencePath(tk.valuePtr);
+		wlPrintReferencePath(ast, n);
 	} break;
 
-	default: PANIC("Unhandled print function for %s %d", WlKindText[tk.kind], tk.kind); break;
+	default: PANIC("Unhandled print function for %s %d", WlKindText[kind], kind); break;
 	}
 }
@@ -0,0 +1,622 @@
+#include <walc.h>
+
+// strength reduction, replaces arithmetic by cheaper arithmetic that computes the same value
+// multiplying by a power of two becomes a shift, unsigned division by one does too and unsigned remainder a mask
+// 32 bit division by other constants multiplies by a magic number and keeps the high half of the product, see
+// "Division by Invariant Integers using Multiplication" by Granlund and Montgomery. wasm has no 64 bit multiply high,
+// so 64 bit division by them is left alone
+// in loops, the product of an induction variable and an invariant is kept in a local that is stepped along with the
+// variable, so the loop adds instead of multiplies
+// runs after hoist, on bodies that are lowered, so for loops are already while loops
+
+// a product of an induction variable and an invariant, the local is assigned the product before the loop
+typedef struct {
+	WlSymbol *variable;
+	WlbNode factor;
+	WlSymbol *local;
+} WlReducerProduct;
+
+// an assignment in a loop, and the block it is a statement of, NULL when it's part of an expression
+typedef struct {
+	WlBoundAssignment *assignment;
+	WlBoundBlock *block;
+} WlReducerUpdate;
+
+typedef struct {
+	WlBinder *b;
+	// the function that is reduced, the new locals are added to its scope
+	WlBoundFunction *fn;
+	// the assignments in the loop that is reduced
+	List(WlReducerUpdate) updates;
+	List(WlReducerProduct) products;
+	// the assignments before the loop, of the products and the steps that aren't literals
+	List(WlbNode) initial;
+} WlReducer;
+
+static bool reducerIsInteger(WlBType type)
+{
+	return type == WlBType_i32 || type == WlBType_u32 || type == WlBType_i64 || type == WlBType_u64;
+}
+
+static bool reducerIsUnsigned(WlBType type) { return type == WlBType_u32 || type == WlBType_u64; }
+
+// the value of a literal in the width of its type
+static u64 reducerValue(WlbNode n)
+{
+	if (n.type == WlBType_i32 || n.type == WlBType_u32) return (u32)n.dataNum;
+	return (u64)n.dataNum;
+}
+
+// the exponent when value is a power of two, -1 when it isn't
+static int reducerLog2(u64 value)
+{
+	if (value == 0 || (value & (value - 1))) return -1;
+	int log = 0;
+	while (value > 1) {
+		value >>= 1;
+		log++;
+	}
+	return log;
+}
+
+static WlSymbol *reducerLocal(WlReducer *r, WlBType type)
+{
+	return lowerAddLocal(r->b, r->fn, (WlSymbol){.name = STR("reduced"), .type = type, .flags = WlSFlag_Variable});
+}
+
+static WlbNode reducerRef(WlSymbol *s) { return (WlbNode){.kind = WlBKind_Ref, .type = s->type, .data = s}; }
+
+static WlbNode reducerAssign(WlReducer *r, WlSymbol *s, WlbNode expression)
+{
+	WlBoundAssignment *asg = arenaMalloc(sizeof(WlBoundAssignment), &r->b->arena);
+	*asg = (WlBoundAssignment){.expression = expression, .symbol = s};
+	return (WlbNode){.kind = WlBKind_VariableAssignment, .type = s->type, .data = asg, .span = expression.span};
+}
+
+static WlbNode reducerBinary(WlReducer *r, WlbNode left, WlBOperator op, WlbNode right)
+{
+	WlBoundBinaryExpression *bin = arenaMalloc(sizeof(WlBoundBinaryExpression), &r->b->arena);
+	*bin = (WlBoundBinaryExpression){.left = left, .operator= op, .right = right};
+	return (WlbNode){.kind = WlBKind_BinaryExpression, .type = left.type, .data = bin, .span = left.span};
+}
+
+// a node that can be read twice, expressions are assigned to a local first
+static WlbNode reducerStable(WlReducer *r, WlbNode n, List(WlbNode) * prelude)
+{
+	if (n.kind == WlBKind_Ref || n.kind == WlBKind_NumberLiteral) return n;
+	WlSymbol *local = reducerLocal(r, n.type);
+	listPush(prelude, reducerAssign(r, local, n));
+	return reducerRef(local);
+}
+
+// the magic number and shift of a signed divisor, from Hacker's Delight 10-1
+// the divisor is not 0, 1, -1 or the minimum
+static void reducerSignedMagic(i32 d, i32 *magic, int *shift)
+{
+	const u32 two31 = 0x80000000u;
+	u32 ad = d < 0 ? -(u32)d : (u32)d;
+	u32 t = two31 + ((u32)d >> 31);
+	u32 anc = t - 1 - t % ad;
+	u32 q1 = two31 / anc, r1 = two31 - q1 * anc;
+	u32 q2 = two31 / ad, r2 = two31 - q2 * ad;
+	u32 delta;
+	int p = 31;
+	do {
+		p++;
+		q1 *= 2;
+		r1 *= 2;
+		if (r1 >= anc) {
+			q1++;
+			r1 -= anc;
+		}
+		q2 *= 2;
+		r2 *= 2;
+		if (r2 >= ad) {
+			q2++;
+			r2 -= ad;
+		}
+		delta = ad - r2;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+
+	*magic = (i32)(q2 + 1);
+	if (d < 0) *magic = -*magic;
+	*shift = p - 32;
+}
+
+// the magic number and shift of an unsigned divisor, from Hacker's Delight 10-10
+// add is set when the magic number takes 33 bits, its top bit is added back after the multiply
+static void reducerUnsignedMagic(u32 d, u32 *magic, int *shift, bool *add)
+{
+	u32 nc = -1 - (-d) % d;
+	u32 q1 = 0x80000000u / nc, r1 = 0x80000000u - q1 * nc;
+	u32 q2 = 0x7FFFFFFFu / d, r2 = 0x7FFFFFFFu - q2 * d;
+	u32 delta;
+	int p = 31;
+	*add = false;
+	do {
+		p++;
+		if (r1 >= nc - r1) {
+			q1 = 2 * q1 + 1;
+			r1 = 2 * r1 - nc;
+		} else {
+			q1 = 2 * q1;
+			r1 = 2 * r1;
+		}
+		if (r2 + 1 >= d - r2) {
+			if (q2 >= 0x7FFFFFFFu) *add = true;
+			q2 = 2 * q2 + 1;
+			r2 = 2 * r2 + 1 - d;
+		} else {
+			if (q2 >= 0x80000000u) *add = true;
+			q2 = 2 * q2;
+			r2 = 2 * r2 + 1;
+		}
+		delta = d - 1 - r2;
+	} while (p < 64 && (q1 < delta || (q1 == delta && r1 == 0)));
+
+	*magic = q2 + 1;
+	*shift = p - 32;
+}
+
+// whether a 32 bit division by the literal is done with a magic number
+static bool reducerHasMagic(WlbNode divisor)
+{
+	if (divisor.type == WlBType_u32) return (u32)divisor.dataNum > 1;
+	if (divisor.type == WlBType_i32) {
+		i32 d = (i32)divisor.dataNum;
+		return d != 0 && d != 1 && d != -1 && d != INT32_MIN;
+	}
+	return false;
+}
+
+// the quotient of a 32 bit division by a literal that has a magic number
+static WlbNode reducerQuotient(WlReducer *r, WlbNode n, WlbNode divisor, List(WlbNode) * prelude)
+{
+	WlBType type = n.type;
+	if (type == WlBType_i32) {
+		i32 d = (i32)divisor.dataNum, magic;
+		int shift;
+		reducerSignedMagic(d, &magic, &shift);
+
+		// the magic number of the divisor was taken modulo 2^32, the dividend it lost is added back
+		bool fix = (d > 0 && magic < 0) || (d < 0 && magic > 0);
+		if (fix) n = reducerStable(r, n, prelude);
+		WlbNode q = reducerBinary(r, n, WlBOperator_MultiplyHigh, folderIntegerLiteral(divisor, type, (u64)(i64)magic));
+		if (fix) q = reducerBinary(r, q, d > 0 ? WlBOperator_Add : WlBOperator_Subtract, n);
+		if (shift) q = reducerBinary(r, q, WlBOperator_ShiftRight, folderIntegerLiteral(divisor, type, shift));
+
+		// the quotient is rounded down, negative ones are one too small
+		WlSymbol *t = reducerLocal(r, type);
+		listPush(prelude, reducerAssign(r, t, q));
+		WlbNode sign = reducerBinary(r, reducerRef(t), WlBOperator_ShiftRight, folderIntegerLiteral(divisor, type, 31));
+		return reducerBinary(r, reducerRef(t), WlBOperator_Subtract, sign);
+	}
+
+	u32 magic;
+	int shift;
+	bool add;
+	reducerUnsignedMagic((u32)divisor.dataNum, &magic, &shift, &add);
+	if (!add) {
+		WlbNode q = reducerBinary(r, n, WlBOperator_MultiplyHigh, folderIntegerLiteral(divisor, type, magic));
+		if (shift) q = reducerBinary(r, q, WlBOperator_ShiftRight, folderIntegerLiteral(divisor, type, shift));
+		return q;
+	}
+
+	// (n * (2^32 + magic)) >> (32 + shift) without overflowing
+	n = reducerStable(r, n, prelude);
+	WlSymbol *t = reducerLocal(r, type);
+	WlbNode high = reducerBinary(r, n, WlBOperator_MultiplyHigh, folderIntegerLiteral(divisor, type, magic));
+	listPush(prelude, reducerAssign(r, t, high));
+	WlbNode half = reducerBinary(r, reducerBinary(r, n, WlBOperator_Subtract, reducerRef(t)), WlBOperator_ShiftRight,
+								 folderIntegerLiteral(divisor, type, 1));
+	WlbNode q = reducerBinary(r, half, WlBOperator_Add, reducerRef(t));
+	if (shift > 1) q = reducerBinary(r, q, WlBOperator_ShiftRight, folderIntegerLiteral(divisor, type, shift - 1));
+	return q;
+}
+
+// replaces a binary expression with a literal operand by a cheaper one
+static void reduceBinary(WlReducer *r, WlbNode *n)
+{
+	WlBoundBinaryExpression *bin = n->data;
+	WlBType type = bin->left.type;
+	if (!reducerIsInteger(type)) return;
+
+	if (bin->operator== WlBOperator_Multiply && bin->left.kind == WlBKind_NumberLiteral &&
+		bin->right.kind != WlBKind_NumberLiteral) {
+		WlbNode left = bin->left;
+		bin->left = bin->right;
+		bin->right = left;
+	}
+	if (bin->right.kind != WlBKind_NumberLiteral) return;
+
+	WlbNode right = bin->right;
+	// the product wraps, so it's the same whether the literal is signed or not
+	int log = reducerLog2(reducerValue(right));
+	switch (bin->operator) {
+	case WlBOperator_Multiply:
+		if (log > 0) {
+			bin->operator= WlBOperator_ShiftLeft;
+			bin->right = folderIntegerLiteral(right, type, log);
+		}
+		break;
+	case WlBOperator_Divide:
+		if (reducerIsUnsigned(type) && log > 0) {
+			bin->operator= WlBOperator_ShiftRight;
+			bin->right = folderIntegerLiteral(right, type, log);
+		} else if (reducerHasMagic(right)) {
+			List(WlbNode) prelude = listNew();
+			WlbNode q = reducerQuotient(r, bin->left, right, &prelude);
+			if (!listLen(prelude)) {
+				q.span = n->span;
+				*n = q;
+				break;
+			}
+			listPush(&prelude, q);
+			WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &r->b->arena);
+			*blk = (WlBoundBlock){.scope = NULL, .nodes = prelude};
+			*n = (WlbNode){.kind = WlBKind_Block, .type = n->type, .data = blk, .span = n->span};
+		}
+		break;
+	case WlBOperator_Modulo:
+		if (reducerIsUnsigned(type) && log > 0) {
+			bin->operator= WlBOperator_BitwiseAnd;
+			bin->right = folderIntegerLiteral(right, type, reducerValue(right) - 1);
+		} else if (reducerHasMagic(right)) {
+			// n - n / d * d, the dividend is read twice
+			List(WlbNode) prelude = listNew();
+			WlbNode dividend = reducerStable(r, bin->left, &prelude);
+			WlbNode quotient = reducerQuotient(r, dividend, right, &prelude);
+			WlbNode product = reducerBinary(r, quotient, WlBOperator_Multiply, right);
+			reduceBinary(r, &product);
+			listPush(&prelude, reducerBinary(r, dividend, WlBOperator_Subtract, product));
+			WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &r->b->arena);
+			*blk = (WlBoundBlock){.scope = NULL, .nodes = prelude};
+			*n = (WlbNode){.kind = WlBKind_Block, .type = n->type, .data = blk, .span = n->span};
+		}
+		break;
+	default: break;
+	}
+}
+
+// reduces the operands before the expression, so those that are replaced are not looked at twice
+static void reduceNode(WlReducer *r, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			reduceNode(r, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		reduceNode(r, &st->condition);
+		reduceNode(r, &st->thenBlock);
+		reduceNode(r, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		reduceNode(r, &st->condition);
+		reduceNode(r, &st->block);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		reduceNode(r, &st->block);
+		reduceNode(r, &st->condition);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		reduceNode(r, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			reduceNode(r, &st->args[i]);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		reduceNode(r, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		reduceNode(r, &st->left);
+		reduceNode(r, &st->right);
+		reduceBinary(r, n);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		reduceNode(r, &st->expression);
+	} break;
+	default: break;
+	}
+}
+
+static void reducerCollectUpdates(WlReducer *r, WlbNode n, WlBoundBlock *parent)
+{
+	switch (n.kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			reducerCollectUpdates(r, blk->nodes[i], blk);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		reducerCollectUpdates(r, st->condition, NULL);
+		reducerCollectUpdates(r, st->thenBlock, NULL);
+		reducerCollectUpdates(r, st->elseBlock, NULL);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		reducerCollectUpdates(r, st->condition, NULL);
+		reducerCollectUpdates(r, st->block, NULL);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		reducerCollectUpdates(r, st->block, NULL);
+		reducerCollectUpdates(r, st->condition, NULL);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n.data;
+		reducerCollectUpdates(r, st->expression, NULL);
+		listPush(&r->updates, ((WlReducerUpdate){.assignment = st, .block = parent}));
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			reducerCollectUpdates(r, st->args[i], NULL);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n.data;
+		reducerCollectUpdates(r, st->expression, NULL);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		reducerCollectUpdates(r, st->left, NULL);
+		reducerCollectUpdates(r, st->right, NULL);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		reducerCollectUpdates(r, st->expression, NULL);
+	} break;
+	default: break;
+	}
+}
+
+// the literal an induction variable is stepped by, an assignment of the form i = i + c, i = c + i or i = i - c
+static WlbNode *reducerStep(WlReducerUpdate u, WlBOperator *op)
+{
+	WlBoundAssignment *asg = u.assignment;
+	if (!u.block || asg->expression.kind != WlBKind_BinaryExpression) return NULL;
+	WlBoundBinaryExpression *bin = asg->expression.data;
+	*op = bin->operator;
+	bool isVariable = bin->left.kind == WlBKind_Ref && bin->left.data == asg->symbol;
+	if (isVariable && bin->right.kind == WlBKind_NumberLiteral &&
+		(bin->operator== WlBOperator_Add || bin->operator== WlBOperator_Subtract)) {
+		return &bin->right;
+	}
+	if (bin->operator== WlBOperator_Add && bin->left.kind == WlBKind_NumberLiteral && bin->right.kind == WlBKind_Ref &&
+		bin->right.data == asg->symbol) {
+		return &bin->left;
+	}
+	return NULL;
+}
+
+// an integer variable that the loop only steps by literals, in statements so the products can be stepped after them
+static bool reducerIsInductionVariable(WlReducer *r, WlSymbol *s)
+{
+	if (!reducerIsInteger(s->type)) return false;
+	bool stepped = false;
+	for (int i = 0; i < listLen(r->updates); i++) {
+		if (r->updates[i].assignment->symbol != s) continue;
+		WlBOperator op;
+		if (!reducerStep(r->updates[i], &op)) return false;
+		stepped = true;
+	}
+	return stepped;
+}
+
+// literals other than 0 and 1, and variables the loop doesn't assign
+static bool reducerIsFactor(WlReducer *r, WlbNode n)
+{
+	if (n.kind == WlBKind_NumberLiteral) return reducerValue(n) > 1;
+	if (n.kind != WlBKind_Ref || (((WlSymbol *)n.data)->flags & WlSFlag_TypeBits) != WlSFlag_Variable) return false;
+	for (int i = 0; i < listLen(r->updates); i++) {
+		if (r->updates[i].assignment->symbol == n.data) return false;
+	}
+	return true;
+}
+
+static bool reducerIsSameFactor(WlbNode a, WlbNode b)
+{
+	if (a.kind != b.kind) return false;
+	if (a.kind == WlBKind_NumberLiteral) return reducerValue(a) == reducerValue(b);
+	return a.data == b.data;
+}
+
+// replaces the products of induction variables and invariants by the local they are kept in
+static void reduceProducts(WlReducer *r, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			reduceProducts(r, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		reduceProducts(r, &st->condition);
+		reduceProducts(r, &st->thenBlock);
+		reduceProducts(r, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		reduceProducts(r, &st->condition);
+		reduceProducts(r, &st->block);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		reduceProducts(r, &st->block);
+		reduceProducts(r, &st->condition);
+	} break;
+	case WlBKind_VariableAssignment: {
+		WlBoundAssignment *st = n->data;
+		reduceProducts(r, &st->expression);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n->data;
+		for (int i = 0; i < listLen(st->args); i++) {
+			reduceProducts(r, &st->args[i]);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n->data;
+		reduceProducts(r, &st->expression);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n->data;
+		for (int side = 0; side < 2 && st->operator== WlBOperator_Multiply && reducerIsInteger(n->type); side++) {
+			WlbNode variable = side ? st->right : st->left, factor = side ? st->left : st->right;
+			if (variable.kind != WlBKind_Ref || !reducerIsInductionVariable(r, variable.data) ||
+				!reducerIsFactor(r, factor)) {
+				continue;
+			}
+
+			WlSymbol *local = NULL;
+			for (int i = 0; i < listLen(r->products); i++) {
+				if (r->products[i].variable == variable.data && reducerIsSameFactor(r->products[i].factor, factor)) {
+					local = r->products[i].local;
+				}
+			}
+			if (!local) {
+				// the product itself is what the local starts out as
+				local = reducerLocal(r, n->type);
+				listPush(&r->initial, reducerAssign(r, local, *n));
+				WlReducerProduct product = {.variable = variable.data, .factor = factor, .local = local};
+				listPush(&r->products, product);
+			}
+			*n = (WlbNode){.kind = WlBKind_Ref, .type = n->type, .data = local, .span = n->span};
+			return;
+		}
+		reduceProducts(r, &st->left);
+		reduceProducts(r, &st->right);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n->data;
+		reduceProducts(r, &st->expression);
+	} break;
+	default: break;
+	}
+}
+
+// puts the step of a product right after the step of its variable, so it is the product wherever it is read
+static void reducerInsertAfter(WlBoundBlock *blk, WlBoundAssignment *asg, WlbNode step)
+{
+	int at = 0;
+	while (blk->nodes[at].data != asg) at++;
+	listPush(&blk->nodes, step);
+	for (int i = listLen(blk->nodes) - 1; i > at + 1; i--) {
+		blk->nodes[i] = blk->nodes[i - 1];
+	}
+	blk->nodes[at + 1] = step;
+}
+
+// the product locals are stepped by the step of their variable times the factor
+static void reducerStepProducts(WlReducer *r)
+{
+	for (int i = 0; i < listLen(r->products); i++) {
+		WlReducerProduct p = r->products[i];
+		for (int j = 0; j < listLen(r->updates); j++) {
+			WlReducerUpdate u = r->updates[j];
+			if (u.assignment->symbol != p.variable) continue;
+			WlBOperator op;
+			WlbNode literal = *reducerStep(u, &op);
+
+			WlbNode step;
+			if (p.factor.kind == WlBKind_NumberLiteral) {
+				step = folderIntegerLiteral(literal, p.local->type, reducerValue(literal) * reducerValue(p.factor));
+			} else if (reducerValue(literal) == 1) {
+				step = p.factor;
+			} else {
+				WlSymbol *local = reducerLocal(r, p.local->type);
+				listPush(&r->initial,
+						 reducerAssign(r, local, reducerBinary(r, p.factor, WlBOperator_Multiply, literal)));
+				step = reducerRef(local);
+			}
+			reducerInsertAfter(u.block, u.assignment,
+							   reducerAssign(r, p.local, reducerBinary(r, reducerRef(p.local), op, step)));
+		}
+	}
+}
+
+// the loop becomes a block that assigns the product locals and then runs the loop
+static void reduceLoop(WlReducer *r, WlbNode *loop)
+{
+	if (r->updates) LISTHEAD(r->updates)->len = 0;
+	if (r->products) LISTHEAD(r->products)->len = 0;
+	if (r->initial) LISTHEAD(r->initial)->len = 0;
+	reducerCollectUpdates(r, *loop, NULL);
+	reduceProducts(r, loop);
+	if (!listLen(r->products)) return;
+	reducerStepProducts(r);
+
+	WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &r->b->arena);
+	*blk = (WlBoundBlock){.scope = NULL, .nodes = listNew()};
+	for (int i = 0; i < listLen(r->initial); i++) {
+		listPush(&blk->nodes, r->initial[i]);
+	}
+	listPush(&blk->nodes, *loop);
+	*loop = (WlbNode){.kind = WlBKind_Block, .type = WlBType_u0, .data = blk, .span = loop->span};
+}
+
+// inner loops are reduced first, their products may step with a variable of the outer loop too
+static void reduceLoops(WlReducer *r, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			reduceLoops(r, &blk->nodes[i]);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		reduceLoops(r, &st->thenBlock);
+		reduceLoops(r, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		reduceLoops(r, &st->block);
+		reduceLoop(r, n);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		reduceLoops(r, &st->block);
+		reduceLoop(r, n);
+	} break;
+	default: break;
+	}
+}
+
+void reduceFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (!fn->lowered || fn->optimized || fn->body.kind != WlBKind_Block) return;
+	WlReducer r = {.b = b, .fn = fn};
+	// the products are taken out of loops before they are turned into shifts
+	reduceLoops(&r, &fn->body);
+	reduceNode(&r, &fn->body);
+	listFree(&r.updates);
+	listFree(&r.products);
+	listFree(&r.initial);
+}
+
+// runs after hoist, the steps of the products that aren't literals are invariant once it has
+void reduce(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		reduceFunction(b, b->functions[i]);
+	}
+}
@@ -0,0 +1,163 @@
+#ifndef SCAN_H
+#define SCAN_H
+#include <sti_base.h>
+
+// vectorized byte scanning used by the lexer
+// every function takes a buffer, a start index and the buffer length and returns the index of the first byte
+// that stops the scan, or len when the end of the buffer is reached
+// vector loads are only performed on full chunks that lie within [0, len), the tail is handled by scalar code
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCAN_SSE2
+#endif
+
+#if defined(SCAN_AVX2) || defined(SCAN_SSE2)
+#ifdef _MSC_VER
+#include <intrin.h>
+static inline int scanCtz(unsigned int mask)
+{
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+}
+#else
+#define scanCtz(mask) __builtin_ctz(mask)
+#endif
+#endif
+
+static inline bool scanIsWhitespace(unsigned char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+static inline bool scanIsSymbol(unsigned char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= '_' && c <= 'z') || (c >= 128 && c <= 254);
+}
+
+#ifdef SCAN_SSE2
+// bytes in the unsigned range [lo, hi] become 0xFF
+static inline __m128i scanInRange16(__m128i v, unsigned char lo, unsigned char hi)
+{
+	__m128i shifted = _mm_sub_epi8(v, _mm_set1_epi8((char)lo));
+	return _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8((char)(hi - lo))), shifted);
+}
+#endif
+
+#ifdef SCAN_AVX2
+static inline __m256i scanInRange32(__m256i v, unsigned char lo, unsigned char hi)
+{
+	__m256i shifted = _mm256_sub_epi8(v, _mm256_set1_epi8((char)lo));
+	return _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8((char)(hi - lo))), shifted);
+}
+#endif
+
+// skips spaces, tabs and newlines
+static inline int scanSkipWhitespace(char *buf, int i, int len)
+{
+#if defined(SCAN_AVX2)
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	while (i + 32 <= len) {
+		__m256i v = _mm256_loadu_si256((__m256i *)(buf + i));
+		__m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+									 _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, lf)));
+		unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(ws);
+		if (mask) return i + scanCtz(mask);
+		i += 32;
+	}
+#elif defined(SCAN_SSE2)
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	while (i + 16 <= len) {
+		__m128i v = _mm_loadu_si128((__m128i *)(buf + i));
+		__m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+								  _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+		unsigned int mask = ~_mm_movemask_epi8(ws) & 0xFFFF;
+		if (mask) return i + scanCtz(mask);
+		i += 16;
+	}
+#endif
+	while (i < len && scanIsWhitespace(buf[i]))
+		i++;
+	return i;
+}
+
+// finds the first occurence of any of the three given bytes
+// pass the same byte multiple times to search for fewer candidates
+static inline int scanFindAny3(char *buf, int i, int len, char a, char b, char c)
+{
+#if defined(SCAN_AVX2)
+	const __m256i va = _mm256_set1_epi8(a);
+	const __m256i vb = _mm256_set1_epi8(b);
+	const __m256i vc = _mm256_set1_epi8(c);
+	while (i + 32 <= len) {
+		__m256i v = _mm256_loadu_si256((__m256i *)(buf + i));
+		__m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)),
+									  _mm256_cmpeq_epi8(v, vc));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(hit);
+		if (mask) return i + scanCtz(mask);
+		i += 32;
+	}
+#elif defined(SCAN_SSE2)
+	const __m128i va = _mm_set1_epi8(a);
+	const __m128i vb = _mm_set1_epi8(b);
+	const __m128i vc = _mm_set1_epi8(c);
+	while (i + 16 <= len) {
+		__m128i v = _mm_loadu_si128((__m128i *)(buf + i));
+		__m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)), _mm_cmpeq_epi8(v, vc));
+		unsigned int mask = _mm_movemask_epi8(hit);
+		if (mask) return i + scanCtz(mask);
+		i += 16;
+	}
+#endif
+	while (i < len && buf[i] != a && buf[i] != b && buf[i] != c)
+		i++;
+	return i;
+}
+
+// finds the end of the current line, which is a newline or a null byte
+static inline int scanFindEndOfLine(char *buf, int i, int len) { return scanFindAny3(buf, i, len, '\n', '\r', '\0'); }
+
+// finds the end of a string literal, which is a quote or a null byte
+static inline int scanFindStringEnd(char *buf, int i, int len) { return scanFindAny3(buf, i, len, '"', '"', '\0'); }
+
+// finds the next candidate for the start or end of a block comment
+// the caller inspects the byte that follows to see if it is actually '/*' or '*/'
+static inline int scanFindCommentDelimiter(char *buf, int i, int len)
+{
+	return scanFindAny3(buf, i, len, '/', '*', '\0');
+}
+
+// skips a run of symbol characters (anything that is not reserved by the compiler)
+static inline int scanSymbolRun(char *buf, int i, int len)
+{
+#if defined(SCAN_AVX2)
+	while (i + 32 <= len) {
+		__m256i v = _mm256_loadu_si256((__m256i *)(buf + i));
+		__m256i symbol = _mm256_or_si256(_mm256_or_si256(scanInRange32(v, '0', '9'), scanInRange32(v, 'A', 'Z')),
+										 _mm256_or_si256(scanInRange32(v, '_', 'z'), scanInRange32(v, 128, 254)));
+		unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(symbol);
+		if (mask) return i + scanCtz(mask);
+		i += 32;
+	}
+#elif defined(SCAN_SSE2)
+	while (i + 16 <= len) {
+		__m128i v = _mm_loadu_si128((__m128i *)(buf + i));
+		__m128i symbol = _mm_or_si128(_mm_or_si128(scanInRange16(v, '0', '9'), scanInRange16(v, 'A', 'Z')),
+									  _mm_or_si128(scanInRange16(v, '_', 'z'), scanInRange16(v, 128, 254)));
+		unsigned int mask = ~_mm_movemask_epi8(symbol) & 0xFFFF;
+		if (mask) return i + scanCtz(mask);
+		i += 16;
+	}
+#endif
+	while (i < len && scanIsSymbol(buf[i]))
+		i++;
+	return i;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include <walc.h>
+
+// tree shaking, finds the functions and imports that can be called from an export or @entrypoint function
+// the emitter only adds the live ones to the module, and with them only the data their string literals use
+// runs on the lowered and folded bodies, so calls in branches the folder removed don't keep a function alive
+
+static void shakeFunction(WlBoundFunction *fn, List(WlBoundFunction *) * work)
+{
+	if (fn->live) return;
+	fn->live = true;
+	listPush(work, fn);
+}
+
+static void shakeNode(WlbNode n, List(WlBoundFunction *) * work)
+{
+	switch (n.kind) {
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			shakeNode(blk->nodes[i], work);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		shakeNode(st->condition, work);
+		shakeNode(st->thenBlock, work);
+		shakeNode(st->elseBlock, work);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		shakeNode(st->condition, work);
+		shakeNode(st->block, work);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n.data;
+		shakeNode(st->block, work);
+		shakeNode(st->condition, work);
+	} break;
+	case WlBKind_ForLoop: {
+		WlBoundFor *st = n.data;
+		shakeNode(st->preCondition, work);
+		shakeNode(st->condition, work);
+		shakeNode(st->postCondition, work);
+		shakeNode(st->block, work);
+	} break;
+	case WlBKind_VariableDeclaration: {
+		WlBoundVariable *st = n.data;
+		shakeNode(st->initializer, work);
+	} break;
+	case WlBKind_VariableAssignment:
+	case WlBKind_AssignmentExpression: {
+		WlBoundAssignment *st = n.data;
+		shakeNode(st->expression, work);
+	} break;
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		shakeFunction(st->function->function, work);
+		for (int i = 0; i < listLen(st->args); i++) {
+			shakeNode(st->args[i], work);
+		}
+	} break;
+	case WlBKind_Return: {
+		WlBoundReturn *st = n.data;
+		shakeNode(st->expression, work);
+	} break;
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *st = n.data;
+		shakeNode(st->left, work);
+		shakeNode(st->right, work);
+	} break;
+	case WlBKind_TernaryExpression: {
+		WlBoundTernaryExpression *st = n.data;
+		shakeNode(st->condition, work);
+		shakeNode(st->thenExpr, work);
+		shakeNode(st->elseExpr, work);
+	} break;
+	case WlBKind_PreUnaryExpression: {
+		WlBoundPreUnaryExpression *st = n.data;
+		shakeNode(st->expression, work);
+	} break;
+	case WlBKind_PostUnaryExpression: {
+		WlBoundPostUnaryExpression *st = n.data;
+		shakeNode(st->expression, work);
+	} break;
+	default: break;
+	}
+}
+
+// marks the functions reachable from the exports and @entrypoint functions as live
+// the symbol indices of the previous module are dropped, the emitter hands them out again over the live functions only
+// so the function index space stays dense
+void shake(WlBinder *b)
+{
+	List(WlBoundFunction *) work = listNew();
+	for (int i = 0; i < listLen(b->functions); i++) {
+		WlBoundFunction *fn = b->functions[i];
+		fn->live = false;
+		fn->symbol->index = -1;
+	}
+	for (int i = 0; i < listLen(b->functions); i++) {
+		WlBoundFunction *fn = b->functions[i];
+		if (fn->symbol->flags & (WlSFlag_Export | WlSFlag_Entrypoint)) shakeFunction(fn, &work);
+	}
+
+	// bodies reach more functions, which are appended to the worklist
+	for (int i = 0; i < listLen(work); i++) {
+		shakeNode(work[i]->body, &work);
+	}
+	listFree(&work);
+}
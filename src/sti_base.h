@@ -46,6 +46,17 @@ extern "C" {
 #error "Unknown compiler"
 #endif
 
+#ifdef PLATFORM_WIN
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 typedef uint8_t u8;
 typedef uint16_t u16;
 typedef uint32_t u32;
@@ -202,7 +213,7 @@ Str strFormat(const char *fmt, ...)
 	s[len] = 0;
 
 	va_start(args, fmt);
-	vsnprintf(s, len, fmt, args);
+	vsnprintf(s, len + 1, fmt, args);
 	va_end(args);
 
 	return (Str){s, len};
@@ -303,7 +314,7 @@ void listEnsureCapacity__(void **lp, int size);
 #define listPeek(lp) (listLen(*(lp)) == 0 ? NULL : (*(lp))[LISTHEAD(*(lp))->len - 1])
 #define listFree(lp) (free(LISTHEAD(*(lp))), *(lp) = NULL)
 
-#define listReserve(lp, n) listReserve_impl(lp, n, sizeof(**(lp)))
+#define listReserve(lp, n) listReserve_impl((void **)(lp), n, sizeof(**(lp)))
 
 void listReserve_impl(void **lp, int itemCount, int size)
 {
@@ -487,12 +498,102 @@ bool fileReadAllText(const char *filename, Str *data)
 	fseek(fp, 0, SEEK_SET);
 	char *buf = smalloc(sizeof(char) * (len + 1));
 	fread(buf, 1, len, fp);
+	buf[len] = '\0';
 	data->buf = buf;
 	data->len = len;
 	fclose(fp);
 	return true;
 }
 
+// maps the file into memory read only instead of copying it onto the heap
+// like fileReadAllText the returned data is always followed by a zero byte
+// the data must be released with fileUnmap
+#ifdef PLATFORM_WIN
+bool fileMapAllText(const char *filename, Str *data)
+{
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart % info.dwPageSize == 0) {
+		// the view ends exactly on a page boundary so there is no room for the zero byte, read it instead
+		CloseHandle(file);
+		return fileReadAllText(filename, data);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping) return fileReadAllText(filename, data);
+
+	char *buf = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!buf) return fileReadAllText(filename, data);
+
+	// the rest of the last page is zero filled, which gives us the sentinel
+	data->buf = buf;
+	data->len = size.QuadPart;
+	return true;
+}
+
+void fileUnmap(Str *data)
+{
+	MEMORY_BASIC_INFORMATION info;
+	if (data->buf && VirtualQuery(data->buf, &info, sizeof(info)) && info.Type == MEM_MAPPED) {
+		UnmapViewOfFile(data->buf);
+	} else {
+		free(data->buf);
+	}
+	*data = STREMPTY;
+}
+#else
+static size_t fileMapLength(size_t len)
+{
+	// always leave room for at least one zero byte past the end of the file
+	size_t pageSize = sysconf(_SC_PAGESIZE);
+	return (len / pageSize + 1) * pageSize;
+}
+
+bool fileMapAllText(const char *filename, Str *data)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return false;
+	}
+
+	// reserve zeroed pages for the file plus the sentinel, then map the file over the start of the reservation
+	size_t len = st.st_size;
+	size_t mapLen = fileMapLength(len);
+	char *buf = mmap(NULL, mapLen, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	if (len > 0 && mmap(buf, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		munmap(buf, mapLen);
+		close(fd);
+		return false;
+	}
+	close(fd);
+
+	data->buf = buf;
+	data->len = len;
+	return true;
+}
+
+void fileUnmap(Str *data)
+{
+	if (data->buf) munmap(data->buf, fileMapLength(data->len));
+	*data = STREMPTY;
+}
+#endif
+
 // runs terminal command
 int commandReadAllText(const char *command, Str *data)
 {
@@ -563,6 +664,15 @@ void *arenaMalloc(size_t bytes, ArenaAllocator *alloc)
 	return offset;
 }
 
+// moves the pages of from into alloc, which frees them together with its own
+void arenaAppend(ArenaAllocator *alloc, ArenaAllocator *from)
+{
+	alloc->current->next = from->first;
+	alloc->current = from->current;
+	from->first = NULL;
+	from->current = NULL;
+}
+
 void arenaFree(ArenaAllocator *alloc)
 {
 	ArenaPage *page = alloc->first;
@@ -0,0 +1,73 @@
+#ifndef THREAD_H
+#define THREAD_H
+#include <sti_base.h>
+
+// minimal portable threads, just enough to fan work out to a few workers and wait for them
+// the Thread has to stay alive until it is joined, because the platform entry point reads it
+
+#ifndef PLATFORM_WIN
+#include <pthread.h>
+#endif
+
+typedef void (*ThreadFunction)(void *arg);
+
+typedef struct {
+	ThreadFunction function;
+	void *arg;
+#ifdef PLATFORM_WIN
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+} Thread;
+
+#ifdef PLATFORM_WIN
+static DWORD WINAPI threadEntry(LPVOID t)
+{
+	((Thread *)t)->function(((Thread *)t)->arg);
+	return 0;
+}
+#else
+static void *threadEntry(void *t)
+{
+	((Thread *)t)->function(((Thread *)t)->arg);
+	return NULL;
+}
+#endif
+
+static inline void threadStart(Thread *t, ThreadFunction function, void *arg)
+{
+	t->function = function;
+	t->arg = arg;
+#ifdef PLATFORM_WIN
+	t->handle = CreateThread(NULL, 0, threadEntry, t, 0, NULL);
+	if (t->handle == NULL) PANIC("Failed to start thread");
+#else
+	if (pthread_create(&t->handle, NULL, threadEntry, t) != 0) PANIC("Failed to start thread");
+#endif
+}
+
+static inline void threadJoin(Thread *t)
+{
+#ifdef PLATFORM_WIN
+	WaitForSingleObject(t->handle, INFINITE);
+	CloseHandle(t->handle);
+#else
+	pthread_join(t->handle, NULL);
+#endif
+}
+
+// number of hardware threads, at least 1
+static inline int threadProcessorCount()
+{
+#ifdef PLATFORM_WIN
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	int count = info.dwNumberOfProcessors;
+#else
+	int count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? count : 1;
+}
+
+#endif
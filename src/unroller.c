@@ -0,0 +1,383 @@
+#include <walc.h>
+
+// loop unrolling, copies the body of counted loops so they branch and step their counter less often
+// a counted loop is a while loop that compares an integer variable to a literal or to a variable the loop doesn't
+// assign, and steps the variable by a literal at the end of its body and nowhere else, like for loops are lowered to
+// a loop that runs a known number of times is replaced by that many copies of its body in which the variable is a
+// literal. other loops run several copies of their body per iteration for as long as that many iterations are left,
+// and are followed by the loop itself for the iterations that remain
+// the copies may take up to UNROLLERBUDGET nodes, @unroll(n) on a for loop copies its body n times whatever its size
+// and @unroll(1) leaves it alone
+// runs after fold, the function is folded again once a loop is unrolled so the copies fold with their literal
+
+// the most nodes the copies of the body of a loop may take
+#define UNROLLERBUDGET 96
+// how many copies of its body a loop that doesn't run a known number of times runs per iteration
+#define UNROLLERFACTOR 4
+
+typedef struct {
+	WlBinder *b;
+	// the function the loops are in, the copies are folded with it
+	WlBoundFunction *fn;
+	// the variables the loop that is unrolled assigns
+	List(WlSymbol *) assigned;
+	bool unrolled;
+} WlUnroller;
+
+// variable compare bound holds for as long as the loop runs, the variable is stepped by step in direction
+typedef struct {
+	WlSymbol *variable;
+	WlBOperator compare;
+	WlbNode bound;
+	WlBOperator direction;
+	u64 step;
+} WlUnrollerCount;
+
+static bool unrollerIsInteger(WlBType type)
+{
+	return type == WlBType_i32 || type == WlBType_u32 || type == WlBType_i64 || type == WlBType_u64;
+}
+
+static u64 unrollerMin(WlBType type)
+{
+	switch (type) {
+	case WlBType_i32: return (u32)INT32_MIN;
+	case WlBType_i64: return (u64)INT64_MIN;
+	default: return 0;
+	}
+}
+
+static u64 unrollerMax(WlBType type)
+{
+	switch (type) {
+	case WlBType_i32: return INT32_MAX;
+	case WlBType_u32: return UINT32_MAX;
+	case WlBType_i64: return INT64_MAX;
+	default: return UINT64_MAX;
+	}
+}
+
+// the same comparison with its operands swapped
+static WlBOperator unrollerMirror(WlBOperator op)
+{
+	switch (op) {
+	case WlBOperator_Greater: return WlBOperator_Less;
+	case WlBOperator_GreaterOrEqual: return WlBOperator_LessOrEqual;
+	case WlBOperator_Less: return WlBOperator_Greater;
+	case WlBOperator_LessOrEqual: return WlBOperator_GreaterOrEqual;
+	default: return op;
+	}
+}
+
+static WlbNode unrollerBinary(WlUnroller *u, WlbNode left, WlBOperator op, WlbNode right, WlBType type)
+{
+	WlBoundBinaryExpression *bin = arenaMalloc(sizeof(WlBoundBinaryExpression), &u->b->arena);
+	*bin = (WlBoundBinaryExpression){.left = left, .operator= op, .right = right};
+	return (WlbNode){.kind = WlBKind_BinaryExpression, .type = type, .data = bin, .span = left.span};
+}
+
+static WlbNode unrollerBlock(WlUnroller *u, WlSpan span)
+{
+	WlBoundBlock *blk = arenaMalloc(sizeof(WlBoundBlock), &u->b->arena);
+	*blk = (WlBoundBlock){.scope = NULL, .nodes = listNew()};
+	return (WlbNode){.kind = WlBKind_Block, .type = WlBType_u0, .data = blk, .span = span};
+}
+
+// i = i + c, i = c + i or i = i - c, on its own or in the block an increment or decrement is lowered to
+static bool unrollerIsStep(WlbNode n, WlUnrollerCount *c)
+{
+	if (n.kind == WlBKind_Block) {
+		WlBoundBlock *blk = n.data;
+		bool found = false;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			if (blk->nodes[i].kind == WlBKind_Ref) continue;
+			if (found || !unrollerIsStep(blk->nodes[i], c)) return false;
+			found = true;
+		}
+		return found;
+	}
+	if (n.kind != WlBKind_VariableAssignment) return false;
+
+	WlBoundAssignment *asg = n.data;
+	if (asg->expression.kind != WlBKind_BinaryExpression) return false;
+	WlBoundBinaryExpression *bin = asg->expression.data;
+	WlbNode step;
+	if (bin->left.kind == WlBKind_Ref && bin->left.data == asg->symbol && bin->right.kind == WlBKind_NumberLiteral &&
+		(bin->operator== WlBOperator_Add || bin->operator== WlBOperator_Subtract)) {
+		step = bin->right;
+	} else if (bin->operator== WlBOperator_Add && bin->right.kind == WlBKind_Ref && bin->right.data == asg->symbol &&
+			   bin->left.kind == WlBKind_NumberLiteral) {
+		step = bin->left;
+	} else {
+		return false;
+	}
+	if (!unrollerIsInteger(asg->symbol->type)) return false;
+
+	// negative steps go the other way
+	bool wide = asg->symbol->type == WlBType_i64 || asg->symbol->type == WlBType_u64;
+	i64 value = wide ? step.dataNum : (i32)step.dataNum;
+	c->variable = asg->symbol;
+	c->direction = bin->operator;
+	if (value < 0) {
+		value = -value;
+		c->direction = c->direction == WlBOperator_Add ? WlBOperator_Subtract : WlBOperator_Add;
+	}
+	c->step = value;
+	return value > 0 && value <= INT32_MAX;
+}
+
+// makes the statement n leave no value behind, false when it computes one that can't be left out
+// the loop discards the values of the statements in its body when it branches back, the copies of the body run one
+// after the other without that, so an increment like s++ would leave s to the next copy
+static bool unrollerDiscard(WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_None:
+	case WlBKind_VariableDeclaration:
+	case WlBKind_VariableAssignment:
+	case WlBKind_WhileLoop:
+	case WlBKind_DoWhileLoop:
+	case WlBKind_Return: return true;
+	case WlBKind_Ref:
+	case WlBKind_NumberLiteral:
+	case WlBKind_BoolLiteral:
+	case WlBKind_StringLiteral: *n = (WlbNode){.kind = WlBKind_None, .type = WlBType_u0, .span = n->span}; return true;
+	case WlBKind_AssignmentExpression: n->kind = WlBKind_VariableAssignment; return true;
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		WlBoundBlock *blk = n->data;
+		int len = 0;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			if (!unrollerDiscard(&blk->nodes[i])) return false;
+			if (blk->nodes[i].kind != WlBKind_None) blk->nodes[len++] = blk->nodes[i];
+		}
+		if (blk->nodes) LISTHEAD(blk->nodes)->len = len;
+		n->kind = WlBKind_Block;
+		n->type = WlBType_u0;
+		return true;
+	}
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		if (!unrollerDiscard(&st->thenBlock) || !unrollerDiscard(&st->elseBlock)) return false;
+		n->type = WlBType_u0;
+		return true;
+	}
+	default: return false;
+	}
+}
+
+static int unrollerAssignments(WlUnroller *u, WlSymbol *s)
+{
+	int count = 0;
+	for (int i = 0; i < listLen(u->assigned); i++) {
+		if (u->assigned[i] == s) count++;
+	}
+	return count;
+}
+
+// whether the loop counts, the step is the last node of its body
+static bool unrollerCount(WlUnroller *u, WlBoundWhile *loop, WlUnrollerCount *c)
+{
+	if (loop->block.kind != WlBKind_Block || loop->condition.kind != WlBKind_BinaryExpression) return false;
+	WlBoundBlock *body = loop->block.data;
+	int len = listLen(body->nodes);
+	if (!len || !unrollerIsStep(body->nodes[len - 1], c)) return false;
+
+	WlBoundBinaryExpression *cond = loop->condition.data;
+	if (!folderIsComparison(cond->operator)) return false;
+	if (cond->left.kind == WlBKind_Ref && cond->left.data == c->variable) {
+		c->compare = cond->operator;
+		c->bound = cond->right;
+	} else if (cond->right.kind == WlBKind_Ref && cond->right.data == c->variable) {
+		c->compare = unrollerMirror(cond->operator);
+		c->bound = cond->left;
+	} else {
+		return false;
+	}
+
+	if (u->assigned) LISTHEAD(u->assigned)->len = 0;
+	hoisterCollectAssigned(loop->condition, &u->assigned);
+	hoisterCollectAssigned(loop->block, &u->assigned);
+	if (unrollerAssignments(u, c->variable) != 1) return false;
+	if (c->bound.kind == WlBKind_NumberLiteral) return true;
+	if (c->bound.kind != WlBKind_Ref) return false;
+	WlSymbol *bound = c->bound.data;
+	return (bound->flags & WlSFlag_TypeBits) == WlSFlag_Variable && unrollerAssignments(u, bound) == 0;
+}
+
+// how many times the loop runs when the variable starts at the literal init, -1 when it's more than limit
+static int unrollerTripCount(WlUnrollerCount *c, WlbNode init, int limit)
+{
+	WlBType type = c->variable->type;
+	u64 value = init.dataNum, holds;
+	for (int count = 0; count <= limit; count++) {
+		foldIntegerBinary(type, c->compare, value, c->bound.dataNum, &holds);
+		if (!holds) return count;
+		foldIntegerBinary(type, c->direction, value, c->step, &value);
+	}
+	return -1;
+}
+
+// the loop becomes a copy of its body for every iteration, the variable is assigned its last value after them
+static void unrollFully(WlUnroller *u, WlbNode *n, WlUnrollerCount *c, WlbNode init, int count)
+{
+	WlBoundWhile *loop = n->data;
+	WlBoundBlock *body = loop->block.data;
+	WlBType type = c->variable->type;
+	WlInliner in = {.b = u->b, .caller = u->fn};
+	listPush(&in.substitutions, ((WlInlineSubstitution){.from = c->variable}));
+
+	WlbNode copies = unrollerBlock(u, n->span);
+	WlBoundBlock *blk = copies.data;
+	u64 value = init.dataNum;
+	for (int i = 0; i < count; i++) {
+		in.substitutions[0].to = folderIntegerLiteral(init, type, value);
+		WlbNode copy = unrollerBlock(u, loop->block.span);
+		// the step is left out, the copies read the literal instead
+		for (int j = 0; j < listLen(body->nodes) - 1; j++) {
+			listPush(&((WlBoundBlock *)copy.data)->nodes, inlinerCopy(&in, body->nodes[j]));
+		}
+		listPush(&blk->nodes, copy);
+		foldIntegerBinary(type, c->direction, value, c->step, &value);
+	}
+
+	WlBoundAssignment *last = arenaMalloc(sizeof(WlBoundAssignment), &u->b->arena);
+	*last = (WlBoundAssignment){.expression = folderIntegerLiteral(init, type, value), .symbol = c->variable};
+	listPush(&blk->nodes, ((WlbNode){.kind = WlBKind_VariableAssignment, .type = type, .data = last, .span = n->span}));
+
+	listFree(&in.substitutions);
+	*n = copies;
+}
+
+// the loop is preceded by one that runs factor copies of the body for as long as that many iterations are left
+// with k the distance the variable goes in factor - 1 steps, that is while i < n - k, for which n - k may not overflow
+static void unrollPartially(WlUnroller *u, WlbNode *n, WlUnrollerCount *c, int factor)
+{
+	bool up = c->compare == WlBOperator_Less || c->compare == WlBOperator_LessOrEqual;
+	bool down = c->compare == WlBOperator_Greater || c->compare == WlBOperator_GreaterOrEqual;
+	if (!(up && c->direction == WlBOperator_Add) && !(down && c->direction == WlBOperator_Subtract)) return;
+
+	WlBoundWhile *loop = n->data;
+	WlBType type = c->variable->type;
+	u64 distance = (u64)(factor - 1) * c->step;
+	if (distance > INT32_MAX) return;
+
+	u64 limit;
+	foldIntegerBinary(type, up ? WlBOperator_Add : WlBOperator_Subtract, up ? unrollerMin(type) : unrollerMax(type),
+					  distance, &limit);
+	WlBOperator guardCompare = up ? WlBOperator_GreaterOrEqual : WlBOperator_LessOrEqual;
+	WlBOperator shift = up ? WlBOperator_Subtract : WlBOperator_Add;
+	WlbNode k = folderIntegerLiteral(c->bound, type, distance);
+
+	WlbNode condition;
+	WlbNode variable = {.kind = WlBKind_Ref, .type = type, .data = c->variable, .span = loop->condition.span};
+	if (c->bound.kind == WlBKind_NumberLiteral) {
+		u64 holds, bound;
+		foldIntegerBinary(type, guardCompare, c->bound.dataNum, limit, &holds);
+		if (!holds) return;
+		foldIntegerBinary(type, shift, c->bound.dataNum, distance, &bound);
+		condition = unrollerBinary(u, variable, c->compare, folderIntegerLiteral(c->bound, type, bound), WlBType_bool);
+	} else {
+		WlbNode edge = folderIntegerLiteral(c->bound, type, limit);
+		WlbNode guard = unrollerBinary(u, c->bound, guardCompare, edge, WlBType_bool);
+		WlbNode bound = unrollerBinary(u, c->bound, shift, k, type);
+		WlbNode compare = unrollerBinary(u, variable, c->compare, bound, WlBType_bool);
+		condition = unrollerBinary(u, guard, WlBOperator_And, compare, WlBType_bool);
+	}
+
+	WlInliner in = {.b = u->b, .caller = u->fn};
+	WlbNode copies = unrollerBlock(u, loop->block.span);
+	for (int i = 0; i < factor; i++) {
+		listPush(&((WlBoundBlock *)copies.data)->nodes, inlinerCopy(&in, loop->block));
+	}
+	WlBoundWhile *unrolled = arenaMalloc(sizeof(WlBoundWhile), &u->b->arena);
+	*unrolled = (WlBoundWhile){.condition = condition, .block = copies, .unroll = 1};
+	loop->unroll = 1;
+
+	WlbNode both = unrollerBlock(u, n->span);
+	listPush(&((WlBoundBlock *)both.data)->nodes,
+			 ((WlbNode){.kind = WlBKind_WhileLoop, .type = WlBType_u0, .data = unrolled, .span = n->span}));
+	listPush(&((WlBoundBlock *)both.data)->nodes, *n);
+	*n = both;
+}
+
+// the loop at index i of the block, the node before it is where a known trip count starts
+static void unrollLoop(WlUnroller *u, WlBoundBlock *blk, int i)
+{
+	WlbNode *n = &blk->nodes[i];
+	WlBoundWhile *loop = n->data;
+	WlUnrollerCount c;
+	if (loop->unroll == 1 || !unrollerCount(u, loop, &c)) return;
+	// leaving the values out doesn't change the loop itself, so it may stay as it is when one can't be
+	if (!unrollerDiscard(&loop->block)) return;
+
+	int limit = loop->unroll ? INLINERUNCOPYABLE - 1 : UNROLLERBUDGET;
+	int cost = inlinerCost(loop->block, 0, limit);
+	if (cost > limit) return;
+	int copies = loop->unroll ? loop->unroll : UNROLLERBUDGET / cost;
+
+	// a loop that runs a known number of times is unrolled fully when the copies fit
+	WlbNode init = {.kind = WlBKind_None};
+	if (i > 0 && blk->nodes[i - 1].kind == WlBKind_VariableAssignment) {
+		WlBoundAssignment *asg = blk->nodes[i - 1].data;
+		if (asg->symbol == c.variable) init = asg->expression;
+	}
+	if (init.kind == WlBKind_NumberLiteral && c.bound.kind == WlBKind_NumberLiteral) {
+		int count = unrollerTripCount(&c, init, copies);
+		if (count >= 0) {
+			unrollFully(u, n, &c, init, count);
+			u->unrolled = true;
+			return;
+		}
+	}
+
+	int factor = loop->unroll ? loop->unroll : min(UNROLLERFACTOR, copies);
+	if (factor < 2 || c.compare == WlBOperator_Equal || c.compare == WlBOperator_NotEqual) return;
+	unrollPartially(u, n, &c, factor);
+	u->unrolled |= n->kind == WlBKind_Block;
+}
+
+// inner loops are unrolled first, the size of the outer loop includes their copies
+static void unrollNode(WlUnroller *u, WlbNode *n)
+{
+	switch (n->kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n->data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			unrollNode(u, &blk->nodes[i]);
+			if (blk->nodes[i].kind == WlBKind_WhileLoop) unrollLoop(u, blk, i);
+		}
+	} break;
+	case WlBKind_If: {
+		WlBoundIf *st = n->data;
+		unrollNode(u, &st->thenBlock);
+		unrollNode(u, &st->elseBlock);
+	} break;
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n->data;
+		unrollNode(u, &st->block);
+	} break;
+	case WlBKind_DoWhileLoop: {
+		WlBoundDoWhile *st = n->data;
+		unrollNode(u, &st->block);
+	} break;
+	default: break;
+	}
+}
+
+void unrollFunction(WlBinder *b, WlBoundFunction *fn)
+{
+	if (!fn->lowered || fn->optimized || fn->body.kind != WlBKind_Block) return;
+	WlUnroller u = {.b = b, .fn = fn};
+	unrollNode(&u, &fn->body);
+	listFree(&u.assigned);
+	if (u.unrolled) foldFunction(b, fn);
+}
+
+// runs after fold, so loops whose bounds fold to literals run a known number of times
+void unroll(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		unrollFunction(b, b->functions[i]);
+	}
+}
@@ -104,6 +104,7 @@ typedef enum WlKind
 	WlKind_StParenthesizedExpression,
 	WlKind_StType,
 	WlKind_StBlock,
+	WlKind_StLazyBlock,
 	WlKind_StExpression,
 	WlKind_StPreUnary,
 	WlKind_StPostUnary,
@@ -204,6 +205,7 @@ char *WlKindText[] = {
 	"WlKind_StParenthesizedExpression",
 	"WlKind_StType",
 	"WlKind_StBlock",
+	"WlKind_StLazyBlock",
 	"WlKind_StExpression",
 	"WlKind_StPreUnary",
 	"WlKind_StPostUnary",
@@ -271,12 +273,13 @@ char *WlBTypeText[] = {
 	"infer weak",
 };
 
+// a range of the text of a source file, see wlSourceFileAdd
+// file 0 is no file at all, which is what generated nodes point at
 #define SPANEMPTY ((WlSpan){0})
 typedef struct WlSpan {
-	Str filename;
-	Str source;
-	size_t start;
-	size_t len;
+	u32 file;
+	u32 start;
+	u32 len;
 } WlSpan;
 
 typedef enum
@@ -284,12 +287,14 @@ typedef enum
 	UnterminatedCommentDiagnostic,
 	UnexpectedCharacterDiagnostic,
 	UnterminatedStringDiagnostic,
+	IntegerLiteralOverflowDiagnostic,
 	UnexpectedTokenDiagnostic,
 	UnexpectedTokenInPrimaryExpressionDiagnostic,
 	useAfterSectionStartDiagnostic,
 	VariableAlreadyExistsDiagnostic,
 	VariableNotFoundDiagnostic,
 	CannotImplicitlyConvertDiagnostic,
+	UnknownTypeDiagnostic,
 } WlDiagnosticKind;
 
 typedef struct {
@@ -311,17 +316,23 @@ typedef struct {
 	};
 } WlDiagnostic;
 
+// interned identifier, see interner.c
+typedef u32 WlAtom;
+
 typedef struct {
 	WlKind kind;
+	// set for symbols
+	WlAtom atom;
 	WlSpan span;
 	union {
 		i64 valueNum;
 		f64 valueFloat;
 		Str valueStr;
-		void *valuePtr;
 	};
 } WlToken;
 
+#include <interner.c>
+
 #include <diagnostics.c>
 
 #include <parser.c>
@@ -330,6 +341,20 @@ typedef struct {
 
 #include <lowerer.c>
 
+#include <inliner.c>
+
+#include <folder.c>
+
+#include <hoister.c>
+
+#include <unroller.c>
+
+#include <reducer.c>
+
+#include <eliminator.c>
+
+#include <shaker.c>
+
 #include <wasmEmitter.c>
 
 #endif // WALC_H
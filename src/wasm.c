@@ -35,6 +35,7 @@ typedef u8 WasmType;
 #define WasmType_F32  0x7D
 #define WasmType_I64  0x7E
 #define WasmType_I32  0x7F
+#define WasmType_V128 0x7B
 
 typedef u8 WasmOp;
 #define WasmOp_I32Const 0x41
@@ -135,9 +136,14 @@ void wasmModuleAddMemory(Wasm *module, Str name, int pages, int maxPages)
 }
 
 // adds data to the module and returns its offset
+// data that is already part of the module is not added again, the offset of the existing copy is returned
 // you must also add memory to the wasm module if data is set
 int wasmModuleAddData(Wasm *module, Buf data)
 {
+	for (int i = 0; i < listLen(module->data); i++) {
+		if (bufEqual(module->data[i].data, data)) return module->data[i].offset;
+	}
+
 	int offset = module->dataOffset;
 	WasmData d = {
 		.offset = offset,
@@ -214,8 +220,13 @@ void wasmAppendSection(DynamicBuf *destination, WasmSection section, Buf section
 void wasmPushOpi32Const(DynamicBuf *body, i32 value);
 void wasmPushOpEnd(DynamicBuf *body);
 
+static int wasmFuncCompareId(const void *a, const void *b) { return ((WasmFunc *)a)->id - ((WasmFunc *)b)->id; }
+
 Buf wasmModuleCompile(Wasm module)
 {
+	// functions can be added in any order once their ids are reserved, the sections list them by id
+	if (module.bodies) qsort(module.bodies, listLen(module.bodies), sizeof(WasmFunc), wasmFuncCompareId);
+
 	DynamicBuf bytecode = dynamicBufCreateWithCapacity(0xFFFF);
 	dynamicBufAppend(&bytecode, BUF(wasmMagic));
 	dynamicBufAppend(&bytecode, BUF(wasmModule));
@@ -341,6 +352,8 @@ Buf wasmModuleCompile(Wasm module)
 						typeCount++;
 						leb128EncodeU(currentCount, &localBuf);
 						dynamicBufPush(&localBuf, current);
+						current = body.locals[i];
+						currentCount = 1;
 					}
 				}
 				leb128EncodeU(currentCount, &localBuf);
@@ -494,141 +507,141 @@ void wasmPushOpTableSet(DynamicBuf *body, WasmLocalIdx x)
 void wasmPushOpi32Load(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x28);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x29);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpf32Load(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2A);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpf64Load(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2B);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Load8s(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2C);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Load8u(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2D);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Load16s(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2E);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Load16u(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x2F);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load8s(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x30);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load8u(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x31);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load16s(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x32);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load16u(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x33);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load32s(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x34);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Load32u(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x35);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 
 void wasmPushOpi32Store(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x36);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Store(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x37);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpf32Store(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x38);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpf64Store(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x39);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Store8(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x3A);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi32Store16(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x3B);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Store8(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x3C);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Store16(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x3D);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 void wasmPushOpi64Store32(DynamicBuf *body, i32 offset, i32 align)
 {
 	dynamicBufPush(body, 0x3E);
-	leb128EncodeU(offset, body);
 	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
 }
 
 void wasmPushOpMemorySize(DynamicBuf *body) { dynamicBufPush(body, 0x3F); }
@@ -642,7 +655,7 @@ void wasmPushOpi32Const(DynamicBuf *body, i32 value)
 void wasmPushOpi64Const(DynamicBuf *body, i64 value)
 {
 	dynamicBufPush(body, 0x42);
-	leb128EncodeS(value, body);
+	leb128EncodeS64(value, body);
 }
 void wasmPushOpf32Const(DynamicBuf *body, f32 value)
 {
@@ -771,7 +784,7 @@ void wasmPushOpi32TrunsF64S(DynamicBuf *body) { dynamicBufPush(body, 0xAA); }
 void wasmPushOpi32TruncF64U(DynamicBuf *body) { dynamicBufPush(body, 0xAB); }
 
 void wasmPushOpi64ExtendI32S(DynamicBuf *body) { dynamicBufPush(body, 0xAC); }
-void wasmPushOpi64ExtendI32U(DynamicBuf *body) { dynamicBufPush(body, 0xAC); }
+void wasmPushOpi64ExtendI32U(DynamicBuf *body) { dynamicBufPush(body, 0xAD); }
 void wasmPushOpi64TruncF32S(DynamicBuf *body) { dynamicBufPush(body, 0xAE); }
 void wasmPushOpi64TruncF32U(DynamicBuf *body) { dynamicBufPush(body, 0xAF); }
 void wasmPushOpi64TruncF64S(DynamicBuf *body) { dynamicBufPush(body, 0xB0); }
@@ -930,4 +943,306 @@ void wasmPushOpTableFill(DynamicBuf *body, WasmTableIdx x)
 	leb128EncodeU(x, body);
 }
 
+
+// SIMD instructions are prefixed by 0xFD, followed by their opcode as an unsigned LEB128 integer
+static void wasmPushOpSimd(DynamicBuf *body, u32 op)
+{
+	dynamicBufPush(body, 0xFD);
+	leb128EncodeU(op, body);
+}
+static void wasmPushOpSimdMemory(DynamicBuf *body, u32 op, i32 offset, i32 align)
+{
+	wasmPushOpSimd(body, op);
+	leb128EncodeU(align, body);
+	leb128EncodeU(offset, body);
+}
+static void wasmPushOpSimdLane(DynamicBuf *body, u32 op, u8 lane)
+{
+	wasmPushOpSimd(body, op);
+	dynamicBufPush(body, lane);
+}
+
+void wasmPushOpv128Load(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x00, offset, align);
+}
+void wasmPushOpv128Load8x8S(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x01, offset, align);
+}
+void wasmPushOpv128Load8x8U(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x02, offset, align);
+}
+void wasmPushOpv128Load16x4S(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x03, offset, align);
+}
+void wasmPushOpv128Load16x4U(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x04, offset, align);
+}
+void wasmPushOpv128Load32x2S(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x05, offset, align);
+}
+void wasmPushOpv128Load32x2U(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x06, offset, align);
+}
+void wasmPushOpv128Load8Splat(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x07, offset, align);
+}
+void wasmPushOpv128Load16Splat(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x08, offset, align);
+}
+void wasmPushOpv128Load32Splat(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x09, offset, align);
+}
+void wasmPushOpv128Load64Splat(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x0A, offset, align);
+}
+void wasmPushOpv128Store(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x0B, offset, align);
+}
+void wasmPushOpv128Load32Zero(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x5C, offset, align);
+}
+void wasmPushOpv128Load64Zero(DynamicBuf *body, i32 offset, i32 align)
+{
+	wasmPushOpSimdMemory(body, 0x5D, offset, align);
+}
+
+// The v128.const instruction pushes its 16 immediate bytes, lane 0 of any shape comes first
+void wasmPushOpv128Const(DynamicBuf *body, u8 bytes[16])
+{
+	wasmPushOpSimd(body, 0x0C);
+	for (int i = 0; i < 16; i++)
+		dynamicBufPush(body, bytes[i]);
+}
+// The i8x16.shuffle instruction picks each byte of the result from the 32 bytes of its two operands
+void wasmPushOpi8x16Shuffle(DynamicBuf *body, u8 lanes[16])
+{
+	wasmPushOpSimd(body, 0x0D);
+	for (int i = 0; i < 16; i++)
+		dynamicBufPush(body, lanes[i]);
+}
+
+void wasmPushOpi8x16Swizzle(DynamicBuf *body) { wasmPushOpSimd(body, 0x0E); }
+void wasmPushOpi8x16Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x0F); }
+void wasmPushOpi16x8Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x10); }
+void wasmPushOpi32x4Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x11); }
+void wasmPushOpi64x2Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x12); }
+void wasmPushOpf32x4Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x13); }
+void wasmPushOpf64x2Splat(DynamicBuf *body) { wasmPushOpSimd(body, 0x14); }
+
+void wasmPushOpi8x16ExtractLaneS(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x15, lane); }
+void wasmPushOpi8x16ExtractLaneU(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x16, lane); }
+void wasmPushOpi8x16ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x17, lane); }
+void wasmPushOpi16x8ExtractLaneS(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x18, lane); }
+void wasmPushOpi16x8ExtractLaneU(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x19, lane); }
+void wasmPushOpi16x8ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1A, lane); }
+void wasmPushOpi32x4ExtractLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1B, lane); }
+void wasmPushOpi32x4ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1C, lane); }
+void wasmPushOpi64x2ExtractLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1D, lane); }
+void wasmPushOpi64x2ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1E, lane); }
+void wasmPushOpf32x4ExtractLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x1F, lane); }
+void wasmPushOpf32x4ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x20, lane); }
+void wasmPushOpf64x2ExtractLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x21, lane); }
+void wasmPushOpf64x2ReplaceLane(DynamicBuf *body, u8 lane) { wasmPushOpSimdLane(body, 0x22, lane); }
+
+void wasmPushOpi8x16Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0x23); }
+void wasmPushOpi8x16Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0x24); }
+void wasmPushOpi8x16LtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x25); }
+void wasmPushOpi8x16LtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x26); }
+void wasmPushOpi8x16GtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x27); }
+void wasmPushOpi8x16GtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x28); }
+void wasmPushOpi8x16LeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x29); }
+void wasmPushOpi8x16LeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x2A); }
+void wasmPushOpi8x16GeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x2B); }
+void wasmPushOpi8x16GeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x2C); }
+
+void wasmPushOpi16x8Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0x2D); }
+void wasmPushOpi16x8Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0x2E); }
+void wasmPushOpi16x8LtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x2F); }
+void wasmPushOpi16x8LtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x30); }
+void wasmPushOpi16x8GtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x31); }
+void wasmPushOpi16x8GtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x32); }
+void wasmPushOpi16x8LeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x33); }
+void wasmPushOpi16x8LeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x34); }
+void wasmPushOpi16x8GeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x35); }
+void wasmPushOpi16x8GeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x36); }
+
+void wasmPushOpi32x4Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0x37); }
+void wasmPushOpi32x4Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0x38); }
+void wasmPushOpi32x4LtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x39); }
+void wasmPushOpi32x4LtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x3A); }
+void wasmPushOpi32x4GtS(DynamicBuf *body) { wasmPushOpSimd(body, 0x3B); }
+void wasmPushOpi32x4GtU(DynamicBuf *body) { wasmPushOpSimd(body, 0x3C); }
+void wasmPushOpi32x4LeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x3D); }
+void wasmPushOpi32x4LeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x3E); }
+void wasmPushOpi32x4GeS(DynamicBuf *body) { wasmPushOpSimd(body, 0x3F); }
+void wasmPushOpi32x4GeU(DynamicBuf *body) { wasmPushOpSimd(body, 0x40); }
+
+void wasmPushOpf32x4Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0x41); }
+void wasmPushOpf32x4Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0x42); }
+void wasmPushOpf32x4Lt(DynamicBuf *body) { wasmPushOpSimd(body, 0x43); }
+void wasmPushOpf32x4Gt(DynamicBuf *body) { wasmPushOpSimd(body, 0x44); }
+void wasmPushOpf32x4Le(DynamicBuf *body) { wasmPushOpSimd(body, 0x45); }
+void wasmPushOpf32x4Ge(DynamicBuf *body) { wasmPushOpSimd(body, 0x46); }
+
+void wasmPushOpf64x2Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0x47); }
+void wasmPushOpf64x2Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0x48); }
+void wasmPushOpf64x2Lt(DynamicBuf *body) { wasmPushOpSimd(body, 0x49); }
+void wasmPushOpf64x2Gt(DynamicBuf *body) { wasmPushOpSimd(body, 0x4A); }
+void wasmPushOpf64x2Le(DynamicBuf *body) { wasmPushOpSimd(body, 0x4B); }
+void wasmPushOpf64x2Ge(DynamicBuf *body) { wasmPushOpSimd(body, 0x4C); }
+
+void wasmPushOpv128Not(DynamicBuf *body) { wasmPushOpSimd(body, 0x4D); }
+void wasmPushOpv128And(DynamicBuf *body) { wasmPushOpSimd(body, 0x4E); }
+void wasmPushOpv128AndNot(DynamicBuf *body) { wasmPushOpSimd(body, 0x4F); }
+void wasmPushOpv128Or(DynamicBuf *body) { wasmPushOpSimd(body, 0x50); }
+void wasmPushOpv128Xor(DynamicBuf *body) { wasmPushOpSimd(body, 0x51); }
+void wasmPushOpv128Bitselect(DynamicBuf *body) { wasmPushOpSimd(body, 0x52); }
+void wasmPushOpv128AnyTrue(DynamicBuf *body) { wasmPushOpSimd(body, 0x53); }
+
+void wasmPushOpf32x4DemoteF64x2Zero(DynamicBuf *body) { wasmPushOpSimd(body, 0x5E); }
+void wasmPushOpf64x2PromoteLowF32x4(DynamicBuf *body) { wasmPushOpSimd(body, 0x5F); }
+
+void wasmPushOpi8x16Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0x60); }
+void wasmPushOpi8x16Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0x61); }
+void wasmPushOpi8x16Popcnt(DynamicBuf *body) { wasmPushOpSimd(body, 0x62); }
+void wasmPushOpi8x16AllTrue(DynamicBuf *body) { wasmPushOpSimd(body, 0x63); }
+void wasmPushOpi8x16Bitmask(DynamicBuf *body) { wasmPushOpSimd(body, 0x64); }
+void wasmPushOpi8x16NarrowI16x8S(DynamicBuf *body) { wasmPushOpSimd(body, 0x65); }
+void wasmPushOpi8x16NarrowI16x8U(DynamicBuf *body) { wasmPushOpSimd(body, 0x66); }
+void wasmPushOpi8x16Shl(DynamicBuf *body) { wasmPushOpSimd(body, 0x6B); }
+void wasmPushOpi8x16ShrS(DynamicBuf *body) { wasmPushOpSimd(body, 0x6C); }
+void wasmPushOpi8x16ShrU(DynamicBuf *body) { wasmPushOpSimd(body, 0x6D); }
+void wasmPushOpi8x16Add(DynamicBuf *body) { wasmPushOpSimd(body, 0x6E); }
+void wasmPushOpi8x16AddSatS(DynamicBuf *body) { wasmPushOpSimd(body, 0x6F); }
+void wasmPushOpi8x16AddSatU(DynamicBuf *body) { wasmPushOpSimd(body, 0x70); }
+void wasmPushOpi8x16Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0x71); }
+void wasmPushOpi8x16SubSatS(DynamicBuf *body) { wasmPushOpSimd(body, 0x72); }
+void wasmPushOpi8x16SubSatU(DynamicBuf *body) { wasmPushOpSimd(body, 0x73); }
+void wasmPushOpi8x16MinS(DynamicBuf *body) { wasmPushOpSimd(body, 0x76); }
+void wasmPushOpi8x16MinU(DynamicBuf *body) { wasmPushOpSimd(body, 0x77); }
+void wasmPushOpi8x16MaxS(DynamicBuf *body) { wasmPushOpSimd(body, 0x78); }
+void wasmPushOpi8x16MaxU(DynamicBuf *body) { wasmPushOpSimd(body, 0x79); }
+void wasmPushOpi8x16AvgrU(DynamicBuf *body) { wasmPushOpSimd(body, 0x7B); }
+
+void wasmPushOpi16x8Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0x80); }
+void wasmPushOpi16x8Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0x81); }
+void wasmPushOpi16x8AllTrue(DynamicBuf *body) { wasmPushOpSimd(body, 0x83); }
+void wasmPushOpi16x8Bitmask(DynamicBuf *body) { wasmPushOpSimd(body, 0x84); }
+void wasmPushOpi16x8NarrowI32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0x85); }
+void wasmPushOpi16x8NarrowI32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0x86); }
+void wasmPushOpi16x8ExtendLowI8x16S(DynamicBuf *body) { wasmPushOpSimd(body, 0x87); }
+void wasmPushOpi16x8ExtendHighI8x16S(DynamicBuf *body) { wasmPushOpSimd(body, 0x88); }
+void wasmPushOpi16x8ExtendLowI8x16U(DynamicBuf *body) { wasmPushOpSimd(body, 0x89); }
+void wasmPushOpi16x8ExtendHighI8x16U(DynamicBuf *body) { wasmPushOpSimd(body, 0x8A); }
+void wasmPushOpi16x8Shl(DynamicBuf *body) { wasmPushOpSimd(body, 0x8B); }
+void wasmPushOpi16x8ShrS(DynamicBuf *body) { wasmPushOpSimd(body, 0x8C); }
+void wasmPushOpi16x8ShrU(DynamicBuf *body) { wasmPushOpSimd(body, 0x8D); }
+void wasmPushOpi16x8Add(DynamicBuf *body) { wasmPushOpSimd(body, 0x8E); }
+void wasmPushOpi16x8AddSatS(DynamicBuf *body) { wasmPushOpSimd(body, 0x8F); }
+void wasmPushOpi16x8AddSatU(DynamicBuf *body) { wasmPushOpSimd(body, 0x90); }
+void wasmPushOpi16x8Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0x91); }
+void wasmPushOpi16x8SubSatS(DynamicBuf *body) { wasmPushOpSimd(body, 0x92); }
+void wasmPushOpi16x8SubSatU(DynamicBuf *body) { wasmPushOpSimd(body, 0x93); }
+void wasmPushOpi16x8Mul(DynamicBuf *body) { wasmPushOpSimd(body, 0x95); }
+void wasmPushOpi16x8MinS(DynamicBuf *body) { wasmPushOpSimd(body, 0x96); }
+void wasmPushOpi16x8MinU(DynamicBuf *body) { wasmPushOpSimd(body, 0x97); }
+void wasmPushOpi16x8MaxS(DynamicBuf *body) { wasmPushOpSimd(body, 0x98); }
+void wasmPushOpi16x8MaxU(DynamicBuf *body) { wasmPushOpSimd(body, 0x99); }
+void wasmPushOpi16x8AvgrU(DynamicBuf *body) { wasmPushOpSimd(body, 0x9B); }
+
+void wasmPushOpi32x4Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0xA0); }
+void wasmPushOpi32x4Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0xA1); }
+void wasmPushOpi32x4AllTrue(DynamicBuf *body) { wasmPushOpSimd(body, 0xA3); }
+void wasmPushOpi32x4Bitmask(DynamicBuf *body) { wasmPushOpSimd(body, 0xA4); }
+void wasmPushOpi32x4ExtendLowI16x8S(DynamicBuf *body) { wasmPushOpSimd(body, 0xA7); }
+void wasmPushOpi32x4ExtendHighI16x8S(DynamicBuf *body) { wasmPushOpSimd(body, 0xA8); }
+void wasmPushOpi32x4ExtendLowI16x8U(DynamicBuf *body) { wasmPushOpSimd(body, 0xA9); }
+void wasmPushOpi32x4ExtendHighI16x8U(DynamicBuf *body) { wasmPushOpSimd(body, 0xAA); }
+void wasmPushOpi32x4Shl(DynamicBuf *body) { wasmPushOpSimd(body, 0xAB); }
+void wasmPushOpi32x4ShrS(DynamicBuf *body) { wasmPushOpSimd(body, 0xAC); }
+void wasmPushOpi32x4ShrU(DynamicBuf *body) { wasmPushOpSimd(body, 0xAD); }
+void wasmPushOpi32x4Add(DynamicBuf *body) { wasmPushOpSimd(body, 0xAE); }
+void wasmPushOpi32x4Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0xB1); }
+void wasmPushOpi32x4Mul(DynamicBuf *body) { wasmPushOpSimd(body, 0xB5); }
+void wasmPushOpi32x4MinS(DynamicBuf *body) { wasmPushOpSimd(body, 0xB6); }
+void wasmPushOpi32x4MinU(DynamicBuf *body) { wasmPushOpSimd(body, 0xB7); }
+void wasmPushOpi32x4MaxS(DynamicBuf *body) { wasmPushOpSimd(body, 0xB8); }
+void wasmPushOpi32x4MaxU(DynamicBuf *body) { wasmPushOpSimd(body, 0xB9); }
+void wasmPushOpi32x4DotI16x8S(DynamicBuf *body) { wasmPushOpSimd(body, 0xBA); }
+
+void wasmPushOpi64x2Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0xC0); }
+void wasmPushOpi64x2Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0xC1); }
+void wasmPushOpi64x2AllTrue(DynamicBuf *body) { wasmPushOpSimd(body, 0xC3); }
+void wasmPushOpi64x2Bitmask(DynamicBuf *body) { wasmPushOpSimd(body, 0xC4); }
+void wasmPushOpi64x2ExtendLowI32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0xC7); }
+void wasmPushOpi64x2ExtendHighI32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0xC8); }
+void wasmPushOpi64x2ExtendLowI32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0xC9); }
+void wasmPushOpi64x2ExtendHighI32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0xCA); }
+void wasmPushOpi64x2Shl(DynamicBuf *body) { wasmPushOpSimd(body, 0xCB); }
+void wasmPushOpi64x2ShrS(DynamicBuf *body) { wasmPushOpSimd(body, 0xCC); }
+void wasmPushOpi64x2ShrU(DynamicBuf *body) { wasmPushOpSimd(body, 0xCD); }
+void wasmPushOpi64x2Add(DynamicBuf *body) { wasmPushOpSimd(body, 0xCE); }
+void wasmPushOpi64x2Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0xD1); }
+void wasmPushOpi64x2Mul(DynamicBuf *body) { wasmPushOpSimd(body, 0xD5); }
+void wasmPushOpi64x2Eq(DynamicBuf *body) { wasmPushOpSimd(body, 0xD6); }
+void wasmPushOpi64x2Ne(DynamicBuf *body) { wasmPushOpSimd(body, 0xD7); }
+void wasmPushOpi64x2LtS(DynamicBuf *body) { wasmPushOpSimd(body, 0xD8); }
+void wasmPushOpi64x2GtS(DynamicBuf *body) { wasmPushOpSimd(body, 0xD9); }
+void wasmPushOpi64x2LeS(DynamicBuf *body) { wasmPushOpSimd(body, 0xDA); }
+void wasmPushOpi64x2GeS(DynamicBuf *body) { wasmPushOpSimd(body, 0xDB); }
+
+void wasmPushOpf32x4Ceil(DynamicBuf *body) { wasmPushOpSimd(body, 0x67); }
+void wasmPushOpf32x4Floor(DynamicBuf *body) { wasmPushOpSimd(body, 0x68); }
+void wasmPushOpf32x4Trunc(DynamicBuf *body) { wasmPushOpSimd(body, 0x69); }
+void wasmPushOpf32x4Nearest(DynamicBuf *body) { wasmPushOpSimd(body, 0x6A); }
+void wasmPushOpf32x4Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0xE0); }
+void wasmPushOpf32x4Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0xE1); }
+void wasmPushOpf32x4Sqrt(DynamicBuf *body) { wasmPushOpSimd(body, 0xE3); }
+void wasmPushOpf32x4Add(DynamicBuf *body) { wasmPushOpSimd(body, 0xE4); }
+void wasmPushOpf32x4Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0xE5); }
+void wasmPushOpf32x4Mul(DynamicBuf *body) { wasmPushOpSimd(body, 0xE6); }
+void wasmPushOpf32x4Div(DynamicBuf *body) { wasmPushOpSimd(body, 0xE7); }
+void wasmPushOpf32x4Min(DynamicBuf *body) { wasmPushOpSimd(body, 0xE8); }
+void wasmPushOpf32x4Max(DynamicBuf *body) { wasmPushOpSimd(body, 0xE9); }
+void wasmPushOpf32x4Pmin(DynamicBuf *body) { wasmPushOpSimd(body, 0xEA); }
+void wasmPushOpf32x4Pmax(DynamicBuf *body) { wasmPushOpSimd(body, 0xEB); }
+
+void wasmPushOpf64x2Ceil(DynamicBuf *body) { wasmPushOpSimd(body, 0x74); }
+void wasmPushOpf64x2Floor(DynamicBuf *body) { wasmPushOpSimd(body, 0x75); }
+void wasmPushOpf64x2Trunc(DynamicBuf *body) { wasmPushOpSimd(body, 0x7A); }
+void wasmPushOpf64x2Nearest(DynamicBuf *body) { wasmPushOpSimd(body, 0x94); }
+void wasmPushOpf64x2Abs(DynamicBuf *body) { wasmPushOpSimd(body, 0xEC); }
+void wasmPushOpf64x2Neg(DynamicBuf *body) { wasmPushOpSimd(body, 0xED); }
+void wasmPushOpf64x2Sqrt(DynamicBuf *body) { wasmPushOpSimd(body, 0xEF); }
+void wasmPushOpf64x2Add(DynamicBuf *body) { wasmPushOpSimd(body, 0xF0); }
+void wasmPushOpf64x2Sub(DynamicBuf *body) { wasmPushOpSimd(body, 0xF1); }
+void wasmPushOpf64x2Mul(DynamicBuf *body) { wasmPushOpSimd(body, 0xF2); }
+void wasmPushOpf64x2Div(DynamicBuf *body) { wasmPushOpSimd(body, 0xF3); }
+void wasmPushOpf64x2Min(DynamicBuf *body) { wasmPushOpSimd(body, 0xF4); }
+void wasmPushOpf64x2Max(DynamicBuf *body) { wasmPushOpSimd(body, 0xF5); }
+void wasmPushOpf64x2Pmin(DynamicBuf *body) { wasmPushOpSimd(body, 0xF6); }
+void wasmPushOpf64x2Pmax(DynamicBuf *body) { wasmPushOpSimd(body, 0xF7); }
+
+void wasmPushOpi32x4TruncSatF32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0xF8); }
+void wasmPushOpi32x4TruncSatF32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0xF9); }
+void wasmPushOpf32x4ConvertI32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0xFA); }
+void wasmPushOpf32x4ConvertI32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0xFB); }
+void wasmPushOpi32x4TruncSatF64x2SZero(DynamicBuf *body) { wasmPushOpSimd(body, 0xFC); }
+void wasmPushOpi32x4TruncSatF64x2UZero(DynamicBuf *body) { wasmPushOpSimd(body, 0xFD); }
+void wasmPushOpf64x2ConvertLowI32x4S(DynamicBuf *body) { wasmPushOpSimd(body, 0xFE); }
+void wasmPushOpf64x2ConvertLowI32x4U(DynamicBuf *body) { wasmPushOpSimd(body, 0xFF); }
+
 #endif // WASM_H
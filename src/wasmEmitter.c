@@ -192,11 +192,85 @@ void emitOperator(WlBType type, WlBOperator op, DynamicBuf *opcodes)
 }
 
 void emitStatement(WlbNode statement, DynamicBuf *opcodes);
-void emitBlock(WlBoundBlock b, DynamicBuf *opcodes)
+
+// wasm only multiplies 32 bit integers into the low half, the operands are multiplied as 64 bit integers instead
+void emitMultiplyHigh(WlBoundBinaryExpression bin, DynamicBuf *opcodes)
+{
+	WlbNode operands[] = {bin.left, bin.right};
+	for (int i = 0; i < 2; i++) {
+		emitStatement(operands[i], opcodes);
+		if (bin.left.type == WlBType_i32) {
+			wasmPushOpi64ExtendI32S(opcodes);
+		} else {
+			wasmPushOpi64ExtendI32U(opcodes);
+		}
+	}
+	wasmPushOpi64Mul(opcodes);
+	wasmPushOpi64Const(opcodes, 32);
+	wasmPushOpi64ShrU(opcodes);
+	wasmPushOpi32WrapI64(opcodes);
+}
+
+// how many values a node leaves on the stack, a string literal is its offset and its length
+static int emitValueCount(WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_Ref:
+	case WlBKind_NumberLiteral:
+	case WlBKind_BoolLiteral:
+	case WlBKind_StringLiteral:
+	case WlBKind_BinaryExpression:
+	case WlBKind_PreUnaryExpression:
+	case WlBKind_AssignmentExpression:
+	case WlBKind_Call:
+	case WlBKind_If:
+		if (n.type == WlBType_u0) return 0;
+		return n.kind == WlBKind_StringLiteral ? 2 : 1;
+	case WlBKind_Block:
+	case WlBKind_DoExpression: {
+		// the binder gives statement blocks the return type of the function, they only have a value when a node does
+		if (n.type == WlBType_u0) return 0;
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			if (emitValueCount(blk->nodes[i])) return 1;
+		}
+		return 0;
+	}
+	default: return 0;
+	}
+}
+
+// statements like b++; or calls leave a value that nobody uses, it is dropped
+// a block of a type other than u0 keeps the value of the last node that has one, which is not always its last node,
+// the block x++ is lowered to reads x before it assigns it
+void emitBlock(WlBoundBlock b, WlBType type, DynamicBuf *opcodes)
 {
+	int value = -1;
+	for (int j = listLen(b.nodes) - 1; type != WlBType_u0 && j >= 0 && value < 0; j--) {
+		if (emitValueCount(b.nodes[j])) value = j;
+	}
+
 	for (int j = 0; j < listLen(b.nodes); j++) {
 		WlbNode statementNode = b.nodes[j];
 		emitStatement(statementNode, opcodes);
+		if (j == value) continue;
+		for (int k = emitValueCount(statementNode); k > 0; k--) {
+			wasmPushOpDrop(opcodes);
+		}
+	}
+}
+
+// the body of a function, a branch or a loop, which has the type of what it is the body of
+static void emitBody(WlbNode body, WlBType type, DynamicBuf *opcodes)
+{
+	if (body.kind == WlBKind_Block) {
+		emitBlock(*(WlBoundBlock *)body.data, type, opcodes);
+		return;
+	}
+	emitStatement(body, opcodes);
+	if (type != WlBType_u0) return;
+	for (int k = emitValueCount(body); k > 0; k--) {
+		wasmPushOpDrop(opcodes);
 	}
 }
 
@@ -223,34 +297,43 @@ void emitStatement(WlbNode statement, DynamicBuf *opcodes)
 		emitStatement(var.expression, opcodes);
 		wasmPushOpLocalSet(opcodes, var.symbol->index);
 	} break;
+	case WlBKind_AssignmentExpression: {
+		WlBoundAssignment var = *(WlBoundAssignment *)statement.data;
+		emitStatement(var.expression, opcodes);
+		wasmPushOpLocalTee(opcodes, var.symbol->index);
+	} break;
 	case WlBKind_Function: {
 		// do nothing! These are added to the module globally
 	} break;
 	case WlBKind_None: break;
 	case WlBKind_BinaryExpression: {
 		WlBoundBinaryExpression bin = *(WlBoundBinaryExpression *)statement.data;
+		if (bin.operator== WlBOperator_MultiplyHigh) {
+			emitMultiplyHigh(bin, opcodes);
+			break;
+		}
 		emitStatement(bin.left, opcodes);
 		emitStatement(bin.right, opcodes);
 		emitOperator(bin.left.type, bin.operator, opcodes);
 	} break;
 	case WlBKind_Block: {
 		WlBoundBlock blk = *(WlBoundBlock *)statement.data;
-		emitBlock(blk, opcodes);
+		emitBlock(blk, statement.type, opcodes);
 	} break;
 	case WlBKind_If: {
 		WlBoundIf tr = *(WlBoundIf *)statement.data;
-		if (tr.thenBlock.kind == WlBKind_NumberLiteral && tr.thenBlock.kind == WlBKind_NumberLiteral) {
-			emitStatement(tr.thenBlock, opcodes);
+		if (tr.thenBlock.kind == WlBKind_NumberLiteral && tr.elseBlock.kind == WlBKind_NumberLiteral) {
 			emitStatement(tr.thenBlock, opcodes);
+			emitStatement(tr.elseBlock, opcodes);
 			emitStatement(tr.condition, opcodes);
 			wasmPushOpSelect(opcodes);
 		} else {
 			emitStatement(tr.condition, opcodes);
 			wasmPushOpIf(opcodes, boundTypeToWasm(statement.type));
-			emitStatement(tr.thenBlock, opcodes);
+			emitBody(tr.thenBlock, statement.type, opcodes);
 			if (tr.elseBlock.kind != WlBKind_None) {
 				wasmPushOpElse(opcodes);
-				emitStatement(tr.elseBlock, opcodes);
+				emitBody(tr.elseBlock, statement.type, opcodes);
 			}
 			wasmPushOpEnd(opcodes);
 		}
@@ -265,7 +348,7 @@ void emitStatement(WlbNode statement, DynamicBuf *opcodes)
 		wasmPushOpi32Eqz(opcodes);
 		wasmPushOpBrIf(opcodes, 1);
 
-		emitStatement(whl.block, opcodes);
+		emitBody(whl.block, WlBType_u0, opcodes);
 
 		wasmPushOpBr(opcodes, 0);
 
@@ -278,7 +361,7 @@ void emitStatement(WlbNode statement, DynamicBuf *opcodes)
 		wasmPushOpBlock(opcodes, WasmType_Void);
 		wasmPushOpLoop(opcodes, WasmType_Void);
 
-		emitStatement(whl.block, opcodes);
+		emitBody(whl.block, WlBType_u0, opcodes);
 
 		// (br_if 1 (eqz (condition)))
 		emitStatement(whl.condition, opcodes);
@@ -366,73 +449,151 @@ void emitStatement(WlbNode statement, DynamicBuf *opcodes)
 	}
 }
 
-Buf emitWasm(WlBinder *b)
+// adds a function or import to the module, bodies that wlBindReachable never reached are not part of it
+void emitFunction(WlBoundFunction *fn)
 {
-	source = wasmModuleCreate();
-
-	wasmModuleAddMemory(&source, STR("memory"), 1, 2);
+	if (!(fn->symbol->flags & WlSFlag_Import) && fn->body.kind == WlBKind_Unresolved) return;
+	varOffset = 0;
 
-	int functionCount = listLen(b->functions);
-	for (int i = 0; i < functionCount; i++) {
-		varOffset = 0;
-		WlBoundFunction *fn = b->functions[i];
+	int index = fn->symbol->index;
+	if (index == -1) {
+		index = wasmModuleReserveFunctionId(&source);
+		fn->symbol->index = index;
+	}
 
-		int index = fn->symbol->index;
-		if (index == -1) {
-			index = wasmModuleReserveFunctionId(&source);
-			fn->symbol->index = index;
+	DynamicBuf args = dynamicBufCreate();
+	for (int i = 0; i < fn->paramCount; i++) {
+		WlSymbol *param = fn->scope->symbols[i];
+		param->index = varOffset;
+		if (param->type == WlBType_str) {
+			dynamicBufPush(&args, WasmType_I32);
+			dynamicBufPush(&args, WasmType_I32);
+			varOffset += 2;
+		} else {
+			dynamicBufPush(&args, boundTypeToWasm(param->type));
+			varOffset += 1;
 		}
+	}
 
-		DynamicBuf args = dynamicBufCreate();
-		for (int i = 0; i < fn->paramCount; i++) {
-			WlSymbol *param = fn->scope->symbols[i];
-			param->index = varOffset;
-			if (param->type == WlBType_str) {
-				dynamicBufPush(&args, WasmType_I32);
-				dynamicBufPush(&args, WasmType_I32);
+	DynamicBuf rets = dynamicBufCreate();
+	WasmType returnType = boundTypeToWasm(fn->symbol->type);
+	if (returnType != WasmType_Void) dynamicBufPush(&rets, returnType);
+
+	if (fn->symbol->flags & WlSFlag_Import) {
+		wasmModuleAddImport(&source, fn->symbol->name, dynamicBufToBuf(args), dynamicBufToBuf(rets), index);
+	} else {
+
+		DynamicBuf locals = dynamicBufCreate();
+
+		for (int i = fn->paramCount; i < listLen(fn->scope->symbols); i++) {
+			WlSymbol *local = fn->scope->symbols[i];
+			// TODO: maybe filter out functions and constants before reaching the emitter
+			if ((local->flags & WlSFlag_TypeBits) == WlSFlag_Function) continue;
+			if ((local->flags & WlSFlag_Constant)) continue;
+			local->index = varOffset;
+			if (local->type == WlBType_str) {
+				dynamicBufPush(&locals, WasmType_I32);
+				dynamicBufPush(&locals, WasmType_I32);
 				varOffset += 2;
 			} else {
-				dynamicBufPush(&args, boundTypeToWasm(param->type));
+				dynamicBufPush(&locals, boundTypeToWasm(local->type));
 				varOffset += 1;
 			}
 		}
 
-		DynamicBuf rets = dynamicBufCreate();
-		WasmType returnType = boundTypeToWasm(fn->symbol->type);
-		if (returnType != WasmType_Void) dynamicBufPush(&rets, returnType);
+		DynamicBuf opcodes = dynamicBufCreate();
 
-		if (fn->symbol->flags & WlSFlag_Import) {
-			wasmModuleAddImport(&source, fn->symbol->name, dynamicBufToBuf(args), dynamicBufToBuf(rets), index);
-		} else {
+		emitBody(fn->body, fn->symbol->type, &opcodes);
 
-			DynamicBuf locals = dynamicBufCreate();
-
-			for (int i = fn->paramCount; i < listLen(fn->scope->symbols); i++) {
-				WlSymbol *local = fn->scope->symbols[i];
-				// TODO: maybe filter out functions and constants before reaching the emitter
-				if ((local->flags & WlSFlag_TypeBits) == WlSFlag_Function) continue;
-				if ((local->flags & WlSFlag_Constant)) continue;
-				local->index = varOffset;
-				if (local->type == WlBType_str) {
-					dynamicBufPush(&locals, WasmType_I32);
-					dynamicBufPush(&locals, WasmType_I32);
-					varOffset += 2;
-				} else {
-					dynamicBufPush(&locals, boundTypeToWasm(local->type));
-					varOffset += 1;
-				}
-			}
+		wasmModuleAddFunction(&source, (fn->symbol->flags & WlSFlag_Export) ? fn->symbol->name : STREMPTY,
+							  dynamicBufToBuf(args), dynamicBufToBuf(rets), dynamicBufToBuf(locals),
+							  dynamicBufToBuf(opcodes), index);
+	}
+}
+
+// imports take the first function indices, so they are added before any function reserves one
+static void emitImports(WlBinder *b)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		WlBoundFunction *fn = b->functions[i];
+		if ((fn->symbol->flags & WlSFlag_Import) && fn->live) emitFunction(fn);
+	}
+}
 
-			DynamicBuf opcodes = dynamicBufCreate();
+Buf emitWasm(WlBinder *b)
+{
+	source = wasmModuleCreate();
 
-			emitStatement(fn->body, &opcodes);
+	wasmModuleAddMemory(&source, STR("memory"), 1, 2);
 
-			wasmModuleAddFunction(&source, (fn->symbol->flags & WlSFlag_Export) ? fn->symbol->name : STREMPTY,
-								  dynamicBufToBuf(args), dynamicBufToBuf(rets), dynamicBufToBuf(locals),
-								  dynamicBufToBuf(opcodes), index);
+	shake(b);
+	emitImports(b);
+	int functionCount = listLen(b->functions);
+	for (int i = 0; i < functionCount; i++) {
+		WlBoundFunction *fn = b->functions[i];
+		if ((fn->symbol->flags & WlSFlag_Import) || !fn->live) continue;
+		emitFunction(fn);
+	}
+
+	Buf wasm = wasmModuleCompile(source);
+	return wasm;
+}
+
+// compiles the reachable functions of a binder of wlBinderCreateReachable one body at a time
+// a body is parsed, bound, lowered, inlined, folded, unrolled, hoisted, reduced, has its common subexpressions
+// eliminated and is emitted, after which its syntax and bound tree are released with wlReleaseBody
+// so apart from the signatures and the module only the body being compiled and its local functions are in memory
+// once there are diagnostics nothing is emitted anymore, the bodies are still bound to report theirs, and the result
+// is empty
+Buf emitWasmStreaming(WlBinder *b)
+{
+	WlParser *p = b->parser;
+	assert(p != NULL);
+
+	source = wasmModuleCreate();
+
+	wasmModuleAddMemory(&source, STR("memory"), 1, 2);
+
+	// the bodies that call an import are not bound yet, every import is kept because they take the first indices
+	for (int i = 0; i < listLen(b->functions); i++) {
+		if (b->functions[i]->symbol->flags & WlSFlag_Import) b->functions[i]->live = true;
+	}
+	emitImports(b);
+	WlStreamedBody body;
+	while (wlBindNextBody(b, &body)) {
+		bool failed = listLen(b->diagnostics) || listLen(p->diagnostics) || listLen(p->lexer.diagnostics);
+		if (!failed) {
+			lowerFunction(b, body.function);
+			for (int i = body.functionCount; i < listLen(b->functions); i++) {
+				lowerFunction(b, b->functions[i]);
+			}
+			// the other top-level bodies are released or not bound yet, only calls to local functions are inlined
+			inlineFunction(b, body.function);
+			foldFunction(b, body.function);
+			unrollFunction(b, body.function);
+			hoistFunction(b, body.function);
+			reduceFunction(b, body.function);
+			eliminateFunction(b, body.function);
+			for (int i = body.functionCount; i < listLen(b->functions); i++) {
+				inlineFunction(b, b->functions[i]);
+				foldFunction(b, b->functions[i]);
+				unrollFunction(b, b->functions[i]);
+				hoistFunction(b, b->functions[i]);
+				reduceFunction(b, b->functions[i]);
+				eliminateFunction(b, b->functions[i]);
+			}
+			emitFunction(body.function);
+			for (int i = body.functionCount; i < listLen(b->functions); i++) {
+				emitFunction(b->functions[i]);
+			}
 		}
+		wlReleaseBody(b, &body);
 	}
 
+	if (listLen(b->diagnostics) || listLen(p->diagnostics) || listLen(p->lexer.diagnostics)) {
+		wasmModuleFree(&source);
+		return (Buf){0};
+	}
 	Buf wasm = wasmModuleCompile(source);
 	return wasm;
 }
@@ -5,9 +5,18 @@
 #include <sti_test.h>
 
 #include <binder.test.c>
+#include <eliminator.test.c>
+#include <folder.test.c>
+#include <hoister.test.c>
+#include <inliner.test.c>
 #include <leb128.test.c>
+#include <number.test.c>
 #include <parser.test.c>
+#include <reducer.test.c>
+#include <scan.test.c>
+#include <shaker.test.c>
 #include <sti.test.c>
+#include <unroller.test.c>
 #include <walc.test.c>
 #include <wasm.test.c>
 
@@ -16,7 +25,16 @@ void test_main()
 	test_sti();
 	test_leb128();
 	test_wasm();
+	test_scan();
+	test_number();
 	test_parser();
 	test_binder();
+	test_folder();
+	test_hoister();
+	test_inliner();
+	test_reducer();
+	test_unroller();
+	test_eliminator();
+	test_shaker();
 	test_walc();
 }
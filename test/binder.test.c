@@ -4,18 +4,32 @@
 
 #include <sti_test.h>
 
-#include <walc.h>
+#include <passes.h>
 
-List(WlToken) referencePathFromString(Str s)
+List(WlAtom) referencePathFromString(Str s)
 {
 	WlParser p = wlParserCreate(STREMPTY, s);
-	List(WlToken) tks = wlParseReferencePath(&p);
-	wlParserFree(&p);
+	WlNode ref = wlParseReferencePath(&p);
 	if (listLen(p.diagnostics) > 0) {
 		diagnosticPrintAll(p.diagnostics);
 		PANIC("Failed to parse reference path");
 	}
-	return tks;
+
+	int len;
+	WlAtom *atoms = wlAstPath(&p.ast, ref, &len);
+	List(WlAtom) path = listNew();
+	for (int i = 0; i < len; i++) {
+		listPush(&path, atoms[i]);
+	}
+	wlParserFree(&p);
+	return path;
+}
+
+WlSymbol *findSymbolByPath(WlBinder *b, List(WlAtom) path, WlSymbolFlags flags)
+{
+	WlSymbol *s = wlFindSymbolInNamespace(b, path, listLen(path), flags);
+	listFree(&path);
+	return s;
 }
 
 void test_binder_symbols()
@@ -26,13 +40,13 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 
 		test_assert("the first variable is created", a != NULL);
 
 		WlCreateAndPushScope(&b);
 
-		WlSymbol *a2 = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a2 = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 
 		test_assert("the second variable is created", a2 != NULL);
 
@@ -47,11 +61,11 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 
 		test_assert("the first variable is created", a != NULL);
 
-		WlSymbol *a2 = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a2 = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 
 		test_assert("the second variable is not created", a2 == NULL);
 
@@ -66,11 +80,11 @@ void test_binder_symbols()
 		WlBinder b = wlBinderCreate(NULL);
 
 		WlCreateAndPushScope(&b);
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 		test_assert("the variable is created", a != NULL);
 		WlPopScope(&b);
 
-		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, STR("a"));
+		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, wlIntern(STR("a")));
 
 		test_assert("the variable is not found", a2 == NULL);
 
@@ -84,11 +98,11 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 		test_assert("the variable is created", a != NULL);
 
 		WlCreateAndPushScope(&b);
-		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, STR("a"));
+		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, wlIntern(STR("a")));
 		test_assert("the is variable not found", a2 != NULL);
 		WlPopScope(&b);
 
@@ -100,12 +114,12 @@ void test_binder_symbols()
 		WlBinder b = wlBinderCreate(NULL);
 
 		WlCreateAndPushScope(&b);
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 		test_assert("the variable is created", a != NULL);
 		WlPopScope(&b);
 
 		WlCreateAndPushScope(&b);
-		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, STR("a"));
+		WlSymbol *a2 = wlFindVariable(&b, SPANEMPTY, wlIntern(STR("a")));
 		test_assert("the variable not found", a2 == NULL);
 		WlPopScope(&b);
 
@@ -116,13 +130,13 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlCreateAndPushNamespace(&b, STR("Foo"));
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32, false);
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Foo")));
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32, false);
 		test_assert("the variable is created", a != NULL);
 		WlPopScope(&b);
 
 		WlCreateAndPushScope(&b);
-		WlSymbol *a2 = wlFindSymbolInNamespace(&b, referencePathFromString(STR("Foo.a")), WlSFlag_Variable);
+		WlSymbol *a2 = findSymbolByPath(&b, referencePathFromString(STR("Foo.a")), WlSFlag_Variable);
 
 		test_assert("the variable is found", a2 != NULL);
 		WlPopScope(&b);
@@ -134,15 +148,15 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlCreateAndPushNamespace(&b, STR("Foo"));
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32,false);
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Foo")));
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32,false);
 		test_assert("the variable is created", a != NULL);
 		WlPopScope(&b);
 
-		WlCreateAndPushNamespace(&b, STR("Foo"));
-		WlCreateAndPushNamespace(&b, STR("Bar"));
-		WlCreateAndPushNamespace(&b, STR("Baz"));
-		WlSymbol *a2 = wlFindSymbolInNamespace(&b, referencePathFromString(STR("a")), WlSFlag_Variable);
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Foo")));
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Bar")));
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Baz")));
+		WlSymbol *a2 = findSymbolByPath(&b, referencePathFromString(STR("a")), WlSFlag_Variable);
 
 		test_assert("the variable is found", a2 != NULL);
 		WlPopScope(&b);
@@ -156,22 +170,107 @@ void test_binder_symbols()
 	{
 		WlBinder b = wlBinderCreate(NULL);
 
-		WlCreateAndPushNamespace(&b, STR("Foo"));
-		WlCreateAndPushNamespace(&b, STR("Bar"));
-		WlCreateAndPushNamespace(&b, STR("Baz"));
-		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, STR("a"), WlBType_i32,false);
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Foo")));
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Bar")));
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Baz")));
+		WlSymbol *a = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("a")), WlBType_i32,false);
 		test_assert("the variable is created", a != NULL);
 		WlPopScope(&b);
 		WlPopScope(&b);
 		WlPopScope(&b);
 
-		WlCreateAndPushNamespace(&b, STR("Foo"));
-		WlSymbol *a2 = wlFindSymbolInNamespace(&b, referencePathFromString(STR("Bar.Baz.a")), WlSFlag_Variable);
+		WlCreateAndPushNamespace(&b, wlIntern(STR("Foo")));
+		WlSymbol *a2 = findSymbolByPath(&b, referencePathFromString(STR("Bar.Baz.a")), WlSFlag_Variable);
 		test_assert("the variable is found", a2 != NULL);
 		WlPopScope(&b);
 
 		wlBinderFree(&b);
 	}
+
+	test_that("Large scopes find every symbol and keep declaration order")
+	{
+		WlBinder b = wlBinderCreate(NULL);
+
+		int count = 1000;
+		WlSymbol **symbols = malloc(count * sizeof(WlSymbol *));
+		for (int i = 0; i < count; i++) {
+			char name[16];
+			snprintf(name, sizeof(name), "s%d", i);
+			WlSymbolFlags flags = i % 2 ? WlSFlag_Function : WlSFlag_Variable;
+			symbols[i] = wlPushSymbol(&b, wlIntern(strFromCstr(name)), WlBType_i32, flags);
+		}
+
+		bool allFound = true, kindsMatch = true, ordered = true;
+		WlScope *scope = listPeek(&b.scopes);
+		for (int i = 0; i < count; i++) {
+			char name[16];
+			snprintf(name, sizeof(name), "s%d", i);
+			WlAtom atom = wlIntern(strFromCstr(name));
+			WlSymbolFlags kind = i % 2 ? WlSFlag_Function : WlSFlag_Variable;
+			WlSymbolFlags otherKind = i % 2 ? WlSFlag_Variable : WlSFlag_Function;
+			if (wlFindSymbol(&b, atom, kind, true) != symbols[i]) allFound = false;
+			if (wlFindSymbol(&b, atom, WlSFlag_Any, true) != symbols[i]) allFound = false;
+			if (wlFindSymbol(&b, atom, otherKind, true) != NULL) kindsMatch = false;
+			if (scope->symbols[i] != symbols[i]) ordered = false;
+		}
+
+		test_assert("every symbol is found by name", allFound);
+		test_assert("lookups filter by kind", kindsMatch);
+		test_assert("symbols keep their declaration order", ordered);
+		WlSymbol *again = wlPushSymbol(&b, wlIntern(STR("s500")), WlBType_i32, WlSFlag_Variable);
+		test_assert("a name is not declared twice", again == NULL);
+		test_assert("missing names are not found", wlFindSymbol(&b, wlIntern(STR("s1000")), WlSFlag_Any, true) == NULL);
+
+		free(symbols);
+		wlBinderFree(&b);
+	}
+
+	test_that("Paths resolved through uses are cached per scope")
+	{
+		Str source = STR("use Foo;\n"
+						 "namespace Foo { use Bar; callme() {} }\n"
+						 "namespace Foo.Bar.Baz { callme() {} }\n"
+						 "namespace Other { callme() {} }\n");
+		WlParser p = wlParserCreate(STREMPTY, source);
+		wlParse(&p);
+		WlBinder b = wlBind(&p.ast, p.topLevelDeclarations);
+
+		WlScope *global = b.scopes[0];
+		listPush(&b.scopes, global);
+		WlSymbol *foo = findSymbolByPath(&b, referencePathFromString(STR("Foo")), WlSFlag_Namespace);
+		WlSymbol *fooCallme = findSymbolByPath(&b, referencePathFromString(STR("Foo.callme")), WlSFlag_Function);
+		WlSymbol *bazCallme =
+			findSymbolByPath(&b, referencePathFromString(STR("Foo.Bar.Baz.callme")), WlSFlag_Function);
+
+		test_assert("namespace scopes are sealed", global->sealed && foo->scope->sealed);
+		test_assert("scopes with uses have a visible table", global->visibleCapacity && foo->scope->visibleCapacity);
+
+		WlSymbol *viaUse = findSymbolByPath(&b, referencePathFromString(STR("callme")), WlSFlag_Function);
+		test_assert("used namespaces are searched", viaUse == fooCallme);
+
+		listPush(&b.scopes, foo->scope);
+		u32 count = b.resolutionCount;
+		WlSymbol *first = findSymbolByPath(&b, referencePathFromString(STR("Baz.callme")), WlSFlag_Function);
+		test_assert("the path is cached", b.resolutionCount == count + 1);
+		WlSymbol *second = findSymbolByPath(&b, referencePathFromString(STR("Baz.callme")), WlSFlag_Function);
+		test_assert("a cached path resolves to the same symbol", first == bazCallme && second == bazCallme);
+		test_assert("a cached path is not added again", b.resolutionCount == count + 1);
+		WlSymbol *other = findSymbolByPath(&b, referencePathFromString(STR("Other.callme")), WlSFlag_Function);
+		test_assert("the first segment is found in the parents", other && other != fooCallme && other != bazCallme);
+		listPop(&b.scopes);
+
+		WlCreateAndPushScope(&b);
+		WlSymbol *callme = wlPushVariable(&b, SPANEMPTY, wlIntern(STR("callme")), WlBType_i32, false);
+		test_assert("unsealed scopes shadow sealed ones",
+					findSymbolByPath(&b, referencePathFromString(STR("callme")), WlSFlag_Variable) == callme);
+		test_assert("symbols of other kinds still resolve through the uses",
+					findSymbolByPath(&b, referencePathFromString(STR("callme")), WlSFlag_Function) == fooCallme);
+		WlPopScope(&b);
+		listPop(&b.scopes);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
 }
 
 typedef struct {
@@ -205,14 +304,14 @@ void test_binder_expression_type_resolution()
 	{
 		ExpressionTypeData data = implicitTypeExpressions[i];
 		WlParser p = wlParserCreate(STREMPTY, strFromCstr(data.source));
-		WlToken t = wlParseExpression(&p);
+		WlNode t = wlParseExpression(&p);
 
 		for (int i = 0; i < listLen(p.diagnostics); i++) {
 			diagnosticPrint(p.diagnostics[i]);
 		}
 		test_assert(cstrFormat("%s has no diagnostics", data.source), listLen(p.diagnostics) == 0);
 
-		WlBinder b = wlBinderCreate(NULL);
+		WlBinder b = wlBinderCreate(&p.ast);
 
 		WlbNode n = wlBindExpressionOfType(&b, t, WlBType_inferStrong);
 
@@ -250,8 +349,8 @@ void test_binder_expression_type_resolution()
 	{
 		ExpressionTypeData data = explicitTypeExpressions[i];
 		WlParser p = wlParserCreate(STREMPTY, strFromCstr(data.source));
-		WlToken t = wlParseExpression(&p);
-		WlBinder b = wlBinderCreate(NULL);
+		WlNode t = wlParseExpression(&p);
+		WlBinder b = wlBinderCreate(&p.ast);
 		WlbNode n = wlBindExpressionOfType(&b, t, data.type);
 
 		test_assert(cstrFormat("%s: Expression is of type %s", data.source, WlBTypeText[data.type]),
@@ -262,12 +361,309 @@ void test_binder_expression_type_resolution()
 	test_that("floating point expression cannot be converted to int")
 	{
 		WlParser p = wlParserCreate(STREMPTY, STR("10+1.1"));
-		WlToken t = wlParseExpression(&p);
-		WlBinder b = wlBinderCreate(NULL);
+		WlNode t = wlParseExpression(&p);
+		WlBinder b = wlBinderCreate(&p.ast);
 		WlbNode n = wlBindExpressionOfType(&b, t, WlBType_i32);
 		test_assert(cstrFormat("A diagnostic was reported"),
 					listLen(b.diagnostics) == 1 && b.diagnostics[0].kind == CannotImplicitlyConvertDiagnostic);
 	}
+
+	test_that("Variables are inferred from their later uses")
+	{
+		Str source = STR("count(i32 n) { var i = 0; while i < n { i++; } }\n"
+						 "f32 half() { var x = 1; x = x / 2.; return x; }\n"
+						 "wide() { var y = 1; var z = y; }\n");
+		WlParser p = wlParserCreate(STREMPTY, source);
+		wlParse(&p);
+		WlBinder b = wlBind(&p.ast, p.topLevelDeclarations);
+		test_assert("No diagnostics were reported", listLen(b.diagnostics) == 0);
+
+		WlBoundBlock *count = b.functions[0]->body.data;
+		WlBoundVariable *i = count->nodes[0].data;
+		test_assert("the counter takes the type of the bound it is compared to", i->symbol->type == WlBType_i32);
+		test_assert("the initializer is of the same type", i->initializer.type == WlBType_i32);
+
+		WlBoundBlock *half = b.functions[1]->body.data;
+		WlBoundVariable *x = half->nodes[0].data;
+		test_assert("the variable takes the type of the return", x->symbol->type == WlBType_f32);
+		test_assert("the integer initializer becomes a float",
+					x->initializer.type == WlBType_f32 && x->initializer.dataFloat == 1.);
+
+		WlBoundBlock *wide = b.functions[2]->body.data;
+		WlBoundVariable *y = wide->nodes[0].data;
+		WlBoundVariable *z = wide->nodes[1].data;
+		test_assert("unconstrained numbers get their default type",
+					y->symbol->type == WlBType_i64 && z->symbol->type == WlBType_i64);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+	test_that("Type names resolve through the type table")
+	{
+		WlBinder b = wlBinderCreate(NULL);
+		bool allFound = true;
+		for (int i = 0; i < WlBType_end; i++) {
+			if (wlTypeLookup(&b.types, wlBTypeAtoms[i]) != i) allFound = false;
+		}
+		test_assert("every builtin is registered", allFound);
+		test_assert("an unknown name is not found",
+					wlTypeLookup(&b.types, wlIntern(STR("blah"))) == WlBType_unknown);
+		wlBinderFree(&b);
+	}
+
+	test_that("Unknown type names are reported once")
+	{
+		WlParser p = wlParserCreate(STREMPTY, STR("blah foo(blah a) { var b = a + 1; return b; }"));
+		wlParse(&p);
+		WlBinder b = wlBind(&p.ast, p.topLevelDeclarations);
+		int unknown = 0;
+		for (int i = 0; i < listLen(b.diagnostics); i++) {
+			if (b.diagnostics[i].kind == UnknownTypeDiagnostic) unknown++;
+		}
+		test_assert("each unknown name is reported", unknown == 2 && listLen(b.diagnostics) == 2);
+		test_assert("the function is left returning an unknown type", b.functions[0]->symbol->type == WlBType_unknown);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
+
+void test_binder_reachability()
+{
+	test_section("binder reachability");
+
+	test_that("Only bodies reachable from exports and entrypoints are parsed and bound")
+	{
+		// unused calls a function that does not exist, so binding it would fail
+		Str source = STR("import print(str msg);\n"
+						 "export main() { used(); }\n"
+						 "used() { print(\"used\"); }\n"
+						 "@entrypoint start() {}\n"
+						 "unused() { doesNotExist(); }\n");
+		WlParser p = wlParserCreateLazy(STREMPTY, source);
+		wlParse(&p);
+		WlBinder b = wlBindReachable(&p);
+
+		test_assert("No diagnostics were reported", listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert("All functions are declared", listLen(b.functions) == 5);
+
+		WlBoundFunction *used = findSymbolByPath(&b, referencePathFromString(STR("used")), WlSFlag_Function)->function;
+		WlBoundFunction *start = findSymbolByPath(&b, referencePathFromString(STR("start")), WlSFlag_Function)->function;
+		WlBoundFunction *unused =
+			findSymbolByPath(&b, referencePathFromString(STR("unused")), WlSFlag_Function)->function;
+		test_assert("Called functions are bound", used->body.kind == WlBKind_Block);
+		test_assert("Entrypoints are bound", start->body.kind == WlBKind_Block);
+		test_assert("Unreachable functions are not bound", unused->body.kind == WlBKind_Unresolved);
+		test_assert("Unreachable bodies are not parsed",
+					wlAstKind(&p.ast, (WlNode)unused->body.dataNum) == WlKind_StLazyBlock);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Lazy bodies with syntax errors are reported and not bound")
+	{
+		Str source = STR("export i32 main(i32 c) { used(); var a = c; if c > 2 { a = 1; } a + 1 else { c; } }\n"
+						 "used() {}\n");
+		WlParser p = wlParserCreateLazy(STREMPTY, source);
+		wlParse(&p);
+		WlBinder b = wlBindReachable(&p);
+
+		test_assert("The syntax error is reported", listLen(p.diagnostics) > 0);
+		WlBoundFunction *main = findSymbolByPath(&b, referencePathFromString(STR("main")), WlSFlag_Function)->function;
+		test_assert("The body is left empty", main->body.kind == WlBKind_None);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+
+		p = wlParserCreateWithOptions(STREMPTY, source, WlParserLazyBodies | WlParserParallel);
+		wlParse(&p);
+		b = wlBinderCreateReachable(&p);
+		Buf wasm = emitWasmStreaming(&b);
+		test_assert("Streaming reports it and emits nothing", listLen(p.diagnostics) > 0 && wasm.len == 0);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
+
+void test_binder_parallel()
+{
+	test_section("binder parallel");
+
+	test_that("parallel and serial binders agree")
+	{
+		String text = {0};
+		stringAppend(&text, STR("import print(str msg);\n"));
+		for (int i = 0; i < 600; i++) {
+			stringAppend(&text, strFormat("i32 f%d(i32 a) {\n"
+										  "    var b = a * 2;\n"
+										  "    u0 local() { print(\"local\"); }\n"
+										  "    local();\n"
+										  "    %s\n"
+										  "    f%d(a);\n"
+										  "    return b;\n"
+										  "}\n",
+										  i, i % 50 == 7 ? "i32 c = 1.5;" : "", (i + 1) % 600));
+		}
+		stringToCStr(&text);
+		Str source = {.buf = text.buf, .len = text.len};
+
+		WlParser p = wlParserCreate(STREMPTY, source);
+		wlParse(&p);
+		test_assert("the source parses", listLen(p.diagnostics) == 0);
+
+		WlBinder serial = wlBinderCreate(&p.ast);
+		wlBindSignatures(&serial, p.topLevelDeclarations);
+		wlBindBodies(&serial, 1);
+		test_assert("the serial binder reports the conversions", listLen(serial.diagnostics) == 12);
+
+		int threadCounts[] = {2, 3, 8};
+		for (int i = 0; i < 3; i++) {
+			WlBinder parallel = wlBinderCreate(&p.ast);
+			wlBindSignatures(&parallel, p.topLevelDeclarations);
+			wlBindBodies(&parallel, threadCounts[i]);
+
+			char *name = cstrFormat("%d threads", threadCounts[i]);
+			bool functionsMatch = listLen(serial.functions) == listLen(parallel.functions);
+			bool bodiesBound = true;
+			for (int j = 0; functionsMatch && j < listLen(serial.functions); j++) {
+				WlBoundFunction *a = serial.functions[j];
+				WlBoundFunction *b = parallel.functions[j];
+				if (!strEqual(a->symbol->name, b->symbol->name)) functionsMatch = false;
+				if (!(a->symbol->flags & WlSFlag_Import) && b->body.kind != WlBKind_Block) bodiesBound = false;
+			}
+			test_assert(cstrFormat("%s declare the same functions in order", name), functionsMatch);
+			test_assert(cstrFormat("%s bind every body", name), bodiesBound);
+
+			bool diagnosticsMatch = listLen(serial.diagnostics) == listLen(parallel.diagnostics);
+			for (int j = 0; diagnosticsMatch && j < listLen(serial.diagnostics); j++) {
+				WlDiagnostic a = serial.diagnostics[j];
+				WlDiagnostic b = parallel.diagnostics[j];
+				if (a.kind != b.kind || a.span.start != b.span.start) diagnosticsMatch = false;
+			}
+			test_assert(cstrFormat("%s report the same diagnostics in order", name), diagnosticsMatch);
+
+			wlBinderFree(&parallel);
+		}
+
+		wlBinderFree(&serial);
+		wlParserFree(&p);
+		stringFree(&text);
+	}
+}
+
+// replaces removed bytes after the first occurrence of find with inserted, reparses and rebinds
+static void rebindEdit(String *text, WlParser *p, WlBinder *b, char *find, int removed, char *inserted)
+{
+	u32 offset = strstr(text->buf, find) - text->buf;
+	String next = {0};
+	stringAppend(&next, strSlice(stringToStr(*text), 0, offset));
+	stringAppend(&next, strFromCstr(inserted));
+	stringAppend(&next, strSlice(stringToStr(*text), offset + removed, text->len - offset - removed));
+	stringToCStr(&next);
+
+	wlParserReparse(p, stringToStr(next), (WlTextEdit){offset, removed, strlen(inserted)});
+	wlRebind(b, p->topLevelDeclarations);
+
+	// kept bodies may not point into the old text
+	memset(text->buf, 0, text->len);
+	stringFree(text);
+	*text = next;
+}
+
+// runs every pass, kept bodies were lowered and optimized by the compile before the rebind
+static Buf rebindCompile(WlBinder *b)
+{
+	lower(b);
+	inlineCalls(b);
+	fold(b);
+	unroll(b);
+	hoist(b);
+	reduce(b);
+	eliminate(b);
+	return emitWasm(b);
+}
+
+// emits the rebound module and one compiled from scratch, which have to be the same
+static bool rebindMatchesFullBind(String text, WlBinder *b)
+{
+	Buf incremental = rebindCompile(b);
+
+	WlParser p = wlParserCreate(STREMPTY, stringToStr(text));
+	wlParse(&p);
+	WlBinder full = wlBind(&p.ast, p.topLevelDeclarations);
+	Buf expected = rebindCompile(&full);
+
+	bool match = incremental.len == expected.len && memcmp(incremental.buf, expected.buf, expected.len) == 0;
+	match = match && listLen(b->diagnostics) == listLen(full.diagnostics);
+	wlBinderFree(&full);
+	wlParserFree(&p);
+	return match;
+}
+
+static void *bodyOf(WlBinder *b, char *name)
+{
+	WlBoundFunction *fn = functionNamed(b, name);
+	return fn ? fn->body.data : NULL;
+}
+
+void test_binder_incremental()
+{
+	test_section("binder incremental");
+
+	test_that("Rebinding only binds the bodies that changed or whose dependencies did")
+	{
+		// nothing is inlined, a body that a call was inlined into is always bound again
+		String text = {0};
+		stringAppend(&text, STR("import print(str msg);\n"
+								"@noinline twice(i32 a) { var b = a * 2; }\n"
+								"@noinline quad() { twice(1); }\n"
+								"hello(str msg) { u0 local(str s) { print(s); } local(\"local\"); print(msg); }\n"
+								"@noinline i32 work(i32 n) {\n"
+								"    var s = 0;\n"
+								"    for var i = 0; i < n; i++; { s = s + n * 2 + (n * 2) / 3; }\n"
+								"    return s;\n"
+								"}\n"
+								"export main() { quad(); hello(\"hello\"); work(3); }\n"));
+		stringToCStr(&text);
+
+		WlParser p = wlParserCreate(STREMPTY, stringToStr(text));
+		wlParse(&p);
+		WlBinder b = wlBind(&p.ast, p.topLevelDeclarations);
+		test_assert("the first bind matches a full bind", rebindMatchesFullBind(text, &b));
+
+		void *twice = bodyOf(&b, "twice"), *quad = bodyOf(&b, "quad"), *hello = bodyOf(&b, "hello"),
+			 *main = bodyOf(&b, "main");
+
+		rebindEdit(&text, &p, &b, "a * 2", 5, "a * 3");
+		test_assert("an edited body is bound again", bodyOf(&b, "twice") != twice);
+		test_assert("the other bodies are kept",
+					bodyOf(&b, "quad") == quad && bodyOf(&b, "hello") == hello && bodyOf(&b, "main") == main);
+		test_assert("a body edit matches a full bind", rebindMatchesFullBind(text, &b));
+
+		twice = bodyOf(&b, "twice");
+		rebindEdit(&text, &p, &b, "i32 a", 3, "i64");
+		test_assert("the callers of a changed signature are bound again",
+					bodyOf(&b, "twice") != twice && bodyOf(&b, "quad") != quad);
+		test_assert("functions that do not call it are kept", bodyOf(&b, "hello") == hello && bodyOf(&b, "main") == main);
+		test_assert("a signature edit matches a full bind", rebindMatchesFullBind(text, &b));
+
+		quad = bodyOf(&b, "quad");
+		rebindEdit(&text, &p, &b, "hello(", 0, "other() {}\n");
+		test_assert("bodies after a new declaration are kept and moved",
+					bodyOf(&b, "quad") == quad && bodyOf(&b, "hello") == hello && bodyOf(&b, "main") == main);
+		test_assert("kept local functions are emitted again", bodyOf(&b, "local") != NULL);
+		test_assert("a new declaration matches a full bind", rebindMatchesFullBind(text, &b));
+
+		rebindEdit(&text, &p, &b, "other() {}\n", 0, "namespace inner { quad() {} }\nuse inner;\n");
+		test_assert("a use that does not change what the bodies resolve keeps them", bodyOf(&b, "main") == main);
+		rebindEdit(&text, &p, &b, "quad() { twice", 4, "quat");
+		test_assert("a body is bound again when its call resolves elsewhere", bodyOf(&b, "main") != main);
+		test_assert("a shadowing declaration matches a full bind", rebindMatchesFullBind(text, &b));
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+		stringFree(&text);
+	}
 }
 
 void test_binder()
@@ -275,4 +671,7 @@ void test_binder()
 	test_section("binder");
 	test_binder_symbols();
 	test_binder_expression_type_resolution();
+	test_binder_reachability();
+	test_binder_parallel();
+	test_binder_incremental();
 }
@@ -0,0 +1,104 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_eliminator
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass eliminatorPasses[] = {fold, eliminate, NULL};
+
+// how many values are kept in a local for later
+static int eliminatedValues(WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		int count = 0;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			count += eliminatedValues(blk->nodes[i]);
+		}
+		return count;
+	}
+	case WlBKind_If: {
+		WlBoundIf *st = n.data;
+		return eliminatedValues(st->condition) + eliminatedValues(st->thenBlock) + eliminatedValues(st->elseBlock);
+	}
+	case WlBKind_WhileLoop: {
+		WlBoundWhile *st = n.data;
+		return eliminatedValues(st->condition) + eliminatedValues(st->block);
+	}
+	case WlBKind_VariableAssignment: return eliminatedValues(((WlBoundAssignment *)n.data)->expression);
+	case WlBKind_AssignmentExpression: return 1 + eliminatedValues(((WlBoundAssignment *)n.data)->expression);
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *bin = n.data;
+		return eliminatedValues(bin->left) + eliminatedValues(bin->right);
+	}
+	case WlBKind_Call: {
+		WlBoundCallExpression *st = n.data;
+		int count = 0;
+		for (int i = 0; i < listLen(st->args); i++) {
+			count += eliminatedValues(st->args[i]);
+		}
+		return count;
+	}
+	default: return 0;
+	}
+}
+
+typedef struct {
+	char *source;
+	int values;
+} EliminateData;
+
+void test_eliminator()
+{
+	test_section("eliminator");
+
+	test_that("A repeated expression reads the local the first one assigns")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 a, i32 b) { a * b + a * b }";
+		WlBoundBinaryExpression *sum = lastNode(compileMain(&p, &b, source, eliminatorPasses)).data;
+		test_assert("the first is assigned", sum->left.kind == WlBKind_AssignmentExpression);
+		WlBoundAssignment *first = sum->left.data;
+		test_assert("the second is read", sum->right.kind == WlBKind_Ref && sum->right.data == first->symbol);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	EliminateData data[] = {
+		{"export i32 main(i32 a, i32 b) { (a * b + 1) * (a * b + 1) }", 1},
+		{"export i32 main(i32 a, i32 b) { a * b + b * a }", 1},
+		{"export i32 main(i32 a, i32 b) { a - b + (b - a) }", 0},
+		{"export f32 main(f32 a, f32 b) { a * b + b * a }", 0},
+		{"export i32 main(i32 a, i32 b) { a / b + a / b }", 1},
+		{"export i32 main(i32 p, i32 b) { var a = p; var x = a * b; a = a + 1; x + a * b }", 0},
+		{"export i32 main(i32 a, i32 b) { var s = a * b; if a > b { s = s + a * b; } s + a * b }", 1},
+		{"export i32 main(i32 a, i32 b) { var s = 0; if a > b { s = a * b; } s + a * b }", 0},
+		{"export i32 main(i32 n, i32 k) { var s = n * k; var i = 0; while i < n { s = s + n * k; i = i + 1; } s }", 1},
+		{"export i32 main(i32 n, i32 k) { var i = 0; while i < n { i = i + k * i; } i + k * i }", 0},
+		{"@noinline i32 scale(i32 a) { a * 4 }\n"
+		 "export i32 main(i32 a) { scale(a) + scale(a) }",
+		 1},
+		{"import print(str msg);\n"
+		 "@noinline i32 noisy(i32 a) { print(\"noisy\"); a }\n"
+		 "export i32 main(i32 a) { noisy(a) + noisy(a) }",
+		 0},
+	};
+
+	test_theory("Values are only reused where they were computed on every path", EliminateData, data)
+	{
+		EliminateData d = data[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode body = compileMain(&p, &b, d.source, eliminatorPasses)->body;
+		test_assert(cstrFormat("%s: No diagnostics were reported", d.source),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert(cstrFormat("%s: %d values are kept in a local", d.source, d.values),
+					eliminatedValues(body) == d.values);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
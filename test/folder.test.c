@@ -0,0 +1,111 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_folder
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass folderPasses[] = {fold, NULL};
+
+typedef struct {
+	char *source;
+	WlBType type;
+	i64 value;
+} FoldIntegerData;
+
+typedef struct {
+	char *source;
+	WlBType type;
+	f64 value;
+} FoldFloatData;
+
+void test_folder()
+{
+	test_section("folder");
+
+	FoldIntegerData integers[] = {
+		{"i32 main() { return 2147483647 + 1; }", WlBType_i32, INT32_MIN},
+		{"u32 main() { return 0 - 1; }", WlBType_u32, UINT32_MAX},
+		{"i32 main() { return 0 - 7 / 2; }", WlBType_i32, -3},
+		{"i32 main() { return (0 - 7) / 2; }", WlBType_i32, -3},
+		{"i32 main() { return (0 - 7) % 2; }", WlBType_i32, -1},
+		{"u32 main() { return (0 - 7) / 2; }", WlBType_u32, 2147483644},
+		{"i32 main() { return 1 << 33; }", WlBType_i32, 2},
+		{"i32 main() { return (0 - 8) >> 1; }", WlBType_i32, -4},
+		{"u32 main() { return (0 - 8) >> 1; }", WlBType_u32, 2147483644},
+		{"i64 main() { return 4294967295 + 1; }", WlBType_i64, 4294967296},
+		{"bool main() { return (0 - 1) < 0; }", WlBType_bool, 1},
+		{"i32 main() { return 10 + do { let a = 4; let b = a * 0 + 3; let c = (a + b) * 0; a * b + c }; }", WlBType_i32,
+		 22},
+		{"i32 main() { var x = 0; if 1 > 2 { x = 1; } else { x = 2; } return 3; }", WlBType_i32, 3},
+	};
+
+	test_theory("Integer expressions fold to the value wasm computes", FoldIntegerData, integers)
+	{
+		FoldIntegerData data = integers[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, data.source, folderPasses));
+		test_assert(cstrFormat("%s: folds to %lld", data.source, data.value),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0 && n.kind == WlBKind_NumberLiteral &&
+						n.type == data.type && n.dataNum == data.value);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	FoldFloatData floats[] = {
+		{"f32 main() { return 0.1 + 0.2; }", WlBType_f32, (f32)((f32)0.1 + (f32)0.2)},
+		{"f64 main() { return 0.1 + 0.2; }", WlBType_f64, 0.1 + 0.2},
+		{"f64 main() { return 1. / 4; }", WlBType_f64, 0.25},
+	};
+
+	test_theory("Floating point expressions round like wasm", FoldFloatData, floats)
+	{
+		FoldFloatData data = floats[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, data.source, folderPasses));
+		test_assert(cstrFormat("%s: folds to %g", data.source, data.value),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0 && n.kind == WlBKind_NumberLiteral &&
+						n.type == data.type && n.dataFloat == data.value);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	{
+		char *traps[] = {
+			"i32 main() { return 1 / 0; }",
+			"i32 main() { return (0 - 2147483647 - 1) / (0 - 1); }",
+		};
+		test_theory("Operations that trap are not folded", char *, traps)
+		{
+			WlParser p;
+			WlBinder b;
+			WlbNode n = lastNode(compileMain(&p, &b, traps[i], folderPasses));
+			test_assert(cstrFormat("%s: the division is left", traps[i]), n.kind == WlBKind_BinaryExpression);
+			wlBinderFree(&b);
+			wlParserFree(&p);
+		}
+	}
+
+	test_that("The remainder of the overflowing division is 0")
+	{
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, "i32 main() { return (0 - 2147483647 - 1) % (0 - 1); }", folderPasses));
+		test_assert("its remainder is 0", n.kind == WlBKind_NumberLiteral && n.dataNum == 0);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Variables are not propagated")
+	{
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, "i32 main() { var a = 1; a = a + 1; return a + 1; }", folderPasses));
+		test_assert("the result still reads the variable", n.kind == WlBKind_BinaryExpression);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_hoister
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+// a block that ends in a loop, which the hoister wraps the loop in
+static WlBoundBlock *findLoopBlock(WlbNode n)
+{
+	if (n.kind != WlBKind_Block) return NULL;
+	WlBoundBlock *blk = n.data;
+	int len = listLen(blk->nodes);
+	if (len > 1 && blk->nodes[len - 1].kind == WlBKind_WhileLoop && blk->nodes[0].kind == WlBKind_VariableAssignment &&
+		strEqual(((WlBoundAssignment *)blk->nodes[0].data)->symbol->name, STR("hoisted"))) {
+		return blk;
+	}
+	for (int i = 0; i < len; i++) {
+		WlBoundBlock *found = findLoopBlock(blk->nodes[i]);
+		if (found) return found;
+	}
+	return NULL;
+}
+
+static WlPass hoisterPasses[] = {fold, hoist, NULL};
+
+void test_hoister()
+{
+	test_section("hoister");
+
+	test_that("Invariant expressions are computed before the loop")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 n, i32 k) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + k * 3 + i; }\n"
+					   "    s\n"
+					   "}\n";
+		WlBoundBlock *blk = findLoopBlock(compileMain(&p, &b, source, hoisterPasses)->body);
+		test_assert("the loop is wrapped", blk != NULL && listLen(blk->nodes) == 2);
+		WlBoundAssignment *asg = blk->nodes[0].data;
+		test_assert("the product is assigned before it",
+					asg->expression.kind == WlBKind_BinaryExpression &&
+						((WlBoundBinaryExpression *)asg->expression.data)->operator== WlBOperator_Multiply);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Expressions that read variables the loop assigns are left alone")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 n) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + i * 3; }\n"
+					   "    s\n"
+					   "}\n";
+		WlBoundBlock *blk = findLoopBlock(compileMain(&p, &b, source, hoisterPasses)->body);
+		test_assert("nothing is hoisted", blk == NULL);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Division is not hoisted, it could trap when the loop doesn't run")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 n, i32 k) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + 10 / k; }\n"
+					   "    s\n"
+					   "}\n";
+		WlBoundBlock *blk = findLoopBlock(compileMain(&p, &b, source, hoisterPasses)->body);
+		test_assert("nothing is hoisted", blk == NULL);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Calls are only hoisted when the function is pure")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "import print(str msg);\n"
+					   "@noinline i32 scale(i32 a) { a * 4 }\n"
+					   "@noinline i32 noisy(i32 a) { print(\"noisy\"); a }\n"
+					   "export i32 main(i32 n, i32 k) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + scale(k) + noisy(k); }\n"
+					   "    s\n"
+					   "}\n";
+		WlBoundBlock *blk = findLoopBlock(compileMain(&p, &b, source, hoisterPasses)->body);
+		test_assert("one call is hoisted", blk != NULL && listLen(blk->nodes) == 2);
+		WlBoundCallExpression *call = ((WlBoundAssignment *)blk->nodes[0].data)->expression.data;
+		test_assert("the pure one", strEqual(call->function->name, STR("scale")));
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
@@ -0,0 +1,90 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_inliner
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass inlinerPasses[] = {inlineCalls, fold, NULL};
+
+void test_inliner()
+{
+	test_section("inliner");
+
+	test_that("Small functions are inlined and left out of the module")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "i32 double(i32 a) { a * 2 }\n"
+					   "export i32 main() { double(3) + double(4) }\n";
+		WlBoundFunction *caller = compileMain(&p, &b, source, inlinerPasses);
+
+		WlbNode n = lastNode(caller);
+		test_assert("the arguments are folded into the copies", n.kind == WlBKind_NumberLiteral && n.dataNum == 14);
+		emitWasm(&b);
+		test_assert("the function is not called anymore", functionNamed(&b, "double")->symbol->index == -1);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Parameters that the function assigns get a local of their own")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "i64 inc(i64 n) { ++n }\n"
+					   "export i64 main(i64 x) { inc(x) + x }\n";
+		WlBoundFunction *caller = compileMain(&p, &b, source, inlinerPasses);
+
+		WlSymbol *x = caller->scope->symbols[0];
+		WlbNode n = lastNode(caller);
+		WlBoundBinaryExpression *bin = n.data;
+		test_assert("the call is inlined", n.kind == WlBKind_BinaryExpression && bin->left.kind == WlBKind_Block);
+		WlBoundBlock *copy = bin->left.data;
+		WlBoundAssignment *param = copy->nodes[0].data;
+		test_assert("the argument is assigned to a new local",
+					copy->nodes[0].kind == WlBKind_VariableAssignment && param->symbol != x);
+		test_assert("the variable that was passed is left alone",
+					bin->right.kind == WlBKind_Ref && bin->right.data == x);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Recursive functions are only inlined into their callers once")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "i32 fact(i32 n) { n < 2 ? 1 : n * fact(n - 1) }\n"
+					   "export i32 main() { fact(5) }\n";
+		WlBoundFunction *caller = compileMain(&p, &b, source, inlinerPasses);
+
+		test_assert("the copy is inlined", lastNode(caller).kind == WlBKind_Block);
+		emitWasm(&b);
+		test_assert("the copy still calls the function", functionNamed(&b, "fact")->symbol->index != -1);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Notes force or block inlining")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "@noinline i32 one() { 1 }\n"
+					   "@inline i32 big(i32 a) { a + a + a + a + a + a + a + a + a + a + a + a + a + a }\n"
+					   "export i32 main() { one() + big(2) }\n";
+		WlBoundFunction *caller = compileMain(&p, &b, source, inlinerPasses);
+
+		WlbNode n = lastNode(caller);
+		WlBoundBinaryExpression *bin = n.data;
+		test_assert("No diagnostics were reported", listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert("@noinline functions are called", n.kind == WlBKind_BinaryExpression && bin->left.kind == WlBKind_Call);
+		test_assert("@inline functions are inlined whatever their size",
+					bin->right.kind == WlBKind_NumberLiteral && bin->right.dataNum == 28);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
@@ -10,6 +10,11 @@ typedef struct {
 	u8 bytes[8];
 } SignedLeb128TestData;
 
+typedef struct {
+	i64 n;
+	u8 bytes[10];
+} Signed64Leb128TestData;
+
 void test_leb128_signed()
 {
 	test_section("leb128 signed encoding");
@@ -60,6 +65,32 @@ void test_leb128_signed()
 		}
 	}
 
+	{
+		Signed64Leb128TestData testData[] = {
+			{0, {0}},
+			//
+			{-1, {127}},
+			{0x7FFFFFFF, {255, 255, 255, 255, 7}},
+			{4294967296ll, {128, 128, 128, 128, 16}},
+			{-4294967296ll, {128, 128, 128, 128, 112}},
+			{INT64_MAX, {255, 255, 255, 255, 255, 255, 255, 255, 255, 0}},
+			{INT64_MIN, {128, 128, 128, 128, 128, 128, 128, 128, 128, 127}},
+		};
+
+		test_theory("Signed 64 bit numbers encode in up to 10 bytes", Signed64Leb128TestData, testData)
+		{
+			Signed64Leb128TestData data = testData[i];
+			DynamicBuf bytes = dynamicBufCreate();
+			leb128EncodeS64(data.n, &bytes);
+
+			test_assert(cstrFormat("%lld encodes in at most 10 bytes", (long long)data.n), bytes.len <= 10);
+			test_assert(cstrFormat("%lld encodes correctly", (long long)data.n),
+						bufEqual(dynamicBufToBuf(bytes), (Buf){data.bytes, bytes.len}));
+
+			dynamicBufFree(&bytes);
+		}
+	}
+
 	test_section("leb128 signed decoding");
 
 	{
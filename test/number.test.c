@@ -0,0 +1,56 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_number
+#endif
+
+#include <number.h>
+#include <sti_test.h>
+
+void test_number()
+{
+	test_section("number");
+
+	test_that("eight digit chunks are recognized and parsed")
+	{
+		char *digits = "0123456789012345";
+		for (int i = 0; i <= 8; i++) {
+			u64 expected = 0;
+			for (int j = 0; j < 8; j++) {
+				expected = expected * 10 + (digits[i + j] - '0');
+			}
+			u64 chunk = numberLoad8(digits + i);
+			test_assert(cstrFormat("'%.8s' is all digits", digits + i), numberIsEightDigits(chunk));
+			test_assert(cstrFormat("'%.8s' parses as %llu", digits + i, expected),
+						numberParseEightDigits(chunk) == expected);
+		}
+	}
+
+	test_that("any non digit byte rejects the chunk")
+	{
+		// the bytes right next to '0' and '9' and a few that only differ in the high nibble
+		char *rejected = "/:\0 .\xB0\xB9\x10";
+		for (int r = 0; r < 8; r++) {
+			for (int at = 0; at < 8; at++) {
+				char buf[8];
+				memset(buf, '5', 8);
+				buf[at] = rejected[r];
+				test_assert(cstrFormat("byte %d at %d is rejected", (u8)rejected[r], at),
+							!numberIsEightDigits(numberLoad8(buf)));
+			}
+		}
+	}
+
+	test_that("decimal runs flag overflow but consume every digit")
+	{
+		char *text = "184467440737095516159 ";
+		u64 value = 0;
+		bool overflow = false;
+		int end = numberParseDecimal(text, 0, strlen(text), &value, &overflow);
+		test_assert("stops at the space", end == 21);
+		test_assert("reports the overflow", overflow);
+
+		value = 0;
+		overflow = false;
+		numberParseDecimal(text, 0, 20, &value, &overflow);
+		test_assert("u64 max still fits", !overflow && value == UINT64_MAX);
+	}
+}
@@ -95,6 +95,53 @@ void test_token_lexing()
 		}
 	}
 
+	test_that("lexer lexes every keyword")
+	{
+		for (int kind = WlKind_Keywords_Start + 1; kind < WlKind_Keywords_End; kind++) {
+			Str keyword = strFromCstr(WlKindText[kind]);
+			WlLexer l = wlLexerCreate(STREMPTY, keyword);
+			List(WlToken) tokens = wlLexerLexTokens(&l);
+			test_assert(cstrFormat("'%.*s' is lexed as a keyword", STRPRINT(keyword)),
+						listLen(tokens) == 1 && tokens[0].kind == kind);
+
+			listFree(&tokens);
+			wlLexerFree(&l);
+		}
+	}
+
+	{
+		char *names[] = {"i", "iff", "fo", "format", "returns", "Return", "lets", "doo", "whilex", "x", "namespace_"};
+		test_theory("symbols that look like keywords are symbols", char *, names)
+		{
+			Str symbol = strFromCstr(names[i]);
+			WlLexer l = wlLexerCreate(STREMPTY, symbol);
+			List(WlToken) tokens = wlLexerLexTokens(&l);
+			test_assert(cstrFormat("'%.*s' is a single symbol", STRPRINT(symbol)),
+						listLen(tokens) == 1 && tokens[0].kind == WlKind_Symbol);
+
+			listFree(&tokens);
+			wlLexerFree(&l);
+		}
+	}
+
+	test_that("lexer interns symbols")
+	{
+		Str source = STR("foo bar foo Foo");
+		WlLexer l = wlLexerCreate(STREMPTY, source);
+		List(WlToken) tokens = wlLexerLexTokens(&l);
+
+		test_assert("lexes 4 symbols", listLen(tokens) == 4);
+		test_assert("atoms are set", tokens[0].atom && tokens[1].atom && tokens[3].atom);
+		test_assert("equal names share an atom", tokens[0].atom == tokens[2].atom);
+		test_assert("different names get different atoms",
+					tokens[0].atom != tokens[1].atom && tokens[0].atom != tokens[3].atom);
+		test_assert("atom text matches the source", strEqual(wlAtomText(tokens[1].atom), STR("bar")));
+		test_assert("interning the text again gives the same atom", wlIntern(STR("foo")) == tokens[0].atom);
+
+		listFree(&tokens);
+		wlLexerFree(&l);
+	}
+
 	{
 		char *names[] = {"$foo", "~Bar", "()[]!", "@gh", "foo;"};
 		test_theory("unexpected symbol names are illegal", char *, names)
@@ -112,16 +159,44 @@ void test_token_lexing()
 	}
 
 	{
-		char *numbers[] = {"1", "35", "0xF00", "0b10110", "3837", "101010"};
-		int expectedValues[] = {1, 35, 0xF00, 22, 3837, 101010};
+		char *numbers[] = {"1",
+						   "35",
+						   "0xF00",
+						   "0b10110",
+						   "3837",
+						   "101010",
+						   "0",
+						   "0x10",
+						   "0b1",
+						   "1234567890123",
+						   "9223372036854775807",
+						   "18446744073709551615",
+						   "0xFFFFFFFFFFFFFFFF",
+						   "0x7fffffffffffffff",
+						   "000000000000000000000042"};
+		i64 expectedValues[] = {1,
+								35,
+								0xF00,
+								22,
+								3837,
+								101010,
+								0,
+								16,
+								1,
+								1234567890123,
+								9223372036854775807ll,
+								(i64)18446744073709551615ull,
+								(i64)0xFFFFFFFFFFFFFFFFull,
+								0x7fffffffffffffffll,
+								42};
 		test_theory("lexer lexes individual numbers", char *, numbers)
 		{
 			Str number = strFromCstr(numbers[i]);
-			int expected = expectedValues[i];
+			i64 expected = expectedValues[i];
 
 			WlLexer l = wlLexerCreate(STREMPTY, number);
 			List(WlToken) tokens = wlLexerLexTokens(&l);
-			test_assert(cstrFormat("lexes single number '%.*s' as %d", STRPRINT(number), expected),
+			test_assert(cstrFormat("lexes single number '%.*s' as %lld", STRPRINT(number), expected),
 						listLen(tokens) == 1 && tokens[0].kind == WlKind_Number && tokens[0].valueNum == expected);
 
 			listFree(&tokens);
@@ -129,6 +204,51 @@ void test_token_lexing()
 		}
 	}
 
+	{
+		char *numbers[] = {"18446744073709551616", "99999999999999999999999", "0x10000000000000000",
+						   "0b11111111111111111111111111111111111111111111111111111111111111111"};
+		test_theory("lexer reports integers that do not fit in 64 bits", char *, numbers)
+		{
+			Str number = strFromCstr(numbers[i]);
+			WlLexer l = wlLexerCreate(STREMPTY, number);
+			List(WlToken) tokens = wlLexerLexTokens(&l);
+			test_assert(cstrFormat("'%.*s' reports an overflow", STRPRINT(number)),
+						listLen(l.diagnostics) == 1 && l.diagnostics[0].kind == IntegerLiteralOverflowDiagnostic);
+			test_assert("the whole literal becomes one bad token",
+						listLen(tokens) == 1 && tokens[0].kind == WlKind_Bad && tokens[0].span.len == number.len);
+
+			listFree(&tokens);
+			wlLexerFree(&l);
+		}
+	}
+
+	{
+		char *numbers[] = {"1.2",
+						   "0.1",
+						   "3.14159265358979323846",
+						   "0.30000000000000004",
+						   "123456789.987654321",
+						   "0.0000000001",
+						   "9007199254740993.0",
+						   "18446744073709551616.5",
+						   "2.0000000000000000000000000000001",
+						   "1."};
+		test_theory("lexer lexes floats with correct rounding", char *, numbers)
+		{
+			Str number = strFromCstr(numbers[i]);
+			f64 expected = strtod(numbers[i], NULL);
+
+			WlLexer l = wlLexerCreate(STREMPTY, number);
+			List(WlToken) tokens = wlLexerLexTokens(&l);
+			test_assert(cstrFormat("lexes single float '%.*s' as %.17g", STRPRINT(number), expected),
+						listLen(tokens) == 1 && tokens[0].kind == WlKind_FloatNumber &&
+							tokens[0].valueFloat == expected);
+
+			listFree(&tokens);
+			wlLexerFree(&l);
+		}
+	}
+
 	test_that("lexer lexes assignment sequence without spaces")
 	{
 		Str source = STR("i32 a=101010;");
@@ -206,6 +326,142 @@ void test_token_lexing()
 	}
 }
 
+static bool diagnosticsMatch(List(WlDiagnostic) a, List(WlDiagnostic) b)
+{
+	if (listLen(a) != listLen(b)) return false;
+	for (int i = 0; i < listLen(a); i++) {
+		WlDiagnostic x = a[i], y = b[i];
+		if (x.kind != y.kind || x.span.start != y.span.start || x.span.len != y.span.len) return false;
+	}
+	return true;
+}
+
+void test_token_store()
+{
+	test_section("parser token store");
+
+	Str source = STR("export i32 main(i32 a) { print(\"hi\"); let b = 16 + 2.5; a // done\n}");
+
+	test_that("token store holds the same tokens as the lexer")
+	{
+		WlLexer l = wlLexerCreate(STREMPTY, source);
+		List(WlToken) tokens = wlLexerLexTokens(&l);
+		WlLexer l2 = wlLexerCreate(STREMPTY, source);
+		WlTokenStore store = wlLexerLexTokenStore(&l2);
+
+		test_assert("stores every token and the EOF", wlTokenStoreLen(&store) == listLen(tokens) + 1);
+		test_assert("last token is EOF", store.kinds[wlTokenStoreLen(&store) - 1] == WlKind_EOF);
+
+		for (int i = 0; i < listLen(tokens); i++) {
+			WlToken expected = tokens[i];
+			WlToken t = wlTokenStoreGet(&store, i);
+			test_assert(cstrFormat("token %d has the same kind", i), t.kind == expected.kind);
+			test_assert(cstrFormat("token %d has the same span", i),
+						t.span.start == expected.span.start && t.span.len == expected.span.len);
+			if (t.kind == WlKind_Symbol || t.kind == WlKind_String) {
+				test_assert(cstrFormat("token %d has the same text", i), strEqual(t.valueStr, expected.valueStr));
+			} else if (t.kind == WlKind_Number || t.kind == WlKind_FloatNumber) {
+				test_assert(cstrFormat("token %d has the same value", i), t.valueNum == expected.valueNum);
+			}
+		}
+
+		wlTokenStoreFree(&store);
+		listFree(&tokens);
+		wlLexerFree(&l);
+		wlLexerFree(&l2);
+	}
+
+	test_that("streaming and pre-lexed parsers agree")
+	{
+		WlParser streaming = wlParserCreateStreaming(STREMPTY, source);
+		WlParser stored = wlParserCreate(STREMPTY, source);
+		wlParse(&streaming);
+		wlParse(&stored);
+
+		test_assert("neither reports errors", listLen(streaming.diagnostics) == 0 && listLen(stored.diagnostics) == 0);
+		test_assert("both find one declaration",
+					listLen(streaming.topLevelDeclarations) == 1 && listLen(stored.topLevelDeclarations) == 1);
+		WlAst *a = &streaming.ast;
+		WlAst *b = &stored.ast;
+		test_assert("both build the same number of nodes", a->count == b->count);
+		test_assert("the trees match", memcmp(a->kinds, b->kinds, a->count) == 0 &&
+										   memcmp(a->spans, b->spans, a->count * sizeof(WlNodeRange)) == 0 &&
+										   memcmp(a->data, b->data, a->count * sizeof(WlNodeData)) == 0);
+
+		wlParserFree(&streaming);
+		wlParserFree(&stored);
+	}
+
+	test_that("parallel and serial parsers agree")
+	{
+		char *declarations = "use foo;\n"
+							 "import print(str msg);\n"
+							 "namespace foo.bar { use baz; i64 double(i64 a) { a * 2 } }\n"
+							 "@entrypoint @note(\"x\", 1)\n"
+							 "export i32 main(i32 a, i32 b) {\n"
+							 "    /* } */ print(\"}\"); // }\n"
+							 "    var c = a > b ? (a + 1) : -b;\n"
+							 "    if c > 2 { c = c - 1; } else { c++; }\n"
+							 "    for var i = 0; i < c; i++; { print(\"loop\"); }\n"
+							 "    while c > 0 { --c; }\n"
+							 "    do { c = foo.bar.double(c); } while c < 100;\n"
+							 "    u0 local() { print(\"local\"); }\n"
+							 "    let d = do { 1 };\n"
+							 "    return 1.5 + c;\n"
+							 "}\n"
+							 "broken() { let = ; }\n";
+		String text = {0};
+		for (int i = 0; i < 20; i++) {
+			stringAppend(&text, strFromCstr(declarations));
+		}
+		stringToCStr(&text);
+		Str source = {.buf = text.buf, .len = text.len};
+
+		WlParser serial = wlParserCreate(STREMPTY, source);
+		wlParse(&serial);
+		test_assert("the serial parse reports the broken declarations", listLen(serial.diagnostics) > 0);
+
+		int chunkSizes[] = {1, 50, 1000, 1000000};
+		int threadCounts[] = {1, 4, 3, 2};
+		for (int i = 0; i < 4; i++) {
+			WlParser parallel = wlParserCreate(STREMPTY, source);
+			parallel.sectionStart = true;
+			wlParseParallel(&parallel, threadCounts[i], chunkSizes[i]);
+
+			WlAst *a = &serial.ast;
+			WlAst *b = &parallel.ast;
+			char *name = cstrFormat("%d token chunks on %d threads", chunkSizes[i], threadCounts[i]);
+			test_assert(cstrFormat("%s build the same number of nodes", name), a->count == b->count);
+			test_assert(cstrFormat("%s build the same tree", name),
+						memcmp(a->kinds, b->kinds, a->count) == 0 && memcmp(a->ops, b->ops, a->count) == 0 &&
+							memcmp(a->spans, b->spans, a->count * sizeof(WlNodeRange)) == 0 &&
+							memcmp(a->data, b->data, a->count * sizeof(WlNodeData)) == 0 &&
+							listLen(a->extra) == listLen(b->extra) &&
+							memcmp(a->extra, b->extra, listLen(a->extra) * sizeof(u32)) == 0);
+			test_assert(cstrFormat("%s find the same declarations", name),
+						listLen(serial.topLevelDeclarations) == listLen(parallel.topLevelDeclarations) &&
+							memcmp(serial.topLevelDeclarations, parallel.topLevelDeclarations,
+								   listLen(serial.topLevelDeclarations) * sizeof(WlNode)) == 0);
+			test_assert(cstrFormat("%s report the same diagnostics in order", name),
+						diagnosticsMatch(serial.diagnostics, parallel.diagnostics));
+
+			wlParserFree(&parallel);
+		}
+
+		wlParserFree(&serial);
+		stringFree(&text);
+	}
+
+	test_that("lookahead past the end keeps returning EOF")
+	{
+		WlParser p = wlParserCreate(STREMPTY, STR("a"));
+		test_assert("first token is a symbol", wlParserTake(&p).kind == WlKind_Symbol);
+		test_assert("then EOF", wlParserTake(&p).kind == WlKind_EOF);
+		test_assert("and EOF again", wlParserPeekKind(&p) == WlKind_EOF && wlParserLookaheadKind(&p, 3) == WlKind_EOF);
+		wlParserFree(&p);
+	}
+}
+
 typedef struct {
 	Str source;
 	int left;
@@ -232,9 +488,9 @@ void test_expression_parsing()
 		Str source = STR("hello()");
 		WlParser p = wlParserCreate(STREMPTY, source);
 
-		WlToken t = wlParseExpression(&p);
-		test_assert("call expression is found", t.kind == WlKind_StCall);
-		test_assert("No arguments are found", listLen(((WlSyntaxCall *)t.valuePtr)->args) == 0);
+		WlNode t = wlParseExpression(&p);
+		test_assert("call expression is found", wlAstKind(&p.ast, t) == WlKind_StCall);
+		test_assert("No arguments are found", wlAstCall(&p.ast, t).args.len == 0);
 
 		wlParserFree(&p);
 	}
@@ -256,22 +512,26 @@ void test_expression_parsing()
 		BinaryExpressionTestData data = binaryExpressions[i];
 
 		WlParser p = wlParserCreate(STREMPTY, data.source);
-		WlToken t = wlParseExpression(&p);
+		WlAst *ast = &p.ast;
+		WlNode t = wlParseExpression(&p);
 
 		test_assert(cstrFormat("%.*s parses as binary epxression", STRPRINT(data.source)),
-					t.kind == WlKind_StBinaryExpression);
+					wlAstKind(ast, t) == WlKind_StBinaryExpression);
 
-		WlBinaryExpression be = *(WlBinaryExpression *)t.valuePtr;
+		WlBinaryExpression be = wlAstBinary(ast, t);
 
-		test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)), be.left.kind == WlKind_Number);
-		test_assert(cstrFormat("%.*s left has the right value", STRPRINT(data.source)), be.left.valueNum == data.left);
+		test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)),
+					wlAstKind(ast, be.left) == WlKind_Number);
+		test_assert(cstrFormat("%.*s left has the right value", STRPRINT(data.source)),
+					wlAstData(ast, be.left).valueNum == data.left);
 
 		test_assert(cstrFormat("%.*s operator has the right kind", STRPRINT(data.source)),
-					be.operator.kind == data.operator);
+					be.operator== data.operator);
 
-		test_assert(cstrFormat("%.*s right is a number", STRPRINT(data.source)), be.right.kind == WlKind_Number);
+		test_assert(cstrFormat("%.*s right is a number", STRPRINT(data.source)),
+					wlAstKind(ast, be.right) == WlKind_Number);
 		test_assert(cstrFormat("%.*s right has the right value", STRPRINT(data.source)),
-					be.right.valueNum == data.right);
+					wlAstData(ast, be.right).valueNum == data.right);
 
 		wlParserFree(&p);
 	}
@@ -289,12 +549,13 @@ void test_expression_parsing()
 			OperatorPrecedenceData data = expressions[i];
 
 			WlParser p = wlParserCreate(STREMPTY, data.source);
-			WlToken t = wlParseExpression(&p);
+			WlAst *ast = &p.ast;
+			WlNode t = wlParseExpression(&p);
 
 			test_assert(cstrFormat("%.*s parses as binary epxression", STRPRINT(data.source)),
-						t.kind == WlKind_StBinaryExpression);
+						wlAstKind(ast, t) == WlKind_StBinaryExpression);
 
-			WlBinaryExpression be = *(WlBinaryExpression *)t.valuePtr;
+			WlBinaryExpression be = wlAstBinary(ast, t);
 
 			if (data.firstOperatorHasHigherPrecedence) {
 				//     *
@@ -304,32 +565,33 @@ void test_expression_parsing()
 				// n   n
 
 				test_assert(cstrFormat("%.*s top operator has the right kind", STRPRINT(data.source)),
-							be.operator.kind = data.operator2);
+							be.operator == data.operator2);
 
 				test_assert(cstrFormat("%.*s left is a binary expression", STRPRINT(data.source)),
-							be.left.kind == WlKind_StBinaryExpression);
+							wlAstKind(ast, be.left) == WlKind_StBinaryExpression);
 
-				WlBinaryExpression bel = *(WlBinaryExpression *)be.left.valuePtr;
+				WlBinaryExpression bel = wlAstBinary(ast, be.left);
 
-				test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)), bel.left.kind == WlKind_Number);
+				test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)),
+							wlAstKind(ast, bel.left) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s left has the right value", STRPRINT(data.source)),
-							bel.left.valueNum == data.val1);
+							wlAstData(ast, bel.left).valueNum == data.val1);
 
 				test_assert(cstrFormat("%.*s left operator has the right kind", STRPRINT(data.source)),
-							bel.operator.kind == data.operator1);
+							bel.operator == data.operator1);
 
 				test_assert(cstrFormat("%.*s center is a number", STRPRINT(data.source)),
-							bel.right.kind == WlKind_Number);
+							wlAstKind(ast, bel.right) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s center has the right value", STRPRINT(data.source)),
-							bel.right.valueNum == data.val2);
+							wlAstData(ast, bel.right).valueNum == data.val2);
 
 				test_assert(cstrFormat("%.*s right is a number", STRPRINT(data.source)),
-							be.right.kind == WlKind_Number);
+							wlAstKind(ast, be.right) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s right has the right value", STRPRINT(data.source)),
-							be.right.valueNum == data.val3);
+							wlAstData(ast, be.right).valueNum == data.val3);
 
 			} else {
 				//     *
@@ -339,32 +601,33 @@ void test_expression_parsing()
 				//     n   n
 
 				test_assert(cstrFormat("%.*s top operator has the right kind", STRPRINT(data.source)),
-							be.operator.kind = data.operator1);
+							be.operator == data.operator1);
 
 				test_assert(cstrFormat("%.*s right is a binary expression", STRPRINT(data.source)),
-							be.right.kind == WlKind_StBinaryExpression);
+							wlAstKind(ast, be.right) == WlKind_StBinaryExpression);
 
-				WlBinaryExpression ber = *(WlBinaryExpression *)be.right.valuePtr;
+				WlBinaryExpression ber = wlAstBinary(ast, be.right);
 
-				test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)), be.left.kind == WlKind_Number);
+				test_assert(cstrFormat("%.*s left is a number", STRPRINT(data.source)),
+							wlAstKind(ast, be.left) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s left has the right value", STRPRINT(data.source)),
-							be.left.valueNum == data.val1);
+							wlAstData(ast, be.left).valueNum == data.val1);
 
 				test_assert(cstrFormat("%.*s center is a number", STRPRINT(data.source)),
-							ber.left.kind == WlKind_Number);
+							wlAstKind(ast, ber.left) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s center has the right value", STRPRINT(data.source)),
-							ber.left.valueNum == data.val2);
+							wlAstData(ast, ber.left).valueNum == data.val2);
 
 				test_assert(cstrFormat("%.*s right operator has the right kind", STRPRINT(data.source)),
-							ber.operator.kind == data.operator2);
+							ber.operator == data.operator2);
 
 				test_assert(cstrFormat("%.*s right is a number", STRPRINT(data.source)),
-							ber.right.kind == WlKind_Number);
+							wlAstKind(ast, ber.right) == WlKind_Number);
 
 				test_assert(cstrFormat("%.*s right has the right value", STRPRINT(data.source)),
-							ber.right.valueNum == data.val3);
+							wlAstData(ast, ber.right).valueNum == data.val3);
 			}
 
 			wlParserFree(&p);
@@ -373,13 +636,13 @@ void test_expression_parsing()
 		test_that("parser reports diagnostic on illegal primary expression")
 		{
 			WlParser p = wlParserCreate(STREMPTY, STR("+"));
-			WlToken t = wlParsePrimaryExpression(&p);
+			WlNode t = wlParsePrimaryExpression(&p);
 
 			test_assert("lexer had no errors", listLen(p.lexer.diagnostics) == 0);
 			test_assert("parser reported a diagnostic", listLen(p.diagnostics) == 1);
 			test_assert("it is an unexpected token in primary expression diagnostic",
 						p.diagnostics[0].kind == UnexpectedTokenInPrimaryExpressionDiagnostic);
-			test_assert("the returned token is bad", t.kind == WlKind_Bad);
+			test_assert("the returned node is bad", wlAstKind(&p.ast, t) == WlKind_Bad);
 
 			wlParserFree(&p);
 		}
@@ -387,12 +650,12 @@ void test_expression_parsing()
 		test_that("parser reports diagnostic on unexpected token")
 		{
 			WlParser p = wlParserCreate(STREMPTY, STR("export u0 main[]"));
-			WlToken t = wlParseFunction(&p);
+			WlNode t = wlParseFunction(&p);
 
 			test_assert("lexer had no errors", listLen(p.lexer.diagnostics) == 0);
 			test_assert("parser reported a diagnostic", listLen(p.diagnostics) >= 1);
 			test_assert("it is an unexpected token diagnostic", p.diagnostics[0].kind == UnexpectedTokenDiagnostic);
-			test_assert("the returned token is bad", t.kind == WlKind_Bad);
+			test_assert("the returned node is bad", wlAstKind(&p.ast, t) == WlKind_Bad);
 
 			wlParserFree(&p);
 		}
@@ -405,12 +668,9 @@ void test_return_statement_parsing()
 	{
 		Str source = STR("return;");
 		WlParser p = wlParserCreate(STREMPTY, source);
-		WlToken t = wlParseStatement(&p);
-		test_assert("Parses return statement", t.kind == WlKind_StReturnStatement);
-
-		WlReturnStatement ret = *(WlReturnStatement *)t.valuePtr;
-
-		test_assert("Has no expression", ret.expression.kind == WlKind_Missing);
+		WlNode t = wlParseStatement(&p);
+		test_assert("Parses return statement", wlAstKind(&p.ast, t) == WlKind_StReturnStatement);
+		test_assert("Has no expression", wlAstData(&p.ast, t).lhs == WLNODEMISSING);
 		wlParserFree(&p);
 	}
 
@@ -418,12 +678,9 @@ void test_return_statement_parsing()
 	{
 		Str source = STR("return 10 + 20;");
 		WlParser p = wlParserCreate(STREMPTY, source);
-		WlToken t = wlParseStatement(&p);
-		test_assert("Parses return statement", t.kind == WlKind_StReturnStatement);
-
-		WlReturnStatement ret = *(WlReturnStatement *)t.valuePtr;
-
-		test_assert("Has expression", ret.expression.kind != WlKind_Missing);
+		WlNode t = wlParseStatement(&p);
+		test_assert("Parses return statement", wlAstKind(&p.ast, t) == WlKind_StReturnStatement);
+		test_assert("Has expression", wlAstData(&p.ast, t).lhs != WLNODEMISSING);
 
 		wlParserFree(&p);
 	}
@@ -435,16 +692,13 @@ void test_function_parsing()
 	{
 		Str source = STR("u32 a, u32 b, u32 c");
 		WlParser p = wlParserCreate(STREMPTY, source);
-		WlKind delimeter = WlKind_TkComma;
+		WlNodeRange t = wlParseParameterList(&p);
 
-		List(WlToken) t = wlParseParameterList(&p);
-
-		test_assert("parses 5 tokens", listLen(t) == 5);
-		test_assert("1st token is symbol", t[0].kind == WlKind_StFunctionParameter);
-		test_assert("2nd token is delimeter", t[1].kind == delimeter);
-		test_assert("3rd token is symbol", t[2].kind == WlKind_StFunctionParameter);
-		test_assert("4th token is delimeter", t[3].kind == delimeter);
-		test_assert("5th token is symbol", t[4].kind == WlKind_StFunctionParameter);
+		test_assert("parses 3 parameters", t.len == 3);
+		for (int i = 0; i < t.len; i++) {
+			test_assert(cstrFormat("parameter %d is a parameter node", i),
+						wlAstKind(&p.ast, wlAstChild(&p.ast, t, i)) == WlKind_StFunctionParameter);
+		}
 
 		wlParserFree(&p);
 	}
@@ -453,19 +707,331 @@ void test_function_parsing()
 	{
 		Str source = STR("u32 a, u32 b, u32 c,");
 		WlParser p = wlParserCreate(STREMPTY, source);
-		WlKind delimeter = WlKind_TkComma;
+		WlNodeRange t = wlParseParameterList(&p);
+
+		test_assert("parses 3 parameters", t.len == 3);
+		test_assert("consumes the trailing comma", wlParserPeekKind(&p) == WlKind_EOF);
+		test_assert("no errors are reported", listLen(p.diagnostics) == 0);
+
+		wlParserFree(&p);
+	}
+
+	test_that("lazy bodies are skipped and parsed on demand")
+	{
+		Str source = STR("i32 foo(i32 a) { if (a > 1) { return a; } return 1; } bar() {}");
+		WlParser p = wlParserCreateLazy(STREMPTY, source);
+		wlParse(&p);
+
+		test_assert("finds two declarations", listLen(p.topLevelDeclarations) == 2);
+		WlSyntaxFunction fn = wlAstFunction(&p.ast, p.topLevelDeclarations[0]);
+		test_assert("the body is lazy", wlAstKind(&p.ast, fn.body) == WlKind_StLazyBlock);
+		test_assert("the lazy body spans the braces", wlAstSpan(&p.ast, fn.body).start == 15 &&
+														  wlAstSpan(&p.ast, fn.body).len == 38);
+
+		int count = p.ast.count;
+		wlParseLazyBlock(&p, fn.body);
+		test_assert("the body is now a block", wlAstKind(&p.ast, fn.body) == WlKind_StBlock);
+		test_assert("it has two statements", wlAstData(&p.ast, fn.body).range.len == 2);
+		test_assert("its span is unchanged", wlAstSpan(&p.ast, fn.body).start == 15);
+		test_assert("the statements were added", p.ast.count > count);
+		test_assert("no errors are reported", listLen(p.diagnostics) == 0);
+
+		WlSyntaxFunction bar = wlAstFunction(&p.ast, p.topLevelDeclarations[1]);
+		test_assert("other bodies stay lazy", wlAstKind(&p.ast, bar.body) == WlKind_StLazyBlock);
+
+		wlParserFree(&p);
+	}
+
+	test_that("lazy bodies with syntax errors report them and stop at their closing brace")
+	{
+		Str source = STR("i32 foo(i32 c, i32 a) { if c > 2 { c = c - 1; } a + 1 else { c++; } } bar() {}");
+		WlParser p = wlParserCreateLazy(STREMPTY, source);
+		wlParse(&p);
+
+		test_assert("the braces are balanced, so no errors are reported yet", listLen(p.diagnostics) == 0);
+		WlSyntaxFunction fn = wlAstFunction(&p.ast, p.topLevelDeclarations[0]);
+		int cursor = p.tokenCursor;
+		wlParseLazyBlock(&p, fn.body);
+		test_assert("the body is now a block", wlAstKind(&p.ast, fn.body) == WlKind_StBlock);
+		test_assert("the errors are reported", listLen(p.diagnostics) > 0);
+		test_assert("the parser is back where it was", p.tokenCursor == cursor);
+
+		WlSyntaxFunction bar = wlAstFunction(&p.ast, p.topLevelDeclarations[1]);
+		test_assert("the next body is left alone", wlAstKind(&p.ast, bar.body) == WlKind_StLazyBlock);
+		wlParseLazyBlock(&p, bar.body);
+		test_assert("and parses on its own", wlAstKind(&p.ast, bar.body) == WlKind_StBlock);
+
+		wlParserFree(&p);
+	}
+}
+
+// compares two subtrees by shape, content and spans, the node indices may differ
+static bool astEqual(WlAst *a, WlNode x, WlAst *b, WlNode y)
+{
+	if (x == WLNODEMISSING || y == WLNODEMISSING) return x == y;
+	WlKind kind = wlAstKind(a, x);
+	if (kind != wlAstKind(b, y) || a->ops[x] != b->ops[y]) return false;
+	if (a->spans[x].start != b->spans[y].start || a->spans[x].len != b->spans[y].len) return false;
+
+	WlNodeData dx = wlAstData(a, x);
+	WlNodeData dy = wlAstData(b, y);
+#define CHILD(cx, cy) \
+	if (!astEqual(a, (cx), b, (cy))) return false
+#define CHILDREN(rx, ry)                                                                                               \
+	if ((rx).len != (ry).len) return false;                                                                            \
+	for (int i = 0; i < (rx).len; i++) {                                                                               \
+		CHILD(wlAstChild(a, (rx), i), wlAstChild(b, (ry), i));                                                         \
+	}
+
+	switch (kind) {
+	case WlKind_StRef: {
+		int lx, ly;
+		WlAtom *px = wlAstPath(a, x, &lx);
+		WlAtom *py = wlAstPath(b, y, &ly);
+		return lx == ly && memcmp(px, py, lx * sizeof(WlAtom)) == 0;
+	}
+	case WlKind_StBlock: CHILDREN(dx.range, dy.range); return true;
+	case WlKind_StCall:
+	case WlKind_StNote: {
+		WlSyntaxCall cx = wlAstCall(a, x), cy = wlAstCall(b, y);
+		CHILD(cx.path, cy.path);
+		CHILDREN(cx.args, cy.args);
+		return true;
+	}
+	case WlKind_Bad:
+		if (dx.rhs == WLNODEMISSING) return dy.rhs == WLNODEMISSING;
+	case WlKind_StFunction:
+	case WlKind_StImport: {
+		WlSyntaxFunction fx = wlAstFunction(a, x), fy = wlAstFunction(b, y);
+		CHILDREN(fx.notes, fy.notes);
+		CHILD(fx.type, fy.type);
+		CHILD(fx.name, fy.name);
+		CHILDREN(fx.parameters, fy.parameters);
+		CHILD(fx.body, fy.body);
+		return true;
+	}
+	case WlKind_StTernaryExpression:
+	case WlKind_StIf:
+		CHILD(dx.lhs, dy.lhs);
+		CHILD(a->extra[dx.rhs], b->extra[dy.rhs]);
+		CHILD(a->extra[dx.rhs + 1], b->extra[dy.rhs + 1]);
+		return true;
+	case WlKind_StVariableDeclaration:
+		CHILD(a->extra[dx.lhs], b->extra[dy.lhs]);
+		CHILD(a->extra[dx.lhs + 1], b->extra[dy.lhs + 1]);
+		CHILD(dx.rhs, dy.rhs);
+		return true;
+	case WlKind_StFor: {
+		WlSyntaxFor fx = wlAstFor(a, x), fy = wlAstFor(b, y);
+		CHILD(fx.preCondition, fy.preCondition);
+		CHILD(fx.condition, fy.condition);
+		CHILD(fx.postCondition, fy.postCondition);
+		CHILD(fx.block, fy.block);
+		CHILDREN(fx.notes, fy.notes);
+		return true;
+	}
+	default:
+		if (kind < WlKind_Syntax_Start || kind == WlKind_StLazyBlock) return dx.valueNum == dy.valueNum;
+		CHILD(dx.lhs, dy.lhs);
+		CHILD(dx.rhs, dy.rhs);
+		return true;
+	}
+#undef CHILDREN
+#undef CHILD
+}
+
+static bool parsesMatch(WlParser *a, WlParser *b)
+{
+	if (listLen(a->topLevelDeclarations) != listLen(b->topLevelDeclarations)) return false;
+	for (int i = 0; i < listLen(a->topLevelDeclarations); i++) {
+		if (!astEqual(&a->ast, a->topLevelDeclarations[i], &b->ast, b->topLevelDeclarations[i])) return false;
+	}
+
+	WlTokenStore *ta = &a->tokenStore;
+	WlTokenStore *tb = &b->tokenStore;
+	if (ta->count != tb->count || memcmp(ta->kinds, tb->kinds, ta->count) != 0 ||
+		memcmp(ta->starts, tb->starts, ta->count * sizeof(u32)) != 0 ||
+		memcmp(ta->lens, tb->lens, ta->count * sizeof(u32)) != 0) {
+		return false;
+	}
+	for (int i = 0; i < ta->count; i++) {
+		bool isLiteral = ta->kinds[i] == WlKind_Number || ta->kinds[i] == WlKind_FloatNumber;
+		if (isLiteral ? ta->literals[ta->values[i]] != tb->literals[tb->values[i]] : ta->values[i] != tb->values[i]) {
+			return false;
+		}
+	}
+
+	return diagnosticsMatch(a->diagnostics, b->diagnostics) &&
+		   diagnosticsMatch(a->lexer.diagnostics, b->lexer.diagnostics);
+}
+
+typedef struct {
+	char *name;
+	char *find;
+	int removed;
+	char *inserted;
+	bool incremental;
+	// a lazy body loses its closing brace, the whole file is parsed again since any brace after it could close it
+	bool unclosedLazily;
+} EditData;
+
+void test_incremental_parsing()
+{
+	test_section("parser incremental");
+
+	char *base = "use foo;\n"
+				 "use foo.bar;\n"
+				 "use foo.bar.baz;\n"
+				 "import print(str msg);\n"
+				 "namespace foo.bar { i64 double(i64 a) { a * 2 } }\n"
+				 "@entrypoint\n"
+				 "export i32 main(i32 a) {\n"
+				 "    var c = a > 1 ? (a + 1) : -a;\n"
+				 "    if c > 2 { c = c - 1; } else { c++; }\n"
+				 "    return 1.5 + c;\n"
+				 "}\n"
+				 "second() { print(\"second\"); }\n"
+				 "i32 third(i32 x) { for var i = 0; i < x; i++; { x = x + 1; } x }\n"
+				 "// the end\n";
+
+	EditData edits[] = {
+		{"a literal inside a body", "c > 2", 5, "c > 3", true},
+		{"a renamed function", "second()", 6, "twice", true},
+		{"a new declaration between two others", "second()", 0, "inserted(i32 a) { a }\n", true},
+		{"a removed declaration", "second()", 30, "", true},
+		{"a joined identifier", "third", 0, "x", true},
+		{"the path of the first use", "foo;", 3, "foo.bar", true},
+		{"text at the end", "// the end", 10, "last() {}", true},
+		{"a literal that overflows", "1.5", 3, "99999999999999999999999", true},
+		{"an unclosed comment", "var c", 0, "/* ", false},
+		{"a removed brace that errors locally", "} else", 1, "", true, true},
+		{"a removed closing brace", "}\nsecond", 1, "", true, true},
+		{"an unclosed block", "return 1.5", 0, "if c { ", false},
+		{"a use turned into a function", "use foo;", 8, "foo() {}", false},
+	};
 
-		List(WlToken) t = wlParseParameterList(&p);
+	test_theory("edits reparse to the same result as a full parse", EditData, edits)
+	{
+		EditData e = edits[i];
+		Str source = strFromCstr(base);
+		u32 offset = strstr(base, e.find) - base;
+
+		String edited = {0};
+		stringAppend(&edited, strSlice(source, 0, offset));
+		stringAppend(&edited, strFromCstr(e.inserted));
+		stringAppend(&edited, strSlice(source, offset + e.removed, source.len - offset - e.removed));
+		stringToCStr(&edited);
+		Str editedSource = stringToStr(edited);
+
+		for (int lazy = 0; lazy < 2; lazy++) {
+			WlParserOptions options = lazy ? WlParserLazyBodies : WlParserDefault;
+			WlParser p = wlParserCreateWithOptions(STREMPTY, source, options);
+			wlParse(&p);
+			bool incremental = wlParserReparse(&p, editedSource, (WlTextEdit){offset, e.removed, strlen(e.inserted)});
+
+			WlParser full = wlParserCreateWithOptions(STREMPTY, editedSource, options);
+			wlParse(&full);
+
+			char *mode = lazy ? "lazily" : "eagerly";
+			bool expected = e.incremental && !(lazy && e.unclosedLazily);
+			test_assert(cstrFormat("%s %s reparses %s", e.name, mode, expected ? "incrementally" : "fully"),
+						incremental == expected);
+			test_assert(cstrFormat("%s %s matches a full parse", e.name, mode), parsesMatch(&p, &full));
+
+			if (lazy) {
+				// bodies that were skipped before the edit still parse from the moved tokens
+				for (int d = 0; d < listLen(p.topLevelDeclarations); d++) {
+					WlNode fp = p.topLevelDeclarations[d];
+					WlNode ff = full.topLevelDeclarations[d];
+					if (wlAstKind(&p.ast, fp) != WlKind_StFunction) continue;
+					wlParseLazyBlock(&p, wlAstFunction(&p.ast, fp).body);
+					wlParseLazyBlock(&full, wlAstFunction(&full.ast, ff).body);
+				}
+				test_assert(cstrFormat("%s parses the lazy bodies the same", e.name), parsesMatch(&p, &full));
+			}
+
+			wlParserFree(&p);
+			wlParserFree(&full);
+		}
+		stringFree(&edited);
+	}
+
+	test_that("Lazy bodies without a closing brace reparse fully")
+	{
+		// the brace that closes first once the block is opened is past the declarations of the region
+		char *source = "first(i32 c) { c; }\nsecond() {}\n}\nthird() {}\n";
+		char *opened = "first(i32 c) { { c; }\nsecond() {}\n}\nthird() {}\n";
+		WlParser p = wlParserCreateWithOptions(STREMPTY, strFromCstr(source), WlParserLazyBodies);
+		wlParse(&p);
+		bool incremental = wlParserReparse(&p, strFromCstr(opened), (WlTextEdit){15, 0, 2});
+		WlParser full = wlParserCreateWithOptions(STREMPTY, strFromCstr(opened), WlParserLazyBodies);
+		wlParse(&full);
+		test_assert("a body that no longer closes in the region is parsed with the whole file", !incremental);
+		test_assert("the body closes where it does in a full parse", parsesMatch(&p, &full));
+		wlParserFree(&p);
+		wlParserFree(&full);
+
+		// a body that runs to the end of the file is closed by an edit after the declarations that follow it
+		source = "first(i32 c) { if c { c; }\nsecond() {}\n";
+		char *closed = "first(i32 c) { if c { c; }\nsecond() {}\n}\n";
+		p = wlParserCreateWithOptions(STREMPTY, strFromCstr(source), WlParserLazyBodies);
+		wlParse(&p);
+		incremental = wlParserReparse(&p, strFromCstr(closed), (WlTextEdit){strlen(source), 0, 2});
+		full = wlParserCreateWithOptions(STREMPTY, strFromCstr(closed), WlParserLazyBodies);
+		wlParse(&full);
+		test_assert("an edit after a body that did not close is parsed with the whole file", !incremental);
+		test_assert("the closed body matches a full parse", parsesMatch(&p, &full));
+		wlParserFree(&p);
+		wlParserFree(&full);
+	}
+
+	test_that("consecutive edits keep matching a full parse")
+	{
+		String text = {0};
+		stringAppend(&text, strFromCstr(base));
+		stringToCStr(&text);
+
+		WlParser p = wlParserCreate(STREMPTY, stringToStr(text));
+		wlParse(&p);
+
+		// type a new function one character at a time, then delete it again
+		char *typed = "\nfour() { print(\"four\"); }";
+		u32 offset = strstr(text.buf, "second()") - text.buf - 1;
+		int incrementalCount = 0;
+		bool allMatch = true;
+		for (int i = 0; i < 2 * strlen(typed); i++) {
+			bool typing = i < strlen(typed);
+			String next = {0};
+			WlTextEdit edit;
+			if (typing) {
+				edit = (WlTextEdit){offset + i, 0, 1};
+				stringAppend(&next, strSlice(stringToStr(text), 0, offset + i));
+				stringPush(&next, typed[i]);
+				stringAppend(&next, strSlice(stringToStr(text), offset + i, text.len - offset - i));
+			} else {
+				u32 at = offset + 2 * strlen(typed) - i - 1;
+				edit = (WlTextEdit){at, 1, 0};
+				stringAppend(&next, strSlice(stringToStr(text), 0, at));
+				stringAppend(&next, strSlice(stringToStr(text), at + 1, text.len - at - 1));
+			}
+			stringToCStr(&next);
+
+			incrementalCount += wlParserReparse(&p, stringToStr(next), edit);
+			WlParser full = wlParserCreate(STREMPTY, stringToStr(next));
+			wlParse(&full);
+			allMatch = allMatch && parsesMatch(&p, &full);
+			wlParserFree(&full);
+
+			stringFree(&text);
+			text = next;
+		}
 
-		test_assert("parses 6 tokens", listLen(t) == 6);
-		test_assert("1st token is symbol", t[0].kind == WlKind_StFunctionParameter);
-		test_assert("2nd token is delimeter", t[1].kind == delimeter);
-		test_assert("3rd token is symbol", t[2].kind == WlKind_StFunctionParameter);
-		test_assert("4th token is delimeter", t[3].kind == delimeter);
-		test_assert("5th token is symbol", t[4].kind == WlKind_StFunctionParameter);
-		test_assert("6th token is delimeter", t[5].kind == delimeter);
+		test_assert("every edit matches a full parse", allMatch);
+		test_assert("most edits are incremental", incrementalCount > strlen(typed));
+		test_assert("the text is back where it started", strEqual(stringToStr(text), strFromCstr(base)));
 
 		wlParserFree(&p);
+		stringFree(&text);
 	}
 }
 
@@ -474,9 +1040,9 @@ void test_namespace_parsing()
 	test_that("single level namespace parses")
 	{
 		WlParser p = wlParserCreate(STREMPTY, STR("namespace foo {}"));
-		WlToken t = wlParseNamespace(&p);
+		WlNode t = wlParseNamespace(&p);
 
-		test_assert("is a namespace", t.kind == WlKind_StNamespace);
+		test_assert("is a namespace", wlAstKind(&p.ast, t) == WlKind_StNamespace);
 		test_assert("encounters no errors", listLen(p.diagnostics) == 0);
 
 		wlParserFree(&p);
@@ -485,9 +1051,9 @@ void test_namespace_parsing()
 	test_that("multi level namespace parses")
 	{
 		WlParser p = wlParserCreate(STREMPTY, STR("namespace foo.bar.baz {}"));
-		WlToken t = wlParseNamespace(&p);
+		WlNode t = wlParseNamespace(&p);
 
-		test_assert("is a namespace", t.kind == WlKind_StNamespace);
+		test_assert("is a namespace", wlAstKind(&p.ast, t) == WlKind_StNamespace);
 		test_assert("encounters no errors", listLen(p.diagnostics) == 0);
 
 		wlParserFree(&p);
@@ -499,8 +1065,10 @@ void test_parser()
 	test_section("parser");
 
 	test_token_lexing();
+	test_token_store();
 	test_expression_parsing();
 	test_return_statement_parsing();
 	test_function_parsing();
 	test_namespace_parsing();
+	test_incremental_parsing();
 }
@@ -0,0 +1,37 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <walc.h>
+
+// the passes that run after lower, a test runs the ones it looks at in the order the compiler would
+typedef void (*WlPass)(WlBinder *b);
+
+static WlBoundFunction *functionNamed(WlBinder *b, char *name)
+{
+	for (int i = 0; i < listLen(b->functions); i++) {
+		if (strEqual(b->functions[i]->symbol->name, strFromCstr(name))) return b->functions[i];
+	}
+	return NULL;
+}
+
+// parses, binds and lowers source and runs passes on it up to the first NULL, the result is the function main
+static WlBoundFunction *compileMain(WlParser *p, WlBinder *b, char *source, WlPass *passes)
+{
+	*p = wlParserCreate(STREMPTY, strFromCstr(source));
+	wlParse(p);
+	*b = wlBind(&p->ast, p->topLevelDeclarations);
+	lower(b);
+	for (int i = 0; passes[i]; i++) {
+		passes[i](b);
+	}
+	return functionNamed(b, "main");
+}
+
+// the last node of the body of fn, which is its value
+static WlbNode lastNode(WlBoundFunction *fn)
+{
+	WlBoundBlock *blk = fn->body.data;
+	return blk->nodes[listLen(blk->nodes) - 1];
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_reducer
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass reducerPasses[] = {fold, hoist, reduce, NULL};
+
+typedef struct {
+	char *source;
+	WlBOperator operator;
+	i64 operand;
+} ReduceShiftData;
+
+typedef struct {
+	char *source;
+	bool reduced;
+} ReduceDivisionData;
+
+static WlBOperator reducedOperator(WlbNode n)
+{
+	return n.kind == WlBKind_BinaryExpression ? ((WlBoundBinaryExpression *)n.data)->operator: -1;
+}
+
+static bool reducerHasMultiplyHigh(WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			if (reducerHasMultiplyHigh(blk->nodes[i])) return true;
+		}
+		return false;
+	}
+	case WlBKind_VariableAssignment: return reducerHasMultiplyHigh(((WlBoundAssignment *)n.data)->expression);
+	case WlBKind_BinaryExpression: {
+		WlBoundBinaryExpression *bin = n.data;
+		return bin->operator== WlBOperator_MultiplyHigh || reducerHasMultiplyHigh(bin->left) ||
+			   reducerHasMultiplyHigh(bin->right);
+	}
+	default: return false;
+	}
+}
+
+void test_reducer()
+{
+	test_section("reducer");
+
+	ReduceShiftData shifts[] = {
+		{"export i32 main(i32 x) { x * 8 }", WlBOperator_ShiftLeft, 3},
+		{"export i64 main(i64 x) { 16 * x }", WlBOperator_ShiftLeft, 4},
+		{"export u32 main(u32 x) { x / 4 }", WlBOperator_ShiftRight, 2},
+		{"export u64 main(u64 x) { x % 32 }", WlBOperator_BitwiseAnd, 31},
+	};
+
+	test_theory("Powers of two become shifts and masks", ReduceShiftData, shifts)
+	{
+		ReduceShiftData data = shifts[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, data.source, reducerPasses));
+		WlBoundBinaryExpression *bin = n.data;
+		test_assert(cstrFormat("%s: No diagnostics were reported", data.source),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert(cstrFormat("%s: The operator is replaced by %lld", data.source, data.operand),
+					reducedOperator(n) == data.operator&& bin->right.kind == WlBKind_NumberLiteral &&
+						bin->right.dataNum == data.operand);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	ReduceDivisionData divisions[] = {
+		{"export i32 main(i32 x) { x / 7 }", true},
+		{"export i32 main(i32 x) { x / (0 - 3) }", true},
+		{"export i32 main(i32 x) { x % 10 }", true},
+		{"export i32 main(i32 x) { x / 8 }", true},
+		{"export u32 main(u32 x) { x / 7 }", true},
+		{"export u32 main(u32 x) { x % 1000 }", true},
+		{"export i32 main(i32 x) { x / (0 - 1) }", false},
+		{"export i64 main(i64 x) { x / 7 }", false},
+	};
+
+	test_theory("32 bit division by other constants multiplies by a magic number", ReduceDivisionData, divisions)
+	{
+		ReduceDivisionData data = divisions[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode n = lastNode(compileMain(&p, &b, data.source, reducerPasses));
+		test_assert(cstrFormat("%s: No diagnostics were reported", data.source),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert(cstrFormat("%s: The division is reduced or left alone", data.source),
+					reducerHasMultiplyHigh(n) == data.reduced);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("Products of induction variables are stepped with them")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 n, i32 k) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + i * k; }\n"
+					   "    s\n"
+					   "}\n";
+		WlBoundBlock *body = compileMain(&p, &b, source, reducerPasses)->body.data;
+		WlBoundBlock *outer = body->nodes[1].data;
+		test_assert("the for loop is wrapped", outer->nodes[1].kind == WlBKind_Block);
+		WlBoundBlock *blk = outer->nodes[1].data;
+		WlBoundAssignment *initial = blk->nodes[0].data;
+		test_assert("the product is assigned before the loop", blk->nodes[0].kind == WlBKind_VariableAssignment &&
+																	reducedOperator(initial->expression) == WlBOperator_Multiply);
+		WlBoundWhile *loop = blk->nodes[1].data;
+		WlBoundBlock *loopBody = loop->block.data;
+		WlBoundAssignment *sum = loopBody->nodes[0].data;
+		WlBoundBinaryExpression *add = sum->expression.data;
+		test_assert("the loop reads the local", add->right.kind == WlBKind_Ref && add->right.data == initial->symbol);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_scan
+#endif
+
+#include <scan.h>
+#include <sti_test.h>
+
+// fills buf with `fill` and places `stop` at index `at`
+static void scanTestBuffer(char *buf, int len, char fill, int at, char stop)
+{
+	memset(buf, fill, len);
+	if (at < len) buf[at] = stop;
+}
+
+void test_scan()
+{
+	test_section("scan");
+
+	// every stop position around the 16 and 32 byte chunk boundaries, including the scalar tail
+	char buf[80];
+	int len = sizeof(buf);
+
+	test_that("whitespace runs stop at the first non whitespace byte")
+	{
+		for (int at = 0; at <= len; at++) {
+			scanTestBuffer(buf, len, at % 2 ? ' ' : '\t', at, 'x');
+			test_assert(cstrFormat("stops at %d", at), scanSkipWhitespace(buf, 0, len) == at);
+		}
+		scanTestBuffer(buf, len, '\n', 40, '\r');
+		test_assert("newlines are whitespace", scanSkipWhitespace(buf, 3, len) == len);
+	}
+
+	test_that("symbol runs stop at the first reserved byte")
+	{
+		char *reserved = "\0 ;(.+\"@[^{\x7F\xFF";
+		for (int r = 0; r < 13; r++) {
+			for (int at = 0; at <= len; at++) {
+				scanTestBuffer(buf, len, "aZ9_`\x80\xFE"[at % 7], at, reserved[r]);
+				test_assert(cstrFormat("stops at %d for byte %d", at, (u8)reserved[r]),
+							scanSymbolRun(buf, 0, len) == at);
+			}
+		}
+	}
+
+	test_that("string scans find the closing quote or a null byte")
+	{
+		for (int at = 0; at <= len; at++) {
+			scanTestBuffer(buf, len, 'a', at, '"');
+			test_assert(cstrFormat("finds quote at %d", at), scanFindStringEnd(buf, 0, len) == at);
+			scanTestBuffer(buf, len, 'a', at, '\0');
+			test_assert(cstrFormat("finds null at %d", at), scanFindStringEnd(buf, 0, len) == at);
+		}
+	}
+
+	test_that("comment scans find delimiter candidates and line ends")
+	{
+		for (int at = 0; at <= len; at++) {
+			scanTestBuffer(buf, len, 'a', at, at % 2 ? '*' : '/');
+			test_assert(cstrFormat("finds delimiter at %d", at), scanFindCommentDelimiter(buf, 0, len) == at);
+			scanTestBuffer(buf, len, '/', at, at % 2 ? '\n' : '\r');
+			test_assert(cstrFormat("finds line end at %d", at), scanFindEndOfLine(buf, 0, len) == at);
+		}
+	}
+
+	test_that("scans never look past the given length")
+	{
+		scanTestBuffer(buf, len, 'a', 20, '"');
+		test_assert("string end is clamped", scanFindStringEnd(buf, 0, 10) == 10);
+		test_assert("symbol run is clamped", scanSymbolRun(buf, 5, 17) == 17);
+		scanTestBuffer(buf, len, ' ', 50, 'x');
+		test_assert("whitespace is clamped", scanSkipWhitespace(buf, 0, 33) == 33);
+	}
+}
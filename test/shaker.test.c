@@ -0,0 +1,50 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_shaker
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass shakerPasses[] = {fold, NULL};
+
+void test_shaker()
+{
+	test_section("shaker");
+
+	test_that("Only functions reachable from exports and entrypoints are emitted")
+	{
+		char *text = "import print(str msg);\n"
+					 "import unusedImport(str msg);\n"
+					 "export main() { used(); if 1 > 2 { folded(); } print(\"used\"); }\n"
+					 "used() { print(\"used\"); }\n"
+					 "@entrypoint start() {}\n"
+					 "folded() { print(\"folded\"); }\n"
+					 "unused() { unusedImport(\"unused\"); unused(); }\n";
+		WlParser p;
+		WlBinder b;
+		compileMain(&p, &b, text, shakerPasses);
+		Buf wasm = emitWasm(&b);
+
+		test_assert("No diagnostics were reported", listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		test_assert("The module was compiled", wasm.len > 0);
+
+		test_assert("Called imports are emitted", functionNamed(&b, "print")->symbol->index == 0);
+		test_assert("Unused imports are left out", functionNamed(&b, "unusedImport")->symbol->index == -1);
+		test_assert("Unreachable functions are left out", functionNamed(&b, "unused")->symbol->index == -1);
+		test_assert("Calls in folded branches don't keep a function", functionNamed(&b, "folded")->symbol->index == -1);
+
+		int live[] = {
+			functionNamed(&b, "main")->symbol->index,
+			functionNamed(&b, "used")->symbol->index,
+			functionNamed(&b, "start")->symbol->index,
+		};
+		test_assert("Function indices are dense",
+					live[0] >= 1 && live[0] <= 3 && live[1] >= 1 && live[1] <= 3 && live[2] >= 1 && live[2] <= 3 &&
+						live[0] != live[1] && live[1] != live[2] && live[0] != live[2]);
+		test_assert("Only the data of live functions is emitted, once", listLen(source.data) == 1);
+
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
@@ -327,6 +327,31 @@ void test_sti_arena()
 	}
 }
 
+void test_sti_file()
+{
+	test_section("sti file");
+
+	test_that("mapped files match the file contents and are zero terminated")
+	{
+		Str expected;
+		Str mapped;
+		test_assert("file reads", fileReadAllText("examples/01_helloworld.wl", &expected));
+		test_assert("file maps", fileMapAllText("examples/01_helloworld.wl", &mapped));
+		test_assert("contents match", strEqual(expected, mapped));
+		test_assert("read text is zero terminated", expected.buf[expected.len] == '\0');
+		test_assert("mapped text is zero terminated", mapped.buf[mapped.len] == '\0');
+
+		fileUnmap(&mapped);
+		strFree(&expected);
+	}
+
+	test_that("mapping a missing file fails")
+	{
+		Str mapped;
+		test_assert("file does not map", !fileMapAllText("examples/this_file_does_not_exist.wl", &mapped));
+	}
+}
+
 void test_sti()
 {
 	test_section("sti");
@@ -338,4 +363,5 @@ void test_sti()
 	test_sti_string();
 	test_sti_map();
 	test_sti_arena();
+	test_sti_file();
 }
@@ -0,0 +1,126 @@
+#ifndef TEST_ENTRYPOINT
+#define TEST_ENTRYPOINT test_unroller
+#endif
+
+#include <sti_test.h>
+
+#include <passes.h>
+
+static WlPass unrollerPasses[] = {fold, unroll, NULL};
+
+// the loops in n in the order they run, at most max of them
+static int unrolledLoops(WlbNode n, WlBoundWhile **loops, int max)
+{
+	int count = 0;
+	if (n.kind == WlBKind_WhileLoop && max > 0) {
+		loops[count++] = n.data;
+	} else if (n.kind == WlBKind_Block) {
+		WlBoundBlock *blk = n.data;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			count += unrolledLoops(blk->nodes[i], loops + count, max - count);
+		}
+	}
+	return count;
+}
+
+// how many statements in the blocks of n leave a value behind
+static int unrolledValues(WlbNode n)
+{
+	switch (n.kind) {
+	case WlBKind_Block: {
+		WlBoundBlock *blk = n.data;
+		int count = 0;
+		for (int i = 0; i < listLen(blk->nodes); i++) {
+			WlbNode st = blk->nodes[i];
+			count += (st.kind == WlBKind_Ref || st.kind == WlBKind_NumberLiteral) + unrolledValues(st);
+		}
+		return count;
+	}
+	case WlBKind_WhileLoop: return unrolledValues(((WlBoundWhile *)n.data)->block);
+	default: return 0;
+	}
+}
+
+typedef struct {
+	char *source;
+	int loops;
+	int copies;
+} UnrollData;
+
+void test_unroller()
+{
+	test_section("unroller");
+
+	UnrollData data[] = {
+		{"export i32 main() { var s = 0; for var i = 0; i < 5; i++; { s = s * 3 + i; } s }", 0, 0},
+		{"export i32 main() { var s = 0; for var i = 10; i > 0; i = i - 3; { s = s * 3 + i; } s }", 0, 0},
+		{"export i32 main(i32 n) { var s = 0; for var i = 0; i < n; i++; { s = s * 3 + i; } s }", 2, 4},
+		{"export i32 main(i32 n) { var s = 0; for var i = n; i >= 0; i = i - 2; { s = s * 3 + i; } s }", 2, 4},
+		{"export i32 main() { var s = 0; for var i = 0; i < 1000; i++; { s = s * 3 + i; } s }", 2, 4},
+		{"export i32 main(i32 n) { var s = 0; @unroll(3) for var i = 0; i < n; i++; { s = s * 3 + i; } s }", 2, 3},
+		{"export i32 main() { var s = 0; @unroll(20) for var i = 0; i < 20; i++; { s = s * 3 + i; } s }", 0, 0},
+		{"export i32 main(i32 n) { var s = 0; @unroll(1) for var i = 0; i < n; i++; { s = s * 3 + i; } s }", 1, 1},
+		{"export i32 main(i32 n) { var s = 0; for var i = 0; i != n; i++; { s = s * 3 + i; } s }", 1, 1},
+		{"export i32 main(i32 k) { var n = k; for var i = 0; i < n; i++; { n = n - 1; } n }", 1, 1},
+	};
+
+	test_theory("Counted loops are unrolled fully or by a factor", UnrollData, data)
+	{
+		UnrollData d = data[i];
+		WlParser p;
+		WlBinder b;
+		WlbNode body = compileMain(&p, &b, d.source, unrollerPasses)->body;
+		test_assert(cstrFormat("%s: No diagnostics were reported", d.source),
+					listLen(p.diagnostics) == 0 && listLen(b.diagnostics) == 0);
+		WlBoundWhile *loops[4];
+		int count = unrolledLoops(body, loops, 4);
+		test_assert(cstrFormat("%s: %d loops are left", d.source, d.loops), count == d.loops);
+		if (count) {
+			WlBoundBlock *first = loops[0]->block.data;
+			int copies = count == 1 ? 1 : listLen(first->nodes);
+			test_assert(cstrFormat("%s: The first runs %d copies of the body", d.source, d.copies), copies == d.copies);
+		}
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	test_that("The remainder loop is the original loop")
+	{
+		WlParser p;
+		WlBinder b;
+		char *source = "export i32 main(i32 n) {\n"
+					   "    var s = 0;\n"
+					   "    for var i = 0; i < n; i++; { s = s + i; }\n"
+					   "    s\n"
+					   "}\n";
+		WlbNode body = compileMain(&p, &b, source, unrollerPasses)->body;
+		WlBoundWhile *loops[2];
+		test_assert("there are two loops", unrolledLoops(body, loops, 2) == 2);
+		WlBoundBinaryExpression *guard = loops[0]->condition.data;
+		test_assert("the unrolled loop checks that the bound can't overflow", guard->operator== WlBOperator_And);
+		WlBoundBinaryExpression *condition = loops[1]->condition.data;
+		test_assert("the remainder checks the original condition",
+					condition->operator== WlBOperator_Less && condition->right.kind == WlBKind_Ref);
+		test_assert("neither is unrolled again", loops[0]->unroll == 1 && loops[1]->unroll == 1);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+
+	char *increments[] = {
+		"export i32 main() { var s = 0; for var i = 0; i < 4; i++; { s++; --s; s++; } s }",
+		"export i32 main(i32 n) { var s = 0; for var i = 0; i < n; i++; { s++; --s; s++; } s }",
+	};
+
+	test_theory("The copies leave no values behind, only the body of main does", char *, increments)
+	{
+		WlParser p;
+		WlBinder b;
+		WlbNode body = compileMain(&p, &b, increments[i], unrollerPasses)->body;
+		WlBoundWhile *loops[2];
+		test_assert(cstrFormat("%s: The loop is unrolled", increments[i]),
+					unrolledLoops(body, loops, 2) != 1 && body.kind == WlBKind_Block);
+		test_assert(cstrFormat("%s: Only the value of main is left", increments[i]), unrolledValues(body) == 1);
+		wlBinderFree(&b);
+		wlParserFree(&p);
+	}
+}
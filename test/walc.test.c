@@ -16,6 +16,11 @@ void strPrintBytes(Str s)
 	printf("\n");
 }
 
+// compiles with lazily parsed bodies and only binds the functions that are reachable
+static bool testLazyBodies = false;
+// compiles one body at a time with emitWasmStreaming, which releases every body once it is emitted
+static bool testStreaming = false;
+
 void test_module_function(char *testName, char *moduleName, char *functionName, char *args, char *expected)
 {
 	test_that(testName)
@@ -23,12 +28,24 @@ void test_module_function(char *testName, char *moduleName, char *functionName,
 		Str filename = strFormat("examples/%s", moduleName);
 		Str source;
 
-		test_assert("File opens", fileReadAllText(filename.buf, &source));
+		test_assert("File opens", fileMapAllText(filename.buf, &source));
 
-		WlParser p = wlParserCreate(filename, source);
+		bool lazy = testLazyBodies || testStreaming;
+		WlParser p = wlParserCreateWithOptions(filename, source, lazy ? WlParserLazyBodies : WlParserDefault);
 		wlParse(&p);
 
-		WlBinder b = wlBind(p.topLevelDeclarations);
+		WlBinder b;
+		Buf wasm = {0};
+		if (testStreaming) {
+			int signatureNodes = p.ast.count;
+			b = wlBinderCreateReachable(&p);
+			int signatureFunctions = listLen(b.functions);
+			wasm = emitWasmStreaming(&b);
+			test_assert("the bodies are released once they are emitted",
+						p.ast.count == signatureNodes && listLen(b.functions) == signatureFunctions);
+		} else {
+			b = testLazyBodies ? wlBindReachable(&p) : wlBind(&p.ast, p.topLevelDeclarations);
+		}
 
 		bool hasDiagnostics = listLen(p.diagnostics) || listLen(p.lexer.diagnostics) || listLen(b.diagnostics);
 
@@ -40,8 +57,16 @@ void test_module_function(char *testName, char *moduleName, char *functionName,
 			for (int i = 0; i < listLen(b.diagnostics); i++)
 				diagnosticPrint(b.diagnostics[i]);
 		} else {
-			lower(&b);
-			Buf wasm = emitWasm(&b);
+			if (!testStreaming) {
+				lower(&b);
+				inlineCalls(&b);
+				fold(&b);
+				unroll(&b);
+				hoist(&b);
+				reduce(&b);
+				eliminate(&b);
+				wasm = emitWasm(&b);
+			}
 
 			test_assert("File saves", fileWriteAllBytes("out.wasm", wasm));
 
@@ -68,6 +93,7 @@ void test_module_function(char *testName, char *moduleName, char *functionName,
 
 		wlBinderFree(&b);
 		wlParserFree(&p);
+		fileUnmap(&source);
 		strFree(&filename);
 	}
 }
@@ -100,6 +126,10 @@ void test_walc()
 	test_module_function("testFloat3() == 1.2", "02_expressions.wl", "testFloat3", "", "1.2000000476837158");
 
 	test_module_function("something() == 22", "02_expressions.wl", "something", "", "22");
+	test_module_function("beyond32() == 4294967296", "02_expressions.wl", "beyond32", "", "4294967296n");
+	test_module_function("largest() == 9223372036854775807", "02_expressions.wl", "largest", "",
+						 "9223372036854775807n");
+	test_module_function("offset(1) == 4294967297", "02_expressions.wl", "offset", "1", "4294967297n");
 
 	test_section("walc functions");
 	test_module_function("Called by main is printed", "03_functions.wl", "main", "", "called by main!");
@@ -109,4 +139,58 @@ void test_walc()
 
 	test_section("walc namespaces");
 	test_module_function("Hello namespaces is printed", "05_namespaces.wl", "main", "", "Hello namespaces");
+
+	test_section("walc control flow");
+	test_module_function("Every loop runs n times", "06_controlflow.wl", "main", "2",
+						 "The number is small"
+						 "We will now print n times."
+						 "for loop!"
+						 "for loop!"
+						 "the same could be done with while loop"
+						 "while loop!"
+						 "while loop!"
+						 "Or with a do while loop. this one will run once even if the number is <= 0"
+						 "do-while loop!"
+						 "do-while loop!");
+
+	test_section("walc loops");
+	test_module_function("counted() == 4", "08_loops.wl", "counted", "", "4");
+	test_module_function("countedTo(10) == 10", "08_loops.wl", "countedTo", "10", "10");
+	test_module_function("countedTo(3) == 3", "08_loops.wl", "countedTo", "3", "3");
+
+	test_section("walc statements");
+	test_module_function("increments(5) == 5", "09_statements.wl", "increments", "5", "5");
+	test_module_function("count() returns nothing", "09_statements.wl", "count", "", "");
+
+	test_section("walc lazy bodies");
+	testLazyBodies = true;
+	test_module_function("Hello world is printed", "01_helloworld.wl", "main", "", "Hello wasm 🎉");
+	test_module_function("isBig(11) == \"Big\"", "02_expressions.wl", "isBig", "11", "Big");
+	test_module_function("Called by main is printed", "03_functions.wl", "main", "", "called by main!");
+	test_module_function("60 is printed", "04_variables.wl", "main", "", "60");
+	test_module_function("Hello namespaces is printed", "05_namespaces.wl", "main", "", "Hello namespaces");
+	testLazyBodies = false;
+
+	test_section("walc streaming");
+	testStreaming = true;
+	test_module_function("Hello world is printed", "01_helloworld.wl", "main", "", "Hello wasm 🎉");
+	test_module_function("isBig(11) == \"Big\"", "02_expressions.wl", "isBig", "11", "Big");
+	test_module_function("largest() == 9223372036854775807", "02_expressions.wl", "largest", "",
+						 "9223372036854775807n");
+	test_module_function("Called by main is printed", "03_functions.wl", "main", "", "called by main!");
+	test_module_function("60 is printed", "04_variables.wl", "main", "", "60");
+	test_module_function("Hello namespaces is printed", "05_namespaces.wl", "main", "", "Hello namespaces");
+	test_module_function("increments(5) == 5", "09_statements.wl", "increments", "5", "5");
+	test_module_function("Every loop runs n times", "06_controlflow.wl", "main", "2",
+						 "The number is small"
+						 "We will now print n times."
+						 "for loop!"
+						 "for loop!"
+						 "the same could be done with while loop"
+						 "while loop!"
+						 "while loop!"
+						 "Or with a do while loop. this one will run once even if the number is <= 0"
+						 "do-while loop!"
+						 "do-while loop!");
+	testStreaming = false;
 }
@@ -144,6 +144,9 @@ void test_wasm_data()
 
 		test("data count matches the amount of data sections pushed", listLen(module.data) == 2);
 
+		test("the same data is only added once",
+			 wasmModuleAddData(&module, STRTOBUF(STR("world"))) == msg2Offset && listLen(module.data) == 2);
+
 		Buf bytecode = wasmModuleCompile(module);
 		u8 expected[] = {0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x05, 0x04, 0x01, 0x01, 0x01,
 						 0x01, 0x0B, 0x15, 0x02, 0x00, 0x41, 0x00, 0x0B, 0x05, 0x68, 0x65, 0x6C, 0x6C,
@@ -154,6 +157,51 @@ void test_wasm_data()
 	}
 }
 
+void test_wasm_simd()
+{
+	test_that("Memory instructions take their alignment before their offset")
+	{
+		DynamicBuf body = dynamicBufCreate();
+		wasmPushOpi32Load(&body, 8, 2);
+		wasmPushOpv128Store(&body, 16, 4);
+		u8 expected[] = {0x28, 0x02, 0x08, 0xFD, 0x0B, 0x04, 0x10};
+		test_assert("the memargs are encoded in order", bufEqual(dynamicBufToBuf(body), BUF(expected)));
+		dynamicBufFree(&body);
+	}
+
+	test_that("SIMD opcodes are prefixed and LEB128 encoded")
+	{
+		DynamicBuf body = dynamicBufCreate();
+		wasmPushOpi32Const(&body, 3);
+		wasmPushOpi32x4Splat(&body);
+		u8 lanes[16] = {1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 4, 0, 0, 0};
+		wasmPushOpv128Const(&body, lanes);
+		wasmPushOpi32x4Add(&body);
+		wasmPushOpi32x4ExtractLane(&body, 2);
+		u8 expected[] = {0x41, 0x03, 0xFD, 0x11, 0xFD, 0x0C, 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+						 0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0xFD, 0xAE, 0x01, 0xFD, 0x1B, 0x02};
+		test_assert("the body has the expected bytes", bufEqual(dynamicBufToBuf(body), BUF(expected)));
+		dynamicBufFree(&body);
+	}
+
+	test_that("Functions can have v128 locals")
+	{
+		Wasm module = wasmModuleCreate();
+		u8 returns[] = {WasmType_I32};
+		u8 locals[] = {WasmType_V128, WasmType_V128, WasmType_I32};
+		u8 opcodes[] = {WasmOp_I32Const, 42};
+		wasmModuleAddFunction(&module, STREMPTY, BUFEMPTY, BUF(returns), BUF(locals), BUF(opcodes), -1);
+
+		Buf bytecode = wasmModuleCompile(module);
+		u8 expectedBytecode[] = {0x00, 0x61, 0x73, 0x6D, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01, 0x60,
+								 0x00, 0x01, 0x7F, 0x03, 0x02, 0x01, 0x00, 0x0A, 0x0A, 0x01, 0x08, 0x02,
+								 0x02, 0x7B, 0x01, 0x7F, 0x41, 0x2A, 0x0B};
+		test_assert("the locals are grouped by type", bufEqual(bytecode, BUF(expectedBytecode)));
+
+		wasmModuleFree(&module);
+	}
+}
+
 void test_wasm()
 {
 	test_section("Wasm");
@@ -162,4 +210,5 @@ void test_wasm()
 	test_wasm_import();
 	test_wasm_func();
 	test_wasm_data();
+	test_wasm_simd();
 }